@@ -34,6 +34,9 @@ extern "C" {
 #include "app.h"
 #include "portButtons.h"
 #include "portI2C.h"
+#include "portCycles.h"
+#include "portSQW.h"
+#include "portUART.h"
 /* USER CODE END Includes */
 
 /* Exported types ------------------------------------------------------------*/
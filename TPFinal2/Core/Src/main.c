@@ -87,9 +87,13 @@ int main(void)
   /* Initialize all configured peripherals */
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
+  CyclesInit();
   I2CInit();
   ButtonsInit();
+  SQWInit();
+  UARTStartReception();
   AppInit();
+  KernelStart(); /**< Runs the threads of the application, does not return*/
 
   /* USER CODE END 2 */
 
@@ -100,9 +104,6 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-
-	  AppUpdate();
-	  I2CDelay(100);
   }
   /* USER CODE END 3 */
 }
@@ -23,6 +23,13 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "portButtons.h"
+#include "portSQW.h"
+#include "portCapture.h"
+#include "portI2C.h"
+#include "portUART.h"
+#include "kernel.h"
+#include "deferred.h"
+#include "swTimer.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -58,7 +65,7 @@
 /* External variables --------------------------------------------------------*/
 
 /* USER CODE BEGIN EV */
-
+extern UART_HandleTypeDef huart2;
 /* USER CODE END EV */
 
 /******************************************************************************/
@@ -165,30 +172,18 @@ void DebugMon_Handler(void)
   /* USER CODE END DebugMonitor_IRQn 1 */
 }
 
-/**
-  * @brief This function handles Pendable request for system service.
-  */
-void PendSV_Handler(void)
-{
-  /* USER CODE BEGIN PendSV_IRQn 0 */
-
-  /* USER CODE END PendSV_IRQn 0 */
-  /* USER CODE BEGIN PendSV_IRQn 1 */
-
-  /* USER CODE END PendSV_IRQn 1 */
-}
-
 /**
   * @brief This function handles System tick timer.
   */
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  DeferredTick();
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  SwTimerTick();
+  KernelTick();
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -218,4 +213,76 @@ void EXTI9_5_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles EXTI line0 interrupt (DS3231 SQW).
+  */
+void EXTI0_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler(SQW_PIN);
+}
+
+/**
+  * @brief This function handles EXTI line1 interrupt (1 PPS reference).
+  */
+void EXTI1_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler(PPS_PIN);
+}
+
+/**
+  * @brief This function handles TIM2 global interrupt (DS3231 32kHz capture).
+  */
+void TIM2_IRQHandler(void)
+{
+  CaptureIRQHandler();
+}
+
+/**
+  * @brief This function handles I2C1 event interrupt.
+  */
+void I2C1_EV_IRQHandler(void)
+{
+  I2CEventIRQHandler();
+}
+
+/**
+  * @brief This function handles I2C1 error interrupt.
+  */
+void I2C1_ER_IRQHandler(void)
+{
+  I2CErrorIRQHandler();
+}
+
+/**
+  * @brief This function handles USART2 global interrupt.
+  */
+void USART2_IRQHandler(void)
+{
+  HAL_UART_IRQHandler(&huart2);
+}
+
+/**
+  * @brief This function handles DMA1 stream5 global interrupt (USART2 RX).
+  */
+void DMA1_Stream5_IRQHandler(void)
+{
+  UARTRxDmaIRQHandler();
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt (USART2 TX).
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  UARTTxDmaIRQHandler();
+}
+
+/**
+  * @brief This function handles TIM7 global interrupt (end of a USART2 frame).
+  */
+void TIM7_IRQHandler(void)
+{
+  UARTFrameTimerIRQHandler();
+}
+
 /* USER CODE END 1 */
@@ -6,27 +6,105 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../Drivers/API/src/API_delay.c \
+../Drivers/API/src/agingCal.c \
 ../Drivers/API/src/app.c \
+../Drivers/API/src/appFsm.c \
+../Drivers/API/src/bench.c \
+../Drivers/API/src/clockGov.c \
+../Drivers/API/src/console.c \
+../Drivers/API/src/deferred.c \
 ../Drivers/API/src/ds3231.c \
+../Drivers/API/src/hsiTrim.c \
+../Drivers/API/src/kernel.c \
+../Drivers/API/src/latency.c \
 ../Drivers/API/src/lcd_i2c.c \
+../Drivers/API/src/modbus.c \
 ../Drivers/API/src/portButtons.c \
-../Drivers/API/src/portI2C.c 
+../Drivers/API/src/portCapture.c \
+../Drivers/API/src/portClock.c \
+../Drivers/API/src/portCycles.c \
+../Drivers/API/src/portI2C.c \
+../Drivers/API/src/portKernel.c \
+../Drivers/API/src/portPower.c \
+../Drivers/API/src/portSQW.c \
+../Drivers/API/src/portUART.c \
+../Drivers/API/src/power.c \
+../Drivers/API/src/scheduler.c \
+../Drivers/API/src/swTimer.c \
+../Drivers/API/src/telemetry.c \
+../Drivers/API/src/tempLog.c \
+../Drivers/API/src/timeSync.c \
+../Drivers/API/src/timezone.c \
+../Drivers/API/src/trace.c \
+../Drivers/API/src/tzdata.c 
 
 OBJS += \
 ./Drivers/API/src/API_delay.o \
+./Drivers/API/src/agingCal.o \
 ./Drivers/API/src/app.o \
+./Drivers/API/src/appFsm.o \
+./Drivers/API/src/bench.o \
+./Drivers/API/src/clockGov.o \
+./Drivers/API/src/console.o \
+./Drivers/API/src/deferred.o \
 ./Drivers/API/src/ds3231.o \
+./Drivers/API/src/hsiTrim.o \
+./Drivers/API/src/kernel.o \
+./Drivers/API/src/latency.o \
 ./Drivers/API/src/lcd_i2c.o \
+./Drivers/API/src/modbus.o \
 ./Drivers/API/src/portButtons.o \
-./Drivers/API/src/portI2C.o 
+./Drivers/API/src/portCapture.o \
+./Drivers/API/src/portClock.o \
+./Drivers/API/src/portCycles.o \
+./Drivers/API/src/portI2C.o \
+./Drivers/API/src/portKernel.o \
+./Drivers/API/src/portPower.o \
+./Drivers/API/src/portSQW.o \
+./Drivers/API/src/portUART.o \
+./Drivers/API/src/power.o \
+./Drivers/API/src/scheduler.o \
+./Drivers/API/src/swTimer.o \
+./Drivers/API/src/telemetry.o \
+./Drivers/API/src/tempLog.o \
+./Drivers/API/src/timeSync.o \
+./Drivers/API/src/timezone.o \
+./Drivers/API/src/trace.o \
+./Drivers/API/src/tzdata.o 
 
 C_DEPS += \
 ./Drivers/API/src/API_delay.d \
+./Drivers/API/src/agingCal.d \
 ./Drivers/API/src/app.d \
+./Drivers/API/src/appFsm.d \
+./Drivers/API/src/bench.d \
+./Drivers/API/src/clockGov.d \
+./Drivers/API/src/console.d \
+./Drivers/API/src/deferred.d \
 ./Drivers/API/src/ds3231.d \
+./Drivers/API/src/hsiTrim.d \
+./Drivers/API/src/kernel.d \
+./Drivers/API/src/latency.d \
 ./Drivers/API/src/lcd_i2c.d \
+./Drivers/API/src/modbus.d \
 ./Drivers/API/src/portButtons.d \
-./Drivers/API/src/portI2C.d 
+./Drivers/API/src/portCapture.d \
+./Drivers/API/src/portClock.d \
+./Drivers/API/src/portCycles.d \
+./Drivers/API/src/portI2C.d \
+./Drivers/API/src/portKernel.d \
+./Drivers/API/src/portPower.d \
+./Drivers/API/src/portSQW.d \
+./Drivers/API/src/portUART.d \
+./Drivers/API/src/power.d \
+./Drivers/API/src/scheduler.d \
+./Drivers/API/src/swTimer.d \
+./Drivers/API/src/telemetry.d \
+./Drivers/API/src/tempLog.d \
+./Drivers/API/src/timeSync.d \
+./Drivers/API/src/timezone.d \
+./Drivers/API/src/trace.d \
+./Drivers/API/src/tzdata.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -36,7 +114,7 @@ Drivers/API/src/%.o Drivers/API/src/%.su Drivers/API/src/%.cyclo: ../Drivers/API
 clean: clean-Drivers-2f-API-2f-src
 
 clean-Drivers-2f-API-2f-src:
-	-$(RM) ./Drivers/API/src/API_delay.cyclo ./Drivers/API/src/API_delay.d ./Drivers/API/src/API_delay.o ./Drivers/API/src/API_delay.su ./Drivers/API/src/app.cyclo ./Drivers/API/src/app.d ./Drivers/API/src/app.o ./Drivers/API/src/app.su ./Drivers/API/src/ds3231.cyclo ./Drivers/API/src/ds3231.d ./Drivers/API/src/ds3231.o ./Drivers/API/src/ds3231.su ./Drivers/API/src/lcd_i2c.cyclo ./Drivers/API/src/lcd_i2c.d ./Drivers/API/src/lcd_i2c.o ./Drivers/API/src/lcd_i2c.su ./Drivers/API/src/portButtons.cyclo ./Drivers/API/src/portButtons.d ./Drivers/API/src/portButtons.o ./Drivers/API/src/portButtons.su ./Drivers/API/src/portI2C.cyclo ./Drivers/API/src/portI2C.d ./Drivers/API/src/portI2C.o ./Drivers/API/src/portI2C.su
+	-$(RM) ./Drivers/API/src/API_delay.cyclo ./Drivers/API/src/API_delay.d ./Drivers/API/src/API_delay.o ./Drivers/API/src/API_delay.su ./Drivers/API/src/agingCal.cyclo ./Drivers/API/src/agingCal.d ./Drivers/API/src/agingCal.o ./Drivers/API/src/agingCal.su ./Drivers/API/src/app.cyclo ./Drivers/API/src/app.d ./Drivers/API/src/app.o ./Drivers/API/src/app.su ./Drivers/API/src/appFsm.cyclo ./Drivers/API/src/appFsm.d ./Drivers/API/src/appFsm.o ./Drivers/API/src/appFsm.su ./Drivers/API/src/bench.cyclo ./Drivers/API/src/bench.d ./Drivers/API/src/bench.o ./Drivers/API/src/bench.su ./Drivers/API/src/clockGov.cyclo ./Drivers/API/src/clockGov.d ./Drivers/API/src/clockGov.o ./Drivers/API/src/clockGov.su ./Drivers/API/src/console.cyclo ./Drivers/API/src/console.d ./Drivers/API/src/console.o ./Drivers/API/src/console.su ./Drivers/API/src/deferred.cyclo ./Drivers/API/src/deferred.d ./Drivers/API/src/deferred.o ./Drivers/API/src/deferred.su ./Drivers/API/src/ds3231.cyclo ./Drivers/API/src/ds3231.d ./Drivers/API/src/ds3231.o ./Drivers/API/src/ds3231.su ./Drivers/API/src/hsiTrim.cyclo ./Drivers/API/src/hsiTrim.d ./Drivers/API/src/hsiTrim.o ./Drivers/API/src/hsiTrim.su ./Drivers/API/src/kernel.cyclo ./Drivers/API/src/kernel.d ./Drivers/API/src/kernel.o ./Drivers/API/src/kernel.su ./Drivers/API/src/latency.cyclo ./Drivers/API/src/latency.d ./Drivers/API/src/latency.o ./Drivers/API/src/latency.su ./Drivers/API/src/lcd_i2c.cyclo ./Drivers/API/src/lcd_i2c.d ./Drivers/API/src/lcd_i2c.o ./Drivers/API/src/lcd_i2c.su ./Drivers/API/src/modbus.cyclo ./Drivers/API/src/modbus.d ./Drivers/API/src/modbus.o ./Drivers/API/src/modbus.su ./Drivers/API/src/portButtons.cyclo ./Drivers/API/src/portButtons.d ./Drivers/API/src/portButtons.o ./Drivers/API/src/portButtons.su ./Drivers/API/src/portCapture.cyclo ./Drivers/API/src/portCapture.d ./Drivers/API/src/portCapture.o ./Drivers/API/src/portCapture.su ./Drivers/API/src/portClock.cyclo ./Drivers/API/src/portClock.d ./Drivers/API/src/portClock.o ./Drivers/API/src/portClock.su ./Drivers/API/src/portCycles.cyclo ./Drivers/API/src/portCycles.d ./Drivers/API/src/portCycles.o ./Drivers/API/src/portCycles.su ./Drivers/API/src/portI2C.cyclo ./Drivers/API/src/portI2C.d ./Drivers/API/src/portI2C.o ./Drivers/API/src/portI2C.su ./Drivers/API/src/portKernel.cyclo ./Drivers/API/src/portKernel.d ./Drivers/API/src/portKernel.o ./Drivers/API/src/portKernel.su ./Drivers/API/src/portPower.cyclo ./Drivers/API/src/portPower.d ./Drivers/API/src/portPower.o ./Drivers/API/src/portPower.su ./Drivers/API/src/portSQW.cyclo ./Drivers/API/src/portSQW.d ./Drivers/API/src/portSQW.o ./Drivers/API/src/portSQW.su ./Drivers/API/src/portUART.cyclo ./Drivers/API/src/portUART.d ./Drivers/API/src/portUART.o ./Drivers/API/src/portUART.su ./Drivers/API/src/power.cyclo ./Drivers/API/src/power.d ./Drivers/API/src/power.o ./Drivers/API/src/power.su ./Drivers/API/src/scheduler.cyclo ./Drivers/API/src/scheduler.d ./Drivers/API/src/scheduler.o ./Drivers/API/src/scheduler.su ./Drivers/API/src/swTimer.cyclo ./Drivers/API/src/swTimer.d ./Drivers/API/src/swTimer.o ./Drivers/API/src/swTimer.su ./Drivers/API/src/telemetry.cyclo ./Drivers/API/src/telemetry.d ./Drivers/API/src/telemetry.o ./Drivers/API/src/telemetry.su ./Drivers/API/src/tempLog.cyclo ./Drivers/API/src/tempLog.d ./Drivers/API/src/tempLog.o ./Drivers/API/src/tempLog.su ./Drivers/API/src/timeSync.cyclo ./Drivers/API/src/timeSync.d ./Drivers/API/src/timeSync.o ./Drivers/API/src/timeSync.su ./Drivers/API/src/timezone.cyclo ./Drivers/API/src/timezone.d ./Drivers/API/src/timezone.o ./Drivers/API/src/timezone.su ./Drivers/API/src/trace.cyclo ./Drivers/API/src/trace.d ./Drivers/API/src/trace.o ./Drivers/API/src/trace.su ./Drivers/API/src/tzdata.cyclo ./Drivers/API/src/tzdata.d ./Drivers/API/src/tzdata.o ./Drivers/API/src/tzdata.su
 
 .PHONY: clean-Drivers-2f-API-2f-src
 
@@ -1,3 +1,6 @@
+#ifndef API_DELAY_H
+#define API_DELAY_H
+
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include <stdint.h>
@@ -23,3 +26,5 @@ void delayInit(delay_t* delay, tick_t duration);
 bool_t delayRead(delay_t* delay);
 void delayWrite(delay_t* delay, tick_t duration);
 /* USER CODE END EFP */
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ * @file agingCal.h
+ * @brief Declarations for the DS3231 aging offset calibration.
+ *
+ * This file contains function prototypes, constants, and data structures for
+ * measuring the frequency error of the DS3231 against a reference and correcting
+ * it through the aging offset register. The 1 Hz SQW edges are timed with the DWT
+ * cycle counter against either a 1 PPS input or host timestamps received through
+ * USART2 ("T <milliseconds>" lines). After each measurement window the offset is
+ * corrected (about 0.1 ppm per unit) until the correction rounds to zero.
+ * The core does not stop (power.h) and the clock stays fast (clockGov.h) while a calibration
+ * runs: the cycle counter stops with the core and its rate changes with the clock.
+ * It relies on clockGov.h, ds3231.h, portSQW.h, portUART.h, power.h and swTimer.h.
+ */
+#ifndef AGINGCAL_H
+#define AGINGCAL_H
+
+/**
+ * @brief Includes the software timer of the settling.
+ */
+#include "swTimer.h"
+
+/**
+ * @brief Includes functions for interfacing with DS3231.
+ */
+#include "ds3231.h"
+
+/**
+ * @brief Includes functions for timestamping the SQW and 1 PPS edges.
+ */
+#include "portSQW.h"
+
+/**
+ * @brief Includes functions for sending the report through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Includes the hold that keeps the core running during a calibration.
+ */
+#include "power.h"
+
+/**
+ * @brief Includes the hold that keeps the clock fast while a calibration runs.
+ */
+#include "clockGov.h"
+
+/**
+ * @brief Error (in ppb) corrected by one unit of the aging offset.
+ */
+#define CAL_PPB_PER_STEP 100
+
+/**
+ * @brief Gap (in milliseconds) between host timestamps that restarts their accumulation (the cycle counter wraps in 59.6 s).
+ */
+#define CAL_HOST_MAX_GAP 50000
+
+/**
+ * @brief Corrections before giving up.
+ */
+#define CAL_MAX_ITERATIONS 6
+
+/**
+ * @brief Time (in milliseconds) the oscillator is left to settle after a correction.
+ */
+#define CAL_SETTLE_TIME 3000
+
+/**
+ * @brief Length (in seconds) of each measurement window.
+ */
+#define CAL_WINDOW 300
+
+/**
+ * @typedef agingCalState_t
+ * @brief States of the calibration.
+ */
+typedef enum{
+	CAL_IDLE,		/**< Not running */
+	CAL_WAITING,	/**< Waiting for the first edges of a reference */
+	CAL_MEASURING,	/**< Accumulating a measurement window */
+	CAL_SETTLING,	/**< Waiting for a new aging offset to settle */
+	CAL_DONE		/**< Finished, report available */
+} agingCalState_t;
+
+/**
+ * @typedef calSource_t
+ * @brief References the DS3231 is compared against.
+ */
+typedef enum{
+	CAL_SOURCE_NONE,
+	CAL_SOURCE_PPS,
+	CAL_SOURCE_HOST
+} calSource_t;
+
+/**
+ * @typedef agingCalReport_t
+ * @brief Progress and result of the calibration.
+ */
+typedef struct{
+	agingCalState_t state;	/**< Current state */
+	calSource_t source;		/**< Reference in use */
+	uint8_t iteration;		/**< Measurement windows completed */
+	uint16_t elapsed;		/**< Seconds of the current window */
+	int8_t initialOffset;	/**< Aging offset before the calibration */
+	int8_t offset;			/**< Aging offset in use */
+	int32_t errorBefore;	/**< Error of the first window (ppb, positive: DS3231 runs fast) */
+	int32_t errorAfter;		/**< Error of the last window (ppb) */
+	bool converged;			/**< True if the last correction rounded to zero */
+} agingCalReport_t;
+
+/**
+ * @function AgingCalFormatPpm
+ * @brief Function that writes an error in ppb as "+d.dddppm".
+ * @param text: buffer to write (at least 14 bytes)
+ * @param ppb: error in parts per billion
+ * @retval none
+ */
+void AgingCalFormatPpm(char *text, int32_t ppb);
+
+/**
+ * @function AgingCalGetReport
+ * @brief Function that copies the progress of the calibration.
+ * @param report: pointer to the agingCalReport_t to fill
+ * @retval none
+ */
+void AgingCalGetReport(agingCalReport_t *report);
+
+/**
+ * @function AgingCalHostTimestamp
+ * @brief Function that feeds a host timestamp, used as reference when no 1 PPS is connected.
+ * @param hostTime: host time in milliseconds (any origin, must be monotonic)
+ * @param stamp: cycle counter when the timestamp arrived
+ * @retval none
+ */
+void AgingCalHostTimestamp(uint32_t hostTime, uint32_t stamp);
+
+/**
+ * @function AgingCalStart
+ * @brief Function that starts a calibration: switches INT/SQW to the 1 Hz square wave and waits for a reference.
+ * @param none
+ * @retval none
+ */
+void AgingCalStart(void);
+
+/**
+ * @function AgingCalStop
+ * @brief Function that stops the calibration, keeping the aging offset reached, and gives INT/SQW back to the alarm.
+ * @param none
+ * @retval none
+ */
+void AgingCalStop(void);
+
+/**
+ * @function AgingCalUpdate
+ * @brief Function that advances the calibration without blocking. To be called periodically.
+ * @param none
+ * @retval state of the calibration
+ */
+agingCalState_t AgingCalUpdate(void);
+
+#endif
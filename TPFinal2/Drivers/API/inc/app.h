@@ -4,39 +4,207 @@
  *
  * This file contains function prototypes, constants, and data structures
  * for running the main application. According to the  LCD with RTC.
- * It relies on the ds3231.h and lcd_i2c.h.
+ * It relies on the ds3231.h, lcd_i2c.h and timezone.h. The DS3231 holds UTC; every screen shows local time.
  */
 #ifndef APP_H
 #define APP_H
 
+/**
+ * @brief Includes functions for calibrating the DS3231 aging offset.
+ */
+#include "agingCal.h"
+
+/**
+ * @brief Includes the states and transition tables of the application FSM.
+ */
+#include "appFsm.h"
+
+/**
+ * @brief Includes the microbenchmarks of the drivers.
+ */
+#include "bench.h"
+
+/**
+ * @brief Includes the clock governor, which slows the clock down between the bursts of work.
+ */
+#include "clockGov.h"
+
+/**
+ * @brief Includes the command console that runs the lines received through USART2.
+ */
+#include "console.h"
+
+/**
+ * @brief Includes the statistics of the deferred interrupt work.
+ */
+#include "deferred.h"
+
 /**
  * @brief Includes functions for interfacing with DS3231.
  */
 #include "ds3231.h"
 
+/**
+ * @brief Includes functions for trimming the HSI against the DS3231.
+ */
+#include "hsiTrim.h"
+
+/**
+ * @brief Includes functions for measuring the input to display latency.
+ */
+#include "latency.h"
+
 /**
  * @brief Includes functions for interfacing with LCD display.
  */
 #include "lcd_i2c.h"
 
+/**
+ * @brief Includes the Modbus RTU slave on USART2.
+ */
+#include "modbus.h"
+
 /**
  * @brief Includes functions for defining GPIO as buttons.
  */
 #include "portButtons.h"
 
+/**
+ * @brief Includes functions for sending data through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Includes the kernel that runs the application and the LCD writes as threads.
+ */
+#include "kernel.h"
+
+/**
+ * @brief Includes the low-power mode, which stops the core between the events.
+ */
+#include "power.h"
+
+/**
+ * @brief Includes the cooperative scheduler that runs the tasks of the application.
+ */
+#include "scheduler.h"
+
+/**
+ * @brief Includes the software timers of the overlay messages and the temperature samples.
+ */
+#include "swTimer.h"
+
+/**
+ * @brief Includes the binary telemetry stream.
+ */
+#include "telemetry.h"
+
+/**
+ * @brief Includes functions for the temperature history.
+ */
+#include "tempLog.h"
+
+/**
+ * @brief Includes the setting of the DS3231 from the host clock.
+ */
+#include "timeSync.h"
+
+/**
+ * @brief Includes the event trace and its dump.
+ */
+#include "trace.h"
+
+/**
+ * @brief Includes functions for converting UTC to local time.
+ */
+#include "timezone.h"
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 
+/**
+ * @brief Time (in ms) between polls of the busy flags of a forced temperature conversion.
+ */
+#define CONVERSION_POLL_TIME 50
+
+/**
+ * @brief Priority of the application thread, above the LCD one.
+ */
+#define APP_PRIORITY 2
+
+/**
+ * @brief Size (in words) of the stack of the application thread.
+ */
+#define APP_STACK_WORDS 1024
+
+/**
+ * @brief Time (in ms) the benchmark waits for the LCD thread to end the frame in flight before it uses the LCD.
+ */
+#define BENCH_SETTLE 100
+
+/**
+ * @brief Interval (in ms) at which the benchmark reads the time to start on a change of the seconds.
+ */
+#define BENCH_SYNC_POLL 10
+
+/**
+ * @brief Deadline (ms) of the display task.
+ */
+#define DISPLAY_DEADLINE 100
+
+/**
+ * @brief Period (ms) of the display task.
+ */
+#define DISPLAY_PERIOD 100
+
+/**
+ * @brief Most lines of the temperature history sent per pass of the dump timer, only while they fit in the transmit
+ * buffer, so the dump never waits for the line.
+ */
+#define DUMP_LINES 8
+
+/**
+ * @brief Period (ms) of the dump timer: about four lines leave the line at 115200 baud meanwhile.
+ */
+#define DUMP_PERIOD 10
 
 /**
  * @brief Definition of the Enter button.
  */
 #define ENTER_BUTTON ENTER_PIN
 
+/**
+ * @brief Deadline (ms) of the input task, from the press or repeat to the screen rendered.
+ */
+#define INPUT_DEADLINE 50
+
 /**
  * @brief Definition of the Left button.
  */
 #define LEFT_BUTTON LEFT_PIN
 
+/**
+ * @brief Presses whose latency can wait for the LCD thread at a time.
+ */
+#define LATENCY_PENDING 8
+
+/**
+ * @brief Priority of the LCD thread.
+ */
+#define LCD_PRIORITY 1
+
+/**
+ * @brief Amount of rows of the LCD.
+ */
+#define LCD_ROWS 2
+
+/**
+ * @brief Size (in words) of the stack of the LCD thread.
+ */
+#define LCD_STACK_WORDS 256
+
 /**
  * @brief Maximum amount of buttons to store.
  */
@@ -52,26 +220,60 @@
  */
 #define MENU_BUTTON MENU_PIN
 
+/**
+ * @brief Period (ms) of the snapshots of the Modbus registers while the slave runs.
+ */
+#define MODBUS_REFRESH 500
+
+/**
+ * @brief Time (milliseconds) the stopped clock message is shown on boot.
+ */
+#define OVERLAY_BOOT_TIME 2000
+
+/**
+ * @brief Time (milliseconds) a confirmation message is shown over the screen.
+ */
+#define OVERLAY_TIME 1000
+
 /**
  * @brief Definition of the Right button.
  */
 #define RIGHT_BUTTON RIGHT_PIN
 
 /**
- * @function AppInit
- * @brief Initializes the main app FSM.
- * @param none
- * @retval none
+ * @brief Column of an LCD row whose content is unknown (nothing written yet).
  */
-void AppInit();
+#define ROW_UNKNOWN 0xFF
+
+/**
+ * @brief Size of the text of a temperature: "-8192.00" and the terminator, with room to spare.
+ */
+#define TEMPERATURE_TEXT_SIZE 10
 
 /**
- * @function AppUpdate
- * @brief Updates the main app FSM
+ * @brief Deadline (ms) of the timers task, from the expiry to the end of the callbacks.
+ */
+#define TIMERS_DEADLINE 50
+
+/**
+ * @brief Deadline (ms) of the UART task.
+ */
+#define UART_DEADLINE 100
+
+
+/**
+ * @brief Time (milliseconds) after the seconds are seen changing during which the time is not read again.
+ * A second lasts 1000 ms; the rest covers a late pass.
+ */
+#define SECOND_GUARD 800
+
+/**
+ * @function AppInit
+ * @brief Initializes the main app FSM and creates its threads. KernelStart must be called after it.
  * @param none
  * @retval none
  */
-void AppUpdate();
+void AppInit();
 
 /**
  * @function ButtonPressed
@@ -81,4 +283,13 @@ void AppUpdate();
  */
 void ButtonPressed(uint16_t GPIO_PIN);
 
+/**
+ * @function ButtonRepeated
+ * @brief This function is called while a button is held, once per repeat
+ * @param GPIO_Pin: number of the Pin that is held
+ * @param steps: steps to advance in this repeat
+ * @retval none
+ */
+void ButtonRepeated(uint16_t GPIO_Pin, uint8_t steps);
+
 #endif
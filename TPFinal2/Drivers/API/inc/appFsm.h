@@ -0,0 +1,208 @@
+/**
+ * @file appFsm.h
+ * @brief States and transition tables of the application FSM.
+ *
+ * Generated by Tools/fsmgen.py from Tools/appfsm.txt. Do not edit.
+ */
+#ifndef APPFSM_H
+#define APPFSM_H
+
+#include <stdint.h>
+
+/**
+ * @brief States of the main FSM (one per screen).
+ */
+typedef enum{
+	SHOWTIME,
+	SETTIME,
+	SETALARM,
+	MULTIZONE,
+	TEMPERATURE,
+	CALIBRATION,
+	MENU
+} app_t;
+
+/**
+ * @brief States of the menu FSM (one per entry).
+ */
+typedef enum{
+	SHOWTIME_M,
+	SETTIME_M,
+	SETALARM_M,
+	MULTIZONE_M,
+	TEMPERATURE_M,
+	CALIBRATION_M
+} menu_t;
+
+/**
+ * @brief Amount of screens.
+ */
+#define APP_SCREEN_COUNT 7
+
+/**
+ * @brief Amount of menu entries.
+ */
+#define APP_MENU_COUNT 6
+
+/**
+ * @brief Amount of editable fields (all screens).
+ */
+#define APP_FIELD_COUNT 10
+
+/**
+ * @brief Field index meaning none: after the last field, or the first field of a screen without fields.
+ */
+#define APP_FIELD_NONE 0xFF
+
+/**
+ * @brief Maximum of a field that takes the length of the month being edited.
+ */
+#define APP_FIELD_MDAYS 0
+
+/**
+ * @brief Screen: handlers and first editable field.
+ */
+typedef struct{
+	void (*update)(uint16_t button);	/**< Called every pass with the button pressed (0 if none)*/
+	void (*enter)(void);				/**< Called when the menu enters the screen (NULL if none)*/
+	void (*leave)(void);				/**< Called when MENU leaves the screen (NULL if none)*/
+	uint8_t firstField;					/**< Index in appFields, APP_FIELD_NONE if none*/
+} appScreen_t;
+
+/**
+ * @brief Menu entry: text, screen entered and neighbours.
+ */
+typedef struct{
+	const char *text[2];	/**< Text of each row*/
+	uint8_t col[2];			/**< Column of the text of each row*/
+	uint8_t screen;			/**< app_t entered with ENTER*/
+	uint8_t right;			/**< menu_t selected with RIGHT*/
+	uint8_t left;			/**< menu_t selected with LEFT*/
+} appMenuEntry_t;
+
+/**
+ * @brief Editable field: member of DS3231_DateTime, range, cursor and next field.
+ */
+typedef struct{
+	uint8_t offset;		/**< Offset of the member in DS3231_DateTime*/
+	uint8_t size;		/**< Size of the member (bytes)*/
+	uint16_t min;		/**< Minimum value*/
+	uint16_t max;		/**< Maximum value, APP_FIELD_MDAYS for the length of the month*/
+	uint8_t wrap;		/**< 1 to wrap around the range, 0 to stop at its ends*/
+	uint8_t row;		/**< Row of the cursor*/
+	uint8_t col;		/**< Column of the cursor*/
+	uint8_t next;		/**< Field selected with ENTER, APP_FIELD_NONE after the last one*/
+} appField_t;
+
+/**
+ * @brief Screens, indexed by app_t.
+ */
+extern const appScreen_t appScreens[APP_SCREEN_COUNT];
+
+/**
+ * @brief Menu entries, indexed by menu_t.
+ */
+extern const appMenuEntry_t appMenu[APP_MENU_COUNT];
+
+/**
+ * @brief Editable fields, grouped by screen.
+ */
+extern const appField_t appFields[APP_FIELD_COUNT];
+
+/**
+ * @function CalibrationMode
+ * @brief Update handler of CALIBRATION.
+ * @param button: button pressed (0 if none)
+ * @retval none
+ */
+void CalibrationMode(uint16_t button);
+
+/**
+ * @function MenuUpdate
+ * @brief Update handler of MENU.
+ * @param button: button pressed (0 if none)
+ * @retval none
+ */
+void MenuUpdate(uint16_t button);
+
+/**
+ * @function MultiZoneMode
+ * @brief Update handler of MULTIZONE.
+ * @param button: button pressed (0 if none)
+ * @retval none
+ */
+void MultiZoneMode(uint16_t button);
+
+/**
+ * @function SetAlarmMode
+ * @brief Update handler of SETALARM.
+ * @param button: button pressed (0 if none)
+ * @retval none
+ */
+void SetAlarmMode(uint16_t button);
+
+/**
+ * @function SetTimeMode
+ * @brief Update handler of SETTIME.
+ * @param button: button pressed (0 if none)
+ * @retval none
+ */
+void SetTimeMode(uint16_t button);
+
+/**
+ * @function ShowTimeMode
+ * @brief Update handler of SHOWTIME.
+ * @param button: button pressed (0 if none)
+ * @retval none
+ */
+void ShowTimeMode(uint16_t button);
+
+/**
+ * @function TemperatureMode
+ * @brief Update handler of TEMPERATURE.
+ * @param button: button pressed (0 if none)
+ * @retval none
+ */
+void TemperatureMode(uint16_t button);
+
+/**
+ * @function AgingCalStart
+ * @brief Enter action of CALIBRATION.
+ * @param none
+ * @retval none
+ */
+void AgingCalStart(void);
+
+/**
+ * @function AgingCalStop
+ * @brief Leave action of CALIBRATION.
+ * @param none
+ * @retval none
+ */
+void AgingCalStop(void);
+
+/**
+ * @function MultiZoneEnter
+ * @brief Enter action of MULTIZONE.
+ * @param none
+ * @retval none
+ */
+void MultiZoneEnter(void);
+
+/**
+ * @function SetAlarmEnter
+ * @brief Enter action of SETALARM.
+ * @param none
+ * @retval none
+ */
+void SetAlarmEnter(void);
+
+/**
+ * @function SetTimeEnter
+ * @brief Enter action of SETTIME.
+ * @param none
+ * @retval none
+ */
+void SetTimeEnter(void);
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file bench.h
+ * @brief Declarations for the microbenchmarks of the drivers.
+ *
+ * This file contains function prototypes, constants and types for timing short pieces
+ * of code with the DWT cycle counter. A case is a function without arguments, given
+ * by the user in a table; BenchRun calls each one a number of times and sends the
+ * fewest, average and most cycles per call through USART2, without the cost of the
+ * measurement itself (the fewest cycles of an empty case). The core runs at the fast
+ * clock meanwhile (power.h, clockGov.h), so the cycles of the drivers that wait for
+ * the I2C bus include the wait. In the simulator the cycle counter only advances with
+ * the modelled bus and delay time, so the same cases give the bus cost of each call.
+ * The replies are "BENCH START clock=<Hz> overhead=<cycles> runs=<n>", a line
+ * "BENCH <name> runs=<n> min=<cycles> avg=<cycles> max=<cycles> us=<us>" per case (us is
+ * the average) and "BENCH END"; Tools/bench.py turns them into a report to compare
+ * against a baseline.
+ * It relies on clockGov.h, console.h, portCycles.h and power.h.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * @brief Includes the hold that keeps the clock fast while the cases run.
+ */
+#include "clockGov.h"
+
+/**
+ * @brief Includes functions for sending the results as replies.
+ */
+#include "console.h"
+
+/**
+ * @brief Includes functions for timing the cases with the cycle counter.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes the hold that keeps the core running while the cases run.
+ */
+#include "power.h"
+
+/**
+ * @brief Calls of each case when no number is given.
+ */
+#ifndef BENCH_RUNS
+#define BENCH_RUNS 16
+#endif
+
+/**
+ * @brief Most calls of each case.
+ */
+#define BENCH_MAX_RUNS 1000
+
+/**
+ * @typedef benchCase_t
+ * @brief Case of the benchmark.
+ */
+typedef struct{
+	const char *name;		/**< Name in the replies, without spaces */
+	void (*run)(void);		/**< Function timed, once per call */
+} benchCase_t;
+
+/**
+ * @function BenchRun
+ * @brief Function that times every case of a table and sends the results through USART2. Not from interrupts.
+ * @param table: table of cases
+ * @param count: number of cases in the table
+ * @param runs: calls of each case, from 1 to BENCH_MAX_RUNS
+ * @retval none
+ */
+void BenchRun(const benchCase_t *table, uint8_t count, uint16_t runs);
+
+#endif // BENCH_H
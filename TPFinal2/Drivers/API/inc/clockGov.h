@@ -0,0 +1,135 @@
+/**
+ * @file clockGov.h
+ * @brief Declarations for the clock governor.
+ *
+ * This file contains function prototypes and constants for running the core on the slow
+ * clock mode (8 MHz from the HSI, PLL off, portClock.h) while it is idle and on the
+ * 72 MHz PLL only for bursts of work: the frames written to the LCD, the commands
+ * received through USART2 (and the dumps they send) and the measurements that count
+ * cycles (HSI trim, aging calibration). A burst holds the fast mode (ClockHold), which
+ * ramps the PLL up at once; the idle thread slows the clock down once nobody holds it,
+ * no I2C1 transfer is running and no byte arrived through USART2 lately. I2C1 is
+ * retimed with the bus locked and USART2 at the switch, and SysTick keeps its phase,
+ * so HAL_GetTick and the software timers run exactly as with the fixed clock.
+ * The governor is off by default ("G1" turns it on). While it is on, the statistics
+ * that count cycles (load and response times of the threads, the latencies) mix the
+ * rates of both modes. A byte that arrives during a ramp up may be lost.
+ * The module measures the time spent in each mode (the time stopped, power.h, counts in
+ * neither) and estimates the energy per second from the supply current of each mode,
+ * against the fixed 72 MHz clock. The currents are estimates for a core that sleeps
+ * most of the time (WFI), to be replaced by readings of IDD (JP6 on the Nucleo).
+ * In the simulator, a minute on the clock screen (a frame per second) spends 2.4 % of the
+ * time fast, with 120 switches: 5.3 mW instead of 19.8 mW with these estimates. The lock
+ * of the PLL at every ramp up (measured on target, "ramp=") is not simulated.
+ * It relies on portClock.h, portI2C.h and portUART.h.
+ */
+#ifndef CLOCKGOV_H
+#define CLOCKGOV_H
+
+/**
+ * @brief Includes the functions that switch the clock mode.
+ */
+#include "portClock.h"
+
+/**
+ * @brief Includes the lock and the retiming of the I2C bus.
+ */
+#include "portI2C.h"
+
+/**
+ * @brief Includes functions for sending the report through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Time (in ms) without a byte through USART2 before the clock slows down: a byte being received would change
+ * its baud rate in the middle.
+ */
+#define CLOCK_RX_QUIET 20
+
+/**
+ * @brief Estimated supply current (in uA) of the fast mode, mostly sleeping.
+ */
+#define CLOCK_FAST_UA 6000
+
+/**
+ * @brief Estimated supply current (in uA) of the slow mode, mostly sleeping.
+ */
+#define CLOCK_SLOW_UA 1500
+
+/**
+ * @brief Supply voltage (in mV) of the estimate.
+ */
+#define CLOCK_SUPPLY_MV 3300
+
+/**
+ * @function ClockEnable
+ * @brief Function that turns the governor on or off. Off, the clock goes back to the fast mode at once. Not from
+ * interrupts.
+ * @param enable: true to slow the clock down while idle, false to keep it fast
+ * @retval none
+ */
+void ClockEnable(bool_t enable);
+
+/**
+ * @function ClockEnabled
+ * @brief Function that checks whether the governor is on.
+ * @param none
+ * @retval true if it is on, false if not
+ */
+bool_t ClockEnabled(void);
+
+/**
+ * @function ClockHold
+ * @brief Function that keeps the fast mode until ClockRelease, ramping the PLL up first if the clock is slow (it
+ * waits for the I2C1 transfer in progress, if any). Holds nest. Not from interrupts.
+ * @param none
+ * @retval none
+ */
+void ClockHold(void);
+
+/**
+ * @function ClockIdle
+ * @brief Function that slows the clock down if the governor is on and nothing needs the fast mode, and charges the
+ * time to the mode it ran in. To be called from the idle thread before it sleeps, at least once a minute.
+ * @param none
+ * @retval none
+ */
+void ClockIdle(void);
+
+/**
+ * @function ClockInit
+ * @brief Function that takes the clock set by SystemClock_Config as the fast mode and clears the statistics. The
+ * governor starts off.
+ * @param none
+ * @retval none
+ */
+void ClockInit(void);
+
+/**
+ * @function ClockRelease
+ * @brief Function that ends a ClockHold. The clock slows down the next time the core is idle.
+ * @param none
+ * @retval none
+ */
+void ClockRelease(void);
+
+/**
+ * @function ClockReport
+ * @brief Function that sends the statistics through USART2: state, time in each mode (ms), switches, average and
+ * worst ramp up (us), and the estimated power (uW, the energy in uJ per second) against the fixed 72 MHz clock
+ * ("fixed72=").
+ * @param none
+ * @retval none
+ */
+void ClockReport(void);
+
+/**
+ * @function ClockResetStats
+ * @brief Function that clears the statistics.
+ * @param none
+ * @retval none
+ */
+void ClockResetStats(void);
+
+#endif // CLOCKGOV_H
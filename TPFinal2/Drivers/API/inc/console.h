@@ -0,0 +1,137 @@
+/**
+ * @file console.h
+ * @brief Declarations for the command console on USART2.
+ *
+ * This file contains function prototypes and types for running the lines received
+ * through USART2 as commands. A line is split into words in its own slot of the
+ * reception queue (portUART.h): the separators are overwritten with terminators and
+ * the arguments point into the line, so nothing is copied. The first word names the
+ * command, looked up in a table given by the user with the number of arguments it
+ * takes; "HELP" sends the usage of every command. A command replies with its own lines;
+ * an unknown command or a wrong number of arguments replies "ERR" and the usage.
+ * Each call runs one line, so a script sent at full line rate is run a line at a
+ * time between the other tasks; the lines wait in the reception queue meanwhile.
+ * The module counts the lines run, the errors, the longest queue and the longest run,
+ * and ConsoleReport sends them with the losses of the reception and of UARTWrite. Every
+ * command run is also a span of the trace (trace.h).
+ * It relies on portCycles.h, portUART.h and API_delay.h.
+ */
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+/**
+ * @brief Includes the bool_t type.
+ */
+#include "API_delay.h"
+
+/**
+ * @brief Includes functions for timing the commands with the cycle counter.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes the reception queue and functions for sending the replies through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Maximum number of words of a command line, its name included.
+ */
+#define CONSOLE_MAX_ARGS 8
+
+/**
+ * @brief Maximum length of a reply line sent by ConsoleReply, including the line end.
+ */
+#define CONSOLE_REPLY_SIZE 96
+
+/**
+ * @typedef consoleCmd_t
+ * @brief Command of the console.
+ */
+typedef struct{
+	const char *name;						/**< First word of the line, matched exactly */
+	uint8_t minArgs;						/**< Fewest words after the name */
+	uint8_t maxArgs;						/**< Most words after the name */
+	void (*run)(uint8_t argc, char *argv[]);	/**< Function of the command, argv[0] is the name */
+	const char *usage;						/**< Arguments and description, sent by "HELP" */
+} consoleCmd_t;
+
+/**
+ * @function ConsoleCommandName
+ * @brief Function that gets the name of a command, for the reports of other modules.
+ * @param command: index of the command in the table
+ * @retval name of the command, NULL if there is no command with that index
+ */
+const char *ConsoleCommandName(uint8_t command);
+
+/**
+ * @function ConsoleInit
+ * @brief Function that takes the table of commands and clears the statistics.
+ * @param table: table of commands
+ * @param count: number of commands in the table
+ * @retval none
+ */
+void ConsoleInit(const consoleCmd_t *table, uint8_t count);
+
+/**
+ * @function ConsoleReply
+ * @brief Function that sends a reply line through USART2, formatted as printf and ended by "\r\n". It is cut at
+ * CONSOLE_REPLY_SIZE.
+ * @param format: format of the line (without line end)
+ * @retval none
+ */
+void ConsoleReply(const char *format, ...);
+
+/**
+ * @function ConsoleReport
+ * @brief Function that sends the statistics through USART2: lines run, errors, lines dropped by the reception,
+ * reception errors, bytes dropped by UARTWrite, longest queue and longest run of a command (us).
+ * @param none
+ * @retval none
+ */
+void ConsoleReport(void);
+
+/**
+ * @function ConsoleResetStats
+ * @brief Function that clears the statistics, those of the reception included.
+ * @param none
+ * @retval none
+ */
+void ConsoleResetStats(void);
+
+/**
+ * @function ConsoleStamp
+ * @brief Function that gets the stamp of the line being run, for commands that measure their arrival.
+ * @param none
+ * @retval cycle counter at the first byte of the line
+ */
+uint32_t ConsoleStamp(void);
+
+/**
+ * @function ConsoleTokenize
+ * @brief Function that splits a line into words separated by spaces, in place: the first separator after each
+ * word is overwritten with a terminator.
+ * @param line: line to split, null terminated
+ * @param argv: array to store the pointers to the words
+ * @param max: size of argv
+ * @retval number of words in the line (more than max if some did not fit)
+ */
+uint8_t ConsoleTokenize(char *line, char *argv[], uint8_t max);
+
+/**
+ * @function ConsoleUsage
+ * @brief Function that replies "ERR" and the usage of the command being run, for arguments its function rejects.
+ * @param none
+ * @retval none
+ */
+void ConsoleUsage(void);
+
+/**
+ * @function ConsoleUpdate
+ * @brief Function that runs the oldest line received, if any, and frees its slot. Empty lines are skipped.
+ * @param none
+ * @retval true if more lines are waiting, false if not
+ */
+bool_t ConsoleUpdate(void);
+
+#endif // CONSOLE_H
@@ -0,0 +1,82 @@
+/**
+ * @file deferred.h
+ * @brief Declarations for the deferred interrupt work.
+ *
+ * This file contains function prototypes and types for splitting an interrupt in two
+ * halves. The interrupt itself only posts the event: a handler, an argument and the
+ * cycle counter at the post go into a queue and PendSV is requested. PendSV, at the
+ * lowest priority, runs every handler queued in a batch before it switches threads,
+ * so the processing never delays an interrupt, SysTick included, and a thread woken by
+ * a handler runs right after the batch.
+ * The module also measures the SysTick period, to show how much other interrupts
+ * delay it. DeferredReport sends the statistics through USART2.
+ * It relies on portCycles.h, portKernel.h and portUART.h.
+ */
+#ifndef DEFERRED_H
+#define DEFERRED_H
+
+/**
+ * @brief Includes the cycle counter to stamp the posts.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes functions for sending the report through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Events that can wait in the queue (a power of 2). A post to a full queue is dropped.
+ */
+#define DEFERRED_QUEUE 16
+
+/**
+ * @brief Handler of a deferred event. Receives the argument of the post and the cycle counter when it was posted.
+ */
+typedef void (*deferredHandler_t)(uint32_t arg, uint32_t stamp);
+
+/**
+ * @function DeferredPost
+ * @brief Function that queues an event and requests PendSV. Meant for interrupts: a few dozen cycles with the
+ * interrupts masked.
+ * @param handler: function that processes the event
+ * @param arg: argument of the handler
+ * @retval none
+ */
+void DeferredPost(deferredHandler_t handler, uint32_t arg);
+
+/**
+ * @function DeferredReport
+ * @brief Function that sends the statistics through USART2: events posted and dropped, batches run, largest batch,
+ * longest wait from a post to its handler (us) and largest deviation of the SysTick period (us).
+ * @param none
+ * @retval none
+ */
+void DeferredReport(void);
+
+/**
+ * @function DeferredResetStats
+ * @brief Function that clears the statistics.
+ * @param none
+ * @retval none
+ */
+void DeferredResetStats(void);
+
+/**
+ * @function DeferredRun
+ * @brief Function that runs the handlers of the events queued, oldest first, until the queue is empty. It must be
+ * called from PendSV only.
+ * @param none
+ * @retval none
+ */
+void DeferredRun(void);
+
+/**
+ * @function DeferredTick
+ * @brief Function that measures the period of the SysTick interrupt. It must be called first thing in SysTick_Handler.
+ * @param none
+ * @retval none
+ */
+void DeferredTick(void);
+
+#endif // DEFERRED_H
@@ -25,22 +25,47 @@
 #include <stdint.h>
 
 
+/**
+ * @brief Aging offset register. Two's complement, each LSB is about 0.1 ppm at 25 C (positive slows the clock)
+ */
+#define AGING_REGISTER 0x10
+
 /**
  * @brief Size (in bytes) of the buffer to transmit/receive data for alarms
  */
 #define ALARM_SIZE 4
 
+/**
+ * @brief Enable 32kHz output bit of the status register
+ */
+#define EN32KHZ_BIT (1<<3)
+
 /**
  * @brief Register to start to write to or read from to set the alarm. In the DS3231, it contains data
  * about the seconds.
  */
 #define ALARM_START_REGISTER 0x08
 
+/**
+ * @brief Busy bit of the status register. Set while a temperature conversion is running
+ */
+#define BSY_BIT (1<<2)
+
 /**
  * @brief Mask for keeping the 5 LSB. Used in month byte to avoid the century bit
  */
 #define CENTURY_MASK 0x1F
 
+/**
+ * @brief Convert temperature bit of the control register. Forces a conversion, cleared by the DS3231 when done
+ */
+#define CONV_BIT (1<<5)
+
+/**
+ * @brief Control register of the DS3231
+ */
+#define CONTROL_REGISTER 0x0E
+
 /**
  * @brief Mask for keeping all the bits but the MSB. Used in seconds byte to avoid the control register
  */
@@ -51,6 +76,11 @@
  */
 #define DS3231_ADDR (0x68 << 1)
 
+/**
+ * @brief Interrupt control bit of the control register. Set: INT/SQW signals alarms; clear: square wave
+ */
+#define INTCN_BIT (1<<2)
+
 /**
  * @brief First day of the month. Used to initialize a time struct
  */
@@ -81,16 +111,63 @@
  */
 #define NIBBLE_SIZE 4
 
+/**
+ * @brief Oscillator stop flag of the status register. Set when the oscillator stopped (e.g.: VBAT was lost)
+ * and the time is not reliable. Only cleared by writing 0
+ */
+#define OSF_BIT (1<<7)
+
+/**
+ * @brief Rate select bits of the control register. Both clear select a 1 Hz square wave
+ */
+#define RATE_SELECT_MASK ((1<<4)|(1<<3))
+
+/**
+ * @brief Size (in bytes) of a single register write: register address and value
+ */
+#define REGISTER_WRITE_SIZE 2
+
 /**
  * @brief Saturday in the time struct.
  */
 #define LAST_DAY 7
 
+/**
+ * @brief Size (in bytes) of the time snapshot. It starts at the status register and the DS3231 register pointer wraps
+ * from 0x12 to 0x00, so one burst gets status, aging, temperature and the time registers
+ */
+#define SNAPSHOT_SIZE 11
+
+/**
+ * @brief Index of the seconds register in the time snapshot
+ */
+#define SNAPSHOT_TIME_INDEX 4
+
 /**
  * @brief Sunday in the time struct. Used to initialize a time struct
  */
 #define FIRST_DAY 1
 
+/**
+ * @brief Status register of the DS3231
+ */
+#define STATUS_REGISTER 0x0F
+
+/**
+ * @brief Shift of the fraction bits (0.25 C resolution) in the temperature LSB register
+ */
+#define TEMPERATURE_FRACTION_SHIFT 6
+
+/**
+ * @brief Register with the integer part of the temperature (two's complement). The fraction is in the next one
+ */
+#define TEMPERATURE_REGISTER 0x11
+
+/**
+ * @brief Size (in bytes) of the buffer to receive the temperature
+ */
+#define TEMPERATURE_SIZE 2
+
 /**
  * @brief Size (in bytes) of the buffer to transmit/receive data for time
  */
@@ -130,6 +207,17 @@ typedef struct {
     uint16_t Year;  /**< Complete year (e.g.: 2025) */
 } DS3231_DateTime;
 
+/**
+ * @typedef DS3231_Validity
+ * @brief Validity of the time held by the DS3231, updated by every GetTime.
+ */
+typedef enum {
+    TIME_UNKNOWN,   /**< The time was not read yet */
+    TIME_VALID,     /**< The time can be trusted */
+    TIME_STOPPED,   /**< The oscillator stopped (OSF set): the time must be set again */
+    TIME_CORRUPT    /**< The registers hold values out of range */
+} DS3231_Validity;
+
 
 /**
  * @function bcd2dec
@@ -156,6 +244,14 @@ void CopyTime(DS3231_DateTime *timeToCopy, DS3231_DateTime *timeToPaste);
  */
 uint8_t DecToBcd(uint8_t val);
 
+/**
+ * @function GetAgingOffset
+ * @brief Function that gets the aging offset of the DS3231 crystal.
+ * @param none
+ * @retval aging offset (about 0.1 ppm per unit, positive slows the clock)
+ */
+int8_t GetAgingOffset(void);
+
 /**
  * @function SetAlarm
  * @brief Function that gets an alarm of the DS3231.
@@ -164,13 +260,30 @@ uint8_t DecToBcd(uint8_t val);
  */
 void GetAlarm(DS3231_DateTime *time);
 
+/**
+ * @function GetTemperature
+ * @brief Function that gets the last temperature converted by the DS3231.
+ * @param none
+ * @retval temperature in 0.25 C units (e.g.: 93 is 23.25 C)
+ */
+int16_t GetTemperature(void);
+
 /**
  * @function GetTime
- * @brief Function that get the date and time from the DS3231.
+ * @brief Function that get the date and time from the DS3231. The oscillator stop flag is read in the same
+ * burst, so checking the validity costs no extra I2C transaction.
  * @param time: pointer to the DateTime struct that will store the date and time
- * @retval none
+ * @retval boolean that indicates if the time is valid (see GetTimeValidity)
+ */
+bool GetTime(DS3231_DateTime *time);
+
+/**
+ * @function GetTimeValidity
+ * @brief Function that gets the validity of the time found by the last GetTime.
+ * @param none
+ * @retval validity of the last time read
  */
-void GetTime(DS3231_DateTime *time);
+DS3231_Validity GetTimeValidity(void);
 
 /**
  * @function InitTime
@@ -180,6 +293,14 @@ void GetTime(DS3231_DateTime *time);
  */
 void InitTime(DS3231_DateTime *time);
 
+/**
+ * @function IsConversionBusy
+ * @brief Function that checks, without blocking, whether a temperature conversion is still running.
+ * @param none
+ * @retval boolean that indicates if the DS3231 is still converting (CONV or BSY set)
+ */
+bool IsConversionBusy(void);
+
 /**
  * @function IsAlarmSet
  * @brief Function that checks whether an alarm is set.
@@ -188,6 +309,23 @@ void InitTime(DS3231_DateTime *time);
  */
 bool IsAlarmSet(DS3231_DateTime *alarm);
 
+/**
+ * @function Set32kHzOutput
+ * @brief Function that enables or disables the 32.768 kHz output of the DS3231.
+ * @param enable: true to enable the output
+ * @retval none
+ */
+void Set32kHzOutput(bool enable);
+
+/**
+ * @function SetAgingOffset
+ * @brief Function that sets the aging offset of the DS3231 crystal. It applies after the next temperature
+ * conversion, so one is forced (if none is running).
+ * @param offset: aging offset (about 0.1 ppm per unit, positive slows the clock)
+ * @retval none
+ */
+void SetAgingOffset(int8_t offset);
+
 /**
  * @function SetAlarm
  * @brief Function that sets an alarm of the DS3231.
@@ -196,12 +334,30 @@ bool IsAlarmSet(DS3231_DateTime *alarm);
  */
 void SetAlarm(DS3231_DateTime *time);
 
+/**
+ * @function SetSquareWave
+ * @brief Function that selects the function of the INT/SQW pin: 1 Hz square wave or alarm interrupt.
+ * @param enable: true for the 1 Hz square wave, false for the alarm interrupt
+ * @retval none
+ */
+void SetSquareWave(bool enable);
+
 /**
  * @function SetTime
- * @brief Function that sets the date and time of the DS3231.
+ * @brief Function that sets the date and time of the DS3231. Also clears the oscillator stop flag, so the time
+ * is valid again.
  * @param time: pointer to the DateTime struct that store the date and time to set
  * @retval none
  */
 void SetTime(DS3231_DateTime *time);
 
+/**
+ * @function StartConversion
+ * @brief Function that forces a temperature conversion. It does not wait for it: poll IsConversionBusy
+ * and then read the result with GetTemperature.
+ * @param none
+ * @retval boolean that indicates if the conversion was started (false if one is already running)
+ */
+bool StartConversion(void);
+
 #endif
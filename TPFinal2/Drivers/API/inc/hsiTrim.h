@@ -0,0 +1,92 @@
+/**
+ * @file hsiTrim.h
+ * @brief Declarations for the HSI trimming service.
+ *
+ * This file contains function prototypes and constants for correcting the HSI
+ * oscillator (the source of the 72 MHz PLL clock, +-1% from factory) against the
+ * DS3231 32.768 kHz output (+-2 ppm). Every measurement window counts system clock
+ * cycles over the 32 kHz edges with TIM2 input capture. The HSITRIM field is moved
+ * one step at a time (each step is about 0.2-0.4%) while that reduces the error.
+ * The remaining error, below half a step, is corrected by loading the measured
+ * frequency into SystemCoreClock and recomputing the SysTick reload (1 / 72000 resolution)
+ * and the USART2 divider. Measurements repeat periodically to follow temperature drift.
+ * Windows and waits are timed with a software timer, whose callback runs in the main loop.
+ * The core does not stop (power.h) and the clock stays fast (clockGov.h) during a window.
+ * It relies on clockGov.h, ds3231.h, portCapture.h, portUART.h, power.h and swTimer.h.
+ */
+#ifndef HSITRIM_H
+#define HSITRIM_H
+
+/**
+ * @brief Includes the software timer of the windows.
+ */
+#include "swTimer.h"
+
+/**
+ * @brief Includes functions for interfacing with DS3231.
+ */
+#include "ds3231.h"
+
+/**
+ * @brief Includes the TIM2 input capture functions.
+ */
+#include "portCapture.h"
+
+/**
+ * @brief Includes functions for sending the report through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Includes the hold that keeps the core running during a window.
+ */
+#include "power.h"
+
+/**
+ * @brief Includes the hold that keeps the clock fast during a window, and its calibration.
+ */
+#include "clockGov.h"
+
+/**
+ * @brief Frequency (in Hz) of the DS3231 32kHz output.
+ */
+#define HSITRIM_REFERENCE 32768
+
+/**
+ * @brief Fewest edges for a valid window (half the expected ones). Fewer means the 32kHz output is not connected.
+ */
+#define HSITRIM_MIN_EDGES (HSITRIM_REFERENCE / 2)
+
+/**
+ * @brief Time (in milliseconds) between measurements once the trim is found.
+ */
+#define HSITRIM_PERIOD 60000
+
+/**
+ * @brief Largest HSITRIM value.
+ */
+#define HSITRIM_MAX 31
+
+/**
+ * @brief Length (in milliseconds) of a measurement window.
+ */
+#define HSITRIM_WINDOW 1000
+
+/**
+ * @function HsiTrimGetError
+ * @brief Function that returns the error of the last measurement against the nominal clock.
+ * @param none
+ * @retval error in ppm (positive: the clock runs fast)
+ */
+int32_t HsiTrimGetError(void);
+
+/**
+ * @function HsiTrimInit
+ * @brief Function that enables the DS3231 32kHz output and starts the first measurement. The rest of the service
+ * runs from the software timer.
+ * @param none
+ * @retval none
+ */
+void HsiTrimInit(void);
+
+#endif
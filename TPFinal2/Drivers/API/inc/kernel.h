@@ -0,0 +1,270 @@
+/**
+ * @file kernel.h
+ * @brief Declarations for the preemptive kernel.
+ *
+ * This file contains function prototypes and types for running the firmware as a few
+ * threads with fixed priorities. Every thread has its own static stack and runs until
+ * it blocks (on a semaphore, a message queue or a sleep); the highest priority thread
+ * that is ready always runs, so a thread woken by an interrupt preempts a lower one at
+ * once. The scheduling decision is taken with the interrupts masked and the context
+ * switch itself is done by the port (portKernel.h) in the lowest priority exception.
+ * The kernel times every activation of a thread (from the moment it is made ready to
+ * the moment it blocks again) with the DWT cycle counter and keeps the worst one, its
+ * response time, together with the CPU time of every thread. KernelReport sends them
+ * through USART2.
+ * It relies on API_delay.h, portCycles.h and portUART.h.
+ */
+#ifndef KERNEL_H
+#define KERNEL_H
+
+/**
+ * @brief Includes the tick_t and bool_t types.
+ */
+#include "API_delay.h"
+
+/**
+ * @brief Includes functions for timing the activations with the cycle counter.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes functions for sending the report through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Maximum amount of threads, the idle thread included.
+ */
+#define KERNEL_MAX_THREADS 6
+
+/**
+ * @brief Size (in words) of the stack of the idle thread.
+ */
+#define KERNEL_IDLE_STACK 128
+
+/**
+ * @brief Timeout that never expires.
+ */
+#define KERNEL_FOREVER 0xFFFFFFFFU
+
+/**
+ * @brief Value the stacks are filled with, to find the deepest word used.
+ */
+#define KERNEL_STACK_FILL 0xDEADBEEFU
+
+/* Declaration of the external error handler function. Declared in the main */
+extern void Error_Handler();
+
+/**
+ * @function KernelIdle
+ * @brief External function that is called forever by the idle thread, when no other thread is ready: waits for the
+ * next interrupt, or sleeps deeper
+ * @param none
+ * @retval none
+ */
+extern void KernelIdle(void);
+
+/**
+ * @typedef kSem_t
+ * @brief Counting semaphore. A semaphore initialized with a count of 1 and a maximum of 1 is a lock.
+ */
+typedef struct{
+	volatile uint16_t count;	/**< Units available */
+	uint16_t max;				/**< Units above which KernelSemGive is ignored */
+} kSem_t;
+
+/**
+ * @typedef kThread_t
+ * @brief Thread. Owned by its user, only changed through the functions of this module.
+ */
+typedef struct kThread{
+	uint32_t *sp;				/**< Saved stack pointer while it does not run (first field: used by the port) */
+	const char *name;			/**< Name in the report */
+	uint32_t *stack;			/**< Lowest word of its stack */
+	uint32_t stackWords;		/**< Size of its stack (words) */
+	uint8_t priority;			/**< Higher runs first, 0 is the idle thread */
+	volatile uint8_t state;		/**< Ready, waiting for a semaphore or sleeping */
+	bool_t acquired;			/**< Whether the last wait got the semaphore (false on timeout) */
+	bool_t timed;				/**< Whether the wait has a timeout */
+	kSem_t *waitSem;			/**< Semaphore it waits for */
+	tick_t wakeTick;			/**< Tick the wait times out at */
+	uint32_t readyCycles;		/**< Cycle counter when the current activation started */
+	uint32_t activations;		/**< Activations since the statistics were reset */
+	uint32_t worstResponse;		/**< Longest activation (cycles) */
+	uint64_t runCycles;			/**< Time it ran (cycles), the interrupts it was preempted by included */
+} kThread_t;
+
+/**
+ * @typedef kQueue_t
+ * @brief Message queue of fixed size items, copied in and out.
+ */
+typedef struct{
+	uint8_t *buffer;			/**< Storage of length items */
+	uint16_t itemSize;			/**< Size (bytes) of an item */
+	uint16_t length;			/**< Capacity (items) */
+	uint16_t head;				/**< Next item to receive */
+	uint16_t tail;				/**< Next place to send to */
+	kSem_t items;				/**< Items queued */
+	kSem_t spaces;				/**< Places free */
+} kQueue_t;
+
+/**
+ * @function KernelAdvance
+ * @brief Function that counts several ticks at once, waking the threads whose sleep or wait timed out meanwhile, after
+ * the tick was stopped (a sleep or STOP). It must be called from PendSV, the SysTick interrupt or with the
+ * interrupts masked.
+ * @param ticks: ticks elapsed
+ * @retval none
+ */
+void KernelAdvance(tick_t ticks);
+
+/**
+ * @function KernelNextTimeout
+ * @brief Function that gets the ticks to the earliest timeout of a thread that sleeps or waits with a timeout.
+ * @param none
+ * @retval ticks to it, KERNEL_FOREVER if no thread has a timeout
+ */
+tick_t KernelNextTimeout(void);
+
+/**
+ * @function KernelQueueCount
+ * @brief Function that gets the number of items waiting in a queue.
+ * @param queue: queue to look at
+ * @retval items queued
+ */
+uint16_t KernelQueueCount(kQueue_t *queue);
+
+/**
+ * @function KernelQueueInit
+ * @brief Function that initializes an empty message queue.
+ * @param queue: queue to initialize
+ * @param buffer: storage of at least itemSize * length bytes
+ * @param itemSize: size (bytes) of an item
+ * @param length: capacity (items)
+ * @retval none
+ */
+void KernelQueueInit(kQueue_t *queue, void *buffer, uint16_t itemSize, uint16_t length);
+
+/**
+ * @function KernelQueueReceive
+ * @brief Function that takes the oldest item of a queue, waiting for one if it is empty.
+ * @param queue: queue to receive from
+ * @param item: buffer of itemSize bytes to copy the item to
+ * @param timeout: ticks (ms) to wait, 0 not to wait (the only value allowed in interrupts) or KERNEL_FOREVER
+ * @retval true if an item was received, false on timeout
+ */
+bool_t KernelQueueReceive(kQueue_t *queue, void *item, tick_t timeout);
+
+/**
+ * @function KernelQueueSend
+ * @brief Function that appends an item to a queue, waiting for a free place if it is full.
+ * @param queue: queue to send to
+ * @param item: item of itemSize bytes to copy
+ * @param timeout: ticks (ms) to wait, 0 not to wait (the only value allowed in interrupts) or KERNEL_FOREVER
+ * @retval true if the item was queued, false on timeout
+ */
+bool_t KernelQueueSend(kQueue_t *queue, const void *item, tick_t timeout);
+
+/**
+ * @function KernelReport
+ * @brief Function that sends the statistics through USART2: a "thread <name> ..." line per thread with its
+ * activations, worst response time (us), CPU load (per mille) and deepest stack use (words), and a "cpu ..." line
+ * with the load of the threads that are not idle.
+ * @param none
+ * @retval none
+ */
+void KernelReport(void);
+
+/**
+ * @function KernelResetStats
+ * @brief Function that clears the statistics of every thread.
+ * @param none
+ * @retval none
+ */
+void KernelResetStats(void);
+
+/**
+ * @function KernelRunning
+ * @brief Function that checks whether the kernel was started, so a thread can block.
+ * @param none
+ * @retval true if it was started, false before KernelStart
+ */
+bool_t KernelRunning(void);
+
+/**
+ * @function KernelSemGive
+ * @brief Function that adds a unit to a semaphore, waking the highest priority thread that waits for it. Can be
+ * called from interrupts.
+ * @param sem: semaphore to give
+ * @retval none
+ */
+void KernelSemGive(kSem_t *sem);
+
+/**
+ * @function KernelSemInit
+ * @brief Function that initializes a semaphore.
+ * @param sem: semaphore to initialize
+ * @param count: units available at the start
+ * @param max: maximum units
+ * @retval none
+ */
+void KernelSemInit(kSem_t *sem, uint16_t count, uint16_t max);
+
+/**
+ * @function KernelSemTake
+ * @brief Function that takes a unit of a semaphore, waiting for one if there is none. Before KernelStart it does not
+ * wait.
+ * @param sem: semaphore to take
+ * @param timeout: ticks (ms) to wait, 0 not to wait (the only value allowed in interrupts) or KERNEL_FOREVER
+ * @retval true if it got the unit, false on timeout
+ */
+bool_t KernelSemTake(kSem_t *sem, tick_t timeout);
+
+/**
+ * @function KernelSleep
+ * @brief Function that blocks the calling thread for some ticks. Before KernelStart it returns at once.
+ * @param ticks: ticks (ms) to sleep
+ * @retval none
+ */
+void KernelSleep(tick_t ticks);
+
+/**
+ * @function KernelStart
+ * @brief Function that creates the idle thread and switches to the highest priority thread. It does not return on
+ * the board.
+ * @param none
+ * @retval none
+ */
+void KernelStart(void);
+
+/**
+ * @function KernelThreadCreate
+ * @brief Function that creates a thread, ready to run from the start of its function once the kernel starts.
+ * @param thread: thread to create
+ * @param name: name in the report
+ * @param stack: static stack, aligned to 8 bytes
+ * @param stackWords: size of the stack (words)
+ * @param priority: priority, from 1 (lowest) up
+ * @param entry: function of the thread. It must never return
+ * @retval none
+ */
+void KernelThreadCreate(kThread_t *thread, const char *name, uint32_t *stack, uint32_t stackWords, uint8_t priority,
+		void (*entry)(void));
+
+/**
+ * @function KernelThreadGet
+ * @brief Function that gets a thread, to read its statistics.
+ * @param index: index in the order they were created (the idle thread is the last one)
+ * @retval pointer to the thread, NULL if there is no thread with that index
+ */
+const kThread_t *KernelThreadGet(uint8_t index);
+
+/**
+ * @function KernelTick
+ * @brief Function that wakes the threads whose sleep or wait timed out. It must be called from the SysTick interrupt.
+ * @param none
+ * @retval none
+ */
+void KernelTick(void);
+
+#endif // KERNEL_H
@@ -0,0 +1,111 @@
+/**
+ * @file latency.h
+ * @brief Declarations for the input to display latency histograms.
+ *
+ * This file contains function prototypes, constants, and data structures
+ * for measuring the time from the first edge of a button press (EXTI interrupt)
+ * to the moment the screen that handled it has been written to the HD44780 DDRAM.
+ * Each screen keeps the count, minimum, maximum and sum of its samples and a
+ * histogram with LATENCY_SUB_BUCKETS buckets per power of two (at most 25% wide),
+ * enough for percentiles without storing the samples.
+ */
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/**
+ * @brief Includes functions for timestamping with the cycle counter.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes functions for sending data through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Includes boolean type definitions.
+ */
+#include <stdbool.h>
+
+/**
+ * @brief Includes integer type definitions.
+ */
+#include <stdint.h>
+
+/**
+ * @brief Buckets of each histogram. With 4 buckets per power of two they cover up to 33 s in microseconds.
+ */
+#define LATENCY_BUCKETS 96
+
+/**
+ * @brief Buckets per power of two.
+ */
+#define LATENCY_SUB_BUCKETS 4
+
+/**
+ * @typedef latencyScreen_t
+ * @brief Screens with a latency histogram.
+ */
+typedef enum{
+	LAT_MENU,
+	LAT_SETTIME,
+	LAT_SETALARM,
+	LAT_SCREEN_COUNT
+} latencyScreen_t;
+
+/**
+ * @typedef latencyStats_t
+ * @brief Summary of the latencies of a screen, in microseconds.
+ */
+typedef struct{
+	uint32_t count;	/**< Samples recorded */
+	uint32_t min;	/**< Shortest latency */
+	uint32_t avg;	/**< Average latency */
+	uint32_t p99;	/**< 99th percentile (upper bound of its bucket) */
+	uint32_t max;	/**< Longest latency */
+} latencyStats_t;
+
+/**
+ * @function LatencyDump
+ * @brief Function that sends the summary and the non empty buckets of every screen through USART2 as CSV lines.
+ * @param none
+ * @retval none
+ */
+void LatencyDump(void);
+
+/**
+ * @function LatencyGetStats
+ * @brief Function that gets the summary of the latencies of a screen.
+ * @param screen: screen (LAT_xxx)
+ * @param stats: pointer to the latencyStats_t to fill
+ * @retval none
+ */
+void LatencyGetStats(latencyScreen_t screen, latencyStats_t *stats);
+
+/**
+ * @function LatencyPercentile
+ * @brief Function that gets a percentile of the latencies of a screen from its histogram.
+ * @param screen: screen (LAT_xxx)
+ * @param permille: percentile in tenths of a percent (e.g.: 990 for p99)
+ * @retval upper bound (in microseconds) of the bucket that holds the percentile, 0 if there are no samples
+ */
+uint32_t LatencyPercentile(latencyScreen_t screen, uint16_t permille);
+
+/**
+ * @function LatencyRecord
+ * @brief Function that records the latency of an input handled by a screen, ending now.
+ * @param screen: screen that handled the input (LAT_xxx)
+ * @param edge: cycle counter at the button edge
+ * @retval none
+ */
+void LatencyRecord(latencyScreen_t screen, uint32_t edge);
+
+/**
+ * @function LatencyReset
+ * @brief Function that clears the histograms of every screen.
+ * @param none
+ * @retval none
+ */
+void LatencyReset(void);
+
+#endif
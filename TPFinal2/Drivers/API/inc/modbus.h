@@ -0,0 +1,168 @@
+/**
+ * @file modbus.h
+ * @brief Declarations for the Modbus RTU slave on USART2.
+ *
+ * This file contains function prototypes, constants and types for serving holding
+ * registers to a Modbus RTU master through USART2. While the slave runs, USART2 is in
+ * frame mode (portUART.h): a request ends after 3.5 characters of silence, timed by TIM7,
+ * and is served by ModbusUpdate. Reads (function 3) are answered from a register image
+ * owned by the user, who keeps it up to date outside the requests, so nothing slower
+ * than a copy sits between a request and its reply. Writes (functions 6 and 16) are
+ * handed to the user through ModbusWrite, which checks and applies them.
+ * A request with a bad CRC, or for another address, is dropped without a reply, as the
+ * protocol asks; a broadcast (address 0) is served but not answered. The text output
+ * of the other modules is dropped while the slave runs.
+ * The module counts the requests, the replies, the exceptions, the frames dropped and
+ * the longest turnaround, from the end of a request to its reply queued.
+ * It relies on portCycles.h, portUART.h and API_delay.h.
+ */
+#ifndef MODBUS_H
+#define MODBUS_H
+
+/**
+ * @brief Includes the bool_t type.
+ */
+#include "API_delay.h"
+
+/**
+ * @brief Includes functions for timing the turnaround with the cycle counter.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes the frame mode of USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Silence (in us) that ends a request: 3.5 characters, fixed at 1750 us above 19200 baud.
+ */
+#define MODBUS_GAP 1750
+
+/**
+ * @brief Address of the broadcasts.
+ */
+#define MODBUS_BROADCAST 0
+
+/**
+ * @brief Highest address of a slave.
+ */
+#define MODBUS_MAX_ADDRESS 247
+
+/**
+ * @brief Most registers read by a request (function 3).
+ */
+#define MODBUS_MAX_READ 125
+
+/**
+ * @brief Most registers written by a request (function 16).
+ */
+#define MODBUS_MAX_WRITE 123
+
+/**
+ * @brief Result of ModbusWrite: the registers were written.
+ */
+#define MODBUS_OK 0
+
+/**
+ * @brief Exception code: the function is not supported.
+ */
+#define MODBUS_ILLEGAL_FUNCTION 1
+
+/**
+ * @brief Exception code: the registers do not exist or can not be written that way.
+ */
+#define MODBUS_ILLEGAL_ADDRESS 2
+
+/**
+ * @brief Exception code: a value is out of range or the request is malformed.
+ */
+#define MODBUS_ILLEGAL_VALUE 3
+
+/**
+ * @brief Exception code: the write failed.
+ */
+#define MODBUS_DEVICE_FAILURE 4
+
+/**
+ * @typedef modbusStats_t
+ * @brief Statistics of the slave, since the last ModbusResetStats.
+ */
+typedef struct{
+	uint32_t requests;			/**< Requests for this address or broadcast */
+	uint32_t replies;			/**< Replies sent, exceptions included */
+	uint32_t exceptions;		/**< Requests answered with an exception */
+	uint32_t crcErrors;			/**< Frames dropped for their CRC or length */
+	uint32_t ignored;			/**< Frames for other addresses */
+	uint32_t turnaroundMax;		/**< Longest time from the end of a request to its reply queued (us) */
+} modbusStats_t;
+
+/**
+ * @function ModbusWrite
+ * @brief External function that is called to write registers, from ModbusUpdate. It checks the values and applies
+ * them, and updates the image.
+ * @param address: first register
+ * @param count: number of registers, within the image
+ * @param values: values of the registers
+ * @retval MODBUS_OK, or the exception code to reply
+ */
+extern uint8_t ModbusWrite(uint16_t address, uint16_t count, const uint16_t *values);
+
+/**
+ * @function ModbusAddress
+ * @brief Function that gets the address of the slave.
+ * @param none
+ * @retval address, 0 if the slave is not running
+ */
+uint8_t ModbusAddress(void);
+
+/**
+ * @function ModbusGetStats
+ * @brief Function that gets the statistics of the slave.
+ * @param stats: pointer to store the statistics
+ * @retval none
+ */
+void ModbusGetStats(modbusStats_t *stats);
+
+/**
+ * @function ModbusInit
+ * @brief Function that takes the register image and clears the statistics. The slave starts stopped.
+ * @param image: holding registers, read by the requests as they are
+ * @param count: number of registers in the image
+ * @retval none
+ */
+void ModbusInit(uint16_t *image, uint16_t count);
+
+/**
+ * @function ModbusResetStats
+ * @brief Function that clears the statistics, those of the reception included.
+ * @param none
+ * @retval none
+ */
+void ModbusResetStats(void);
+
+/**
+ * @function ModbusStart
+ * @brief Function that switches USART2 to frames and starts serving the requests for an address.
+ * @param address: address of the slave, 1 to MODBUS_MAX_ADDRESS
+ * @retval true if it started, false if the address is out of range
+ */
+bool_t ModbusStart(uint8_t address);
+
+/**
+ * @function ModbusStop
+ * @brief Function that stops the slave and switches USART2 back to lines. A reply being served is still sent.
+ * @param none
+ * @retval none
+ */
+void ModbusStop(void);
+
+/**
+ * @function ModbusUpdate
+ * @brief Function that serves the request received, if any, and frees it.
+ * @param none
+ * @retval none
+ */
+void ModbusUpdate(void);
+
+#endif // MODBUS_H
@@ -5,14 +5,23 @@
  * This file contains function prototypes and constants for defining GPIO
  * for buttons with external interrupts. It relies on the HAL functions
  * provided by stm32f4xx_hal.h.
+ * The first edge of a press (interrupt) starts a DELAY ms software timer and the pin is read when it expires; a
+ * second timer generates the auto-repeat of the held buttons and ends it when the pin is read released. Nothing is
+ * polled. The repeat accelerates: REPEAT_STAGE_LENGTH repeats of REPEAT_STEPS_1 steps,
+ * then REPEAT_STAGE_LENGTH of REPEAT_STEPS_2 and REPEAT_STEPS_3 from then on.
  */
 #ifndef PORTBUTTONS_H
 #define PORTBUTTONS_H
 
 /**
- * @brief Includes functions for non-blocking delaysd.
+ * @brief Includes the software timers of the debounce and the auto-repeat.
  */
-#include "API_delay.h"
+#include "swTimer.h"
+
+/**
+ * @brief Includes functions for timestamping with the cycle counter.
+ */
+#include "portCycles.h"
 
 /**
  * @brief Includes STM32 HAL functions.
@@ -75,6 +84,55 @@
  */
 #define NUMBER_OF_BUTTONS 4
 
+#ifndef REPEAT_DELAY
+/**
+ * @brief Time (in ms) a button must be held before it starts repeating.
+ */
+#define REPEAT_DELAY 500
+#endif
+
+#ifndef REPEAT_PERIOD
+/**
+ * @brief Time (in ms) between repeats of a held button.
+ */
+#define REPEAT_PERIOD 100
+#endif
+
+#ifndef REPEAT_PINS
+/**
+ * @brief Buttons that repeat while held. The rest only generate one press.
+ */
+#define REPEAT_PINS (RIGHT_PIN|LEFT_PIN)
+#endif
+
+#ifndef REPEAT_STAGE_LENGTH
+/**
+ * @brief Amount of repeats before the repeat accelerates to the next stage.
+ */
+#define REPEAT_STAGE_LENGTH 10
+#endif
+
+#ifndef REPEAT_STEPS_1
+/**
+ * @brief Steps of each repeat in the first stage.
+ */
+#define REPEAT_STEPS_1 1
+#endif
+
+#ifndef REPEAT_STEPS_2
+/**
+ * @brief Steps of each repeat in the second stage.
+ */
+#define REPEAT_STEPS_2 5
+#endif
+
+#ifndef REPEAT_STEPS_3
+/**
+ * @brief Steps of each repeat from the third stage on.
+ */
+#define REPEAT_STEPS_3 10
+#endif
+
 /**
  * @brief Definition of the external interruption line for Right button.
  */
@@ -93,12 +151,30 @@
 
 /**
  * @function ButtonPressed
- * @brief External function that is called when a button is pressed (after considering debounce)
+ * @brief External function that is called when a button is pressed (after considering debounce), from the deferred
+ * work of PendSV
  * @param GPIO_Pin: number of the Pin that was pressed
  * @retval none
  */
 extern void ButtonPressed(uint16_t GPIO_Pin);
 
+/**
+ * @function ButtonRepeated
+ * @brief External function that is called while a repeating button is held (from the main loop, not from an interrupt)
+ * @param GPIO_Pin: number of the Pin that is held
+ * @param steps: steps to advance in this repeat (REPEAT_STEPS_1, REPEAT_STEPS_2 or REPEAT_STEPS_3)
+ * @retval none
+ */
+extern void ButtonRepeated(uint16_t GPIO_Pin, uint8_t steps);
+
+/**
+ * @function ButtonGetEdge
+ * @brief Function that gets the cycle counter at the first edge of the last press of a button, to measure latencies
+ * @param GPIO_Pin: number of the Pin of the button
+ * @retval cycle counter at the edge
+ */
+uint32_t ButtonGetEdge(uint16_t GPIO_Pin);
+
 /**
  * @function ButtonsInit
  * @brief Function that initializes GPIO as buttons
@@ -109,7 +185,7 @@ void ButtonsInit(void);
 
 /**
  * @function HAL_GPIO_EXTI_Callback
- * @brief Function that activate when a button is pressed
+ * @brief Function that activate when a button is pressed. It only posts the edge to the deferred work
  * @param GPIO_Pin: number of the Pin that triggered the interruption function
  * @retval none
  */
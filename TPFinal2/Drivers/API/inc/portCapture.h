@@ -0,0 +1,86 @@
+/**
+ * @file portCapture.h
+ * @brief Declarations for the TIM2 input capture wrapper.
+ *
+ * This file contains function prototypes and constants for timing the DS3231
+ * 32 kHz output with TIM2 channel 1 (PA0). TIM2 is a 32-bit timer clocked at the
+ * system clock (APB1 timers run at twice PCLK1), so each capture is a system clock
+ * stamp. The input prescaler captures one every CAPTURE_PRESCALER edges.
+ * There is no HAL TIM module in this project, so TIM2 is set through its registers
+ * (CMSIS definitions provided by stm32f4xx_hal.h).
+ */
+#ifndef PORTCAPTURE_H
+#define PORTCAPTURE_H
+
+/**
+ * @brief Includes STM32 HAL functions.
+ */
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief Alternate function of the capture pin.
+ */
+#define CAPTURE_AF GPIO_AF1_TIM2
+
+/**
+ * @brief Definition of the port of the GPIO Pin for the 32 kHz input.
+ */
+#define CAPTURE_GPIO_PORT GPIOA
+
+/**
+ * @brief Priority of the TIM2 interrupt.
+ */
+#define CAPTURE_IRQ_PRIORITY 1
+
+/**
+ * @brief Definition of the GPIO Pin for the 32 kHz input (TIM2_CH1).
+ */
+#define CAPTURE_PIN GPIO_PIN_0
+
+/**
+ * @brief Edges per capture (input prescaler of channel 1).
+ */
+#define CAPTURE_PRESCALER 8
+
+/**
+ * @function CaptureGet
+ * @brief Function that gets the timer ticks elapsed between the first and the last capture, and the input edges between them.
+ * @param ticks: pointer to store the elapsed ticks (system clock cycles)
+ * @param edges: pointer to store the elapsed input edges
+ * @retval none
+ */
+void CaptureGet(uint32_t *ticks, uint32_t *edges);
+
+/**
+ * @function CaptureInit
+ * @brief Function that initializes TIM2 channel 1 as input capture. It starts stopped.
+ * @param none
+ * @retval none
+ */
+void CaptureInit(void);
+
+/**
+ * @function CaptureIRQHandler
+ * @brief Function that stores a capture. Called from TIM2_IRQHandler.
+ * @param none
+ * @retval none
+ */
+void CaptureIRQHandler(void);
+
+/**
+ * @function CaptureStart
+ * @brief Function that restarts the accumulation and enables the capture interrupt.
+ * @param none
+ * @retval none
+ */
+void CaptureStart(void);
+
+/**
+ * @function CaptureStop
+ * @brief Function that disables the capture interrupt, keeping the values accumulated.
+ * @param none
+ * @retval none
+ */
+void CaptureStop(void);
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * @file portClock.h
+ * @brief Declarations for the wrapper RCC HAL functions of the clock modes.
+ *
+ * This file contains function prototypes and constants for switching the system clock
+ * between two modes, both from the HSI: fast, the 72 MHz PLL clock set by
+ * SystemClock_Config, and slow, the HSI divided by 2 with the PLL off (8 MHz, no flash
+ * wait states, PCLK1 8 MHz). A switch keeps the phase of SysTick: what was left of the
+ * current tick is scaled to the new clock, so the tick does not gain or lose time at
+ * the switch. SystemCoreClock follows the mode, corrected by the HSI measurement
+ * (hsiTrim.h), and the USART2 divider is recomputed from it. The I2C1 timing is not:
+ * the caller retimes it with the bus locked (portI2C.h).
+ * It relies on the HAL functions provided by stm32f4xx_hal.h and on portCycles.h and portUART.h.
+ */
+#ifndef PORTCLOCK_H
+#define PORTCLOCK_H
+
+/**
+ * @brief Includes STM32 HAL functions.
+ */
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief Includes the cycle counter functions, to time the switches.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes the function that recomputes the baud rate divider.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Nominal core clock (in Hz) of the fast mode: HSI / 8 * 72 / 2.
+ */
+#define CLOCK_FAST_HZ 72000000
+
+/**
+ * @brief Nominal core clock (in Hz) of the slow mode: HSI / 2. PCLK1 must stay above 2 MHz for I2C1.
+ */
+#define CLOCK_SLOW_HZ 8000000
+
+/**
+ * @typedef clockMode_t
+ * @brief Modes of the system clock.
+ */
+typedef enum{
+	CLOCK_MODE_SLOW,	/**< HSI / 2, PLL off */
+	CLOCK_MODE_FAST		/**< PLL at 72 MHz */
+} clockMode_t;
+
+/**
+ * @function ClockPortCalibrate
+ * @brief Function that takes the measured core clock of the fast mode, loads the one of the current mode into
+ * SystemCoreClock and recomputes the SysTick reload and the USART2 divider from it.
+ * @param frequency: measured core clock (in Hz) of the fast mode
+ * @retval none
+ */
+void ClockPortCalibrate(uint32_t frequency);
+
+/**
+ * @function ClockPortInit
+ * @brief Function that takes the clock set by SystemClock_Config as the fast mode. It must be called before any
+ * switch.
+ * @param none
+ * @retval none
+ */
+void ClockPortInit(void);
+
+/**
+ * @function ClockPortMode
+ * @brief Function that gets the current mode.
+ * @param none
+ * @retval current mode
+ */
+clockMode_t ClockPortMode(void);
+
+/**
+ * @function ClockPortResume
+ * @brief Function that restores the current mode after STOP (which leaves the core on the HSI with the PLL off) and
+ * restarts SysTick. It must be called with the interrupts masked.
+ * @param none
+ * @retval time (us) from the wake to the restored clock
+ */
+uint32_t ClockPortResume(void);
+
+/**
+ * @function ClockPortSet
+ * @brief Function that switches the system clock to a mode. Going fast, the PLL locks first on the HSI, with the
+ * interrupts enabled; the switch itself runs with them masked. No I2C1 transfer may be running.
+ * @param mode: mode to switch to
+ * @retval time (us) the switch took, counted at the rate of the old mode
+ */
+uint32_t ClockPortSet(clockMode_t mode);
+
+#endif // PORTCLOCK_H
@@ -0,0 +1,57 @@
+/**
+ * @file portCycles.h
+ * @brief Declarations for the wrapper of the DWT cycle counter.
+ *
+ * This file contains function prototypes for timestamping events with
+ * the Cortex-M4 DWT CYCCNT register, which counts core clock cycles
+ * (13.9 ns at 72 MHz, wrapping every 59.6 s). It relies on the CMSIS
+ * definitions provided by stm32f4xx_hal.h.
+ */
+#ifndef PORTCYCLES_H
+#define PORTCYCLES_H
+
+/**
+ * @brief Includes STM32 HAL functions.
+ */
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief Cycles in a microsecond at the current core clock.
+ */
+#define CYCLES_PER_US (SystemCoreClock / 1000000)
+
+/**
+ * @function CyclesInit
+ * @brief Function that enables the DWT cycle counter.
+ * @param none
+ * @retval none
+ */
+void CyclesInit(void);
+
+/**
+ * @function CyclesNow
+ * @brief Function that reads the cycle counter. Inlined so that it costs a single load.
+ * @param none
+ * @retval current value of the cycle counter
+ */
+static inline uint32_t CyclesNow(void){
+	return DWT->CYCCNT;
+}
+
+/**
+ * @function CyclesToMicros
+ * @brief Function that converts a cycle count to microseconds.
+ * @param cycles: amount of cycles
+ * @retval microseconds
+ */
+uint32_t CyclesToMicros(uint32_t cycles);
+
+/**
+ * @function CyclesWaitUntil
+ * @brief Function that busy-waits until the cycle counter reaches a value, for events timed closer than a tick.
+ * @param cycles: value to reach, less than 29.8 s ahead at 72 MHz (a value behind returns at once)
+ * @retval none
+ */
+void CyclesWaitUntil(uint32_t cycles);
+
+#endif
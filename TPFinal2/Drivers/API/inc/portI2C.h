@@ -4,7 +4,11 @@
  *
  * This file contains function prototypes and constants for interfacing
  * with any integrated circuit via I2C. It relies on the HAL functions
- * provided by stm32f4xx_hal.h.
+ * provided by stm32f4xx_hal.h. Once the kernel runs, a transfer is done by the I2C1
+ * interrupts while the calling thread waits for its completion on a semaphore, so lower
+ * priority threads keep running, and the delays sleep the thread instead of spinning.
+ * The transfers, the failed ones and those that never completed are counted, and traced
+ * from their request to their completion.
  */
 #ifndef PORT_H
 #define PORT_H
@@ -14,6 +18,16 @@
  */
 #include "stm32f4xx_hal.h"
 
+/**
+ * @brief Includes the semaphores the transfers wait on.
+ */
+#include "kernel.h"
+
+/**
+ * @brief Includes the trace of the transfers.
+ */
+#include "trace.h"
+
 /**
  * @brief Speed of the clock for the I2C communication.
  */
@@ -24,22 +38,67 @@
  */
 #define TIMEOUT HAL_MAX_DELAY
 
+/**
+ * @brief Time (in ms) a thread waits for the completion interrupt of a transfer before resetting the bus.
+ */
+#define I2C_IT_TIMEOUT 50
+
+/**
+ * @brief Priority of the I2C1 interrupts.
+ */
+#define I2C_IRQ_PRIORITY 5
+
 /**
  * @brief Size (in bits) of the memory address.
  */
 #define REG_SIZE I2C_MEMADD_SIZE_8BIT
 
+/**
+ * @typedef i2cStats_t
+ * @brief Counts of the transfers since the reset.
+ */
+typedef struct{
+	uint32_t transfers;	/**< Transfers started */
+	uint32_t errors;	/**< Transfers the HAL refused or ended with an error (e.g. no acknowledge) */
+	uint32_t timeouts;	/**< Transfers whose completion never came (the bus was reset) */
+} i2cStats_t;
+
 /* Declaration of the external error handler function. Declared in the main */
 extern void Error_Handler();
 
 /**
  * @function I2CDelay
- * @brief Function that delays the main program for a specified number of miliseconds in a blocking way.
+ * @brief Function that delays the main program for a specified number of miliseconds in a blocking way. Once the
+ * kernel runs only the calling thread is delayed.
  * @param delayTime: time (in miliseconds) for delay
  * @retval None
  */
 void I2CDelay(uint32_t delayTime);
 
+/**
+ * @function I2CErrorIRQHandler
+ * @brief Function that handles the I2C1 error interrupt. It must be called from I2C1_ER_IRQHandler.
+ * @param None
+ * @retval None
+ */
+void I2CErrorIRQHandler(void);
+
+/**
+ * @function I2CEventIRQHandler
+ * @brief Function that handles the I2C1 event interrupt. It must be called from I2C1_EV_IRQHandler.
+ * @param None
+ * @retval None
+ */
+void I2CEventIRQHandler(void);
+
+/**
+ * @function I2CGetStats
+ * @brief Function that gets the counts of the transfers.
+ * @param stats: pointer to the i2cStats_t to fill
+ * @retval none
+ */
+void I2CGetStats(i2cStats_t *stats);
+
 /**
  * @function I2CInit
  * @brief Function that initializes the I2C protocol handle.
@@ -48,6 +107,14 @@ void I2CDelay(uint32_t delayTime);
  */
 void I2CInit(void);
 
+/**
+ * @function I2CLock
+ * @brief Function that takes the bus, so no transfer runs until I2CUnlock (e.g. while the clock changes). Once the
+ * kernel runs it waits for the transfer in progress, if any.
+ * @param timeout: ticks to wait for the bus (0 to only check it, for the idle thread)
+ * @retval true if the bus was taken, false on timeout
+ */
+bool_t I2CLock(tick_t timeout);
 
 /**
  * @function I2CMasterTransmit
@@ -70,4 +137,21 @@ void I2CMasterTransmit(uint16_t devAddr, uint8_t *buffer, uint16_t size);
  */
 void I2CReadMemory(uint16_t startReg, uint16_t devAddr, uint8_t *buffer, uint16_t size);
 
+/**
+ * @function I2CRetime
+ * @brief Function that recomputes the I2C1 timing (input clock, SCL period and rise time) from the current PCLK1,
+ * after the clock changed. The bus must be taken (I2CLock).
+ * @param None
+ * @retval None
+ */
+void I2CRetime(void);
+
+/**
+ * @function I2CUnlock
+ * @brief Function that gives back the bus taken by I2CLock.
+ * @param None
+ * @retval None
+ */
+void I2CUnlock(void);
+
 #endif
@@ -0,0 +1,80 @@
+/**
+ * @file portKernel.h
+ * @brief Declarations for the Cortex-M4 port of the kernel.
+ *
+ * This file contains the function prototypes the kernel (kernel.c) uses to build the
+ * first frame of a thread and to switch threads. The switch is done by PendSV, at the
+ * lowest priority, right after the deferred interrupt work (deferred.h): it runs once
+ * every interrupt has returned, saves the registers of kernelCurrent on its stack (the
+ * FPU ones only if the thread used the FPU) and restores the ones of kernelNext. The threads run on the process stack (PSP) and the
+ * interrupts on the main stack (MSP).
+ * It relies on kernel.h and stm32f4xx_hal.h.
+ */
+#ifndef PORTKERNEL_H
+#define PORTKERNEL_H
+
+/**
+ * @brief Includes the thread type.
+ */
+#include "kernel.h"
+
+/**
+ * @brief Includes the CMSIS core functions and registers.
+ */
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief Thread that runs, NULL before the first switch. Defined in kernel.c.
+ */
+extern kThread_t *volatile kernelCurrent;
+
+/**
+ * @brief Thread to switch to at the next PendSV. Defined in kernel.c.
+ */
+extern kThread_t *volatile kernelNext;
+
+/**
+ * @function KernelPortIdle
+ * @brief Function that waits for the next interrupt, from the idle thread. If the interrupts are masked, an interrupt
+ * that becomes pending still ends the wait, and runs once they are unmasked.
+ * @param none
+ * @retval none
+ */
+void KernelPortIdle(void);
+
+/**
+ * @function KernelPortInIsr
+ * @brief Function that checks whether the caller is an interrupt.
+ * @param none
+ * @retval true in an interrupt, false in a thread
+ */
+bool_t KernelPortInIsr(void);
+
+/**
+ * @function KernelPortInitStack
+ * @brief Function that builds the first frame of a thread at the top of its stack, as if it had been switched out
+ * just before the first instruction of its function.
+ * @param thread: thread with its stack set
+ * @param entry: function of the thread
+ * @retval none
+ */
+void KernelPortInitStack(kThread_t *thread, void (*entry)(void));
+
+/**
+ * @function KernelPortStart
+ * @brief Function that switches from main to kernelNext. It does not return on the board.
+ * @param none
+ * @retval none
+ */
+void KernelPortStart(void);
+
+/**
+ * @function KernelPortSwitch
+ * @brief Function that requests PendSV, which runs the deferred interrupt work and then switches to kernelNext. It
+ * happens when the interrupts are unmasked and no other interrupt runs.
+ * @param none
+ * @retval none
+ */
+void KernelPortSwitch(void);
+
+#endif // PORTKERNEL_H
@@ -0,0 +1,86 @@
+/**
+ * @file portPower.h
+ * @brief Declarations for the wrapper PWR HAL functions of the STOP mode.
+ *
+ * This file contains function prototypes and constants for sleeping the core between
+ * events. A sleep (WFI) keeps every clock running but SysTick, which is reprogrammed
+ * to interrupt only when the next tick that matters is due instead of every
+ * millisecond; the ticks skipped are counted on wake, so nothing but the tick
+ * interrupts themselves is lost. In STOP the PLL, the HSI, SysTick, the DWT cycle counter and the clocks of the
+ * peripherals stop; only the EXTI lines wake the core: the DS3231 SQW output (EXTI0),
+ * the buttons (EXTI9_5) and, while stopped, the USART2 RX pin (EXTI3), whose falling
+ * start bit wakes the core. The byte that wakes it is lost, so the host sends a newline
+ * before a command. On wake the core runs on the HSI: the clock mode it was stopped in
+ * is restored (portClock.h).
+ * It relies on the HAL functions provided by stm32f4xx_hal.h and on API_delay.h and portClock.h.
+ */
+#ifndef PORTPOWER_H
+#define PORTPOWER_H
+
+/**
+ * @brief Includes STM32 HAL functions.
+ */
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief Includes the function that restores the clock mode after a stop.
+ */
+#include "portClock.h"
+
+/**
+ * @brief Includes the tick_t type.
+ */
+#include "API_delay.h"
+
+/**
+ * @brief EXTI line of the USART2 RX pin (PA3).
+ */
+#define POWER_RX_LINE EXTI_IMR_MR3
+
+/**
+ * @brief Definition of the external interruption line for the USART2 RX pin.
+ */
+#define POWER_RX_IRQN EXTI3_IRQn
+
+/**
+ * @brief Priority of the RX wake interrupt. Below the timing inputs and the UART itself.
+ */
+#define POWER_RX_PRIORITY 6
+
+/**
+ * @function PowerRxWake
+ * @brief External function that is called from the EXTI3 interrupt when the USART2 RX pin woke the core
+ * @param none
+ * @retval none
+ */
+extern void PowerRxWake(void);
+
+/**
+ * @function PowerPortInit
+ * @brief Function that selects the falling edge of the USART2 RX pin on EXTI3 and enables its interrupt. The line
+ * stays masked while the core runs, so the bytes received do not interrupt.
+ * @param none
+ * @retval none
+ */
+void PowerPortInit(void);
+
+/**
+ * @function PowerPortSleep
+ * @brief Function that waits for an interrupt with SysTick reprogrammed to interrupt only after some ticks (up to the
+ * 24 bits of its counter, 233 ms at 72 MHz), and then puts it back in phase with the ticks. It must be called with
+ * the interrupts masked, from the idle thread: the interrupt that ends the wait runs once the caller unmasks them.
+ * @param ticks: ticks to the next one that matters, at least 2
+ * @retval ticks elapsed and not counted by SysTick: the caller counts them
+ */
+tick_t PowerPortSleep(tick_t ticks);
+
+/**
+ * @function PowerPortStop
+ * @brief Function that stops the core until an EXTI line wakes it and restores the clock. It must be called with the
+ * interrupts masked: the interrupt that wakes the core runs once the caller unmasks them.
+ * @param none
+ * @retval time (us) from the wake to the restored clock
+ */
+uint32_t PowerPortStop(void);
+
+#endif // PORTPOWER_H
@@ -0,0 +1,118 @@
+/**
+ * @file portSQW.h
+ * @brief Declarations for the wrapper GPIO HAL functions of the timing inputs.
+ *
+ * This file contains function prototypes and constants for timestamping the
+ * edges of the DS3231 INT/SQW output (1 Hz square wave) and of an external 1 PPS
+ * reference with external interrupts. Edges are stamped with the DWT cycle counter
+ * and accumulated per input, so drift can be measured over windows longer than
+ * the 59.6 s wrap of the counter. It relies on the HAL functions provided by stm32f4xx_hal.h.
+ */
+#ifndef PORTSQW_H
+#define PORTSQW_H
+
+/**
+ * @brief Includes the cycle counter functions.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes boolean type definitions.
+ */
+#include <stdbool.h>
+
+/**
+ * @brief Shortest accepted period (in microseconds). Shorter edges are glitches.
+ */
+#define EDGE_MIN_PERIOD_US 900000
+
+/**
+ * @brief Definition of the external interruption line for the 1 PPS reference.
+ */
+#define PPS_EXTI_IRQN EXTI1_IRQn
+
+/**
+ * @brief Definition of the port of the GPIO Pin for the 1 PPS reference.
+ */
+#define PPS_GPIO_PORT GPIOC
+
+/**
+ * @brief Definition of the GPIO Pin for the 1 PPS reference (rising edge on time).
+ */
+#define PPS_PIN GPIO_PIN_1
+
+/**
+ * @brief Priority of the timing inputs. Above the buttons so that stamps are not delayed by them.
+ */
+#define SQW_IRQ_PRIORITY 0
+
+/**
+ * @brief Definition of the external interruption line for the DS3231 SQW output.
+ */
+#define SQW_EXTI_IRQN EXTI0_IRQn
+
+/**
+ * @brief Definition of the port of the GPIO Pin for the DS3231 SQW output.
+ */
+#define SQW_GPIO_PORT GPIOC
+
+/**
+ * @brief Definition of the GPIO Pin for the DS3231 SQW output (open drain, falling edge on the seconds update).
+ */
+#define SQW_PIN GPIO_PIN_0
+
+/**
+ * @typedef edgeInput_t
+ * @brief Timing inputs.
+ */
+typedef enum{
+	SQW_INPUT,
+	PPS_INPUT,
+	EDGE_INPUTS
+} edgeInput_t;
+
+/**
+ * @typedef edgeTrack_t
+ * @brief Accumulated edges of one timing input.
+ */
+typedef struct{
+	uint64_t cycles;	/**< Cycles elapsed between the first and the last edge */
+	uint32_t periods;	/**< Periods elapsed between the first and the last edge */
+	uint32_t last;		/**< Cycle counter at the last edge */
+	bool started;		/**< True once the first edge arrived */
+} edgeTrack_t;
+
+/**
+ * @function SQWEdge
+ * @brief Function called from the EXTI callback when a timing input changes. Stamps the edge.
+ * @param GPIO_Pin: number of the Pin that triggered the interruption
+ * @retval none
+ */
+void SQWEdge(uint16_t GPIO_Pin);
+
+/**
+ * @function SQWGetTrack
+ * @brief Function that copies the accumulated edges of an input (with interrupts masked, so the copy is consistent).
+ * @param input: timing input
+ * @param track: pointer to the edgeTrack_t to fill
+ * @retval none
+ */
+void SQWGetTrack(edgeInput_t input, edgeTrack_t *track);
+
+/**
+ * @function SQWInit
+ * @brief Function that initializes the GPIO of the timing inputs with external interrupts.
+ * @param none
+ * @retval none
+ */
+void SQWInit(void);
+
+/**
+ * @function SQWReset
+ * @brief Function that restarts the accumulation of every input.
+ * @param none
+ * @retval none
+ */
+void SQWReset(void);
+
+#endif
@@ -0,0 +1,297 @@
+/**
+ * @file portUART.h
+ * @brief Declarations for the wrapper UART HAL functions.
+ *
+ * This file contains function prototypes and constants for exchanging data
+ * with a host through USART2 (the ST-LINK virtual COM port). Received bytes are
+ * written by DMA1 stream 5 into a circular buffer; the half, full and idle line
+ * events of the reception hand them to the interrupt, which splits them into text
+ * lines, each copied once into a free slot of a queue. A line stays in its slot,
+ * writable, until its user frees it, so it is parsed in place. Every line is stamped
+ * with the cycle counter at the end of its first byte, worked back from the event by
+ * the frames received after it. A line that finds the queue full is dropped whole.
+ * Sent bytes are copied into a circular buffer that DMA1 stream 6 drains in the
+ * background, so no sender waits for the line: UARTWrite (and _write, under printf)
+ * drops what does not fit and counts it, UARTTransmit waits for room instead (once the
+ * kernel runs, blocked on a semaphore that the end of each chunk gives).
+ * In frame mode (UARTFrameMode) the received bytes are gathered into one binary frame
+ * instead of lines: it ends after a silence on the line, timed by TIM7 (one pulse, 1 us
+ * ticks) from the idle line event, and waits whole until its user frees it; bytes that
+ * arrive meanwhile are dropped as a frame. The text output is dropped (and counted as
+ * that of UARTWrite) while in frame mode: only UARTFrameSend reaches the line.
+ * It relies on the HAL functions provided by stm32f4xx_hal.h. The handle is
+ * initialized by MX_USART2_UART_Init in main.c; the DMA streams and TIM7 by
+ * UARTStartReception. There is no HAL TIM module in this project, so TIM7 is set
+ * through its registers.
+ */
+#ifndef PORTUART_H
+#define PORTUART_H
+
+/**
+ * @brief Includes STM32 HAL functions.
+ */
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief Includes the cycle counter functions.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes boolean type definitions.
+ */
+#include <stdbool.h>
+
+/**
+ * @brief Priority of the USART2 interrupt.
+ */
+#define UART_IRQ_PRIORITY 1
+
+/**
+ * @brief Maximum length of a received line, including the terminator.
+ */
+#define UART_LINE_SIZE 64
+
+/**
+ * @brief Number of received lines that can wait for their user.
+ */
+#define UART_LINE_SLOTS 16
+
+/**
+ * @brief Size (in bytes) of the circular DMA buffer. Half of it arrives in 11 ms at 115200 baud, the longest the
+ * interrupt may be held off.
+ */
+#define UART_RX_RING 256
+
+/**
+ * @brief Size (in bytes) of the circular transmit buffer: about 90 ms of output at 115200 baud.
+ */
+#define UART_TX_RING 1024
+
+/**
+ * @brief Most time (in ms) a thread waits for the end of a chunk before it checks the room again, in case its
+ * completion was lost.
+ */
+#define UART_TX_WAIT 10
+
+/**
+ * @brief Maximum length (in bytes) of a frame received in frame mode: a Modbus RTU frame.
+ */
+#define UART_FRAME_SIZE 256
+
+/**
+ * @brief Bits per frame on the line (start, 8 data, stop), to work the stamps back from the events.
+ */
+#define UART_FRAME_BITS 10
+
+/**
+ * @function UARTFrameReceived
+ * @brief External function that is called from the TIM7 interrupt when a frame is ready to take, in frame mode
+ * @param none
+ * @retval none
+ */
+extern void UARTFrameReceived(void);
+
+/**
+ * @function UARTLineReceived
+ * @brief External function that is called from the USART2 interrupt when a line is ready to take
+ * @param none
+ * @retval none
+ */
+extern void UARTLineReceived(void);
+
+/**
+ * @function UARTRxDmaIRQHandler
+ * @brief Function that handles the interrupt of the USART2 reception stream (DMA1 stream 5).
+ * @param none
+ * @retval none
+ */
+void UARTRxDmaIRQHandler(void);
+
+/**
+ * @function UARTFrameFree
+ * @brief Function that frees the frame received, once its user is done with it, so the next one can be received.
+ * @param none
+ * @retval none
+ */
+void UARTFrameFree(void);
+
+/**
+ * @function UARTFrameGet
+ * @brief Function that gets the frame received, if any, in frame mode. Frames longer than UART_FRAME_SIZE are
+ * dropped and counted as reception errors.
+ * @param size: pointer to store the length of the frame
+ * @param stamp: pointer to store the cycle counter at the end of its last byte
+ * @retval pointer to the frame (writable until UARTFrameFree), or NULL if there is none
+ */
+uint8_t *UARTFrameGet(uint16_t *size, uint32_t *stamp);
+
+/**
+ * @function UARTFrameMode
+ * @brief Function that switches the reception to frames or back to lines. The line or frame being received is lost,
+ * the lines waiting are kept.
+ * @param gap: silence (in us) that ends a frame, longer than a frame on the line, or 0 to receive lines
+ * @retval none
+ */
+void UARTFrameMode(uint16_t gap);
+
+/**
+ * @function UARTFrameSend
+ * @brief Function that queues a frame for the host, in any mode, as UARTTransmit (waiting for room if needed).
+ * @param buffer: pointer to the frame
+ * @param size: length of the frame
+ * @retval none
+ */
+void UARTFrameSend(const uint8_t *buffer, uint16_t size);
+
+/**
+ * @function UARTFrameTimerIRQHandler
+ * @brief Function that handles the interrupt of TIM7, the end of the silence after a frame.
+ * @param none
+ * @retval none
+ */
+void UARTFrameTimerIRQHandler(void);
+
+/**
+ * @function UARTLineCount
+ * @brief Function that gets the number of received lines waiting for their user.
+ * @param none
+ * @retval lines in the queue
+ */
+uint8_t UARTLineCount(void);
+
+/**
+ * @function UARTLineFree
+ * @brief Function that frees the slot of the oldest line, once its user is done with it.
+ * @param none
+ * @retval none
+ */
+void UARTLineFree(void);
+
+/**
+ * @function UARTLineGet
+ * @brief Function that gets the oldest line received, if any, without taking it out of the queue. Lines are
+ * terminated by '\n' ('\r' is dropped) and cut at UART_LINE_SIZE - 1 characters.
+ * @param stamp: pointer to store the cycle counter at the first byte of the line
+ * @retval pointer to the line (null terminated, writable until UARTLineFree), or NULL if there is none
+ */
+char *UARTLineGet(uint32_t *stamp);
+
+/**
+ * @function UARTLinesDropped
+ * @brief Function that gets the lines dropped because the queue was full (in frame mode, the frames dropped because
+ * the last one was not freed), since the last UARTResetStats.
+ * @param none
+ * @retval lines or frames dropped
+ */
+uint32_t UARTLinesDropped(void);
+
+/**
+ * @function UARTResetStats
+ * @brief Function that clears the counts of lines dropped, reception errors and bytes dropped by UARTWrite.
+ * @param none
+ * @retval none
+ */
+void UARTResetStats(void);
+
+/**
+ * @function UARTRetime
+ * @brief Function that recomputes the baud rate divider and the prescaler of TIM7 from the current PCLK1 (after
+ * SystemCoreClock changed). A
+ * transmission in progress is paused between two bytes meanwhile (up to two frames, with the interrupts masked).
+ * @param none
+ * @retval none
+ */
+void UARTRetime(void);
+
+/**
+ * @function UARTRxErrors
+ * @brief Function that gets the reception errors (overrun, framing, noise) since the last UARTResetStats. Each one
+ * restarts the reception and loses the line being received.
+ * @param none
+ * @retval reception errors
+ */
+uint32_t UARTRxErrors(void);
+
+/**
+ * @function UARTRxTick
+ * @brief Function that gets the tick of the last byte received, to keep the baud rate while a line may be arriving.
+ * Bytes written by the DMA and not handed to the interrupt yet count as received now.
+ * @param none
+ * @retval tick (HAL_GetTick) of the last byte
+ */
+uint32_t UARTRxTick(void);
+
+/**
+ * @function UARTSendString
+ * @brief Function to transmit a null terminated string to the host, as UARTTransmit.
+ * @param str: pointer to the string to send
+ * @retval none
+ */
+void UARTSendString(char *str);
+
+/**
+ * @function UARTStartReception
+ * @brief Function that initializes the DMA streams and TIM7, enables their interrupts and those of USART2 and starts
+ * receiving lines.
+ * @param none
+ * @retval none
+ */
+void UARTStartReception(void);
+
+/**
+ * @function UARTTransmit
+ * @brief Function to transmit a buffer to the host. It returns once the data is in the transmit buffer, waiting for
+ * the DMA to make room if it is full (once the kernel runs the calling thread blocks meanwhile, before it polls). Not
+ * from interrupts, with them masked nor from the idle thread (use UARTWrite there). Dropped in frame mode.
+ * @param buffer: pointer to data buffer to be sent
+ * @param size: size of the buffer
+ * @retval none
+ */
+void UARTTransmit(uint8_t *buffer, uint16_t size);
+
+/**
+ * @function UARTTxDmaIRQHandler
+ * @brief Function that handles the interrupt of the USART2 transmission stream (DMA1 stream 6).
+ * @param none
+ * @retval none
+ */
+void UARTTxDmaIRQHandler(void);
+
+/**
+ * @function UARTTxDropped
+ * @brief Function that gets the bytes dropped by UARTWrite because the transmit buffer was full, and those of the text
+ * output dropped in frame mode, since the last UARTResetStats.
+ * @param none
+ * @retval bytes dropped
+ */
+uint32_t UARTTxDropped(void);
+
+/**
+ * @function UARTTxIdle
+ * @brief Function that checks whether everything was sent: the transmit buffer is empty and the last byte left the
+ * line. The clocks must not stop before.
+ * @param none
+ * @retval true if nothing is left to send, false if not
+ */
+bool UARTTxIdle(void);
+
+/**
+ * @function UARTTxUsed
+ * @brief Function that gets the bytes waiting in the transmit buffer.
+ * @param none
+ * @retval bytes not sent yet
+ */
+uint16_t UARTTxUsed(void);
+
+/**
+ * @function UARTWrite
+ * @brief Function that queues a buffer for the host without waiting: if it does not fit whole in the transmit
+ * buffer, or in frame mode, it is dropped and counted. Safe from threads and interrupts.
+ * @param buffer: pointer to data buffer to be sent
+ * @param size: size of the buffer
+ * @retval true if it was queued, false if it was dropped
+ */
+bool UARTWrite(const uint8_t *buffer, uint16_t size);
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file power.h
+ * @brief Declarations for the idle sleep and the low-power mode.
+ *
+ * This file contains function prototypes and constants for sleeping the core while it
+ * has nothing to do. The idle thread always sleeps until the next tick that matters:
+ * the earliest timeout of a thread or expiry of a software timer (a periodic task is a
+ * timeout of the application thread), with SysTick silent until then (tickless), so
+ * HAL_GetTick and every delay built on it read the same as with a tick every
+ * millisecond. In the low-power mode it stops the core instead (STOP mode, portPower.h)
+ * when no thread is in the middle of its work (sleeping or waiting with a timeout), no
+ * software timer expires before the next DS3231 SQW edge, nothing is left to send through
+ * USART2 and nobody holds the core awake. The 1 Hz SQW edges wake it once per second to render the new second;
+ * a button or a byte on USART2 wakes it at any time.
+ * SysTick stops with the core, so the tick falls behind while it is stopped. Every SQW
+ * edge is a whole second after the last one: the tick is moved up to it, together with
+ * the software timers and the timeouts of the kernel, before the second is handed to
+ * the application (PowerSecond).
+ * The module measures the time from every wake to the next frame written to the LCD,
+ * the share of the time the core runs (duty cycle) and the SysTick interrupts left. PowerReport sends them
+ * through USART2.
+ * It relies on deferred.h, kernel.h, portPower.h, portUART.h and swTimer.h.
+ */
+#ifndef POWER_H
+#define POWER_H
+
+/**
+ * @brief Includes the deferred work the SQW edge hands the resync to.
+ */
+#include "deferred.h"
+
+/**
+ * @brief Includes the kernel, whose timeouts keep the core running.
+ */
+#include "kernel.h"
+
+/**
+ * @brief Includes the functions that stop the core.
+ */
+#include "portPower.h"
+
+/**
+ * @brief Includes functions for sending the report through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Includes the software timers, whose expiries keep the core running.
+ */
+#include "swTimer.h"
+
+/**
+ * @brief Time (in ms) between two SQW edges.
+ */
+#define POWER_EDGE_PERIOD 1000
+
+/**
+ * @brief Smallest delay (in ms) of the tick at an SQW edge that is taken for a stop. Less is the error of the clock.
+ */
+#define POWER_RESYNC_MIN 2
+
+/**
+ * @brief Fewest ticks to the next one that matters for a sleep without SysTick. Closer, the idle thread just waits.
+ */
+#define POWER_SLEEP_MIN 2
+
+/**
+ * @brief Time (in ms) the core keeps running after a byte on USART2 woke it, for the rest of the command.
+ */
+#define POWER_RX_AWAKE 5000
+
+/**
+ * @function PowerSecond
+ * @brief External function that is called from PendSV at every SQW edge while the low-power mode is on, once the
+ * tick is in step with it
+ * @param none
+ * @retval none
+ */
+extern void PowerSecond(void);
+
+/**
+ * @function PowerEnable
+ * @brief Function that turns the low-power mode on or off. The DS3231 SQW output must be on for the core to stop.
+ * @param enable: true to stop the core while idle, false to keep it running
+ * @retval none
+ */
+void PowerEnable(bool_t enable);
+
+/**
+ * @function PowerEnabled
+ * @brief Function that checks whether the low-power mode is on.
+ * @param none
+ * @retval true if it is on, false if not
+ */
+bool_t PowerEnabled(void);
+
+/**
+ * @function PowerHold
+ * @brief Function that keeps the core running until PowerRelease, for measurements with counters that stop with it
+ * (the DWT cycle counter, TIM2). Holds nest.
+ * @param none
+ * @retval none
+ */
+void PowerHold(void);
+
+/**
+ * @function PowerIdle
+ * @brief Function that stops the core if it can, or sleeps until the next tick that matters (or any interrupt) and
+ * counts the ticks skipped. To be called forever from the idle thread.
+ * @param none
+ * @retval none
+ */
+void PowerIdle(void);
+
+/**
+ * @function PowerInit
+ * @brief Function that initializes the wake line of USART2 and clears the statistics. The mode starts off.
+ * @param none
+ * @retval none
+ */
+void PowerInit(void);
+
+/**
+ * @function PowerKeepAwake
+ * @brief Function that keeps the core running for some time. Can be called from interrupts.
+ * @param time: time (in ms) from now
+ * @retval none
+ */
+void PowerKeepAwake(tick_t time);
+
+/**
+ * @function PowerRelease
+ * @brief Function that ends a PowerHold.
+ * @param none
+ * @retval none
+ */
+void PowerRelease(void);
+
+/**
+ * @function PowerRendered
+ * @brief Function that tells that a frame was written to the LCD, to measure the wake to render latency.
+ * @param none
+ * @retval none
+ */
+void PowerRendered(void);
+
+/**
+ * @function PowerReport
+ * @brief Function that sends the statistics through USART2: mode, stops, average and worst time from a wake to the
+ * next frame written to the LCD (us), worst restore of the clock (us), duty cycle (per mille of the time running)
+ * and SysTick interrupts per second.
+ * @param none
+ * @retval none
+ */
+void PowerReport(void);
+
+/**
+ * @function PowerResetStats
+ * @brief Function that clears the statistics.
+ * @param none
+ * @retval none
+ */
+void PowerResetStats(void);
+
+/**
+ * @function PowerSqwEdge
+ * @brief Function that hands an SQW edge to PendSV, which resyncs the tick. It must be called from the EXTI
+ * interrupt of the SQW input.
+ * @param none
+ * @retval none
+ */
+void PowerSqwEdge(void);
+
+#endif // POWER_H
@@ -0,0 +1,149 @@
+/**
+ * @file scheduler.h
+ * @brief Declarations for the cooperative task scheduler.
+ *
+ * This file contains function prototypes and types for running the work of the main
+ * loop as tasks. A task is periodic (released every period ms), event-triggered
+ * (released by SchedulerSignal, also from interrupts) or both. Every call to
+ * SchedulerRunNext runs the first released task of the table to completion, so the
+ * order of the table is the priority. Each run is timed with the DWT cycle counter:
+ * the scheduler keeps the run count, the worst and total execution time and the
+ * deadline misses of every task, and the CPU load (time inside the tasks over the
+ * time elapsed). SchedulerReport sends them through USART2. Every run is also a span
+ * of the trace.
+ * It relies on portCycles.h, portUART.h, trace.h and API_delay.h.
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/**
+ * @brief Includes the tick_t and bool_t types.
+ */
+#include "API_delay.h"
+
+/**
+ * @brief Includes functions for timing the runs with the cycle counter.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes functions for sending the report through USART2.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Includes the trace of the runs.
+ */
+#include "trace.h"
+
+/**
+ * @brief Ticks to the next release when no task is periodic (the same as KERNEL_FOREVER).
+ */
+#define SCHEDULER_NO_RELEASE 0xFFFFFFFFU
+
+/**
+ * @typedef schedTask_t
+ * @brief Task of the scheduler. The first four fields are its configuration, the rest is kept by the scheduler
+ * (zero in the initializer).
+ */
+typedef struct{
+	const char *name;			/**< Name in the report */
+	void (*run)(void);			/**< Function of the task, runs to completion */
+	tick_t period;				/**< Time (ms) between releases, 0 for a task that only runs when signaled */
+	tick_t deadline;			/**< Time (ms) from the release to the end of the run */
+	tick_t release;				/**< Tick of the next periodic release */
+	tick_t signalTime;			/**< Tick of the pending signal */
+	volatile bool_t signaled;	/**< Set by SchedulerSignal until the task runs */
+	uint32_t runs;				/**< Runs since the statistics were reset */
+	uint32_t misses;			/**< Runs that ended after their deadline */
+	uint32_t worstCycles;		/**< Longest run (cycles) */
+	uint64_t totalCycles;		/**< Sum of the runs (cycles) */
+} schedTask_t;
+
+/**
+ * @function SchedulerGetCycles
+ * @brief Function that gets the cycles spent inside the tasks and the cycles elapsed since the statistics were reset.
+ * The load over an interval is the ratio of their increments.
+ * @param busy: pointer to store the cycles inside the tasks
+ * @param elapsed: pointer to store the cycles elapsed
+ * @retval none
+ */
+void SchedulerGetCycles(uint64_t *busy, uint64_t *elapsed);
+
+/**
+ * @function SchedulerInit
+ * @brief Function that takes the table of tasks and releases the periodic ones a period from now.
+ * @param tasks: table of tasks, in order of priority
+ * @param count: amount of tasks
+ * @retval none
+ */
+void SchedulerInit(schedTask_t *tasks, uint8_t count);
+
+/**
+ * @function SchedulerMisses
+ * @brief Function that gets the deadline misses of all the tasks since the statistics were reset.
+ * @param none
+ * @retval deadline misses
+ */
+uint32_t SchedulerMisses(void);
+
+/**
+ * @function SchedulerNextRelease
+ * @brief Function that gets the ticks to the next release, so the caller can sleep until then.
+ * @param none
+ * @retval ticks to it (0 if a task is released), SCHEDULER_NO_RELEASE if no task is periodic and none is signaled
+ */
+tick_t SchedulerNextRelease(void);
+
+/**
+ * @function SchedulerReport
+ * @brief Function that sends the statistics through USART2: a "task <name> ..." line per task with its runs, worst
+ * and average execution time (us) and deadline misses, and a "cpu ..." line with the load (per mille).
+ * @param none
+ * @retval none
+ */
+void SchedulerReport(void);
+
+/**
+ * @function SchedulerResetStats
+ * @brief Function that clears the statistics of every task and the CPU load.
+ * @param none
+ * @retval none
+ */
+void SchedulerResetStats(void);
+
+/**
+ * @function SchedulerRunNext
+ * @brief Function that runs the first released task of the table. To be called forever, from the main loop or a
+ * thread, which can sleep for SchedulerNextRelease when it returns false.
+ * @param none
+ * @retval true if a task ran, false if none was released (idle)
+ */
+bool_t SchedulerRunNext(void);
+
+/**
+ * @function SchedulerSetPeriod
+ * @brief Function that changes the period of a task and releases it a period from now.
+ * @param task: index of the task in the table
+ * @param period: time (ms) between releases, 0 for a task that only runs when signaled
+ * @retval none
+ */
+void SchedulerSetPeriod(uint8_t task, tick_t period);
+
+/**
+ * @function SchedulerSignal
+ * @brief Function that releases a task (if it was not already). Can be called from interrupts.
+ * @param task: index of the task in the table
+ * @retval none
+ */
+void SchedulerSignal(uint8_t task);
+
+/**
+ * @function SchedulerTaskName
+ * @brief Function that gets the name of a task, for the reports of other modules.
+ * @param task: index of the task in the table
+ * @retval name of the task, NULL if there is no task with that index
+ */
+const char *SchedulerTaskName(uint8_t task);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,167 @@
+/**
+ * @file swTimer.h
+ * @brief Declarations for the software timer service.
+ *
+ * This file contains function prototypes and constants for any number of software
+ * timers driven by the 1 ms SysTick. The timers are kept in a hierarchical timing
+ * wheel: SW_TIMER_LEVELS wheels of SW_TIMER_SLOTS slots, each slot of a level as long
+ * as a whole turn of the level below. Starting and stopping a timer is O(1) (a link
+ * into or out of a slot list) and every tick only looks at one slot of the first
+ * level, plus the slot of a higher level that cascades down once per turn.
+ * The timers are owned by their users (no allocation). The callback of an expired
+ * timer runs in the main loop (SwTimerDispatch) or, for the few short ones that must
+ * not wait for it, in the tick interrupt itself.
+ * It relies on API_delay.h and stm32f4xx_hal.h.
+ */
+#ifndef SWTIMER_H
+#define SWTIMER_H
+
+/**
+ * @brief Includes the tick_t and bool_t types.
+ */
+#include "API_delay.h"
+
+/**
+ * @brief Includes the CMSIS functions to mask the interrupts.
+ */
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief Bits of the slot index of each level.
+ */
+#define SW_TIMER_BITS 6
+
+/**
+ * @brief Slots of each level (64 ms for the first one).
+ */
+#define SW_TIMER_SLOTS (1U << SW_TIMER_BITS)
+
+/**
+ * @brief Levels of the wheel: together they cover 2^24 ms (4.6 hours).
+ */
+#define SW_TIMER_LEVELS 4
+
+/**
+ * @brief Longest delay or period (in ms). Longer ones are shortened to it.
+ */
+#define SW_TIMER_MAX_DELAY ((1UL << (SW_TIMER_BITS * SW_TIMER_LEVELS)) - 1)
+
+/**
+ * @brief Ticks to the next expiry when no timer is running.
+ */
+#define SW_TIMER_NONE 0xFFFFFFFFU
+
+/**
+ * @brief Context of a callback: the main loop, from SwTimerDispatch.
+ */
+#define SW_TIMER_LOOP 0
+
+/**
+ * @brief Context of a callback: the SysTick interrupt, with the interrupts masked. Only for short callbacks.
+ */
+#define SW_TIMER_TICK 1
+
+/**
+ * @brief Callback of a timer. Receives the argument given to SwTimerInit.
+ */
+typedef void (*swTimerCallback_t)(uint32_t arg);
+
+/**
+ * @typedef swTimer_t
+ * @brief Software timer. Owned by its user, only changed through the functions of this module.
+ */
+typedef struct swTimer{
+	struct swTimer *next;		/**< Next timer of the slot (or expired) list */
+	struct swTimer **link;		/**< Pointer that points to this timer, to unlink it in O(1) */
+	tick_t expires;				/**< Tick of the wheel it expires at */
+	tick_t period;				/**< Reload (ms), 0 for a one-shot timer */
+	swTimerCallback_t callback;	/**< Function called when it expires */
+	uint32_t arg;				/**< Argument of the callback */
+	uint8_t context;			/**< SW_TIMER_LOOP or SW_TIMER_TICK */
+	volatile uint8_t state;		/**< Idle, in the wheel or expired waiting for SwTimerDispatch */
+} swTimer_t;
+
+/**
+ * @function SwTimerExpired
+ * @brief External function that is called from the tick interrupt when a SW_TIMER_LOOP timer expires, to have the
+ * main loop call SwTimerDispatch
+ * @param none
+ * @retval none
+ */
+extern void SwTimerExpired(void);
+
+/**
+ * @function SwTimerAdvance
+ * @brief Function that advances the wheel several ticks at once, after the tick was stopped (a sleep or STOP). The
+ * timers that expired meanwhile expire now, in order. It must be called from PendSV, the SysTick interrupt or with the
+ * interrupts masked.
+ * @param ticks: ticks elapsed
+ * @retval none
+ */
+void SwTimerAdvance(tick_t ticks);
+
+/**
+ * @function SwTimerDispatch
+ * @brief Function that runs the callbacks of the SW_TIMER_LOOP timers that expired since the last call, and restarts
+ * the periodic ones. It must be called from the main loop after SwTimerExpired.
+ * @param none
+ * @retval none
+ */
+void SwTimerDispatch(void);
+
+/**
+ * @function SwTimerInit
+ * @brief Function that initializes a timer (stopped).
+ * @param timer: timer to initialize
+ * @param callback: function called when it expires
+ * @param arg: argument of the callback
+ * @param context: SW_TIMER_LOOP or SW_TIMER_TICK
+ * @retval none
+ */
+void SwTimerInit(swTimer_t *timer, swTimerCallback_t callback, uint32_t arg, uint8_t context);
+
+/**
+ * @function SwTimerIsRunning
+ * @brief Function that checks whether a timer is started and its callback has not run yet.
+ * @param timer: timer to check
+ * @retval true if it is running, false if not
+ */
+bool_t SwTimerIsRunning(const swTimer_t *timer);
+
+/**
+ * @function SwTimerNextExpiry
+ * @brief Function that gets the ticks to the next expiry. Exact for the timers of the first level, a lower bound
+ * for the rest (the start of their slot). Can be called from interrupts.
+ * @param none
+ * @retval ticks to it (0 if an expired timer waits for SwTimerDispatch), SW_TIMER_NONE if no timer is running
+ */
+tick_t SwTimerNextExpiry(void);
+
+/**
+ * @function SwTimerStart
+ * @brief Function that starts a timer, or restarts it if it was running. Can be called from interrupts.
+ * @param timer: timer to start
+ * @param delay: ticks (ms) to the first expiry, at least 1
+ * @param period: ticks (ms) between the following expiries, 0 for a one-shot timer
+ * @retval none
+ */
+void SwTimerStart(swTimer_t *timer, tick_t delay, tick_t period);
+
+/**
+ * @function SwTimerStop
+ * @brief Function that stops a timer. Its callback does not run, even if it had already expired. Can be called from
+ * interrupts.
+ * @param timer: timer to stop
+ * @retval none
+ */
+void SwTimerStop(swTimer_t *timer);
+
+/**
+ * @function SwTimerTick
+ * @brief Function that advances the wheel one tick. It must be called from the SysTick interrupt.
+ * @param none
+ * @retval none
+ */
+void SwTimerTick(void);
+
+#endif // SWTIMER_H
@@ -0,0 +1,154 @@
+/**
+ * @file telemetry.h
+ * @brief Declarations for the binary telemetry stream.
+ *
+ * This file contains function prototypes, constants and the frame for sending a
+ * snapshot of the clock through USART2 at a fixed rate: RTC time, temperature, I2C
+ * counters, input latency, CPU load of the tasks, queue depths and error counts.
+ * A frame is the packed telemetryFrame_t (little endian) followed by its CRC-16
+ * (CCITT: polynomial 0x1021, initial value 0xFFFF, low byte first), COBS encoded and
+ * delimited by a zero byte on each side, so a receiver finds the next frame after any
+ * loss and text lines in between are told apart (they never decode with a valid CRC).
+ * A frame is about 80 bytes on the line, 7 ms at 115200 baud. It is queued without
+ * waiting (UARTWrite): a frame that does not fit in the transmit buffer is dropped and
+ * counted by the UART, so a period shorter than the frame just loses frames.
+ * The frames are built in the timers task; the fields of the application (flags, time,
+ * temperature, button queue) come from it through TelemetrySample.
+ * Tools/telemetry.py decodes the stream.
+ * It relies on kernel.h, latency.h, portI2C.h, portUART.h, scheduler.h and swTimer.h.
+ */
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/**
+ * @brief Includes the kernel, for the tick type.
+ */
+#include "kernel.h"
+
+/**
+ * @brief Includes the input latency summaries.
+ */
+#include "latency.h"
+
+/**
+ * @brief Includes the counts of the I2C transfers.
+ */
+#include "portI2C.h"
+
+/**
+ * @brief Includes the transmit buffer and the counts of the UART.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Includes the CPU load and the deadline misses of the tasks.
+ */
+#include "scheduler.h"
+
+/**
+ * @brief Includes the software timer of the period.
+ */
+#include "swTimer.h"
+
+/**
+ * @brief Version of the frame, its first byte. To be increased at every change of telemetryFrame_t.
+ */
+#define TELEMETRY_VERSION 1
+
+/**
+ * @brief Shortest period (in ms) of the frames.
+ */
+#define TELEMETRY_MIN_PERIOD 10
+
+/**
+ * @brief Flag of telemetryFrame_t.flags: the RTC time is valid.
+ */
+#define TELEMETRY_TIME_VALID 0x01
+
+/**
+ * @brief Flag of telemetryFrame_t.flags: the low-power mode is on.
+ */
+#define TELEMETRY_LOW_POWER 0x02
+
+/**
+ * @brief Flag of telemetryFrame_t.flags: the clock governor is on.
+ */
+#define TELEMETRY_CLOCK_GOV 0x04
+
+/**
+ * @typedef telemetryLatency_t
+ * @brief Input latency of a screen in a frame, since the histograms were cleared.
+ */
+typedef struct __attribute__((packed)){
+	uint16_t count;				/**< Samples (saturated) */
+	uint32_t avg;				/**< Average (us) */
+	uint32_t max;				/**< Longest (us) */
+} telemetryLatency_t;
+
+/**
+ * @typedef telemetryFrame_t
+ * @brief Telemetry frame, before the CRC and the encoding. Counters run from the reset (or from their statistics
+ * reset) and wrap: the receiver takes the differences between frames.
+ */
+typedef struct __attribute__((packed)){
+	uint8_t version;			/**< TELEMETRY_VERSION */
+	uint8_t flags;				/**< TELEMETRY_xxx flags */
+	uint16_t sequence;			/**< Frame number, to count the frames lost */
+	uint32_t uptime;			/**< HAL_GetTick (ms) */
+	uint32_t epoch;				/**< RTC time last read (s since 01/01/2000 UTC) */
+	int16_t temperature;		/**< Last temperature (0.25 C) */
+	uint16_t load;				/**< CPU load of the tasks since the last frame (per mille) */
+	uint32_t i2cTransfers;		/**< I2C transfers */
+	uint32_t i2cErrors;			/**< I2C transfers failed or timed out */
+	telemetryLatency_t latency[LAT_SCREEN_COUNT];	/**< Input latency per screen */
+	uint8_t buttonQueue;		/**< Button events waiting */
+	uint8_t uartLines;			/**< Received lines waiting */
+	uint16_t txUsed;			/**< Bytes waiting in the transmit buffer */
+	uint32_t deadlineMisses;	/**< Deadline misses of the tasks */
+	uint32_t rxErrors;			/**< USART2 reception errors */
+	uint32_t linesDropped;		/**< Received lines dropped */
+	uint32_t txDropped;			/**< Bytes dropped by UARTWrite, frames included */
+} telemetryFrame_t;
+
+/**
+ * @function TelemetrySample
+ * @brief External function that is called while a frame is built, to fill the fields of the application: flags,
+ * epoch, temperature and buttonQueue
+ * @param frame: frame being built
+ * @retval none
+ */
+extern void TelemetrySample(telemetryFrame_t *frame);
+
+/**
+ * @function TelemetryFrames
+ * @brief Function that gets the frames built since the reset.
+ * @param none
+ * @retval frames built (queued or dropped)
+ */
+uint32_t TelemetryFrames(void);
+
+/**
+ * @function TelemetryInit
+ * @brief Function that initializes the timer of the period. The stream starts off.
+ * @param none
+ * @retval none
+ */
+void TelemetryInit(void);
+
+/**
+ * @function TelemetryPeriod
+ * @brief Function that gets the period of the frames.
+ * @param none
+ * @retval period (in ms), 0 if the stream is off
+ */
+tick_t TelemetryPeriod(void);
+
+/**
+ * @function TelemetryStart
+ * @brief Function that starts the stream, the first frame at the next tick, or stops it.
+ * @param period: time (in ms) between frames, at least TELEMETRY_MIN_PERIOD, or 0 to stop
+ * @retval true if the period was taken, false if it is too short
+ */
+bool_t TelemetryStart(tick_t period);
+
+#endif // TELEMETRY_H
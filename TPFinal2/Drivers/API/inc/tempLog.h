@@ -0,0 +1,112 @@
+/**
+ * @file tempLog.h
+ * @brief Declarations for the temperature history log.
+ *
+ * This file contains function prototypes, constants, and data structures
+ * for keeping a RAM ring of periodic temperature samples. Samples are delta encoded
+ * in 2-bit symbols (no change, +0.25 C, -0.25 C or escape followed by an 8-bit delta),
+ * so a day of per-minute readings of a room usually takes less than 400 bytes.
+ * A sample taken more or less than TEMPLOG_PERIOD after the previous one (samples
+ * skipped while the time was not valid, or the time changed) is preceded by an anchor
+ * with its time (21 symbols). When the ring is full the oldest samples are dropped; an
+ * iterator kept meanwhile (e.g. by a dump sent a few lines at a time) skips those it had
+ * not returned yet.
+ */
+#ifndef TEMPLOG_H
+#define TEMPLOG_H
+
+/**
+ * @brief Includes boolean type definitions.
+ */
+#include <stdbool.h>
+
+/**
+ * @brief Includes integer type definitions.
+ */
+#include <stdint.h>
+
+/**
+ * @brief Largest delta (in 0.25 C units) stored after an escape symbol.
+ */
+#define TEMPLOG_MAX_DELTA 127
+
+/**
+ * @brief Smallest delta (in 0.25 C units) stored after an escape symbol (-128 marks an anchor).
+ */
+#define TEMPLOG_MIN_DELTA (-127)
+
+/**
+ * @brief Time (in seconds) between samples.
+ */
+#define TEMPLOG_PERIOD 60
+
+/**
+ * @brief Size (in bytes) of the encoded history. Each byte holds four symbols.
+ */
+#define TEMPLOG_SIZE 512
+
+/**
+ * @typedef tempLogIterator_t
+ * @brief Position of a reader walking the history from the oldest sample to the newest.
+ */
+typedef struct{
+	uint16_t position;	/**< Next symbol to decode */
+	uint16_t remaining;	/**< Samples left to return */
+	int16_t value;		/**< Temperature of the next sample (0.25 C units) */
+	uint32_t epoch;		/**< Time of the next sample (seconds since 01/01/2000 UTC) */
+	uint32_t index;		/**< Number of the next sample since the history was emptied, to find out if it was dropped */
+} tempLogIterator_t;
+
+/**
+ * @function TempLogAdd
+ * @brief Function that appends a sample to the history, dropping the oldest ones if there is no room.
+ * @param temperature: temperature in 0.25 C units
+ * @param epoch: time of the sample (seconds since 01/01/2000 UTC)
+ * @retval none
+ */
+void TempLogAdd(int16_t temperature, uint32_t epoch);
+
+/**
+ * @function TempLogCount
+ * @brief Function that returns the amount of samples stored.
+ * @param none
+ * @retval amount of samples
+ */
+uint16_t TempLogCount(void);
+
+/**
+ * @function TempLogFirst
+ * @brief Function that places an iterator on the oldest sample.
+ * @param it: pointer to the iterator
+ * @retval none
+ */
+void TempLogFirst(tempLogIterator_t *it);
+
+/**
+ * @function TempLogInit
+ * @brief Function that empties the history.
+ * @param none
+ * @retval none
+ */
+void TempLogInit(void);
+
+/**
+ * @function TempLogNext
+ * @brief Function that returns the sample under an iterator and moves it to the next one. If the samples under it
+ * were dropped since the last call, it goes on from the oldest one.
+ * @param it: pointer to the iterator
+ * @param temperature: pointer to store the temperature (0.25 C units)
+ * @param epoch: pointer to store the time of the sample
+ * @retval boolean that indicates if a sample was returned (false after the newest one)
+ */
+bool TempLogNext(tempLogIterator_t *it, int16_t *temperature, uint32_t *epoch);
+
+/**
+ * @function TempLogUsage
+ * @brief Function that returns the amount of bytes used by the encoded history.
+ * @param none
+ * @retval bytes used
+ */
+uint16_t TempLogUsage(void);
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * @file timeSync.h
+ * @brief Declarations for setting the DS3231 from the host clock over USART2.
+ *
+ * This file contains function prototypes, constants and data structures for an
+ * NTP-like exchange with a host through the console. In each round the host sends
+ * its time t1 (us since 01/01/2000 UTC) and the device replies with t2, when the
+ * line arrived (stamped in the reception interrupt, ConsoleStamp), and t3, when the
+ * reply was queued, both on a local timescale of microseconds built from the DWT
+ * cycle counter. The host sends t4, when the reply arrived, with the next line. Each
+ * round gives the offset of the local timescale from the host clock,
+ * ((t2 - t1) + (t3 - t4)) / 2, and the round trip delay, (t4 - t1) - (t3 - t2); the
+ * round with the shortest delay is kept, as its offset has the smallest error (half
+ * the asymmetry of its delay at most).
+ * The timestamps are those of the first byte of each line: the host moves its own
+ * (Tools/timesync.py) to the end of the first byte it sends (t2 is taken there) and to
+ * the start of the first byte it receives (t3 is taken there, the transmitter being idle).
+ * On "SET", the DS3231 is written with the next whole second of the host, at that
+ * second: a software timer wakes the timers task just before it and the rest is waited
+ * for on the cycle counter. The DS3231 restarts its second when the seconds register
+ * is written, so the write starts early by the I2C time up to that byte. The 1 Hz SQW
+ * output is on during the session: the first falling edge after the write is compared
+ * with the host second it should match, which checks the whole chain.
+ * The core does not stop (power.h) and the clock stays fast (clockGov.h) while a session
+ * runs: the local timescale counts cycles. A session ends after SYNC_TIMEOUT without a
+ * round (the cycle counter wraps in 59.6 s), or after the check of a write.
+ * It relies on clockGov.h, console.h, ds3231.h, portI2C.h, portSQW.h, power.h, swTimer.h and timezone.h.
+ */
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+/**
+ * @brief Includes the hold that keeps the clock fast while a session runs.
+ */
+#include "clockGov.h"
+
+/**
+ * @brief Includes the stamp of the lines and the replies.
+ */
+#include "console.h"
+
+/**
+ * @brief Includes functions for interfacing with DS3231.
+ */
+#include "ds3231.h"
+
+/**
+ * @brief Includes the lock and the clock speed of the I2C bus.
+ */
+#include "portI2C.h"
+
+/**
+ * @brief Includes functions for timestamping the SQW edges.
+ */
+#include "portSQW.h"
+
+/**
+ * @brief Includes the hold that keeps the core running while a session runs.
+ */
+#include "power.h"
+
+/**
+ * @brief Includes the software timer of the write and of the timeout.
+ */
+#include "swTimer.h"
+
+/**
+ * @brief Includes the conversion of the second written to a datetime.
+ */
+#include "timezone.h"
+
+/**
+ * @brief Time (in ms) without a round that ends a session. Shorter than half the wrap of the cycle counter.
+ */
+#define SYNC_TIMEOUT 20000
+
+/**
+ * @brief Rounds completed before a write is accepted.
+ */
+#define SYNC_MIN_ROUNDS 4
+
+/**
+ * @brief Shortest time (in ms) from "SET" to the second written.
+ */
+#define SYNC_MARGIN 100
+
+/**
+ * @brief Time (in ms) before the write at which the timer expires. The rest is waited for on the cycle counter.
+ */
+#define SYNC_LEAD 2
+
+/**
+ * @brief Time (in I2C bits) from the start of the write to the acknowledge of the seconds: start, address, register
+ * and seconds, with their acknowledges.
+ */
+#define SYNC_WRITE_BITS 28
+
+/**
+ * @brief Time (in ms) after the write at which the SQW edge of the next second is checked.
+ */
+#define SYNC_CHECK_TIME 1200
+
+/**
+ * @typedef timeSyncState_t
+ * @brief States of a session.
+ */
+typedef enum{
+	SYNC_IDLE,		/**< No session */
+	SYNC_ROUNDS,	/**< Exchanging rounds with the host */
+	SYNC_WRITING,	/**< Waiting for the second to write */
+	SYNC_CHECKING	/**< Waiting for the SQW edge after the write */
+} timeSyncState_t;
+
+/**
+ * @typedef timeSyncReport_t
+ * @brief Progress of the session and result of the last write.
+ */
+typedef struct{
+	timeSyncState_t state;	/**< Current state */
+	uint16_t rounds;		/**< Rounds completed in the session */
+	uint32_t delay;			/**< Round trip delay of the best round (us) */
+	uint32_t second;		/**< Last second written (s since 01/01/2000 UTC), 0 if none */
+	int32_t rtcError;		/**< DS3231 minus host before the last write (ms, saturated) */
+	bool rtcKnown;			/**< True if rtcError was measured (valid time and SQW edges before the write) */
+	int32_t edgeError;		/**< First SQW edge after the last write minus the host second it matches (us) */
+	bool edgeSeen;			/**< True if edgeError was measured */
+} timeSyncReport_t;
+
+/**
+ * @function TimeSyncWritten
+ * @brief External function that is called after the DS3231 is written, from the timers task.
+ * @param none
+ * @retval none
+ */
+extern void TimeSyncWritten(void);
+
+/**
+ * @function TimeSyncGetReport
+ * @brief Function that copies the progress of the session and the result of the last write.
+ * @param report: pointer to the timeSyncReport_t to fill
+ * @retval none
+ */
+void TimeSyncGetReport(timeSyncReport_t *report);
+
+/**
+ * @function TimeSyncInit
+ * @brief Function that initializes the timer of the session.
+ * @param none
+ * @retval none
+ */
+void TimeSyncInit(void);
+
+/**
+ * @function TimeSyncReceived
+ * @brief Function that completes the last round with the time its reply arrived to the host.
+ * @param hostReceive: t4, host time (us since 01/01/2000 UTC) at the start of the first byte of the reply
+ * @retval none
+ */
+void TimeSyncReceived(uint64_t hostReceive);
+
+/**
+ * @function TimeSyncReport
+ * @brief Function that sends the state, the rounds, the best delay and the result of the last write through USART2.
+ * @param none
+ * @retval none
+ */
+void TimeSyncReport(void);
+
+/**
+ * @function TimeSyncRound
+ * @brief Function that starts a round, starting the session if none runs, and replies "SYNC <t2> <t3>" (us of the
+ * local timescale, modulo 2^32).
+ * @param hostSend: t1, host time (us since 01/01/2000 UTC) at the end of the first byte of the line
+ * @param stamp: cycle counter at the end of the first byte of the line
+ * @retval true if the round started, false if a write is in progress
+ */
+bool_t TimeSyncRound(uint64_t hostSend, uint32_t stamp);
+
+/**
+ * @function TimeSyncSet
+ * @brief Function that schedules the write of the next whole second of the host (at least SYNC_MARGIN ahead). The
+ * result is sent through USART2 after the check.
+ * @param none
+ * @retval true if scheduled, false if fewer than SYNC_MIN_ROUNDS rounds were completed
+ */
+bool_t TimeSyncSet(void);
+
+/**
+ * @function TimeSyncStop
+ * @brief Function that ends the session and gives INT/SQW back to its previous function.
+ * @param none
+ * @retval none
+ */
+void TimeSyncStop(void);
+
+#endif // TIMESYNC_H
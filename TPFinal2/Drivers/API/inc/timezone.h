@@ -0,0 +1,159 @@
+/**
+ * @file timezone.h
+ * @brief Declarations for the UTC to local time conversion layer.
+ *
+ * This file contains function prototypes, constants, and data structures
+ * for converting the UTC datetime stored in the DS3231 to local time and back.
+ * Zone rules are not parsed at runtime: Tools/tzgen.py compiles them at build time
+ * into const transition tables (tzdata.c), so a conversion is a table lookup plus an add.
+ * It relies on the DS3231_DateTime struct provided by ds3231.h.
+ */
+#ifndef TIMEZONE_H
+#define TIMEZONE_H
+
+/**
+ * @brief Includes the datetime struct definition.
+ */
+#include "ds3231.h"
+
+/**
+ * @brief Includes the zone identifiers generated at build time.
+ */
+#include "tzdata.h"
+
+/**
+ * @brief Days in four consecutive years, starting on a leap year.
+ */
+#define DAYS_PER_4_YEARS 1461
+
+/**
+ * @brief Day of week of 01/01/2000 (Saturday) counted from Sunday = 0.
+ */
+#define EPOCH_DAY_OF_WEEK 6
+
+/**
+ * @brief Seconds in a day.
+ */
+#define SECONDS_PER_DAY 86400UL
+
+/**
+ * @brief Seconds in an hour.
+ */
+#define SECONDS_PER_HOUR 3600
+
+/**
+ * @brief Seconds in a minute.
+ */
+#define SECONDS_PER_MINUTE 60
+
+/**
+ * @brief Seconds from 01/01/2000 to 01/01/2100: the first second the DS3231 cannot hold.
+ */
+#define TZ_EPOCH_END 3155760000UL
+
+/**
+ * @brief Zone used as local time after reset.
+ */
+#define TZ_DEFAULT_ZONE 0
+
+/**
+ * @typedef TZ_Transition
+ * @brief Row of a compiled transition table.
+ *
+ * The offset applies from Utc until the Utc of the next row.
+ */
+typedef struct {
+	uint32_t Utc;	/**< First second (since 01/01/2000 UTC) the offset applies */
+	int16_t Offset;	/**< Offset to UTC in minutes */
+	uint8_t Dst;	/**< 1 if daylight saving time is in effect */
+} TZ_Transition;
+
+/**
+ * @typedef TZ_Zone
+ * @brief Compiled time zone.
+ */
+typedef struct {
+	char Label[4];						/**< Three letter label shown in the LCD */
+	const TZ_Transition *Transitions;	/**< Transition table sorted by Utc */
+	uint16_t Count;						/**< Amount of rows in the transition table */
+} TZ_Zone;
+
+/**
+ * @brief Zones generated by Tools/tzgen.py. Defined in tzdata.c.
+ */
+extern const TZ_Zone tzZones[TZ_ZONE_COUNT];
+
+/**
+ * @function TzDateTimeToEpoch
+ * @brief Function that converts a datetime to seconds since 01/01/2000 00:00:00.
+ * @param time: pointer to the DS3231_DateTime to convert (years 2000 to 2099)
+ * @retval seconds since 01/01/2000
+ */
+uint32_t TzDateTimeToEpoch(DS3231_DateTime *time);
+
+/**
+ * @function TzEpochToDateTime
+ * @brief Function that converts seconds since 01/01/2000 to a datetime, including day of week.
+ * @param epoch: seconds since 01/01/2000
+ * @param time: pointer to the DS3231_DateTime to fill
+ * @retval none
+ */
+void TzEpochToDateTime(uint32_t epoch, DS3231_DateTime *time);
+
+/**
+ * @function TzGetLabel
+ * @brief Function that returns the LCD label of a zone.
+ * @param zone: zone identifier (TZ_xxx)
+ * @retval pointer to the three letter label
+ */
+const char *TzGetLabel(uint8_t zone);
+
+/**
+ * @function TzGetLocalZone
+ * @brief Function that returns the zone used as local time.
+ * @param none
+ * @retval zone identifier (TZ_xxx)
+ */
+uint8_t TzGetLocalZone(void);
+
+/**
+ * @function TzGetOffset
+ * @brief Function that gets the offset of a zone at a given UTC second. The last table row used
+ * is cached per zone, so consecutive calls cost one or two comparisons.
+ * @param zone: zone identifier (TZ_xxx)
+ * @param utc: seconds since 01/01/2000 UTC
+ * @param dst: pointer to store whether daylight saving time is in effect (can be NULL)
+ * @retval offset to UTC in seconds
+ */
+int32_t TzGetOffset(uint8_t zone, uint32_t utc, bool *dst);
+
+/**
+ * @function TzLocalToUtc
+ * @brief Function that converts a local datetime of a zone to UTC. Near the ends of the century the offset can move
+ * the result out of 2000 to 2099, which the DS3231 cannot hold: then utc is left unchanged.
+ * @param zone: zone identifier (TZ_xxx)
+ * @param local: pointer to the local DS3231_DateTime
+ * @param utc: pointer to the DS3231_DateTime to fill with UTC
+ * @retval true if the UTC time is in 2000 to 2099, false if not
+ */
+bool TzLocalToUtc(uint8_t zone, DS3231_DateTime *local, DS3231_DateTime *utc);
+
+/**
+ * @function TzSetLocalZone
+ * @brief Function that selects the zone used as local time.
+ * @param zone: zone identifier (TZ_xxx)
+ * @retval none
+ */
+void TzSetLocalZone(uint8_t zone);
+
+/**
+ * @function TzUtcToLocal
+ * @brief Function that converts a UTC datetime to the local datetime of a zone.
+ * @param zone: zone identifier (TZ_xxx)
+ * @param utc: pointer to the UTC DS3231_DateTime
+ * @param local: pointer to the DS3231_DateTime to fill with local time
+ * @retval boolean that indicates if daylight saving time is in effect
+ */
+bool TzUtcToLocal(uint8_t zone, DS3231_DateTime *utc, DS3231_DateTime *local);
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file trace.h
+ * @brief Declarations for the event trace.
+ *
+ * This file contains the macros, constants and types for recording the timeline of the
+ * drivers and the application into a RAM ring: begin and end of the tasks, the frames
+ * written to the LCD, the bytes sent to it, the DS3231 time reads, the I2C transfers and
+ * their completions, the button and SQW edges, the USART2 reception events, the console
+ * commands and the clock switches. A record is 8 bytes: the DWT cycle counter, the
+ * event and its phase, the context it ran in (the priority of the thread, or the
+ * exception number with TRACE_ISR) and an argument. Recording costs about 20 cycles,
+ * with the interrupts masked only around the store, so it is on from the reset; the
+ * oldest records are overwritten.
+ * The trace is compiled in unless TRACE_ENABLE is defined as 0, which turns every
+ * TRACE_* macro into nothing. "TR" dumps it through USART2 as text (see TraceDump),
+ * Tools/tracejson.py converts the dump to the Chrome trace format (chrome://tracing,
+ * ui.perfetto.dev). The simulator records the same events, with the times it charges.
+ * It relies on portCycles.h and portKernel.h.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * @brief Includes the cycle counter.
+ */
+#include "portCycles.h"
+
+/**
+ * @brief Includes the thread that runs, for the context of the records.
+ */
+#include "portKernel.h"
+
+/**
+ * @brief 1 to compile the trace in, 0 to leave it out.
+ */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1
+#endif
+
+/**
+ * @brief Records in the ring (8 bytes each). A power of 2; a single one when the trace is left out.
+ */
+#ifndef TRACE_SIZE
+#if TRACE_ENABLE
+#define TRACE_SIZE 1024
+#else
+#define TRACE_SIZE 1
+#endif
+#endif
+
+/**
+ * @brief Flag of the context of the records made by an interrupt, ORed with the exception number.
+ */
+#define TRACE_ISR 0x80
+
+/**
+ * @brief Context of the records made before the kernel runs.
+ */
+#define TRACE_MAIN 0x7F
+
+/**
+ * @brief Phase of an event, in the two upper bits of its code: a point in time.
+ */
+#define TRACE_INSTANT 0x00
+
+/**
+ * @brief Phase of an event: the start of a span.
+ */
+#define TRACE_BEGIN 0x40
+
+/**
+ * @brief Phase of an event: the end of a span.
+ */
+#define TRACE_END 0x80
+
+/**
+ * @typedef traceEvent_t
+ * @brief Events recorded, with their argument.
+ */
+typedef enum{
+	TRACE_TASK,			/**< Span: a task of the scheduler runs (task index) */
+	TRACE_FRAME,		/**< Span: the LCD thread writes a frame (frame number) */
+	TRACE_LCD_SEND,		/**< Span: a byte is sent to the LCD (byte) */
+	TRACE_GET_TIME,		/**< Span: the DS3231 time is read (0, then the validity at the end) */
+	TRACE_BUTTON,		/**< Span: a button is handled by the screen (pin) */
+	TRACE_I2C,			/**< Span: an I2C transfer, from its request to its completion (bytes) */
+	TRACE_I2C_DONE,		/**< Instant: an I2C transfer completes (0 sent, 1 read, 2 failed) */
+	TRACE_EXTI,			/**< Instant: an edge of a button or a timing input (pin) */
+	TRACE_UART_RX,		/**< Instant: a USART2 reception event (position of the DMA in the ring) */
+	TRACE_COMMAND,		/**< Span: a console command runs (index in the table of commands) */
+	TRACE_CLOCK,		/**< Instant: the core clock switched (new frequency in MHz) */
+	TRACE_EVENTS
+} traceEvent_t;
+
+/**
+ * @typedef traceRecord_t
+ * @brief Record of the ring.
+ */
+typedef struct{
+	uint32_t cycles;			/**< Cycle counter */
+	uint8_t code;				/**< Event ORed with its phase */
+	uint8_t context;			/**< Priority of the thread, TRACE_ISR | exception number, or TRACE_MAIN */
+	uint16_t arg;				/**< Argument of the event */
+} traceRecord_t;
+
+/**
+ * @brief Ring of records. Defined in trace.c.
+ */
+extern traceRecord_t traceRing[TRACE_SIZE];
+
+/**
+ * @brief Records made since the ring was cleared; the next one goes to traceCount % TRACE_SIZE. Defined in trace.c.
+ */
+extern uint32_t traceCount;
+
+/**
+ * @brief Flag to check whether records are taken. Defined in trace.c.
+ */
+extern volatile bool_t traceOn;
+
+/**
+ * @function TraceRecord
+ * @brief Function that appends a record to the ring. Inlined, from any context; use the TRACE_* macros.
+ * @param code: event ORed with its phase
+ * @param arg: argument of the event
+ * @retval none
+ */
+static inline void TraceRecord(uint8_t code, uint16_t arg){
+	uint32_t mask, exception;
+	traceRecord_t *record;
+
+	if (!traceOn) return;
+	exception = __get_IPSR();
+	mask = __get_PRIMASK();
+	__disable_irq();
+	record = &traceRing[traceCount++ & (TRACE_SIZE - 1)];
+	record->cycles = CyclesNow();
+	record->code = code;
+	record->context = (exception != 0) ? (TRACE_ISR | exception) : (kernelCurrent != NULL) ? kernelCurrent->priority :
+			TRACE_MAIN;
+	record->arg = arg;
+	__set_PRIMASK(mask);
+}
+
+#if TRACE_ENABLE
+/**
+ * @brief Records the start of a span.
+ */
+#define TRACE_SPAN_BEGIN(event, arg) TraceRecord((event) | TRACE_BEGIN, (arg))
+
+/**
+ * @brief Records the end of a span.
+ */
+#define TRACE_SPAN_END(event, arg) TraceRecord((event) | TRACE_END, (arg))
+
+/**
+ * @brief Records a point in time.
+ */
+#define TRACE_POINT(event, arg) TraceRecord((event) | TRACE_INSTANT, (arg))
+#else
+#define TRACE_SPAN_BEGIN(event, arg) ((void)0)
+#define TRACE_SPAN_END(event, arg) ((void)0)
+#define TRACE_POINT(event, arg) ((void)0)
+#endif
+
+/**
+ * @function TraceClear
+ * @brief Function that empties the ring.
+ * @param none
+ * @retval none
+ */
+void TraceClear(void);
+
+/**
+ * @function TraceDump
+ * @brief Function that sends the ring through USART2, oldest record first, without recording meanwhile: a line
+ * "TRACE records=<n> lost=<n> clock=<Hz>", the names of the events ("TE <code> <name>"), of the threads ("TN
+ * <context> <name>"), of the tasks ("TK <index> <name>") and of the commands ("TC <index> <name>"), a line "TR
+ * <cycles> <code> <context> <arg>" (hex) per record and "TRACE END".
+ * @param none
+ * @retval none
+ */
+void TraceDump(void);
+
+/**
+ * @function TraceEnable
+ * @brief Function that starts or stops taking records. They are taken from the reset.
+ * @param enable: true to take them, false to stop
+ * @retval none
+ */
+void TraceEnable(bool_t enable);
+
+#endif // TRACE_H
@@ -0,0 +1,45 @@
+/**
+ * @file tzdata.h
+ * @brief Identifiers of the time zones compiled into the firmware.
+ *
+ * Generated by Tools/tzgen.py from Tools/tzzones.txt. Do not edit.
+ */
+#ifndef TZDATA_H
+#define TZDATA_H
+
+/**
+ * @brief America/Argentina/Buenos_Aires (6 transitions).
+ */
+#define TZ_BUE 0
+
+/**
+ * @brief Etc/UTC (1 transition).
+ */
+#define TZ_UTC 1
+
+/**
+ * @brief America/Santiago (199 transitions).
+ */
+#define TZ_SCL 2
+
+/**
+ * @brief America/New_York (201 transitions).
+ */
+#define TZ_NYC 3
+
+/**
+ * @brief Europe/Madrid (201 transitions).
+ */
+#define TZ_MAD 4
+
+/**
+ * @brief Amount of time zones compiled.
+ */
+#define TZ_ZONE_COUNT 5
+
+/**
+ * @brief Length of the longest transition table.
+ */
+#define TZ_MAX_TRANSITIONS 201
+
+#endif
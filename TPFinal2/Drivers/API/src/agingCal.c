@@ -0,0 +1,200 @@
+/**
+ * @file agingCal.c
+ * @brief Implementation of the DS3231 aging offset calibration.
+ *
+ * Contains the function definitions declared in agingCal.h.
+ * The error is the ratio between the cycles of a reference second and the cycles
+ * of a DS3231 SQW period, both measured with the same core clock, so the core clock
+ * error cancels out.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "agingCal.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Progress and result of the calibration.
+ */
+static agingCalReport_t report;
+
+/**
+ * @brief Timer to let a new aging offset settle.
+ */
+static swTimer_t settleTimer;
+
+/**
+ * @brief Accumulated host timestamps: cycles and milliseconds elapsed between the first and the last one.
+ */
+static uint64_t hostCycles, hostTime;
+
+/**
+ * @brief Last host timestamp and its cycle counter.
+ */
+static uint32_t hostLastTime, hostLastStamp;
+
+/**
+ * @brief Flag to check whether the first host timestamp of the window arrived.
+ */
+static bool hostStarted;
+
+/**
+ * @brief Restarts the accumulation of both the SQW edges and the reference.
+ */
+static void WindowReset(void){
+	SQWReset();
+	hostStarted = false; /**< Host timestamps are fed from the main loop, no need to mask interrupts*/
+	hostCycles = 0;
+	hostTime = 0;
+	report.elapsed = 0;
+}
+
+/**
+ * @brief Callback of the settle timer (main loop): the new offset settled, a new window starts.
+ */
+static void SettleExpired(uint32_t arg){
+	WindowReset();
+	report.state = CAL_MEASURING;
+}
+
+/**
+ * @brief Sends a line of the report through USART2.
+ */
+static void SendReport(int32_t error, int8_t previous){
+	char line[96];
+	char ppm[16];
+
+	AgingCalFormatPpm(ppm, error);
+	sprintf(line, "CAL %u ref=%s aging=%d->%d error=%s (%ld ms/dia)\r\n", report.iteration,
+			(report.source == CAL_SOURCE_PPS) ? "PPS" : "host", previous, report.offset, ppm,
+			(long)error * 864 / 10000); /**< 1 ppb is 86.4 us per day*/
+	UARTSendString(line);
+}
+
+/**
+ * @brief Ends a window: computes the error and corrects the aging offset.
+ * @param rtc: SQW edges of the window
+ * @param refCycles: cycles of the reference span
+ * @param refSeconds: seconds of the reference span
+ */
+static void WindowEnd(edgeTrack_t *rtc, double refCycles, double refSeconds){
+	double cyclesPerSecond = refCycles / refSeconds;
+	double cyclesPerTick = (double)rtc->cycles / rtc->periods;
+	int32_t error = (int32_t)((cyclesPerSecond / cyclesPerTick - 1.0) * 1e9); /**< Shorter ticks than seconds: DS3231 runs fast*/
+	int32_t step = (error + ((error >= 0) ? CAL_PPB_PER_STEP / 2 : -CAL_PPB_PER_STEP / 2)) / CAL_PPB_PER_STEP;
+	int32_t offset = report.offset + step; /**< A larger offset adds capacitance and slows the clock*/
+	int8_t previous = report.offset;
+
+	if (offset > INT8_MAX) offset = INT8_MAX;
+	if (offset < INT8_MIN) offset = INT8_MIN;
+
+	report.iteration++;
+	if (report.iteration == 1) report.errorBefore = error;
+	report.errorAfter = error;
+	report.converged = (step == 0);
+
+	if (report.converged || (offset == report.offset) || (report.iteration >= CAL_MAX_ITERATIONS)){
+		SendReport(error, previous);
+		report.state = CAL_DONE;
+		return;
+	}
+
+	report.offset = offset;
+	SetAgingOffset(report.offset);
+	SendReport(error, previous);
+	SwTimerStart(&settleTimer, CAL_SETTLE_TIME, 0);
+	report.state = CAL_SETTLING;
+}
+
+/*Writes an error as ppm. Declared in header file*/
+void AgingCalFormatPpm(char *text, int32_t ppb){
+	uint32_t absolute = (ppb < 0) ? -ppb : ppb;
+	sprintf(text, "%c%lu.%03luppm", (ppb < 0) ? '-' : '+', (unsigned long)(absolute / 1000), (unsigned long)(absolute % 1000));
+}
+
+/*Copies the progress. Declared in header file*/
+void AgingCalGetReport(agingCalReport_t *copy){
+	*copy = report;
+}
+
+/*Feeds a host timestamp. Declared in header file*/
+void AgingCalHostTimestamp(uint32_t hostNow, uint32_t stamp){
+	uint32_t elapsed = hostNow - hostLastTime;
+
+	if ((report.state != CAL_WAITING) && (report.state != CAL_MEASURING)) return;
+	if (!hostStarted || (elapsed > CAL_HOST_MAX_GAP)){
+		hostStarted = true;
+		hostCycles = 0;
+		hostTime = 0;
+	}
+	else{
+		hostCycles += (uint32_t)(stamp - hostLastStamp);
+		hostTime += elapsed;
+	}
+	hostLastTime = hostNow;
+	hostLastStamp = stamp;
+}
+
+/*Starts a calibration. Declared in header file*/
+void AgingCalStart(void){
+	if (report.state == CAL_IDLE){ /**< The windows count cycles: the core must run, at one rate*/
+		PowerHold();
+		ClockHold();
+	}
+	report.state = CAL_WAITING;
+	report.source = CAL_SOURCE_NONE;
+	report.iteration = 0;
+	report.converged = false;
+	report.errorBefore = 0;
+	report.errorAfter = 0;
+	report.initialOffset = GetAgingOffset();
+	report.offset = report.initialOffset;
+	SetSquareWave(true);
+	SwTimerInit(&settleTimer, SettleExpired, 0, SW_TIMER_LOOP);
+	WindowReset();
+}
+
+/*Stops the calibration. Declared in header file*/
+void AgingCalStop(void){
+	SwTimerStop(&settleTimer);
+	SetSquareWave(PowerEnabled()); /**< The low-power mode wakes on its edges*/
+	if (report.state != CAL_IDLE){
+		PowerRelease();
+		ClockRelease();
+	}
+	report.state = CAL_IDLE;
+}
+
+/*Advances the calibration. Declared in header file*/
+agingCalState_t AgingCalUpdate(void){
+	edgeTrack_t rtc, pps;
+
+	SQWGetTrack(SQW_INPUT, &rtc);
+	SQWGetTrack(PPS_INPUT, &pps);
+
+	switch(report.state){
+	case CAL_WAITING:
+		if (pps.periods > 0) report.source = CAL_SOURCE_PPS; /**< 1 PPS is preferred: it has no transport jitter*/
+		else if (hostTime > 0) report.source = CAL_SOURCE_HOST;
+		else break;
+		WindowReset();
+		report.state = CAL_MEASURING;
+		break;
+	case CAL_MEASURING:
+		report.elapsed = rtc.periods;
+		if (report.source == CAL_SOURCE_PPS){
+			if ((rtc.periods >= CAL_WINDOW) && (pps.periods >= CAL_WINDOW)){
+				WindowEnd(&rtc, (double)pps.cycles, (double)pps.periods);
+			}
+		}
+		else if ((rtc.periods >= CAL_WINDOW) && (hostTime >= CAL_WINDOW * 1000ULL)){
+			WindowEnd(&rtc, (double)hostCycles, hostTime / 1000.0);
+		}
+		break;
+	default:
+		break;
+	}
+	return report.state;
+}
@@ -5,6 +5,7 @@
  * Contains the function definitions declared in app.h.
  * Implements MEFs to read buttons and switch display text or
  * configure datetime or alarms. Uses lcd_i2c.h and ds3231.h functions.
+ * The screens, menu entries and editable fields are the const tables of appFsm.h, generated from Tools/appfsm.txt.
  */
 
 /**
@@ -13,582 +14,2177 @@
 #include "app.h"
 
 /**
- * @brief States of the main FSM
- *
- * The main app has four possible states (corresponding to the screens to display): ShowTime, SetTime, SetAlarm and Menu.
+ * @brief DS3231 datetime object to store current alarm.
  */
-typedef enum{
-	SHOWTIME,
-	SETTIME,
-	SETALARM,
-	MENU
-} app_t;
+DS3231_DateTime alarm;
 
 /**
- * @brief States of the datetime (for time or alarm) setting FSM
- *
- * The datetime has seven possible states (corresponding to a value to set): Hours, Minutes, Seconds, Day, Date, Month and Year.
- * Alarm setting FSM only uses Hours, Minutes and Day.
+ * @brief Flag to check whether an alarm is set
+ */
+static bool_t alarmIsSet;
+
+/**
+ * @brief DS3231 datetime object to store alarm to set.
+ */
+DS3231_DateTime alarmToSet;
+
+/**
+ * @brief Instance of app_t for the main FSM.
+ */
+static app_t app;
+
+/**
+ * @brief Flag to check whether a forced temperature conversion is running.
+ */
+static bool_t converting;
+
+/**
+ * @brief Button pressed, queued by ButtonPressed for the input task.
+ */
+typedef struct{
+	uint16_t button;	/**< Pin of the button */
+	uint32_t edge;		/**< Cycle counter at the edge of the press */
+} buttonEvent_t;
+
+/**
+ * @brief Queue of the buttons pressed in order, and its storage.
+ */
+static kQueue_t buttonQueue;
+static buttonEvent_t buttonBuffer[MAX_BUFFER];
+
+/**
+ * @brief Application thread: runs the tasks of the scheduler. Woken by appWake or every tick.
+ */
+static kThread_t appThread;
+static uint32_t appStack[APP_STACK_WORDS] __attribute__((aligned(8)));
+static kSem_t appWake;
+
+/**
+ * @brief LCD thread: writes the frame of the screens to the LCD. Woken by lcdWake.
+ */
+static kThread_t lcdThread;
+static uint32_t lcdStack[LCD_STACK_WORDS] __attribute__((aligned(8)));
+static kSem_t lcdWake;
+
+/**
+ * @brief Lock of the frame (shownText, shownCol and the cursor), the pending latencies and frameSeq.
+ */
+static kSem_t frameLock;
+
+/**
+ * @brief Changes of the frame so far.
+ */
+static uint32_t frameSeq;
+
+/**
+ * @brief Cursor of the frame: placed by the LCD thread after the rows when cursorPending is set.
+ */
+static bool_t cursorPending;
+static uint8_t cursorRow, cursorCol;
+
+/**
+ * @brief Text and column of each LCD row as last written by the LCD thread (ROW_UNKNOWN before the first write).
+ */
+static char lcdText[LCD_ROWS][MAX_CHARS];
+static uint8_t lcdCol[LCD_ROWS] = {ROW_UNKNOWN, ROW_UNKNOWN};
+
+/**
+ * @brief Flag to make the LCD thread write every row of the next frame: the LCD was written outside it (benchmark).
+ */
+static bool_t lcdStale;
+
+/**
+ * @brief Press whose latency is recorded once the LCD thread writes the frame it changed.
+ */
+typedef struct{
+	uint32_t edge;		/**< Cycle counter at the edge of the press */
+	uint32_t seq;		/**< frameSeq after it was handled */
+	uint8_t screen;		/**< Screen it was handled in */
+} pendingLatency_t;
+
+/**
+ * @brief Ring of the pending latencies, in the order of the presses.
+ */
+static pendingLatency_t pendingLatency[LATENCY_PENDING];
+static uint8_t pendingHead, pendingCount;
+
+/**
+ * @brief Variable to store the date before displaying it in the LCD.
+ */
+static char datetext[MAX_CHARS];
+
+/**
+ * @brief Array of strings (array of chars) to display in the LCD.
+ */
+static char *dayOfWeek[LAST_DAY] = {"Dom","Lun","Mar","Mie","Jue","Vie","Sab"};
+
+/**
+ * @brief Field being edited in SetTimeMode or SetAlarmMode (index in appFields).
+ */
+static uint8_t field;
+
+/**
+ * @brief Timer of the overlay message.
+ */
+static swTimer_t overlayTimer;
+
+/**
+ * @brief Flag to check whether an overlay message covers the screen.
+ */
+static bool_t overlayShown;
+
+/**
+ * @brief Flag to check whether the button events are being recorded.
+ */
+static bool_t recording;
+
+/**
+ * @brief Tick when the recording started.
+ */
+static uint32_t recordStart;
+
+/**
+ * @brief Holding registers of the Modbus slave. The time and the alarm are UTC, as the DS3231 holds them; a 32-bit
+ * counter takes two registers, high word first. The image is refreshed every MODBUS_REFRESH ms while the slave runs
+ * and after every write.
  */
 typedef enum{
-	HOUR_DT,
-	MINUTE_DT,
-	SECOND_DT,
-	DAY_DT,
-	DATE_DT,
-	MONTH_DT,
-	YEAR_DT
-}datetime_t;
+	REG_SECONDS,		/**< Time: seconds (0-59). Written with the six below at once */
+	REG_MINUTES,		/**< Minutes (0-59) */
+	REG_HOURS,			/**< Hours (0-23) */
+	REG_DAY,			/**< Day of week (1-7 from Sunday), taken from the date on a write */
+	REG_DATE,			/**< Day of month */
+	REG_MONTH,			/**< Month (1-12) */
+	REG_YEAR,			/**< Complete year (2000-2099) */
+	REG_TIME_VALID,		/**< 1 if the time is valid. Read only, as all the ones below but the alarm and console ones */
+	REG_ALARM_SET,		/**< Alarm: 1 if set, 0 to clear it. Written with the three below at once */
+	REG_ALARM_DAY,		/**< Day of week (1-7 from Sunday) */
+	REG_ALARM_HOURS,	/**< Hours (0-23) */
+	REG_ALARM_MINUTES,	/**< Minutes (0-59) */
+	REG_UPTIME,			/**< HAL_GetTick (ms), 32 bits */
+	REG_UPTIME_LO,
+	REG_TEMPERATURE,	/**< Last temperature (0.25 C, signed) */
+	REG_MODES,			/**< Bit 0: low-power mode on, bit 1: clock governor on */
+	REG_I2C,			/**< I2C transfers, 32 bits */
+	REG_I2C_LO,
+	REG_I2C_ERRORS,		/**< I2C transfers failed or timed out, 32 bits */
+	REG_I2C_ERRORS_LO,
+	REG_MISSES,			/**< Deadline misses of the tasks, 32 bits */
+	REG_MISSES_LO,
+	REG_RX_ERRORS,		/**< USART2 reception errors, 32 bits */
+	REG_RX_ERRORS_LO,
+	REG_REQUESTS,		/**< Modbus requests served, 32 bits */
+	REG_REQUESTS_LO,
+	REG_CRC_ERRORS,		/**< Modbus frames dropped for their CRC, 32 bits */
+	REG_CRC_ERRORS_LO,
+	REG_EXCEPTIONS,		/**< Modbus exceptions replied, 32 bits */
+	REG_EXCEPTIONS_LO,
+	REG_TURNAROUND,		/**< Longest Modbus turnaround (us, saturated) */
+	REG_CONSOLE,		/**< Reads 1 while the slave runs. Writing 0 stops it and goes back to the console */
+	REG_COUNT
+} modbusReg_t;
 
 /**
- * @brief States of the menu FSM
- *
- * The menu has three possible states (corresponding to the modes of functioning): ShowTimeMode, SetTimeMode and SetAlarmMode.
+ * @brief Register image of the Modbus slave.
+ */
+static uint16_t registers[REG_COUNT];
+
+/**
+ * @brief Button repeated by ButtonRepeated and not handled yet (0 if none).
+ */
+static uint16_t repeatButton;
+
+/**
+ * @brief Steps of the pending repeat.
+ */
+static uint8_t repeatSteps;
+
+/**
+ * @brief DS3231 datetime object to store current local time (the DS3231 holds UTC).
+ */
+static DS3231_DateTime localTime;
+
+/**
+ * @brief Tasks of the scheduler, in order of priority.
  */
 typedef enum{
-	SHOWTIME_M,
-	SETTIME_M,
-	SETALARM_M
-} menu_t;
+	TASK_INPUT,
+	TASK_TIMERS,
+	TASK_DISPLAY,
+	TASK_UART,
+	TASK_COUNT
+} appTask_t;
 
 /**
- * @brief DS3231 datetime object to store current alarm.
+ * @brief Flag to check whether the current screen must be rendered again: set by the events that change its model
+ * (a button handled, entering the screen, a new temperature sample) and cleared when it is rendered.
  */
-DS3231_DateTime alarm;
+static bool_t dirty;
+
+/**
+ * @brief Instance of menu_t for the menu FSM.
+ */
+static menu_t menu;
+
+/**
+ * @brief Periodic timer of the snapshots of the Modbus registers.
+ */
+static swTimer_t modbusTimer;
+
+/**
+ * @brief Periodic timer that sends the temperature history a few lines at a time, and reader of the history it sends.
+ */
+static swTimer_t dumpTimer;
+static tempLogIterator_t dumpIt;
+
+/**
+ * @brief Tick when the seconds of the DS3231 were last seen changing.
+ */
+static uint32_t secondTick;
+
+/**
+ * @brief Seconds of the last time read by GetTimeIfDue.
+ */
+static uint8_t seenSeconds;
+
+/**
+ * @brief Text of each LCD row of the frame, as last written by ShowRow.
+ */
+static char shownText[LCD_ROWS][MAX_CHARS];
+
+/**
+ * @brief Column of the text of each LCD row of the frame, as last written by ShowRow (ROW_UNKNOWN before the first
+ * write).
+ */
+static uint8_t shownCol[LCD_ROWS] = {ROW_UNKNOWN, ROW_UNKNOWN};
+
+/**
+ * @brief Steps of the current button event: 1 for a press, more while a button is held.
+ */
+static uint8_t steps;
+
+/**
+ * @brief Last temperature read from the DS3231 (0.25 C units).
+ */
+static int16_t temperature;
+
+/**
+ * @brief Periodic timer of the temperature samples.
+ */
+static swTimer_t temperatureTimer;
+
+/**
+ * @brief Timer to poll the end of a forced temperature conversion.
+ */
+static swTimer_t conversionTimer;
+
+/**
+ * @brief DS3231 datetime object to store current time (UTC).
+ */
+DS3231_DateTime time;
+
+/**
+ * @brief Variable to store the time before displaying it in the LCD.
+ */
+static char timetext[MAX_CHARS];
+
+/**
+ * @brief DS3231 datetime object to store time to set.
+ */
+DS3231_DateTime timeToSet;
+
+/**
+ * @brief Zone shown in the first row of the multi-zone screen.
+ */
+static uint8_t zoneShown;
+
+/**
+ * @function AppThread.
+ * @brief Thread of the application: runs the tasks of the scheduler.
+ * @param none
+ * @retval none
+ */
+static void AppThread(void);
+
+/**
+ * @function EditUpdate
+ * @brief Updates the field being edited according to the button pressed.
+ * @param timeSet: pointer to the DS3231_DateTime object to be filled
+ * @param button: button pressed
+ * @retval boolean to indicate whether the edit is complete
+ */
+static bool_t EditUpdate(DS3231_DateTime *timeSet, uint16_t button);
+
+/**
+ * @function EnterScreen.
+ * @brief Switches the main app FSM to a screen, selecting its first field and running its enter action.
+ * @param screen: screen to enter
+ * @retval none
+ */
+static void EnterScreen(app_t screen);
+
+/**
+ * @function DisplayTask.
+ * @brief Task that updates the current screen without a button.
+ * @param none
+ * @retval none
+ */
+static void DisplayTask(void);
+
+/**
+ * @function GetTimeIfDue.
+ * @brief Reads the DS3231 time if it can have changed since the screen was rendered.
+ * @param valid: pointer to store whether the time read is valid
+ * @retval boolean to indicate whether the time was read
+ */
+static bool_t GetTimeIfDue(bool_t *valid);
+
+/**
+ * @function HandleButton.
+ * @brief Hands a button event to the FSM.
+ * @param button: button pressed or held
+ * @param pressed: true for a press, false for a repeat
+ * @param edge: cycle counter at the edge of the press
+ * @retval none
+ */
+static void HandleButton(uint16_t button, bool_t pressed, uint32_t edge);
+
+/**
+ * @function InputTask.
+ * @brief Task that handles the buttons pressed and held.
+ * @param none
+ * @retval none
+ */
+static void InputTask(void);
+
+/**
+ * @function LcdThread.
+ * @brief Thread that writes the frame of the screens to the LCD.
+ * @param none
+ * @retval none
+ */
+static void LcdThread(void);
+
+/**
+ * @function LowPowerMode.
+ * @brief Turns the low-power mode on or off.
+ * @param enable: true for on, false for off
+ * @retval none
+ */
+static void LowPowerMode(bool_t enable);
+
+/**
+ * @function OverlayExpired.
+ * @brief Callback of the overlay timer: removes the overlay message.
+ * @param arg: unused
+ * @retval none
+ */
+static void OverlayExpired(uint32_t arg);
+
+/**
+ * @function OverlayUpdate.
+ * @brief Removes the overlay message when a button is pressed.
+ * @param pressed: true if a button was pressed in this pass
+ * @retval none
+ */
+static void OverlayUpdate(bool_t pressed);
+
+/**
+ * @function RecordButton.
+ * @brief Sends a button event of the recording through USART2.
+ * @param button: button pressed or held
+ * @param repeat: true for a repeat, false for a press
+ * @retval none
+ */
+static void RecordButton(uint16_t button, bool_t repeat);
+
+/**
+ * @function RecordLatency.
+ * @brief Records the latency of a press, now or once the LCD shows the frame it changed.
+ * @param screen: screen the press was handled in
+ * @param edge: cycle counter at the edge of the press
+ * @param seq: frameSeq before it was handled
+ * @retval none
+ */
+static void RecordLatency(latencyScreen_t screen, uint32_t edge, uint32_t seq);
+
+/**
+ * @function ShowEditCursor.
+ * @brief Places the blinking cursor at the field being edited.
+ * @param none
+ * @retval none
+ */
+static void ShowEditCursor();
+
+/**
+ * @function ShowOverlay.
+ * @brief Shows a message over the current screen for a time, without blocking.
+ * @param first: text of the first row
+ * @param col0: column of the first row
+ * @param second: text of the second row
+ * @param col1: column of the second row
+ * @param duration: time (milliseconds) the message is shown
+ * @retval none
+ */
+static void ShowOverlay(char *first, uint8_t col0, char *second, uint8_t col1, tick_t duration);
+
+/**
+ * @function ShowOptions.
+ * @brief Shows menu options according to menu current state.
+ * @param none
+ * @retval none
+ */
+static void ShowOptions();
+
+/**
+ * @function ShowRow.
+ * @brief Writes a row of the LCD, unless it already shows that text at that column.
+ * @param text: text to write
+ * @param row: row of the LCD
+ * @param col: column of the first character
+ * @retval none
+ */
+static void ShowRow(char *text, uint8_t row, uint8_t col);
+
+/**
+ * @function StartScreens.
+ * @brief Starts the menu and the main app FSM, asking for the time if it is invalid.
+ * @param none
+ * @retval none
+ */
+static void StartScreens();
+
+/**
+ * @function StepField
+ * @brief Advances a datetime field by a number of steps, wrapping around its range or stopping at its ends.
+ * @param value: current value of the field
+ * @param min: minimum value of the field
+ * @param max: maximum value of the field
+ * @param delta: steps to advance (negative to go back)
+ * @param wrap: true to wrap around the range, false to stop at its ends
+ * @retval new value of the field
+ */
+static uint16_t StepField(uint16_t value, uint16_t min, uint16_t max, int16_t delta, bool_t wrap);
+
+/**
+ * @function UARTUpdate.
+ * @brief Task that handles the lines received through USART2.
+ * @param none
+ * @retval none
+ */
+static void UARTUpdate(void);
+
+/**
+ * @function AddToQueue
+ * @brief Adds button pressed to button queue, with the cycle counter at its edge. Dropped if the queue is full.
+ * @param value: button pressed
+ * @retval none
+ */
+static void AddToQueue(uint16_t value) {
+    buttonEvent_t event = {value, ButtonGetEdge(value)};
+
+    KernelQueueSend(&buttonQueue, &event, 0); /*Called from the tick interrupt: never waits*/
+}
+
+/**
+ * @function AppThread
+ * @brief Thread of the application: runs the tasks of the scheduler while any is released, then waits for a button,
+ * a timer, a line or the next periodic release, so the core sleeps in between. Above the LCD thread, so a button is
+ * handled while the LCD is being written. In the low-power mode no task is periodic, so it waits without a timeout
+ * and the core can stop.
+ * @param none
+ * @retval none
+ */
+static void AppThread(void){
+	tick_t next;
+
+	for (;;){
+		if (SchedulerRunNext()) continue;
+		next = SchedulerNextRelease();
+		KernelSemTake(&appWake, (next == SCHEDULER_NO_RELEASE) ? KERNEL_FOREVER : next); /**< Wakes at most a tick after the release*/
+	}
+}
+
+/**
+ * @function CalibrationMode
+ * @brief Executes all the actions for the calibration mode. Advances the aging offset calibration and shows
+ * the reference in use and the window progress, or the error before and after once it is done.
+ * Enter leaves the result screen.
+ * @param currentButton: button pressed
+ * @retval none
+ */
+void CalibrationMode(uint16_t currentButton){
+	agingCalReport_t report;
+	char ppm[16];
+
+	AgingCalUpdate();
+	AgingCalGetReport(&report);
+
+	switch(report.state){
+	case CAL_WAITING:
+		strcpy(timetext, "Calibracion");
+		strcpy(datetext, "Esperando ref.");
+		break;
+	case CAL_MEASURING:
+	case CAL_SETTLING:
+		sprintf(timetext, "%s %u ag:%d", (report.source == CAL_SOURCE_PPS) ? "PPS" : "Host", report.iteration + 1, report.offset);
+		if (report.state == CAL_SETTLING) strcpy(datetext, "Ajustando...");
+		else sprintf(datetext, "Midiendo %u/%us", report.elapsed, CAL_WINDOW);
+		break;
+	case CAL_DONE:
+		if (currentButton == ENTER_BUTTON){
+			AgingCalStop();
+			app = SHOWTIME;
+			menu = SHOWTIME_M;
+			return;
+		}
+		AgingCalFormatPpm(ppm, report.errorBefore);
+		sprintf(timetext, "Antes:%s", ppm);
+		AgingCalFormatPpm(ppm, report.errorAfter);
+		sprintf(datetext, "Desp.:%s", ppm);
+		break;
+	default:
+		return;
+	}
+	ShowRow(timetext, 0, 0);
+	ShowRow(datetext, 1, 0);
+}
+
+/**
+ * @function CheckLeapYear
+ * @brief Check if a given year is leap.
+ * @param year: year to be analized
+ * @retval boolean to indicate if the year is leap
+ */
+static bool_t CheckLeapYear(uint16_t year){
+	if ((year%400 ==0)|((year%4==0)&(year%100 !=0))) return true;
+	else return false;
+}
+
+/**
+ * @function AlarmConvert
+ * @brief Converts an alarm (day of week, hours and minutes) between local time and UTC, using the offset of the local
+ * zone at the current time. Shifts the day of week when the conversion crosses midnight.
+ * @param alarmTime: pointer to the DS3231_DateTime with the alarm, converted in place
+ * @param toUtc: true to convert a local alarm to UTC, false to convert a UTC alarm to local time
+ * @retval none
+ */
+static void AlarmConvert(DS3231_DateTime *alarmTime, bool_t toUtc){
+	int32_t offset = TzGetOffset(TzGetLocalZone(), TzDateTimeToEpoch(&time), NULL) / SECONDS_PER_MINUTE;
+	int32_t week = LAST_DAY * 24 * 60;
+	int32_t minutes = ((alarmTime->Day - FIRST_DAY) * 24 + alarmTime->Hours) * 60 + alarmTime->Minutes;
+
+	minutes += toUtc ? -offset : offset;
+	minutes = ((minutes % week) + week) % week;
+	alarmTime->Day = minutes / (24 * 60) + FIRST_DAY;
+	alarmTime->Hours = (minutes / 60) % 24;
+	alarmTime->Minutes = minutes % 60;
+}
+
+/**
+ * @function DaysInMonth
+ * @brief Gets the number of days of a month.
+ * @param month: month (1-12)
+ * @param year: complete year, for February
+ * @retval days of the month
+ */
+static uint8_t DaysInMonth(uint8_t month, uint16_t year){
+	static const uint8_t maxDay[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+
+	return maxDay[month - 1] + (((month == 2) && CheckLeapYear(year)) ? 1 : 0);
+}
+
+/**
+ * @function EditUpdate
+ * @brief Updates the field being edited according to the button pressed, following the field table.
+ * Right and left advance the field by the steps of the event (more than one while a button is held), wrapping
+ * around its range or stopping at its ends. Enter selects the next field. Marks the screen dirty if anything changed.
+ * @param timeSet: pointer to the DS3231_DateTime object to be filled
+ * @param button: button pressed
+ * @retval boolean to indicate whether the edit is complete (enter on the last field)
+ */
+static bool_t EditUpdate(DS3231_DateTime *timeSet, uint16_t button){
+	const appField_t *current;
+	uint8_t *member;
+	uint16_t value, max;
+	int16_t delta = 0;
+
+	if (field == APP_FIELD_NONE) return false;
+	current = &appFields[field];
+	if (button == ENTER_BUTTON){
+		field = current->next;
+		dirty = true; /**< The cursor moves*/
+		return (field == APP_FIELD_NONE);
+	}
+	if (button == RIGHT_BUTTON) delta = steps;
+	else if (button == LEFT_BUTTON) delta = -steps;
+	else return false;
+	dirty = true;
+
+	max = current->max;
+	if (max == APP_FIELD_MDAYS) max = DaysInMonth(timeSet->Month, timeSet->Year);
+	member = (uint8_t *)timeSet + current->offset;
+	value = (current->size == sizeof(uint16_t)) ? *(uint16_t *)member : *member;
+	value = StepField(value, current->min, max, delta, current->wrap);
+	if (current->size == sizeof(uint16_t)) *(uint16_t *)member = value;
+	else *member = (uint8_t)value;
+	return false;
+}
+
+/**
+ * @function EnterScreen
+ * @brief Switches the main app FSM to a screen, selecting its first field and running its enter action.
+ * @param screen: screen to enter
+ * @retval none
+ */
+static void EnterScreen(app_t screen){
+	app = screen;
+	field = appScreens[screen].firstField;
+	if (appScreens[screen].enter != NULL) appScreens[screen].enter();
+}
+
+/**
+ * @function FormatTemperature
+ * @brief Writes a temperature as "[-]dd.dd", cut to the size of the buffer.
+ * @param text: buffer to write
+ * @param size: size of the buffer (TEMPERATURE_TEXT_SIZE fits any value)
+ * @param value: temperature in 0.25 C units
+ * @retval none
+ */
+static void FormatTemperature(char *text, size_t size, int16_t value){
+	uint16_t absolute = (value < 0) ? -value : value;
+	snprintf(text, size, "%s%u.%02u", (value < 0) ? "-" : "", absolute / 4, (absolute % 4) * 25);
+}
+
+/**
+ * @function DumpLines
+ * @brief Callback of the dump timer, every DUMP_PERIOD ms while a dump runs: sends up to DUMP_LINES lines of the
+ * history, only while a whole line fits in the transmit buffer, and stops the timer after the newest sample.
+ * @param arg: unused
+ * @retval none
+ */
+static void DumpLines(uint32_t arg){
+	DS3231_DateTime sampleTime;
+	char line[64];
+	char value[TEMPERATURE_TEXT_SIZE];
+	int16_t sample;
+	uint32_t epoch;
+
+	for (uint8_t i = 0; (i < DUMP_LINES) && (UART_TX_RING - 1 - UARTTxUsed() >= sizeof(line)); i++){
+		if (!TempLogNext(&dumpIt, &sample, &epoch)){
+			SwTimerStop(&dumpTimer);
+			return;
+		}
+		TzEpochToDateTime(epoch, &sampleTime);
+		FormatTemperature(value, sizeof(value), sample);
+		snprintf(line, sizeof(line), "%04d-%02d-%02d %02d:%02d:%02d,%s\r\n", sampleTime.Year, sampleTime.Month,
+				sampleTime.Date, sampleTime.Hours, sampleTime.Minutes, sampleTime.Seconds, value);
+		UARTSendString(line);
+	}
+}
+
+/**
+ * @function DumpTemperatureLog
+ * @brief Starts sending the temperature history through USART2 as CSV lines "yyyy-mm-dd hh:mm:ss,temperature" (UTC),
+ * after a header with the samples and bytes. It returns at once: the dump timer sends the lines (see DumpLines), so a
+ * day of samples (about 37 KB, 3.3 s at 115200 baud) does not hold the tasks; the replies to other commands may come
+ * in between. A dump in progress starts again.
+ * @param none
+ * @retval none
+ */
+static void DumpTemperatureLog(){
+	char line[64];
+
+	snprintf(line, sizeof(line), "# %u muestras, %u bytes\r\n", TempLogCount(), TempLogUsage());
+	UARTSendString(line);
+	UARTSendString("utc,temperatura\r\n");
+	TempLogFirst(&dumpIt);
+	SwTimerStart(&dumpTimer, 1, DUMP_PERIOD);
+}
+
+/**
+ * @function GetTimeIfDue
+ * @brief Reads the DS3231 time if it can have changed since the screen was rendered: always if the screen is dirty,
+ * otherwise once SECOND_GUARD ms have passed since the seconds were seen changing. A second lasts 1000 ms and its
+ * change is seen at most one pass late, so no change is missed while the reads in between are skipped.
+ * Clears the dirty flag when it reads.
+ * @param valid: pointer to store whether the time read is valid
+ * @retval boolean to indicate whether the time was read
+ */
+static bool_t GetTimeIfDue(bool_t *valid){
+	uint32_t now = HAL_GetTick();
+
+	if (!dirty && ((now - secondTick) < SECOND_GUARD)) return false;
+	dirty = false;
+	*valid = GetTime(&time);
+	if (time.Seconds != seenSeconds){
+		seenSeconds = time.Seconds;
+		secondTick = now;
+	}
+	return true;
+}
+
+/**
+ * @function GetFromQueue
+ * @brief Gets the next value from a queue and removes it.
+ * @param edge: pointer to store the cycle counter at the edge of the button
+ * @retval val: the next value of the queue
+ */
+static uint16_t GetFromQueue(uint32_t *edge) {
+    buttonEvent_t event;
+
+    if (!KernelQueueReceive(&buttonQueue, &event, 0)) return -1; /*If queue is empty, return -1*/
+    *edge = event.edge;
+    return event.button;
+}
+
+/**
+ * @function HandleButton
+ * @brief Hands a button event to the FSM: menu leaves the screen (running its leave action) and any other button goes
+ * to the update handler of the screen, both looked up in the screen table. A new screen renders right away, so the
+ * latency of a press handled in the menu or the edit screens is recorded once the LCD thread has written the change
+ * to the DDRAM.
+ * @param button: button pressed or held
+ * @param pressed: true for a press, false for a repeat
+ * @param edge: cycle counter at the edge of the press
+ * @retval none
+ */
+static void HandleButton(uint16_t button, bool_t pressed, uint32_t edge){
+	app_t handledBy = app;
+	uint32_t seq = frameSeq;
+
+	TRACE_SPAN_BEGIN(TRACE_BUTTON, button);
+	if (recording) RecordButton(button, !pressed);
+	OverlayUpdate(pressed);
+	if ((button == MENU_BUTTON) && (app != MENU)){ /**< Menu leaves every screen*/
+		if (appScreens[app].leave != NULL) appScreens[app].leave();
+		app = MENU;
+	}
+	else appScreens[app].update(button);
+	if (app != handledBy){
+		dirty = true;
+		appScreens[app].update(0); /**< The new screen renders now*/
+	}
+
+	if (pressed && (handledBy == MENU)) RecordLatency(LAT_MENU, edge, seq);
+	else if (pressed && (handledBy == SETTIME)) RecordLatency(LAT_SETTIME, edge, seq);
+	else if (pressed && (handledBy == SETALARM)) RecordLatency(LAT_SETALARM, edge, seq);
+	TRACE_SPAN_END(TRACE_BUTTON, button);
+}
+
+/**
+ * @function DisplayTask
+ * @brief Task that updates the current screen without a button, every DISPLAY_PERIOD ms: the screens read the time
+ * when it can have changed and render what changed (a new second, a new temperature sample, an overlay removed).
+ * @param none
+ * @retval none
+ */
+static void DisplayTask(void){
+	appScreens[app].update(0);
+}
+
+/**
+ * @function InputTask
+ * @brief Task released by the buttons: handles every press queued, then the last repeat of a held button (only the
+ * edit screens repeat, and not in the run a press was handled in).
+ * @param none
+ * @retval none
+ */
+static void InputTask(void){
+	uint16_t button;
+	uint32_t edge;
+	bool_t pressed = false;
+
+	while ((button = GetFromQueue(&edge)) != (uint16_t)-1){
+		steps = 1;
+		HandleButton(button, true, edge);
+		pressed = true;
+	}
+	if (!pressed && repeatButton && ((app == SETTIME) || (app == SETALARM))){
+		steps = repeatSteps;
+		HandleButton(repeatButton, false, 0);
+	}
+	repeatButton = 0;
+}
+
+/**
+ * @function LcdThread
+ * @brief Thread that writes the frame of the screens to the LCD, below the application thread: takes a copy of the
+ * frame, writes the rows that differ from what the LCD shows and the cursor, and then records the latency of the
+ * presses whose change is now shown. While a row is written it only holds the bus, so the application thread
+ * preempts it between two transfers.
+ * @param none
+ * @retval none
+ */
+static void LcdThread(void){
+	char text[LCD_ROWS][MAX_CHARS];
+	uint8_t col[LCD_ROWS], row, curRow = 0, curCol = 0;
+	uint32_t seq;
+	bool_t cursor;
+
+	for (;;){
+		KernelSemTake(&lcdWake, KERNEL_FOREVER);
+		KernelSemTake(&frameLock, KERNEL_FOREVER);
+		memcpy(text, shownText, sizeof(text));
+		memcpy(col, shownCol, sizeof(col));
+		seq = frameSeq;
+		cursor = cursorPending;
+		curRow = cursorRow;
+		curCol = cursorCol;
+		cursorPending = false;
+		if (lcdStale) memset(lcdCol, ROW_UNKNOWN, sizeof(lcdCol));
+		lcdStale = false;
+		KernelSemGive(&frameLock);
+
+		ClockHold(); /**< A frame is a burst*/
+		TRACE_SPAN_BEGIN(TRACE_FRAME, seq);
+		for (row = 0; row < LCD_ROWS; row++){
+			if ((lcdCol[row] == col[row]) && (strncmp(lcdText[row], text[row], MAX_CHARS) == 0)) continue;
+			LCD_I2C_ClearWrite(text[row], row, col[row]);
+			memcpy(lcdText[row], text[row], MAX_CHARS);
+			lcdCol[row] = col[row];
+		}
+		if (cursor) LCD_I2C_SetCursor(curRow, curCol);
+		TRACE_SPAN_END(TRACE_FRAME, seq);
+		PowerRendered();
+		ClockRelease();
+
+		KernelSemTake(&frameLock, KERNEL_FOREVER);
+		while ((pendingCount > 0) && ((int32_t)(seq - pendingLatency[pendingHead].seq) >= 0)){
+			LatencyRecord(pendingLatency[pendingHead].screen, pendingLatency[pendingHead].edge);
+			pendingHead = (pendingHead + 1) % LATENCY_PENDING;
+			pendingCount--;
+		}
+		KernelSemGive(&frameLock);
+	}
+}
+
+/**
+ * @function LowPowerMode
+ * @brief Turns the low-power mode on or off. While it is on, the DS3231 SQW output wakes the core every second and
+ * releases the display task instead of its period, so no task is periodic and the core stops between the events. The SQW output stays on while a calibration uses it.
+ * @param enable: true for on, false for off
+ * @retval none
+ */
+static void LowPowerMode(bool_t enable){
+	SetSquareWave(enable || (app == CALIBRATION));
+	SchedulerSetPeriod(TASK_DISPLAY, enable ? 0 : DISPLAY_PERIOD);
+	PowerEnable(enable);
+}
+
+/**
+ * @function MenuInit
+ * @brief Initializes the menu to show time state.
+ * @param none
+ * @retval none
+ */
+static void MenuInit(){
+	menu = SHOWTIME_M;
+}
+
+
+/**
+ * @function MenuUpdate
+ * @brief Updates the menu state according to the button pressed, following the menu table: right and left select
+ * the neighbour entries and enter enters the screen of the entry. The options are only written when they change.
+ * @param button: button pressed
+ * @retval none
+ */
+void MenuUpdate(uint16_t button){
+	if (button == RIGHT_BUTTON) menu = appMenu[menu].right;
+	else if (button == LEFT_BUTTON) menu = appMenu[menu].left;
+	else if (button == ENTER_BUTTON){
+		EnterScreen(appMenu[menu].screen);
+		return;
+	}
+	else if (!dirty) return;
+	ShowOptions();
+	dirty = false;
+}
+
+/**
+ * @function MultiZoneEnter
+ * @brief Enter action of the multi-zone mode: starts showing the local zone in the first row.
+ * @param none
+ * @retval none
+ */
+void MultiZoneEnter(){
+	zoneShown = TzGetLocalZone();
+}
+
+/**
+ * @function OverlayExpired
+ * @brief Callback of the overlay timer (main loop): removes the overlay message. The screen underneath is marked
+ * dirty so it is rendered again.
+ * @param arg: unused
+ * @retval none
+ */
+static void OverlayExpired(uint32_t arg){
+	overlayShown = false;
+	dirty = true;
+}
+
+/**
+ * @function OverlayUpdate
+ * @brief Removes the overlay message as soon as a button is pressed, before its timer expires (the press is handled
+ * in the same pass and its screen rendered right away).
+ * @param pressed: true if a button was pressed in this pass
+ * @retval none
+ */
+static void OverlayUpdate(bool_t pressed){
+	if (overlayShown && pressed){
+		SwTimerStop(&overlayTimer);
+		OverlayExpired(0);
+	}
+}
+
+/**
+ * @function RecordButton
+ * @brief Sends a button event of the recording through USART2: "B <ms> <button>" for a press or
+ * "H <ms> <button> <steps>" for a repeat, with the milliseconds since the recording started.
+ * @param button: button pressed or held
+ * @param repeat: true if the event is a repeat
+ * @retval none
+ */
+static void RecordButton(uint16_t button, bool_t repeat){
+	char line[32];
+	const char *name = (button == RIGHT_BUTTON) ? "RIGHT" : (button == LEFT_BUTTON) ? "LEFT"
+			: (button == MENU_BUTTON) ? "MENU" : "ENTER";
+	unsigned long ms = HAL_GetTick() - recordStart;
+
+	if (repeat) sprintf(line, "H %lu %s %u\r\n", ms, name, steps);
+	else sprintf(line, "B %lu %s\r\n", ms, name);
+	UARTSendString(line);
+}
+
+/**
+ * @function RecordLatency
+ * @brief Records the latency of a press. If handling it changed nothing in the frame, the latency ends now; if not,
+ * it ends when the LCD thread has written that change (or now, if LATENCY_PENDING presses already wait for it).
+ * @param screen: screen the press was handled in
+ * @param edge: cycle counter at the edge of the press
+ * @param seq: frameSeq before it was handled
+ * @retval none
+ */
+static void RecordLatency(latencyScreen_t screen, uint32_t edge, uint32_t seq){
+	pendingLatency_t *pending;
+
+	KernelSemTake(&frameLock, KERNEL_FOREVER);
+	if ((frameSeq == seq) || (pendingCount == LATENCY_PENDING)) LatencyRecord(screen, edge);
+	else{
+		pending = &pendingLatency[(pendingHead + pendingCount) % LATENCY_PENDING];
+		pending->edge = edge;
+		pending->seq = frameSeq;
+		pending->screen = screen;
+		pendingCount++;
+	}
+	KernelSemGive(&frameLock);
+}
+
+/**
+ * @function RecordStart
+ * @brief Starts recording the button events through USART2. Sends the start conditions of the replay: "S <utc> <zone>"
+ * (with " osf" if the time is invalid) and "A <day> <hh> <mm>" with the DS3231 alarm registers if an alarm is set.
+ * Then restarts the screens, as on boot.
+ * @param none
+ * @retval none
+ */
+static void RecordStart(){
+	char line[40];
+	bool_t valid = GetTime(&time);
+
+	sprintf(line, "S %lu %u%s\r\n", (unsigned long)TzDateTimeToEpoch(&time), TzGetLocalZone(), valid ? "" : " osf");
+	UARTSendString(line);
+	GetAlarm(&alarm);
+	if (IsAlarmSet(&alarm)){
+		sprintf(line, "A %u %u %u\r\n", alarm.Day, alarm.Hours, alarm.Minutes);
+		UARTSendString(line);
+	}
+	recordStart = HAL_GetTick();
+	recording = true;
+	StartScreens();
+}
+
+/**
+ * @function SetAlarmEnter
+ * @brief Enter action of the set alarm mode: starts from an empty alarm.
+ * @param none
+ * @retval none
+ */
+void SetAlarmEnter(){
+	InitTime(&alarmToSet);
+}
+
+/**
+ * @function SetAlarmMode
+ * @brief Executes all the functions for Set alarm mode this is allowing to set an alarm with minutes, hours and day of week.
+ * If alarm is set, LCD displays "Alarma guardada, app and menu are sent to showtime, and alarmIsSet is set to True.
+ * The alarm is not saved while the DS3231 time is invalid. The screen is only written after a button changes it.
+ * @param currentButton: button pressed
+ * @retval none
+ */
+void SetAlarmMode(uint16_t currentButton){
+	if (EditUpdate(&alarmToSet,currentButton)){
+		if (!GetTime(&time)){ /**< The UTC offset depends on the current time*/
+			ShowOverlay("Ajuste primero",1,"la hora",4,OVERLAY_TIME);
+
+			app = SHOWTIME;
+			menu = SHOWTIME_M;
+			return;
+		}
+		AlarmConvert(&alarmToSet, true); /**< The DS3231 compares the alarm against UTC*/
+		SetAlarm(&alarmToSet);
+		ShowOverlay("Alarma",5,"guardada.",4,OVERLAY_TIME);
+
+		app = SHOWTIME;
+		menu = SHOWTIME_M;
+		alarmIsSet = true;
+		return;
+	}
+	if (!dirty) return;
+	sprintf(timetext, "%02d:%02d",alarmToSet.Hours, alarmToSet.Minutes);
+	sprintf(datetext, "%s",dayOfWeek[alarmToSet.Day-1]);
+
+	ShowRow(timetext, 0, 5);
+	ShowRow(datetext, 1, 6);
+	ShowEditCursor();
+	dirty = false;
+}
+
+/**
+ * @function SetTimeEnter
+ * @brief Enter action of the set time mode: starts from the current local time, or from the default time if the
+ * DS3231 time is invalid (nothing worth editing in it).
+ * @param none
+ * @retval none
+ */
+void SetTimeEnter(){
+	if (GetTime(&time)) TzUtcToLocal(TzGetLocalZone(), &time, &timeToSet); /**< The time is edited in local time*/
+	else InitTime(&timeToSet);
+}
+
+/**
+ * @function SetTimeMode
+ * @brief Executes all the functions for Set Time mode this is displaying date and time, and allowing to
+ * update values and set a new date and time. If a new datetime is set, LCD displays "Hora actualizada",
+ * and app and menu FSM are sent to show time state. A local time whose UTC falls out of 2000 to 2099 is not set:
+ * LCD displays "Fuera de rango" and the edit starts again. The screen is only written after a button changes it.
+ * @param currentButton: button pressed
+ * @retval none
+ */
+void SetTimeMode(uint16_t currentButton){
+	if (EditUpdate(&timeToSet,currentButton)){
+		if (!TzLocalToUtc(TzGetLocalZone(), &timeToSet, &time)){ /**< The DS3231 holds UTC, in 2000 to 2099*/
+			field = appScreens[SETTIME].firstField; /**< Edited again from the first field*/
+			ShowOverlay("Fuera de",4,"rango.",5,OVERLAY_TIME);
+			return;
+		}
+		SetTime(&time);
+		ShowOverlay("Hora",6,"actualizada.",2,OVERLAY_TIME);
+
+		app = SHOWTIME;
+		menu = SHOWTIME_M;
+		return;
+	}
+	if (!dirty) return;
+	sprintf(timetext, "%02d:%02d:%02d",timeToSet.Hours, timeToSet.Minutes, timeToSet.Seconds);
+	sprintf(datetext, "%s %02d/%02d/%04d",dayOfWeek[timeToSet.Day-1],timeToSet.Date, timeToSet.Month, timeToSet.Year);
+
+	ShowRow(timetext, 0, 4);
+	ShowRow(datetext, 1, 1);
+	ShowEditCursor();
+	dirty = false;
+}
+
+/**
+ * @function StepField
+ * @brief Advances a datetime field by a number of steps, wrapping around its range or stopping at its ends.
+ * @param value: current value of the field
+ * @param min: minimum value of the field
+ * @param max: maximum value of the field
+ * @param delta: steps to advance (negative to go back)
+ * @param wrap: true to wrap around the range, false to stop at its ends
+ * @retval new value of the field
+ */
+static uint16_t StepField(uint16_t value, uint16_t min, uint16_t max, int16_t delta, bool_t wrap){
+	int16_t range = max - min + 1;
+	int16_t offset = (int16_t)(value - min) + delta;
+
+	if (!wrap) return (offset < 0) ? min : (offset >= range) ? max : min + offset;
+	offset %= range;
+	if (offset < 0) offset += range;
+	return min + offset;
+}
+
+/**
+ * @function ShowEditCursor
+ * @brief Places the blinking cursor of the frame at the field being edited, as set in the field table.
+ * @param none
+ * @retval none
+ */
+static void ShowEditCursor(){
+	if (overlayShown || (field == APP_FIELD_NONE)) return;
+	KernelSemTake(&frameLock, KERNEL_FOREVER);
+	cursorRow = appFields[field].row;
+	cursorCol = appFields[field].col;
+	cursorPending = true;
+	frameSeq++;
+	KernelSemGive(&frameLock);
+	KernelSemGive(&lcdWake);
+}
+
+/**
+ * @function ShowOptions
+ * @brief Auxiliary function to show the text of the current menu entry
+ * @param none
+ * @retval none
+ */
+static void ShowOptions(){
+	const appMenuEntry_t *entry = &appMenu[menu];
+
+	ShowRow((char *)entry->text[0], 0, entry->col[0]);
+	ShowRow((char *)entry->text[1], 1, entry->col[1]);
+}
+
+/**
+ * @function MultiZoneMode
+ * @brief Executes all the actions for the multi-zone mode. Shows two consecutive zones as "ZZZ hh:mm:ss" (with a "*"
+ * while daylight saving time is in effect). Right and left scroll one zone, enter makes the zone of the first row
+ * the local zone and returns to show time mode.
+ * @param currentButton: button pressed
+ * @retval none
+ */
+void MultiZoneMode(uint16_t currentButton){
+	uint8_t zone;
+	bool dst;
+	bool_t valid;
+
+	if (currentButton == RIGHT_BUTTON) zoneShown = (zoneShown + 1) % TZ_ZONE_COUNT;
+	else if (currentButton == LEFT_BUTTON) zoneShown = (zoneShown + TZ_ZONE_COUNT - 1) % TZ_ZONE_COUNT;
+	else if (currentButton == ENTER_BUTTON){
+		TzSetLocalZone(zoneShown);
+		app = SHOWTIME;
+		menu = SHOWTIME_M;
+		return;
+	}
+	if (currentButton != 0) dirty = true;
+
+	if (!GetTimeIfDue(&valid)) return; /**< One read for both rows, the conversion is a table lookup per zone*/
+	zone = zoneShown;
+	dst = TzUtcToLocal(zone, &time, &localTime);
+	sprintf(timetext, "%s %02d:%02d:%02d%s",TzGetLabel(zone),localTime.Hours, localTime.Minutes, localTime.Seconds, dst ? "*" : "");
+	zone = (zone + 1) % TZ_ZONE_COUNT;
+	dst = TzUtcToLocal(zone, &time, &localTime);
+	sprintf(datetext, "%s %02d:%02d:%02d%s",TzGetLabel(zone),localTime.Hours, localTime.Minutes, localTime.Seconds, dst ? "*" : "");
+
+	ShowRow(timetext, 0, 2);
+	ShowRow(datetext, 1, 2);
+}
+
+/**
+ * @function ShowOverlay
+ * @brief Shows a two-row message over the current screen and returns: the loop keeps running and handling buttons,
+ * the screens keep updating their models without writing the LCD, and the overlay timer removes the message when it
+ * expires (OverlayExpired).
+ * @param first: text of the first row
+ * @param col0: column of the first row
+ * @param second: text of the second row
+ * @param col1: column of the second row
+ * @param duration: time (milliseconds) the message is shown
+ * @retval none
+ */
+static void ShowOverlay(char *first, uint8_t col0, char *second, uint8_t col1, tick_t duration){
+	overlayShown = false; /**< Replaces any message shown*/
+	ShowRow(first, 0, col0);
+	ShowRow(second, 1, col1);
+	overlayShown = true;
+	SwTimerStart(&overlayTimer, duration, 0);
+}
+
+/**
+ * @function ShowRow
+ * @brief Writes a row of the frame, unless it already holds that text at that column, and wakes the LCD thread to
+ * write it to the LCD (clearing the row first). Every write of this module goes through here. Nothing is written
+ * while an overlay message covers the screen.
+ * @param text: text to write
+ * @param row: row of the LCD
+ * @param col: column of the first character
+ * @retval none
+ */
+static void ShowRow(char *text, uint8_t row, uint8_t col){
+	if (overlayShown) return;
+	if ((shownCol[row] == col) && (strncmp(shownText[row], text, MAX_CHARS) == 0)) return;
+	KernelSemTake(&frameLock, KERNEL_FOREVER);
+	strncpy(shownText[row], text, MAX_CHARS - 1);
+	shownCol[row] = col;
+	frameSeq++;
+	KernelSemGive(&frameLock);
+	KernelSemGive(&lcdWake);
+}
+
+/**
+ * @function ShowTimeMode
+ * @brief Executes all the actions for the show time mode, this is displaying date, time and alarm indicator on screen.
+ * While the DS3231 time is invalid, asks to set it instead. Only reads the time when it can have changed, and only
+ * writes the rows that changed (the date row once a day).
+ * @param currentButton: button pressed (not used)
+ * @retval none
+ */
+void ShowTimeMode(uint16_t currentButton){
+	  uint8_t col;
+	  bool_t valid;
+
+	  if (!GetTimeIfDue(&valid)) return;
+	  if (!valid){
+		  ShowRow("Hora invalida", 0, 1);
+		  ShowRow("Ajuste la hora", 1, 1);
+		  return;
+	  }
+	  TzUtcToLocal(TzGetLocalZone(), &time, &localTime);
+
+	  if (alarmIsSet){
+		  sprintf(timetext, "A   %02d:%02d:%02d %s",localTime.Hours, localTime.Minutes, localTime.Seconds, TzGetLabel(TzGetLocalZone()));
+		  col = 0;
+	  }
+	  else{
+		  sprintf(timetext, "%02d:%02d:%02d %s",localTime.Hours, localTime.Minutes, localTime.Seconds, TzGetLabel(TzGetLocalZone()));
+		  col=4;
+	  }
+
+	  sprintf(datetext, "%s %02d/%02d/%04d",dayOfWeek[localTime.Day-1],localTime.Date, localTime.Month, localTime.Year);
+
+	  ShowRow(timetext, 0, col);
+	  ShowRow(datetext, 1, 1);
+}
+
+/**
+ * @function SlaveRefresh
+ * @brief Callback of the Modbus timer, every MODBUS_REFRESH ms while the slave runs: takes the snapshot of the
+ * registers, reading the DS3231 time and alarm here so the requests never wait for the I2C bus.
+ * @param arg: unused
+ * @retval none
+ */
+static void SlaveRefresh(uint32_t arg){
+	i2cStats_t i2c;
+	modbusStats_t modbus;
+	bool_t valid = GetTime(&time);
+	uint32_t counters[][2] = {
+		{REG_UPTIME, HAL_GetTick()}, {REG_I2C, 0}, {REG_I2C_ERRORS, 0}, {REG_MISSES, SchedulerMisses()},
+		{REG_RX_ERRORS, UARTRxErrors()}, {REG_REQUESTS, 0}, {REG_CRC_ERRORS, 0}, {REG_EXCEPTIONS, 0}
+	};
+
+	GetAlarm(&alarm);
+	I2CGetStats(&i2c);
+	ModbusGetStats(&modbus);
+	counters[1][1] = i2c.transfers;
+	counters[2][1] = i2c.errors + i2c.timeouts;
+	counters[5][1] = modbus.requests;
+	counters[6][1] = modbus.crcErrors;
+	counters[7][1] = modbus.exceptions;
+	registers[REG_SECONDS] = time.Seconds;
+	registers[REG_MINUTES] = time.Minutes;
+	registers[REG_HOURS] = time.Hours;
+	registers[REG_DAY] = time.Day;
+	registers[REG_DATE] = time.Date;
+	registers[REG_MONTH] = time.Month;
+	registers[REG_YEAR] = time.Year;
+	registers[REG_TIME_VALID] = valid ? 1 : 0;
+	registers[REG_ALARM_SET] = IsAlarmSet(&alarm) ? 1 : 0;
+	registers[REG_ALARM_DAY] = alarm.Day;
+	registers[REG_ALARM_HOURS] = alarm.Hours;
+	registers[REG_ALARM_MINUTES] = alarm.Minutes;
+	registers[REG_TEMPERATURE] = (uint16_t)temperature;
+	registers[REG_MODES] = (PowerEnabled() ? 1 : 0) | (ClockEnabled() ? 2 : 0);
+	for (uint8_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++){
+		registers[counters[i][0]] = counters[i][1] >> 16;
+		registers[counters[i][0] + 1] = counters[i][1] & 0xFFFF;
+	}
+	registers[REG_TURNAROUND] = (modbus.turnaroundMax > 0xFFFF) ? 0xFFFF : modbus.turnaroundMax;
+	registers[REG_CONSOLE] = (ModbusAddress() != 0) ? 1 : 0;
+}
+
+/**
+ * @function I2CFailures
+ * @brief Counts the I2C transfers that failed so far, to find out whether a write to the DS3231 went through.
+ * @param none
+ * @retval transfers that ended with an error or a timeout
+ */
+static uint32_t I2CFailures(void){
+	i2cStats_t i2c;
+
+	I2CGetStats(&i2c);
+	return i2c.errors + i2c.timeouts;
+}
+
+/**
+ * @function SlaveStart
+ * @brief Starts the Modbus slave: stops the telemetry stream, whose frames would corrupt the line, keeps the core
+ * out of the stop mode, where USART2 receives nothing, and starts the snapshots.
+ * @param address: address of the slave
+ * @retval none
+ */
+static void SlaveStart(uint8_t address){
+	TelemetryStart(0);
+	PowerHold();
+	ModbusStart(address);
+	SlaveRefresh(0);
+	SwTimerStart(&modbusTimer, MODBUS_REFRESH, MODBUS_REFRESH);
+}
+
+/**
+ * @function SlaveStop
+ * @brief Stops the Modbus slave and goes back to the console.
+ * @param none
+ * @retval none
+ */
+static void SlaveStop(void){
+	SwTimerStop(&modbusTimer);
+	ModbusStop();
+	PowerRelease();
+}
+
+/**
+ * @function StartScreens
+ * @brief Initializes the menu and the main app FSM in ShowTime mode, or in SetTime mode if the DS3231 time is invalid
+ * (e.g.: it lost VBAT). Used on boot and when a recording starts, so that a replay starts from the same screen.
+ * @param none
+ * @retval none
+ */
+static void StartScreens(){
+	MenuInit();
+	app = SHOWTIME;
+	dirty = true;
+
+	if (!GetTime(&time)){ /**< Asks for the time once on boot*/
+		ShowOverlay("Reloj detenido",1,"Ajuste la hora",1,OVERLAY_BOOT_TIME);
+
+		EnterScreen(SETTIME);
+		menu = SETTIME_M;
+	}
+}
+
+/**
+ * @function TemperatureMode
+ * @brief Executes all the actions for the temperature mode. Shows the last temperature in the first row and the
+ * minimum and maximum of the history in the second one, again only when a new sample is logged. Enter starts the dump
+ * of the history through USART2, with a message meanwhile.
+ * @param currentButton: button pressed
+ * @retval none
+ */
+void TemperatureMode(uint16_t currentButton){
+	tempLogIterator_t it;
+	char value[TEMPERATURE_TEXT_SIZE];
+	int16_t sample, min = temperature, max = temperature;
+	uint32_t epoch;
+
+	if (currentButton == ENTER_BUTTON){
+		DumpTemperatureLog();
+		ShowOverlay("Enviando",4,"historial...",2,OVERLAY_TIME);
+		return;
+	}
+	if (!dirty) return;
+	dirty = false;
+
+	TempLogFirst(&it);
+	while (TempLogNext(&it, &sample, &epoch)){
+		if (sample < min) min = sample;
+		if (sample > max) max = sample;
+	}
+
+	FormatTemperature(value, sizeof(value), temperature);
+	sprintf(timetext, "Temp. %s\xDF" "C", value); /**< 0xDF is the degree sign in the HD44780 ROM*/
+	FormatTemperature(value, sizeof(value), min);
+	sprintf(datetext, "m:%s ", value);
+	FormatTemperature(value, sizeof(value), max);
+	strcat(datetext, "M:");
+	strcat(datetext, value);
+
+	ShowRow(timetext, 0, 1);
+	ShowRow(datetext, 1, 0);
+}
 
 /**
- * @brief Flag to check whether an alarm is set
+ * @function TemperatureConverted
+ * @brief Callback of the conversion timer: polls the busy flags of the forced conversion every CONVERSION_POLL_TIME
+ * ms and logs the result once it is ready (only if the DS3231 time is valid).
+ * @param arg: unused
+ * @retval none
  */
-static bool_t alarmIsSet;
+static void TemperatureConverted(uint32_t arg){
+	if (IsConversionBusy()){
+		SwTimerStart(&conversionTimer, CONVERSION_POLL_TIME, 0);
+		return;
+	}
+	converting = false;
+	temperature = GetTemperature();
+	if (app == TEMPERATURE) dirty = true;
+	if (GetTime(&time)) TempLogAdd(temperature, TzDateTimeToEpoch(&time)); /**< A sample with an invalid timestamp is useless*/
+}
 
 /**
- * @brief Instance of datetime_t for alarm setting in SetAlarmMode.
+ * @function TemperatureSample
+ * @brief Callback of the temperature timer, every TEMPLOG_PERIOD seconds: forces a conversion without blocking and
+ * starts polling its end.
+ * @param arg: unused
+ * @retval none
  */
-static datetime_t alarmSet;
+static void TemperatureSample(uint32_t arg){
+	if (converting) return; /**< The last one has not finished yet*/
+	converting = StartConversion();
+	if (converting) SwTimerStart(&conversionTimer, CONVERSION_POLL_TIME, 0);
+}
 
 /**
- * @brief DS3231 datetime object to store alarm to set.
+ * @function AlarmCommand
+ * @brief Console command "ALARM": sends the alarm in local time ("ALARM <day> hh:mm", with " utc" if the DS3231 time
+ * is invalid and it cannot be converted, or "ALARM none"). "ALARM SET <day> <hh:mm>" sets it, the day from 1 (Sunday)
+ * to 7 or as shown on the LCD ("Dom".."Sab"); as on the set alarm screen, it needs a valid time. "ALARM DEL" clears it.
+ * @param argc: number of words
+ * @param argv: words of the line
+ * @retval none
  */
-DS3231_DateTime alarmToSet;
+static void AlarmCommand(uint8_t argc, char *argv[]){
+	DS3231_DateTime set = {0};
+	unsigned int day = 0, hours, minutes;
+	bool_t valid = GetTime(&time);
+	char *end;
+
+	if (argc == 1){
+		GetAlarm(&alarm);
+		if (!IsAlarmSet(&alarm)){
+			ConsoleReply("ALARM none");
+			return;
+		}
+		set = alarm;
+		if (valid) AlarmConvert(&set, false);
+		ConsoleReply("ALARM %s %02u:%02u%s", dayOfWeek[set.Day - 1], set.Hours, set.Minutes, valid ? "" : " utc");
+	}
+	else if ((argc == 2) && (strcmp(argv[1], "DEL") == 0)){
+		SetAlarm(&set); /**< Day 0 never matches: IsAlarmSet reads it as no alarm*/
+		alarmIsSet = false;
+		dirty = true;
+		ConsoleReply("OK");
+	}
+	else if ((argc == 4) && (strcmp(argv[1], "SET") == 0)){
+		for (uint8_t i = 0; i < LAST_DAY; i++){
+			if (strcmp(argv[2], dayOfWeek[i]) == 0) day = i + FIRST_DAY;
+		}
+		if (day == 0){
+			day = strtoul(argv[2], &end, 10);
+			if (*end != '\0') day = 0;
+		}
+		if ((day < FIRST_DAY) || (day > LAST_DAY) || (sscanf(argv[3], "%u:%u", &hours, &minutes) != 2) ||
+				(hours > 23) || (minutes > 59)){
+			ConsoleUsage();
+			return;
+		}
+		if (!valid){ /**< The UTC offset depends on the current time*/
+			ConsoleReply("ERR time invalid");
+			return;
+		}
+		set.Day = day;
+		set.Hours = hours;
+		set.Minutes = minutes;
+		AlarmConvert(&set, true); /**< The DS3231 compares the alarm against UTC*/
+		SetAlarm(&set);
+		alarmIsSet = true;
+		dirty = true;
+		ConsoleReply("OK");
+	}
+	else ConsoleUsage();
+}
 
 /**
- * @brief Instance of app_t for the main FSM.
+ * @brief Argument of the BCD cases and time written by the SetTime case, taken when the benchmark starts.
  */
-static app_t app;
+static volatile uint8_t benchValue;
+static DS3231_DateTime benchTime;
 
 /**
- * @brief Variable to store the buttons pressed in order.
+ * @brief Case of the benchmark: converts a BCD byte.
  */
-static uint16_t buttonBuffer[MAX_BUFFER];
+static void BenchBcdToDec(void){
+	benchValue = BcdToDec(benchValue);
+}
 
 /**
- * @brief Variable to store the date before displaying it in the LCD.
+ * @brief Case of the benchmark: converts a byte to BCD.
  */
-static char datetext[MAX_CHARS];
+static void BenchDecToBcd(void){
+	benchValue = DecToBcd(benchValue);
+}
 
 /**
- * @brief Instance of datetime_t for datetime setting in SetTimeMode.
+ * @brief Case of the benchmark: reads the DS3231 time.
  */
-static datetime_t datetimeSet;
+static void BenchGetTime(void){
+	DS3231_DateTime read;
+
+	GetTime(&read);
+}
 
 /**
- * @brief Array of strings (array of chars) to display in the LCD.
+ * @brief Case of the benchmark: writes the time read when the benchmark started to the DS3231 (set right afterwards).
  */
-static char *dayOfWeek[LAST_DAY] = {"Dom","Lun","Mar","Mie","Jue","Vie","Sab"};
+static void BenchSetTime(void){
+	SetTime(&benchTime);
+}
 
 /**
- * @brief Head and tail of the queue
+ * @brief Case of the benchmark: sends a character to the LCD.
  */
-int head = 0, tail = 0;
+static void BenchLcdSend(void){
+	LCD_I2C_Send(' ', REGISTER_SELECT);
+}
 
 /**
- * @brief Instance of menu_t for the menu FSM.
+ * @brief Case of the benchmark: writes a whole row of text to the LCD.
  */
-static menu_t menu;
+static void BenchLcdWriteString(void){
+	LCD_I2C_WriteString("0123456789ABCDEF");
+}
 
 /**
- * @brief DS3231 datetime object to store current time.
+ * @brief Case of the benchmark: clears a row of the LCD and writes a time on it.
  */
-DS3231_DateTime time;
+static void BenchLcdClearWrite(void){
+	LCD_I2C_ClearWrite("12:34:56 ART", 0, 4);
+}
 
 /**
- * @brief Variable to store the time before displaying it in the LCD.
+ * @brief Case of the benchmark: a whole frame of the show time screen, from the read of the time to both rows
+ * written to the LCD, as the LCD thread writes them.
  */
-static char timetext[MAX_CHARS];
+static void BenchShowTimeFrame(void){
+	dirty = true; /**< Reads the time*/
+	ShowTimeMode(0); /**< The rows are not handed to the LCD thread while the benchmark runs*/
+	LCD_I2C_ClearWrite(timetext, 0, alarmIsSet ? 0 : 4);
+	LCD_I2C_ClearWrite(datetext, 1, 1);
+}
 
 /**
- * @brief DS3231 datetime object to store time to set.
+ * @brief Table of cases of the benchmark ("BENCH", Tools/bench.py): name and function.
  */
-DS3231_DateTime timeToSet;
-
+static const benchCase_t benchCases[] = {
+	{"BcdToDec", BenchBcdToDec},
+	{"DecToBcd", BenchDecToBcd},
+	{"GetTime", BenchGetTime},
+	{"SetTime", BenchSetTime},
+	{"LCD_I2C_Send", BenchLcdSend},
+	{"LCD_I2C_WriteString", BenchLcdWriteString},
+	{"LCD_I2C_ClearWrite", BenchLcdClearWrite},
+	{"ShowTimeMode", BenchShowTimeFrame}
+};
 
 /**
- * @function ShowTimeMode.
- * @brief Displays time in the first row in "hh:mm:ss" format and date in the second row in "day dd/mm/aaaa" format.
- * @param none
+ * @function BenchCommand
+ * @brief Console command "BENCH [<runs>]": times the drivers (bench.h), BENCH_RUNS calls of each case by default.
+ * The frame of the screens is frozen meanwhile, as under an overlay message, and the LCD thread ends the frame in
+ * flight first; the LCD is written again whole afterwards. The SetTime case writes back the time read at the start,
+ * so the benchmark starts on a change of the seconds and, at the end, waits for the next whole second since then
+ * and writes the start time plus the seconds passed: the DS3231 only loses the poll interval, BENCH_SYNC_POLL ms.
+ * It is refused while the calibration or a time synchronization uses the DS3231, and with "ERR time invalid" if the
+ * time is not valid or the seconds do not change (SetTime would make a wrong time valid).
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void ShowTimeMode();
+static void BenchCommand(uint8_t argc, char *argv[]){
+	timeSyncReport_t sync;
+	DS3231_DateTime now;
+	bool_t overlay = overlayShown;
+	unsigned long runs = BENCH_RUNS;
+	uint32_t start, elapsed;
+	char *end;
+
+	if (argc == 2){
+		runs = strtoul(argv[1], &end, 10);
+		if ((*end != '\0') || (runs == 0) || (runs > BENCH_MAX_RUNS)){
+			ConsoleUsage();
+			return;
+		}
+	}
+	TimeSyncGetReport(&sync);
+	if ((app == CALIBRATION) || (sync.state != SYNC_IDLE)){
+		ConsoleReply("ERR busy");
+		return;
+	}
+	GetTime(&now);
+	start = HAL_GetTick();
+	do{ /**< The start time is only known to the second at a change of the seconds*/
+		KernelSleep(BENCH_SYNC_POLL);
+		GetTime(&benchTime);
+	} while ((benchTime.Seconds == now.Seconds) && (HAL_GetTick() - start < 1000 + BENCH_SYNC_POLL));
+	if ((GetTimeValidity() != TIME_VALID) || (benchTime.Seconds == now.Seconds)){
+		ConsoleReply("ERR time invalid");
+		return;
+	}
+	start = HAL_GetTick();
+	benchValue = benchTime.Seconds;
+	overlayShown = true; /**< ShowRow writes nothing*/
+	KernelSleep(BENCH_SETTLE);
+	BenchRun(benchCases, sizeof(benchCases) / sizeof(benchCases[0]), runs);
+	elapsed = HAL_GetTick() - start;
+	KernelSleep(1000 - elapsed % 1000);
+	TzEpochToDateTime(TzDateTimeToEpoch(&benchTime) + elapsed / 1000 + 1, &now);
+	SetTime(&now); /**< The benchmark does not move the clock*/
+	overlayShown = overlay;
+	KernelSemTake(&frameLock, KERNEL_FOREVER);
+	lcdStale = true;
+	frameSeq++;
+	KernelSemGive(&frameLock);
+	KernelSemGive(&lcdWake);
+	ShowEditCursor();
+	dirty = true;
+}
 
 /**
- * @function SetTimeMode.
- * @brief Allow to set date and time. The cursor blinks to the left of the unit to set.
- * @param currentButton: button pressed
+ * @function ClockCommand
+ * @brief Console commands of the clock governor: "G1" turns it on and "G0" off, "G" sends its statistics and "GR"
+ * clears them.
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void SetTimeMode(uint16_t currentButton);
+static void ClockCommand(uint8_t argc, char *argv[]){
+	switch (argv[0][1]){
+	case '1': ClockEnable(true); break;
+	case '0': ClockEnable(false); break;
+	case 'R': ClockResetStats(); break;
+	default: ClockReport(); break;
+	}
+}
 
 /**
- * @function SetAlarmMode.
- * @brief Allow to set hour, minutes and day for alarm. The cursor blinks to the left of the unit to set.
- * @param currentButton: button pressed
+ * @function HostTimeCommand
+ * @brief Console command "T <ms>": a host timestamp for the calibration, taken when the line started to be sent.
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void SetAlarmMode(uint16_t currentButton);
+static void HostTimeCommand(uint8_t argc, char *argv[]){
+	AgingCalHostTimestamp(strtoul(argv[1], NULL, 10), ConsoleStamp());
+}
 
 /**
- * @function ShowOptions.
- * @brief Shows menu options according to menu current state.
- * @param none
+ * @function KernelCommand
+ * @brief Console commands of the run time statistics: "K" sends those of the tasks, the threads, the deferred
+ * interrupt work and the console, "KR" clears them.
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void ShowOptions();
+static void KernelCommand(uint8_t argc, char *argv[]){
+	if (argv[0][1] == 'R'){
+		SchedulerResetStats();
+		KernelResetStats();
+		DeferredResetStats();
+		ConsoleResetStats();
+		return;
+	}
+	SchedulerReport();
+	KernelReport();
+	DeferredReport();
+	ConsoleReport();
+}
 
 /**
- * @function TimeSetUpdate
- * @brief Updates the time/alarm set FSM according to buttons pressed.
- * @param dt: pointer to the datetime_t object to be analized
- * @param timeSet: pointer to the DS3231_DateTime object to be filled
- * @param button: button pressed
- * @retval boolean to indicate whether the time/alarm set is complete
+ * @function LatencyCommand
+ * @brief Console commands of the latency histograms: "L" dumps them, "LR" clears them.
+ * @param argc: number of words
+ * @param argv: words of the line
+ * @retval none
  */
-bool_t TimeSetUpdate(uint16_t *dt, DS3231_DateTime *timeSet, uint16_t button);
-
+static void LatencyCommand(uint8_t argc, char *argv[]){
+	if (argv[0][1] == 'R') LatencyReset();
+	else LatencyDump();
+}
 
 /**
- * @function AddToQueue
- * @brief Adds button pressed to button buffer.
- * @param value: button pressed
+ * @function ModbusCommand
+ * @brief Console commands of the Modbus slave: "MB <address>" starts it (the console stops until the master writes 0
+ * to REG_CONSOLE), "MB" sends its statistics and "MBR" clears them.
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void AddToQueue(uint16_t value) {
-    int nextTail = (tail + 1) % MAX_BUFFER;
-    if (nextTail == head) return; /*If buffer is full*/
-    buttonBuffer[tail] = value;
-    tail = nextTail;
-    return;
+static void ModbusCommand(uint8_t argc, char *argv[]){
+	modbusStats_t stats;
+	unsigned long address;
+	char *end;
+
+	if (argv[0][2] == 'R'){
+		ModbusResetStats();
+		return;
+	}
+	if (argc == 1){
+		ModbusGetStats(&stats);
+		ConsoleReply("MB requests=%lu replies=%lu exceptions=%lu crc=%lu ignored=%lu dropped=%lu turnaround=%luus",
+				(unsigned long)stats.requests, (unsigned long)stats.replies, (unsigned long)stats.exceptions,
+				(unsigned long)stats.crcErrors, (unsigned long)stats.ignored, (unsigned long)UARTLinesDropped(),
+				(unsigned long)stats.turnaroundMax);
+		return;
+	}
+	address = strtoul(argv[1], &end, 10);
+	if ((*end != '\0') || (address == MODBUS_BROADCAST) || (address > MODBUS_MAX_ADDRESS)){
+		ConsoleUsage();
+		return;
+	}
+	ConsoleReply("OK"); /**< Before the switch: the text is dropped once the slave runs*/
+	SlaveStart(address);
 }
 
 /**
- * @function CheckLeapYear
- * @brief Check if a given year is leap.
- * @param year: year to be analized
- * @retval boolean to indicate if the year is leap
+ * @function PowerCommand
+ * @brief Console commands of the low-power mode: "P1" turns it on and "P0" off, "P" sends its statistics and "PR"
+ * clears them.
+ * @param argc: number of words
+ * @param argv: words of the line
+ * @retval none
  */
-static bool_t CheckLeapYear(uint8_t year){
-	if ((year%400 ==0)|((year%4==0)&(year%100 !=0))) return true;
-	else return false;
+static void PowerCommand(uint8_t argc, char *argv[]){
+	switch (argv[0][1]){
+	case '1': LowPowerMode(true); break;
+	case '0': LowPowerMode(false); break;
+	case 'R': PowerResetStats(); break;
+	default: PowerReport(); break;
+	}
 }
 
 /**
- * @function GetFromQueue
- * @brief Gets the next value from a queue and removes it.
- * @param none
- * @retval val: the next value of the queue
+ * @function RecordCommand
+ * @brief Console commands of the recording: "R1" starts recording the button events and "R0" stops it (sending
+ * "E <ms>", the end of the recording).
+ * @param argc: number of words
+ * @param argv: words of the line
+ * @retval none
  */
-static uint16_t GetFromQueue(void) {
-    if (head == tail) return -1; /*If buffer is empty, return -1*/
-    uint16_t val = buttonBuffer[head];
-    head = (head + 1) % MAX_BUFFER;
-    return val;
+static void RecordCommand(uint8_t argc, char *argv[]){
+	if (argv[0][1] == '1') RecordStart();
+	else if (recording){
+		ConsoleReply("E %lu", (unsigned long)(HAL_GetTick() - recordStart));
+		recording = false;
+	}
 }
 
 /**
- * @function MenuInit
- * @brief Initializes the menu to show time state.
- * @param none
+ * @function StatsCommand
+ * @brief Console command "STATS": sends every run time statistic, those of "K", "P" and "G".
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void MenuInit(){
-	menu = SHOWTIME_M;
+static void StatsCommand(uint8_t argc, char *argv[]){
+	SchedulerReport();
+	KernelReport();
+	DeferredReport();
+	ConsoleReport();
+	PowerReport();
+	ClockReport();
 }
 
-
 /**
- * @function MenuUpdate
- * @brief Updates the menu state according to the button pressed.
- * @param button: button pressed
+ * @function SyncCommand
+ * @brief Console command "SYNC" of the time synchronization (Tools/timesync.py): "SYNC <t1> [<t4>]" is a round, the
+ * host time when the line was sent and, after the first, when the last reply arrived (us since 01/01/2000 UTC);
+ * "SYNC SET [<t4>]" writes the next host second to the DS3231 and "SYNC" sends the progress. It is refused while
+ * the calibration uses the SQW edges.
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void MenuUpdate(uint16_t button){
-	ShowOptions();
-	switch(menu){
-	case SHOWTIME_M:
-		if (button == RIGHT_BUTTON) menu = SETTIME_M;
-		else if (button == LEFT_BUTTON) menu = SETALARM_M;
-		else if (button == ENTER_BUTTON){
-			app = SHOWTIME;
-		}
-		break;
-	case SETTIME_M:
-		if (button == RIGHT_BUTTON) menu = SETALARM_M;
-		else if (button == LEFT_BUTTON) menu = SHOWTIME_M;
-		else if (button == ENTER_BUTTON){
-			app = SETTIME;
-			TimeSetInit(&datetimeSet);
-			GetTime(&time);
-			CopyTime(&time,&timeToSet);
-		}
-		break;
-	case SETALARM_M:
-		if (button == RIGHT_BUTTON) menu = SHOWTIME_M;
-		else if (button == LEFT_BUTTON) menu = SETTIME_M;
-		else if (button == ENTER_BUTTON){
-			app = SETALARM;
-			TimeSetInit(&alarmSet);
-			InitTime(&alarmToSet);
+static void SyncCommand(uint8_t argc, char *argv[]){
+	unsigned long long value;
+	char *end;
+
+	if (argc == 1){
+		TimeSyncReport();
+		return;
+	}
+	if (app == CALIBRATION){
+		ConsoleReply("ERR busy");
+		return;
+	}
+	if (argc == 3){
+		value = strtoull(argv[2], &end, 10);
+		if (*end != '\0'){
+			ConsoleUsage();
+			return;
 		}
-		break;
-	default:
-		break;
+		TimeSyncReceived(value);
+	}
+	if (strcmp(argv[1], "SET") == 0){
+		if (TimeSyncSet()) ConsoleReply("OK");
+		else ConsoleReply("ERR rounds");
+		return;
 	}
+	value = strtoull(argv[1], &end, 10);
+	if (*end != '\0') ConsoleUsage();
+	else if (!TimeSyncRound(value, ConsoleStamp())) ConsoleReply("ERR busy");
 }
 
 /**
- * @function SetAlarmMode
- * @brief Executes all the functions for Set alarm mode this is allowing to set an alarm with minutes, hours and day of week.
- * If alarm is set, LCD displays "Alarma guardada, app and menu are sent to showtime, and alarmIsSet is set to True
- * @param currentButton: button pressed
+ * @function TelemetryCommand
+ * @brief Console command "TM": sends the period of the telemetry stream and the frames built ("TM <ms> frames=<n>",
+ * 0 ms while it is off). "TM <ms>" sets the period, "TM 0" stops it.
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void SetAlarmMode(uint16_t currentButton){
-	sprintf(timetext, "%02d:%02d",alarmToSet.Hours, alarmToSet.Minutes);
-	sprintf(datetext, "%s",dayOfWeek[alarmToSet.Day-1]);
-
-	LCD_I2C_ClearWrite(timetext, 0, 5);
-	LCD_I2C_ClearWrite(datetext, 1, 6);
+static void TelemetryCommand(uint8_t argc, char *argv[]){
+	char *end;
+	uint32_t period;
 
-	if (TimeSetUpdate(&alarmSet,&alarmToSet,currentButton)){
-		SetAlarm(&alarmToSet);
-		LCD_I2C_ClearWrite("Alarma",0,5);
-		LCD_I2C_ClearWrite("guardada.",1,4);
-		I2CDelay(1000);
-
-		app = SHOWTIME;
-		menu = SHOWTIME_M;
-		TimeSetInit(&alarmSet);
-		alarmIsSet = true;
+	if (argc == 1){
+		ConsoleReply("TM %lu frames=%lu", (unsigned long)TelemetryPeriod(), (unsigned long)TelemetryFrames());
+		return;
 	}
-
+	period = strtoul(argv[1], &end, 10);
+	if ((*end != '\0') || !TelemetryStart(period)) ConsoleUsage();
+	else ConsoleReply("OK");
 }
 
 /**
- * @function SetTimeMode
- * @brief Executes all the functions for Set Time mode this is displaying date and time, and allowing to
- * update values and set a new date and time. If a new datetime is set, LCD displays "Hora actualizada",
- * and app and menu FSM are sent to show time state
- * @param currentButton: button pressed
+ * @function TempCommand
+ * @brief Console command "TEMP": sends the last temperature and starts the dump of the temperature history.
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void SetTimeMode(uint16_t currentButton){
-
-	sprintf(timetext, "%02d:%02d:%02d",timeToSet.Hours, timeToSet.Minutes, timeToSet.Seconds);
-	sprintf(datetext, "%s %02d/%02d/%04d",dayOfWeek[timeToSet.Day-1],timeToSet.Date, timeToSet.Month, timeToSet.Year);
+static void TempCommand(uint8_t argc, char *argv[]){
+	char value[TEMPERATURE_TEXT_SIZE];
 
-	LCD_I2C_ClearWrite(timetext, 0, 4);
-	LCD_I2C_ClearWrite(datetext, 1, 1);
+	FormatTemperature(value, sizeof(value), temperature);
+	ConsoleReply("TEMP %s", value);
+	DumpTemperatureLog();
+}
 
-	if (TimeSetUpdate(&datetimeSet,&timeToSet,currentButton)){
-		SetTime(&timeToSet);
-		LCD_I2C_ClearWrite("Hora",0,6);
-		LCD_I2C_ClearWrite("actualizada.",1,2);
-		I2CDelay(1000);
+/**
+ * @function TimeCommand
+ * @brief Console command "TIME": sends the local time ("TIME yyyy-mm-dd hh:mm:ss <zone>", or "ERR time invalid").
+ * "TIME yyyy-mm-dd hh:mm:ss" sets it, in local time, as the set time screen; "ERR range" if its UTC falls out of
+ * 2000 to 2099.
+ * @param argc: number of words
+ * @param argv: words of the line
+ * @retval none
+ */
+static void TimeCommand(uint8_t argc, char *argv[]){
+	DS3231_DateTime set = {0};
+	unsigned int year, month, date, hours, minutes, seconds;
 
-		app = SHOWTIME;
-		menu = SHOWTIME_M;
-		TimeSetInit(&datetimeSet);
+	if (argc == 1){
+		if (!GetTime(&time)){
+			ConsoleReply("ERR time invalid");
+			return;
+		}
+		TzUtcToLocal(TzGetLocalZone(), &time, &set);
+		ConsoleReply("TIME %04u-%02u-%02u %02u:%02u:%02u %s", set.Year, set.Month, set.Date, set.Hours, set.Minutes,
+				set.Seconds, TzGetLabel(TzGetLocalZone()));
+		return;
 	}
-
+	if ((argc != 3) || (sscanf(argv[1], "%u-%u-%u", &year, &month, &date) != 3) ||
+			(sscanf(argv[2], "%u:%u:%u", &hours, &minutes, &seconds) != 3) || (year < YEAR_CORRECTION) ||
+			(year > YEAR_CORRECTION + 99) || (month < 1) || (month > 12) || (date < 1) ||
+			(date > DaysInMonth(month, year)) || (hours > 23) || (minutes > 59) || (seconds > 59)){
+		ConsoleUsage();
+		return;
+	}
+	set.Year = year;
+	set.Month = month;
+	set.Date = date;
+	set.Hours = hours;
+	set.Minutes = minutes;
+	set.Seconds = seconds;
+	if (!TzLocalToUtc(TzGetLocalZone(), &set, &time)){ /**< The DS3231 holds UTC; the day of week comes from the date*/
+		ConsoleReply("ERR range");
+		return;
+	}
+	SetTime(&time);
+	dirty = true;
+	ConsoleReply("OK");
 }
 
 /**
- * @function ShowOptions
- * @brief Auxiliary function to show options according to current mode
- * @param none
+ * @function TraceCommand
+ * @brief Console command "TR": sends the event trace (Tools/tracejson.py). "TR0" and "TR1" stop and start the
+ * recording, "TRR" empties the trace.
+ * @param argc: number of words
+ * @param argv: words of the line
  * @retval none
  */
-static void ShowOptions(){
-	switch(menu){
-	case SHOWTIME_M:
-		LCD_I2C_ClearWrite("1) Ver",0,5);
-		LCD_I2C_ClearWrite("fecha y hora",1,2);
-		break;
-	case SETTIME_M:
-		LCD_I2C_ClearWrite("2) Ajustar",0,2);
-		LCD_I2C_ClearWrite("hora y fecha",1,2);
-		break;
-	case SETALARM_M:
-		LCD_I2C_ClearWrite("3) Poner",0,4);
-		LCD_I2C_ClearWrite("alarma",1,5);
-		break;
-	default:
-		break;
+static void TraceCommand(uint8_t argc, char *argv[]){
+	switch (argv[0][2]){
+	case '1': TraceEnable(true); break;
+	case '0': TraceEnable(false); break;
+	case 'R': TraceClear(); break;
+	default: TraceDump(); break;
 	}
 }
 
 /**
- * @function ShowTimeMode
- * @brief Executes all the actions for the show time mode, this is displaying date, time and alarm indicator on screen.
- * @param none
- * @retval none
+ * @brief Table of commands of the console: name, words after it (fewest and most), function and usage. The short
+ * ones are those of the host tools (Tools/), which parse their replies.
  */
-static void ShowTimeMode(){
-	  GetTime(&time);
-	  uint8_t col;
-
-	  if (alarmIsSet){
-		  sprintf(timetext, "A   %02d:%02d:%02d",time.Hours, time.Minutes, time.Seconds);
-		  col = 0;
-	  }
-	  else{
-		  sprintf(timetext, "%02d:%02d:%02d",time.Hours, time.Minutes, time.Seconds);
-		  col=4;
-	  }
-
-	  sprintf(datetext, "%s %02d/%02d/%04d",dayOfWeek[time.Day-1],time.Date, time.Month, time.Year);
-
-	  LCD_I2C_ClearWrite(timetext, 0, col);
-	  LCD_I2C_ClearWrite(datetext, 1, 1);
-}
+static const consoleCmd_t commands[] = {
+	{"ALARM", 0, 3, AlarmCommand, "[SET <day> <hh:mm> | DEL] - local alarm, day 1-7 or Dom..Sab"},
+	{"BENCH", 0, 1, BenchCommand, "[<runs>] - time the drivers (cycles per call)"},
+	{"G", 0, 0, ClockCommand, "- clock governor statistics"},
+	{"G0", 0, 0, ClockCommand, "- clock governor off"},
+	{"G1", 0, 0, ClockCommand, "- clock governor on"},
+	{"GR", 0, 0, ClockCommand, "- clear the clock governor statistics"},
+	{"K", 0, 0, KernelCommand, "- task, thread, deferred work and console statistics"},
+	{"KR", 0, 0, KernelCommand, "- clear the task, thread, deferred work and console statistics"},
+	{"L", 0, 0, LatencyCommand, "- latency histograms"},
+	{"LR", 0, 0, LatencyCommand, "- clear the latency histograms"},
+	{"MB", 0, 1, ModbusCommand, "[<address>] - Modbus statistics, or start the slave (1-247)"},
+	{"MBR", 0, 0, ModbusCommand, "- clear the Modbus statistics"},
+	{"P", 0, 0, PowerCommand, "- low-power statistics"},
+	{"P0", 0, 0, PowerCommand, "- low-power mode off"},
+	{"P1", 0, 0, PowerCommand, "- low-power mode on"},
+	{"PR", 0, 0, PowerCommand, "- clear the low-power statistics"},
+	{"R0", 0, 0, RecordCommand, "- stop recording the buttons"},
+	{"R1", 0, 0, RecordCommand, "- record the buttons"},
+	{"STATS", 0, 0, StatsCommand, "- every run time statistic"},
+	{"SYNC", 0, 2, SyncCommand, "[<t1> [<t4>] | SET [<t4>]] - time sync round, or write the next host second"},
+	{"T", 1, 1, HostTimeCommand, "<ms> - host timestamp for the calibration"},
+	{"TEMP", 0, 0, TempCommand, "- temperature and its history"},
+	{"TM", 0, 1, TelemetryCommand, "[<ms>] - telemetry period, 0 to stop (at least 10 ms)"},
+	{"TIME", 0, 2, TimeCommand, "[yyyy-mm-dd hh:mm:ss] - local time"},
+	{"TR", 0, 0, TraceCommand, "- event trace"},
+	{"TR0", 0, 0, TraceCommand, "- stop the event trace"},
+	{"TR1", 0, 0, TraceCommand, "- start the event trace"},
+	{"TRR", 0, 0, TraceCommand, "- clear the event trace"}
+};
 
 /**
- * @function TimeSetInit
- * @brief Initializes the time set object to hour setting.
+ * @function UARTUpdate
+ * @brief Runs the oldest line received through USART2 on the console (see the table of commands), or serves the
+ * Modbus request received while the slave runs. One line per run: while more are waiting the task signals itself, so
+ * the tasks above it run in between. A command or a request is a burst: it runs on the fast clock.
  * @param none
  * @retval none
  */
-void TimeSetInit(datetime_t *dt){
-	*dt = HOUR_DT;
+static void UARTUpdate(void){
+	ClockHold();
+	if (ModbusAddress() != 0) ModbusUpdate();
+	else if (ConsoleUpdate()) SchedulerSignal(TASK_UART);
+	ClockRelease();
 }
 
 /**
- * @function TimeSetUpdate
- * @brief Updates the time/alarm set FSM according to buttons pressed.
- * @param dt: pointer to the datetime_t object to be analized
- * @param timeSet: pointer to the DS3231_DateTime object to be filled
- * @param button: button pressed
- * @retval boolean to indicate whether the time/alarm set is complete
- */
-bool_t TimeSetUpdate(uint16_t *dt,DS3231_DateTime *timeSet, uint16_t button){
-	uint8_t maxDay[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
-	if (CheckLeapYear(timeSet->Year)) maxDay[1] = 29;
-	SwitchCursor(&dt);
-	switch(*dt){
-	case HOUR_DT:
-		if (button == ENTER_BUTTON) *dt = MINUTE_DT;
-		else if (button == RIGHT_BUTTON){
-			if (timeSet->Hours == 23){
-				timeSet->Hours = 0;
-			}
-			else timeSet->Hours++;
-		}
-		else if (button == LEFT_BUTTON){
-			if (timeSet->Hours == 0){
-				timeSet->Hours = 23;
-			}
-			else timeSet->Hours--;
-		}
-		break;
-	case MINUTE_DT:
-		if (button == ENTER_BUTTON){
-			if (app == SETTIME) *dt = SECOND_DT;
-			if (app == SETALARM) *dt = DAY_DT;
-		}
-		else if (button == RIGHT_BUTTON){
-			if (timeSet->Minutes == 59){
-				timeSet->Minutes = 0;
-			}
-			else timeSet->Minutes++;
-		}
-		else if (button == LEFT_BUTTON){
-			if (timeSet->Minutes == 0){
-				timeSet->Minutes = 59;
-			}
-			else timeSet->Minutes--;
-		}
-		break;
-	case SECOND_DT:
-		if (button == ENTER_BUTTON) *dt = YEAR_DT;
-		else if (button == RIGHT_BUTTON){
-			if (timeSet->Seconds == 59){
-				timeSet->Seconds = 0;
-			}
-			else timeSet->Seconds++;
-		}
-		else if (button == LEFT_BUTTON){
-			if (timeSet->Seconds == 0){
-				timeSet->Seconds = 59;
-			}
-			else timeSet->Seconds--;
-		}
-		break;
-	case YEAR_DT:
-		if (button == ENTER_BUTTON) *dt = MONTH_DT;
-		else if (button == RIGHT_BUTTON){
-			if (timeSet->Year == 99){
-				timeSet->Year = 0;
-			}
-			else timeSet->Year++;
-		}
-		else if (button == LEFT_BUTTON){
-			if (timeSet->Year == 0){
-				timeSet->Year = 99;
-			}
-			else timeSet->Year--;
-		}
-		break;
-	case MONTH_DT:
-		if (button == ENTER_BUTTON) *dt = DATE_DT;
-		else if (button == RIGHT_BUTTON){
-			if (timeSet->Month == 12){
-				timeSet->Month = 1;
-			}
-			else timeSet->Month++;
-		}
-		else if (button == LEFT_BUTTON){
-			if (timeSet->Month == 1){
-				timeSet->Month = 12;
-			}
-			else timeSet->Month--;
-		}
-		break;
-	case DATE_DT:
-		if (button == ENTER_BUTTON) *dt = DAY_DT;
-		else if (button == RIGHT_BUTTON){
-			if (timeSet->Date == maxDay[(timeSet->Month)-1]){
-				timeSet->Date = 1;
-			}
-			else timeSet->Date++;
-		}
-		else if (button == LEFT_BUTTON){
-			if (timeSet->Date == 1){
-				timeSet->Date = maxDay[(timeSet->Month)-1];
-			}
-			else timeSet->Date--;
-		}
-		break;
-	case DAY_DT:
-		if (button == ENTER_BUTTON) return true;
-		else if (button == RIGHT_BUTTON){
-			if (timeSet->Day == 7){
-				timeSet->Day = 1;
-			}
-			else timeSet->Day++;
-		}
-		else if (button == LEFT_BUTTON){
-			if (timeSet->Day == 1){
-				timeSet->Day = 7;
-			}
-			else timeSet->Day--;
-		}
-		break;
-	default:
-		break;
-	}
-	return false;
-}
-
+ * @brief Table of tasks of the scheduler, indexed by appTask_t: name, function, period and deadline (ms).
+ */
+static schedTask_t tasks[TASK_COUNT] = {
+	{"input", InputTask, 0, INPUT_DEADLINE},
+	{"timers", SwTimerDispatch, 0, TIMERS_DEADLINE},
+	{"display", DisplayTask, DISPLAY_PERIOD, DISPLAY_DEADLINE},
+	{"uart", UARTUpdate, 0, UART_DEADLINE}
+};
 
 /**
  * @function AppInit
  * @brief Initializes the main app FSM. Initializes the LCD, clears the screen, initializes the menu FSM.
  * Also gets alarm from DS3231 to check whether an alarm is set. If so, turns alarmIsSet to true, to display
- * an indicator on screen. Finally, initializes the main app FSM in ShowTime mode.
+ * an indicator on screen. Finally, starts the screens (see StartScreens) and the scheduler, and creates the threads
+ * that run once the kernel starts.
  * @param none
  * @retval none
  */
 void AppInit(){
 
+	KernelSemInit(&frameLock, 1, 1);
+	KernelSemInit(&lcdWake, 0, 1);
+	KernelSemInit(&appWake, 0, 1);
+	KernelQueueInit(&buttonQueue, buttonBuffer, sizeof(buttonEvent_t), MAX_BUFFER);
 	LCD_I2C_Init();
 	I2CDelay(1000);
-	LCD_I2C_ClearWrite("",0,0);
-	LCD_I2C_ClearWrite("",1,0);
-	MenuInit();
+	ShowRow("",0,0);
+	ShowRow("",1,0);
 	GetAlarm(&alarm);
 	alarmIsSet = IsAlarmSet(&alarm);
-	app = SHOWTIME;
+	TempLogInit();
+	temperature = GetTemperature(); /**< Last automatic conversion, until the first forced one*/
+	SwTimerInit(&overlayTimer, OverlayExpired, 0, SW_TIMER_LOOP);
+	SwTimerInit(&conversionTimer, TemperatureConverted, 0, SW_TIMER_LOOP);
+	SwTimerInit(&temperatureTimer, TemperatureSample, 0, SW_TIMER_LOOP);
+	SwTimerStart(&temperatureTimer, TEMPLOG_PERIOD * 1000, TEMPLOG_PERIOD * 1000);
+	ConsoleInit(commands, sizeof(commands) / sizeof(commands[0]));
+	TelemetryInit();
+	ModbusInit(registers, REG_COUNT);
+	SwTimerInit(&modbusTimer, SlaveRefresh, 0, SW_TIMER_LOOP);
+	SwTimerInit(&dumpTimer, DumpLines, 0, SW_TIMER_LOOP);
+	TimeSyncInit();
+	ClockInit();
+	HsiTrimInit();
+	PowerInit();
+	StartScreens();
+	SchedulerInit(tasks, TASK_COUNT);
+	KernelThreadCreate(&appThread, "app", appStack, APP_STACK_WORDS, APP_PRIORITY, AppThread);
+	KernelThreadCreate(&lcdThread, "lcd", lcdStack, LCD_STACK_WORDS, LCD_PRIORITY, LcdThread);
+}
+
+/**
+ * @function ButtonPressed
+ * @brief Callback function triggered by button interruption. Adds button pressed to a queue and releases the input
+ * task, waking the application thread
+ * @param GPIO_Pin: number of pin pressed
+ * @retval none
+ */
+void ButtonPressed(uint16_t GPIO_Pin){
+	AddToQueue(GPIO_Pin);
+	SchedulerSignal(TASK_INPUT);
+	KernelSemGive(&appWake);
+}
+
+/**
+ * @function ButtonRepeated
+ * @brief Callback function called by the repeat timer of a held button. Keeps the last repeat for the input task
+ * @param GPIO_Pin: number of pin held
+ * @param stepCount: steps to advance
+ * @retval none
+ */
+void ButtonRepeated(uint16_t GPIO_Pin, uint8_t stepCount){
+	repeatButton = GPIO_Pin;
+	repeatSteps = stepCount;
+	SchedulerSignal(TASK_INPUT);
+	KernelSemGive(&appWake);
 }
 
 /**
- * @function AppUpdate
- * @brief Updates the main app FSM according to the current button pressed. It switches between modes and menu states
+ * @function KernelIdle
+ * @brief Callback function called by the idle thread. Slows the clock down if the governor allows it and stops the
+ * core if the low-power mode does
  * @param none
  * @retval none
  */
-void AppUpdate(){
-	uint16_t currentButton;
-	currentButton = GetFromQueue();
-	if (currentButton == -1) currentButton = 0;
-	switch(app){
-	case SHOWTIME:
-		if (currentButton == MENU_BUTTON) app = MENU;
-		else ShowTimeMode();
-		break;
-	case SETTIME:
-		if (currentButton == MENU_BUTTON){
-			TimeSetInit(&datetimeSet);
-			app = MENU;
-		}
-		else SetTimeMode(currentButton);
-		break;
-	case SETALARM:
-		if (currentButton == MENU_BUTTON){
-			TimeSetInit(&alarmSet);
-			app = MENU;
+void KernelIdle(void){
+	ClockIdle();
+	PowerIdle();
+}
+
+/**
+ * @function ModbusWrite
+ * @brief Callback function called by the Modbus slave to write registers. Takes the time (REG_SECONDS to REG_YEAR,
+ * UTC) and the alarm (REG_ALARM_SET to REG_ALARM_MINUTES, UTC) as whole blocks, checked as the console does, and 0 in
+ * REG_CONSOLE to stop the slave. A write whose I2C transfers fail is answered with MODBUS_DEVICE_FAILURE. The
+ * snapshot is taken again by the Modbus timer right after the reply is queued, so the reply never waits for the reads
+ * @param address: first register
+ * @param count: number of registers
+ * @param values: values of the registers
+ * @retval MODBUS_OK, or the exception code to reply
+ */
+uint8_t ModbusWrite(uint16_t address, uint16_t count, const uint16_t *values){
+	DS3231_DateTime set = {0};
+	uint32_t failures = I2CFailures();
+
+	if ((address == REG_SECONDS) && (count == REG_TIME_VALID)){
+		if ((values[REG_YEAR] < YEAR_CORRECTION) || (values[REG_YEAR] > YEAR_CORRECTION + 99) ||
+				(values[REG_MONTH] < 1) || (values[REG_MONTH] > 12) || (values[REG_DATE] < 1) ||
+				(values[REG_DATE] > DaysInMonth(values[REG_MONTH], values[REG_YEAR])) || (values[REG_HOURS] > 23) ||
+				(values[REG_MINUTES] > 59) || (values[REG_SECONDS] > 59)) return MODBUS_ILLEGAL_VALUE;
+		set.Year = values[REG_YEAR];
+		set.Month = values[REG_MONTH];
+		set.Date = values[REG_DATE];
+		set.Hours = values[REG_HOURS];
+		set.Minutes = values[REG_MINUTES];
+		set.Seconds = values[REG_SECONDS];
+		TzEpochToDateTime(TzDateTimeToEpoch(&set), &set); /**< The day of week comes from the date*/
+		SetTime(&set);
+	}
+	else if ((address == REG_ALARM_SET) && (count == REG_UPTIME - REG_ALARM_SET)){
+		if ((values[0] > 1) || ((values[0] == 1) && ((values[1] < FIRST_DAY) || (values[1] > LAST_DAY) ||
+				(values[2] > 23) || (values[3] > 59)))) return MODBUS_ILLEGAL_VALUE;
+		if (values[0] == 1){ /**< Set flag, day, hours, minutes*/
+			set.Day = values[1];
+			set.Hours = values[2];
+			set.Minutes = values[3];
 		}
-		else SetAlarmMode(currentButton);
-		break;
-	case MENU:
-		MenuUpdate(currentButton);
-		break;
-	default:
-		break;
+		SetAlarm(&set); /**< Day 0 never matches: IsAlarmSet reads it as no alarm*/
+		if (I2CFailures() == failures) alarmIsSet = (values[0] == 1);
+	}
+	else if ((address == REG_CONSOLE) && (count == 1)){
+		if (values[0] != 0) return MODBUS_ILLEGAL_VALUE;
+		SlaveStop();
+		return MODBUS_OK;
 	}
+	else return MODBUS_ILLEGAL_ADDRESS;
+	dirty = true;
+	SwTimerStart(&modbusTimer, 1, MODBUS_REFRESH);
+	return (I2CFailures() == failures) ? MODBUS_OK : MODBUS_DEVICE_FAILURE;
 }
 
 /**
- * @function ButtonPressed
- * @brief Callback function triggered by button interruption. Adds button pressed to a queue
- * @param GPIO_Pin: number of pin pressed
+ * @function PowerSecond
+ * @brief Callback function called at every SQW edge in the low-power mode. Releases the display task for the new
+ * second
+ * @param none
  * @retval none
  */
-void ButtonPressed(uint16_t GPIO_Pin){
-	AddToQueue(GPIO_Pin);
+void PowerSecond(void){
+	SchedulerSignal(TASK_DISPLAY);
+	KernelSemGive(&appWake);
 }
 
 /**
- * @function SwitchCursor
- * @brief Switches cursor according to the state of the time/alarm set FSM
- * @param dt: pointer to the timeset object to be analized
+ * @function SwTimerExpired
+ * @brief Callback function called by the tick interrupt when a software timer expires. Releases the timers task
+ * @param none
  * @retval none
  */
-void SwitchCursor(uint16_t *dt){
-	switch(*dt){
-	case HOUR_DT:
-		if (app == SETTIME) LCD_I2C_SetCursor(0,3);
-		else LCD_I2C_SetCursor(0,4);
-		break;
-	case MINUTE_DT:
-		if (app == SETTIME) LCD_I2C_SetCursor(0,6);
-		else LCD_I2C_SetCursor(0,7);
-		break;
-	case SECOND_DT: LCD_I2C_SetCursor(0,9); break;
-	case DAY_DT:
-		if (app == SETTIME) LCD_I2C_SetCursor(1,0);
-		else LCD_I2C_SetCursor(1,5);
-		break;
-	case DATE_DT: LCD_I2C_SetCursor(1,4); break;
-	case MONTH_DT: LCD_I2C_SetCursor(1,7); break;
-	case YEAR_DT: LCD_I2C_SetCursor(1,10); break;
+void SwTimerExpired(void){
+	SchedulerSignal(TASK_TIMERS);
+	KernelSemGive(&appWake);
+}
+
+/**
+ * @function TelemetrySample
+ * @brief Callback function called while a telemetry frame is built. Fills the fields of the application: the time
+ * last read if valid (without reading the DS3231 again), the last temperature, the button events waiting and the
+ * modes on
+ * @param frame: frame being built
+ * @retval none
+ */
+void TelemetrySample(telemetryFrame_t *frame){
+	if (GetTimeValidity() == TIME_VALID){ /**< An invalid time may be out of range: the epoch stays 0*/
+		frame->epoch = TzDateTimeToEpoch(&time);
+		frame->flags |= TELEMETRY_TIME_VALID;
 	}
+	frame->temperature = temperature;
+	frame->buttonQueue = KernelQueueCount(&buttonQueue);
+	if (PowerEnabled()) frame->flags |= TELEMETRY_LOW_POWER;
+	if (ClockEnabled()) frame->flags |= TELEMETRY_CLOCK_GOV;
+}
+
+/**
+ * @function TimeSyncWritten
+ * @brief Callback function called by the time synchronization after it writes the DS3231. Refreshes the screen
+ * @param none
+ * @retval none
+ */
+void TimeSyncWritten(void){
+	dirty = true;
+}
+
+/**
+ * @function UARTFrameReceived
+ * @brief Callback function called by the TIM7 interrupt when a Modbus request is received. Releases the UART task
+ * @param none
+ * @retval none
+ */
+void UARTFrameReceived(void){
+	SchedulerSignal(TASK_UART);
+	KernelSemGive(&appWake);
+}
+
+/**
+ * @function UARTLineReceived
+ * @brief Callback function called by the USART2 interrupt when a line is received. Releases the UART task and keeps
+ * the core running for the next command
+ * @param none
+ * @retval none
+ */
+void UARTLineReceived(void){
+	SchedulerSignal(TASK_UART);
+	PowerKeepAwake(POWER_RX_AWAKE);
+	KernelSemGive(&appWake);
 }
@@ -0,0 +1,43 @@
+/**
+ * @file appFsm.c
+ * @brief Transition tables of the application FSM.
+ *
+ * Generated by Tools/fsmgen.py from Tools/appfsm.txt. Do not edit.
+ */
+#include "appFsm.h"
+
+#include "ds3231.h"
+
+#include <stddef.h>
+
+const appScreen_t appScreens[APP_SCREEN_COUNT] = {
+	{ShowTimeMode, NULL, NULL, APP_FIELD_NONE},	/* SHOWTIME */
+	{SetTimeMode, SetTimeEnter, NULL, 0},	/* SETTIME */
+	{SetAlarmMode, SetAlarmEnter, NULL, 7},	/* SETALARM */
+	{MultiZoneMode, MultiZoneEnter, NULL, APP_FIELD_NONE},	/* MULTIZONE */
+	{TemperatureMode, NULL, NULL, APP_FIELD_NONE},	/* TEMPERATURE */
+	{CalibrationMode, AgingCalStart, AgingCalStop, APP_FIELD_NONE},	/* CALIBRATION */
+	{MenuUpdate, NULL, NULL, APP_FIELD_NONE},	/* MENU */
+};
+
+const appMenuEntry_t appMenu[APP_MENU_COUNT] = {
+	{{"1) Ver", "fecha y hora"}, {5, 2}, SHOWTIME, SETTIME_M, CALIBRATION_M},
+	{{"2) Ajustar", "hora y fecha"}, {2, 2}, SETTIME, SETALARM_M, SHOWTIME_M},
+	{{"3) Poner", "alarma"}, {4, 5}, SETALARM, MULTIZONE_M, SETTIME_M},
+	{{"4) Ver zonas", "horarias"}, {2, 4}, MULTIZONE, TEMPERATURE_M, SETALARM_M},
+	{{"5) Ver", "temperatura"}, {5, 2}, TEMPERATURE, CALIBRATION_M, MULTIZONE_M},
+	{{"6) Calibrar", "reloj (aging)"}, {2, 1}, CALIBRATION, SHOWTIME_M, TEMPERATURE_M},
+};
+
+const appField_t appFields[APP_FIELD_COUNT] = {
+	{offsetof(DS3231_DateTime, Hours), 1, 0, 23, 1, 0, 3, 1},	/* 0: SETTIME */
+	{offsetof(DS3231_DateTime, Minutes), 1, 0, 59, 1, 0, 6, 2},	/* 1: SETTIME */
+	{offsetof(DS3231_DateTime, Seconds), 1, 0, 59, 1, 0, 9, 3},	/* 2: SETTIME */
+	{offsetof(DS3231_DateTime, Year), 2, 2000, 2099, 1, 1, 10, 4},	/* 3: SETTIME */
+	{offsetof(DS3231_DateTime, Month), 1, 1, 12, 1, 1, 7, 5},	/* 4: SETTIME */
+	{offsetof(DS3231_DateTime, Date), 1, 1, APP_FIELD_MDAYS, 1, 1, 4, 6},	/* 5: SETTIME */
+	{offsetof(DS3231_DateTime, Day), 1, 1, 7, 1, 1, 0, APP_FIELD_NONE},	/* 6: SETTIME */
+	{offsetof(DS3231_DateTime, Hours), 1, 0, 23, 1, 0, 4, 8},	/* 7: SETALARM */
+	{offsetof(DS3231_DateTime, Minutes), 1, 0, 59, 1, 0, 7, 9},	/* 8: SETALARM */
+	{offsetof(DS3231_DateTime, Day), 1, 1, 7, 1, 1, 5, APP_FIELD_NONE},	/* 9: SETALARM */
+};
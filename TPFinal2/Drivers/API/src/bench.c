@@ -0,0 +1,62 @@
+/**
+ * @file bench.c
+ * @brief Implementation of the microbenchmarks of the drivers.
+ *
+ * Contains the function definitions declared in bench.h.
+ * Every call is timed alone, between two reads of the cycle counter, so the
+ * interrupts that hit a call only raise its maximum.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "bench.h"
+
+/**
+ * @brief Empty case: its fewest cycles are the cost of the measurement.
+ */
+static void Empty(void){
+}
+
+/**
+ * @brief Calls a case the given times. Returns the fewest cycles and fills the total and the most.
+ */
+static uint32_t Measure(void (*run)(void), uint16_t runs, uint32_t overhead, uint64_t *total, uint32_t *most){
+	uint32_t start, cycles, fewest = UINT32_MAX;
+
+	*total = 0;
+	*most = 0;
+	for (uint16_t i = 0; i < runs; i++){
+		start = CyclesNow();
+		run();
+		cycles = CyclesNow() - start;
+		cycles = (cycles > overhead) ? (cycles - overhead) : 0;
+		*total += cycles;
+		if (cycles < fewest) fewest = cycles;
+		if (cycles > *most) *most = cycles;
+	}
+	return fewest;
+}
+
+/*Times the cases. Declared in header file*/
+void BenchRun(const benchCase_t *table, uint8_t count, uint16_t runs){
+	uint64_t total;
+	uint32_t overhead, fewest, most, average, micros;
+
+	if ((runs == 0) || (runs > BENCH_MAX_RUNS)) return;
+	PowerHold(); /**< The cycle counter stops with the core*/
+	ClockHold();
+	overhead = Measure(Empty, runs, 0, &total, &most);
+	ConsoleReply("BENCH START clock=%lu overhead=%lu runs=%u", (unsigned long)SystemCoreClock, (unsigned long)overhead,
+			runs);
+	for (uint8_t i = 0; i < count; i++){
+		fewest = Measure(table[i].run, runs, overhead, &total, &most);
+		average = (uint32_t)(total / runs);
+		micros = (uint32_t)((uint64_t)average * 1000000 / SystemCoreClock); /**< Exact at any clock, unlike CYCLES_PER_US*/
+		ConsoleReply("BENCH %s runs=%u min=%lu avg=%lu max=%lu us=%lu", table[i].name, runs, (unsigned long)fewest,
+				(unsigned long)average, (unsigned long)most, (unsigned long)micros);
+	}
+	ConsoleReply("BENCH END");
+	ClockRelease();
+	PowerRelease();
+}
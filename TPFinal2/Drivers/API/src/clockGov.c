@@ -0,0 +1,169 @@
+/**
+ * @file clockGov.c
+ * @brief Implementation of the clock governor.
+ *
+ * Contains the function definitions declared in clockGov.h.
+ * Both switches take the I2C bus first, so no transfer runs at the old timing: a ramp
+ * up waits for it, the idle thread only tries it. The time in each mode is charged from
+ * the cycle counter at the rate of the mode, every time the core is idle and at every
+ * switch; a ramp up is charged to the fast mode.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "clockGov.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Flag to check whether the governor is on.
+ */
+static bool_t enabled;
+
+/**
+ * @brief Holds of the fast mode (ClockHold).
+ */
+static uint8_t holds;
+
+/**
+ * @brief Cycle counter when the time was last charged.
+ */
+static uint32_t chargeCycles;
+
+/**
+ * @brief Statistics: time in each mode (us), switches, ramps up, their worst and total time (us).
+ */
+static uint64_t fastMicros, slowMicros, rampTotal;
+static uint32_t switches, ramps, rampMax;
+
+/**
+ * @brief Charges the time since the last charge to the current mode. Interrupts masked.
+ */
+static void Charge(void){
+	uint32_t now = CyclesNow();
+	uint32_t micros = CyclesToMicros(now - chargeCycles);
+
+	if (ClockPortMode() == CLOCK_MODE_FAST) fastMicros += micros;
+	else slowMicros += micros;
+	chargeCycles = now;
+}
+
+/**
+ * @brief Switches to the fast mode if the clock is slow. Threads only.
+ */
+static void RampUp(void){
+	uint32_t mask, time;
+
+	if (ClockPortMode() == CLOCK_MODE_FAST) return;
+	I2CLock(KERNEL_FOREVER);
+	if (ClockPortMode() == CLOCK_MODE_SLOW){ /**< Another thread may have ramped it up meanwhile*/
+		mask = __get_PRIMASK();
+		__disable_irq();
+		Charge();
+		__set_PRIMASK(mask);
+		time = ClockPortSet(CLOCK_MODE_FAST);
+		I2CRetime();
+		TRACE_POINT(TRACE_CLOCK, (SystemCoreClock + 500000) / 1000000);
+		mask = __get_PRIMASK();
+		__disable_irq();
+		chargeCycles = CyclesNow();
+		fastMicros += time;
+		switches++;
+		ramps++;
+		rampTotal += time;
+		if (time > rampMax) rampMax = time;
+		__set_PRIMASK(mask);
+	}
+	I2CUnlock();
+}
+
+/*Turns the governor on or off. Declared in header file*/
+void ClockEnable(bool_t enable){
+	enabled = enable;
+	if (!enable) RampUp();
+}
+
+/*Checks whether the governor is on. Declared in header file*/
+bool_t ClockEnabled(void){
+	return enabled;
+}
+
+/*Keeps the fast mode. Declared in header file*/
+void ClockHold(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	holds++;
+	__set_PRIMASK(mask);
+	RampUp();
+}
+
+/*Slows the clock down if nothing needs it. Declared in header file*/
+void ClockIdle(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	Charge();
+	if (enabled && (holds == 0) && (ClockPortMode() == CLOCK_MODE_FAST) &&
+			((HAL_GetTick() - UARTRxTick()) >= CLOCK_RX_QUIET) && I2CLock(0)){
+		ClockPortSet(CLOCK_MODE_SLOW);
+		I2CRetime();
+		TRACE_POINT(TRACE_CLOCK, (SystemCoreClock + 500000) / 1000000);
+		I2CUnlock();
+		chargeCycles = CyclesNow(); /**< The few cycles of the switch are not charged*/
+		switches++;
+	}
+	__set_PRIMASK(mask);
+}
+
+/*Initializes the governor. Declared in header file*/
+void ClockInit(void){
+	ClockPortInit();
+	ClockResetStats();
+}
+
+/*Ends a hold. Declared in header file*/
+void ClockRelease(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	if (holds > 0) holds--;
+	__set_PRIMASK(mask);
+}
+
+/*Sends the statistics. Declared in header file*/
+void ClockReport(void){
+	char line[192];
+	uint64_t fast, slow, total;
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	Charge();
+	fast = fastMicros;
+	slow = slowMicros;
+	__set_PRIMASK(mask);
+	total = fast + slow;
+	if (total == 0) total = 1;
+	sprintf(line, "clock mode=%s fast=%lums slow=%lums switches=%lu ramp=%luus max=%luus power=%luuW fixed72=%luuW\r\n",
+			enabled ? "gov" : "fixed", (unsigned long)(fast / 1000), (unsigned long)(slow / 1000),
+			(unsigned long)switches, (unsigned long)(ramps ? rampTotal / ramps : 0), (unsigned long)rampMax,
+			(unsigned long)((fast * CLOCK_FAST_UA + slow * CLOCK_SLOW_UA) / total * CLOCK_SUPPLY_MV / 1000),
+			(unsigned long)((uint32_t)CLOCK_FAST_UA * CLOCK_SUPPLY_MV / 1000));
+	UARTSendString(line);
+}
+
+/*Clears the statistics. Declared in header file*/
+void ClockResetStats(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	fastMicros = 0;
+	slowMicros = 0;
+	rampTotal = 0;
+	switches = 0;
+	ramps = 0;
+	rampMax = 0;
+	chargeCycles = CyclesNow();
+	__set_PRIMASK(mask);
+}
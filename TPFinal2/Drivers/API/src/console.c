@@ -0,0 +1,167 @@
+/**
+ * @file console.c
+ * @brief Implementation of the command console on USART2.
+ *
+ * Contains the function definitions declared in console.h.
+ * The line is run straight from its slot of the reception queue, which is freed only
+ * once the command returns.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "console.h"
+
+/**
+ * @brief Includes the trace of the commands.
+ */
+#include "trace.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Table of commands and its size.
+ */
+static const consoleCmd_t *commands;
+static uint8_t commandCount;
+
+/**
+ * @brief Command being run and the stamp of its line.
+ */
+static const consoleCmd_t *running;
+static uint32_t lineStamp;
+
+/**
+ * @brief Statistics: lines run, errors, longest queue and longest run (cycles).
+ */
+static uint32_t linesRun, errors, worstCycles;
+static uint8_t worstQueue;
+
+/**
+ * @brief Looks a command up by its name. Returns NULL if there is none.
+ */
+static const consoleCmd_t *FindCommand(const char *name){
+	for (uint8_t i = 0; i < commandCount; i++){
+		if (strcmp(commands[i].name, name) == 0) return &commands[i];
+	}
+	return NULL;
+}
+
+/**
+ * @brief Splits a line and runs its command.
+ */
+static void RunLine(char *line){
+	char *argv[CONSOLE_MAX_ARGS];
+	uint8_t argc = ConsoleTokenize(line, argv, CONSOLE_MAX_ARGS);
+	const consoleCmd_t *command;
+
+	if (argc == 0) return;
+	linesRun++;
+	if ((strcmp(argv[0], "HELP") == 0) && (argc == 1)){
+		for (uint8_t i = 0; i < commandCount; i++) ConsoleReply("%s %s", commands[i].name, commands[i].usage);
+		return;
+	}
+	command = FindCommand(argv[0]);
+	if (command == NULL){
+		errors++;
+		ConsoleReply("ERR unknown %s", argv[0]);
+		return;
+	}
+	running = command;
+	if ((argc > CONSOLE_MAX_ARGS) || (argc - 1 < command->minArgs) || (argc - 1 > command->maxArgs)) ConsoleUsage();
+	else{
+		TRACE_SPAN_BEGIN(TRACE_COMMAND, command - commands);
+		command->run(argc, argv);
+		TRACE_SPAN_END(TRACE_COMMAND, command - commands);
+	}
+	running = NULL;
+}
+
+/*Gets the name of a command. Declared in header file*/
+const char *ConsoleCommandName(uint8_t command){
+	return (command < commandCount) ? commands[command].name : NULL;
+}
+
+/*Takes the table of commands. Declared in header file*/
+void ConsoleInit(const consoleCmd_t *table, uint8_t count){
+	commands = table;
+	commandCount = count;
+	ConsoleResetStats();
+}
+
+/*Sends a reply line. Declared in header file*/
+void ConsoleReply(const char *format, ...){
+	char line[CONSOLE_REPLY_SIZE];
+	va_list args;
+	int length;
+
+	va_start(args, format);
+	length = vsnprintf(line, CONSOLE_REPLY_SIZE - 2, format, args);
+	va_end(args);
+	if (length < 0) return;
+	if (length > CONSOLE_REPLY_SIZE - 3) length = CONSOLE_REPLY_SIZE - 3; /**< Cut: the line end still fits*/
+	strcpy(&line[length], "\r\n");
+	UARTSendString(line);
+}
+
+/*Sends the statistics. Declared in header file*/
+void ConsoleReport(void){
+	ConsoleReply("console lines=%lu errors=%lu dropped=%lu rxerr=%lu txdrop=%luB queue=%u/%u wcet=%luus",
+			(unsigned long)linesRun, (unsigned long)errors, (unsigned long)UARTLinesDropped(),
+			(unsigned long)UARTRxErrors(), (unsigned long)UARTTxDropped(), worstQueue, UART_LINE_SLOTS,
+			(unsigned long)CyclesToMicros(worstCycles));
+}
+
+/*Clears the statistics. Declared in header file*/
+void ConsoleResetStats(void){
+	linesRun = 0;
+	errors = 0;
+	worstCycles = 0;
+	worstQueue = 0;
+	UARTResetStats();
+}
+
+/*Gets the stamp of the line being run. Declared in header file*/
+uint32_t ConsoleStamp(void){
+	return lineStamp;
+}
+
+/*Splits a line into words. Declared in header file*/
+uint8_t ConsoleTokenize(char *line, char *argv[], uint8_t max){
+	uint8_t argc = 0;
+
+	for (;;){
+		while (*line == ' ') line++;
+		if (*line == '\0') return argc;
+		if (argc < max) argv[argc] = line;
+		argc++;
+		while ((*line != ' ') && (*line != '\0')) line++;
+		if (*line == '\0') return argc;
+		*line++ = '\0';
+	}
+}
+
+/*Rejects the arguments of the command being run. Declared in header file*/
+void ConsoleUsage(void){
+	if (running == NULL) return;
+	errors++;
+	ConsoleReply("ERR usage: %s %s", running->name, running->usage);
+}
+
+/*Runs the oldest line. Declared in header file*/
+bool_t ConsoleUpdate(void){
+	uint8_t queued = UARTLineCount();
+	char *line = UARTLineGet(&lineStamp);
+	uint32_t start, cycles;
+
+	if (line == NULL) return false;
+	if (queued > worstQueue) worstQueue = queued;
+	start = CyclesNow();
+	RunLine(line);
+	cycles = CyclesNow() - start;
+	if (cycles > worstCycles) worstCycles = cycles;
+	UARTLineFree();
+	return (UARTLineCount() > 0);
+}
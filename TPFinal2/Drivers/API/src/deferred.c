@@ -0,0 +1,115 @@
+/**
+ * @file deferred.c
+ * @brief Implementation of the deferred interrupt work.
+ *
+ * Contains the function definitions declared in deferred.h.
+ * Any interrupt can post, so a post masks the interrupts while it takes its place in
+ * the queue. Only PendSV takes events out: it copies the oldest one before freeing
+ * its place, and a post never writes a place that is not free, so it needs no mask.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "deferred.h"
+
+/**
+ * @brief Includes the function that requests PendSV.
+ */
+#include "portKernel.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Event waiting in the queue.
+ */
+typedef struct{
+	deferredHandler_t handler;
+	uint32_t arg;
+	uint32_t stamp;
+} deferredEvent_t;
+
+/**
+ * @brief Queue of events. head and tail count without wrapping, the place is taken modulo DEFERRED_QUEUE.
+ */
+static deferredEvent_t events[DEFERRED_QUEUE];
+static volatile uint32_t head, tail;
+
+/**
+ * @brief Statistics: events posted and dropped, batches run and largest one, longest wait (cycles).
+ */
+static uint32_t posts, drops, batches, batchMax, waitMax;
+
+/**
+ * @brief Cycle counter at the last SysTick and largest deviation of its period (cycles).
+ */
+static uint32_t tickStamp, tickJitter;
+
+/*Queues an event. Declared in header file*/
+void DeferredPost(deferredHandler_t handler, uint32_t arg){
+	uint32_t stamp = CyclesNow(); /**< First thing: the handler gets when the interrupt happened*/
+	uint32_t mask = __get_PRIMASK();
+	deferredEvent_t *event;
+
+	__disable_irq();
+	if (tail - head == DEFERRED_QUEUE) drops++;
+	else{
+		event = &events[tail % DEFERRED_QUEUE];
+		event->handler = handler;
+		event->arg = arg;
+		event->stamp = stamp;
+		tail++;
+		posts++;
+	}
+	__set_PRIMASK(mask);
+	KernelPortSwitch();
+}
+
+/*Sends the statistics. Declared in header file*/
+void DeferredReport(void){
+	char line[128];
+
+	snprintf(line, sizeof(line), "defer posts=%lu drops=%lu batches=%lu batch=%lu wait=%luus tick=%luus\r\n",
+			(unsigned long)posts, (unsigned long)drops, (unsigned long)batches, (unsigned long)batchMax,
+			(unsigned long)CyclesToMicros(waitMax), (unsigned long)CyclesToMicros(tickJitter));
+	UARTSendString(line);
+}
+
+/*Clears the statistics. Declared in header file*/
+void DeferredResetStats(void){
+	posts = 0;
+	drops = 0;
+	batches = 0;
+	batchMax = 0;
+	waitMax = 0;
+	tickJitter = 0;
+}
+
+/*Runs the handlers of the events queued. Declared in header file*/
+void DeferredRun(void){
+	deferredEvent_t event;
+	uint32_t batch = 0, wait;
+
+	while (head != tail){
+		event = events[head % DEFERRED_QUEUE];
+		head++; /**< Frees the place only once it is copied*/
+		wait = CyclesNow() - event.stamp;
+		if (wait > waitMax) waitMax = wait;
+		event.handler(event.arg, event.stamp);
+		batch++;
+	}
+	if (batch == 0) return;
+	batches++;
+	if (batch > batchMax) batchMax = batch;
+}
+
+/*Measures the period of the SysTick interrupt. Declared in header file*/
+void DeferredTick(void){
+	uint32_t now = CyclesNow();
+	uint32_t period = now - tickStamp;
+	uint32_t nominal = SystemCoreClock / 1000;
+	uint32_t deviation = (period > nominal) ? period - nominal : nominal - period;
+
+	if ((tickStamp != 0) && (deviation > tickJitter) && (deviation < nominal)) tickJitter = deviation; /**< A whole period off is a stop in the debugger, not jitter*/
+	tickStamp = now;
+}
@@ -12,6 +12,27 @@
  */
 #include "ds3231.h"
 
+/**
+ * @brief Validity of the time found by the last GetTime.
+ */
+static DS3231_Validity validity = TIME_UNKNOWN;
+
+/**
+ * @brief Checks that the time registers hold BCD values in range. After a power loss or with a faulty bus
+ * they may not.
+ */
+static bool TimeInRange(DS3231_DateTime *time, uint8_t *registers){
+    uint8_t i;
+
+    for (i = 0; i < TIME_SIZE-1; i++){
+        if ((registers[i] & LOW_NIBBLE_MASK) > 9) return false;
+    }
+    return (time->Seconds < 60) && (time->Minutes < 60) && (time->Hours < 24)
+            && (time->Day >= FIRST_DAY) && (time->Day <= LAST_DAY)
+            && (time->Date >= FIRST) && (time->Date <= 31)
+            && (time->Month >= JANUARY) && (time->Month <= 12);
+}
+
 /*Convert a BCD-encoded value to decimal. Declared in header file*/
 uint8_t BcdToDec(uint8_t val) {
     return ((val >> NIBBLE_SIZE) * 10) + (val & LOW_NIBBLE_MASK); /**< Not necessary to consider special cases because of the solution addressed*/
@@ -33,6 +54,14 @@ uint8_t DecToBcd(uint8_t val) {
     return ((val / 10) << NIBBLE_SIZE) | (val % 10); /**< Not necessary to consider special cases because of the solution addressed*/
 }
 
+/*Gets the aging offset of the DS3231 RTC. Declared in header file*/
+int8_t GetAgingOffset(void){
+    uint8_t buffer;
+    I2CReadMemory(AGING_REGISTER,DS3231_ADDR,&buffer,1);
+
+    return (int8_t)buffer;
+}
+
 /*Gets the alarm from the DS3231 RTC. Declared in header file*/
 void GetAlarm(DS3231_DateTime *time) {
     uint8_t buffer[ALARM_SIZE-1]; /**< In this case, it is not necessary to indicate start register in the data to transmit cause MemRead is used*/
@@ -43,10 +72,20 @@ void GetAlarm(DS3231_DateTime *time) {
     time->Day   = BcdToDec(buffer[2] & LOW_NIBBLE_MASK);  /**< Implemented only in Day of the week alarm mode*/
 }
 
+/*Gets the last temperature converted by the DS3231 RTC. Declared in header file*/
+int16_t GetTemperature(void){
+    uint8_t buffer[TEMPERATURE_SIZE];
+    I2CReadMemory(TEMPERATURE_REGISTER,DS3231_ADDR,buffer,TEMPERATURE_SIZE);
+
+    return (int16_t)(((int8_t)buffer[0]) * 4) + (buffer[1] >> TEMPERATURE_FRACTION_SHIFT); /**< Integer part is two's complement, the fraction adds 0 to 3 quarters*/
+}
+
 /*Gets the time from the DS3231 RTC. Declared in header file*/
-void GetTime(DS3231_DateTime *time) {
-    uint8_t buffer[TIME_SIZE-1]; /**< In this case, it is not necesary to indicate start register in the data to transmit cause MemRead is used*/
-    I2CReadMemory(TIME_START_REGISTER,DS3231_ADDR,buffer,TIME_SIZE-1);
+bool GetTime(DS3231_DateTime *time) {
+    uint8_t snapshot[SNAPSHOT_SIZE]; /**< Status register first, the pointer wraps around to the time registers*/
+    uint8_t *buffer = &snapshot[SNAPSHOT_TIME_INDEX];
+    TRACE_SPAN_BEGIN(TRACE_GET_TIME, 0);
+    I2CReadMemory(STATUS_REGISTER,DS3231_ADDR,snapshot,SNAPSHOT_SIZE);
 
     time->Seconds = BcdToDec(buffer[0]);
     time->Minutes = BcdToDec(buffer[1]);
@@ -55,6 +94,18 @@ void GetTime(DS3231_DateTime *time) {
     time->Date    = BcdToDec(buffer[4]);
     time->Month   = BcdToDec(buffer[5] & CENTURY_MASK); /**< Cleans the MSB that is associated to the century change*/
     time->Year    = YEAR_CORRECTION + BcdToDec(buffer[6]);
+
+    if (snapshot[0] & OSF_BIT) validity = TIME_STOPPED; /**< OSF stays set until SetTime, so a reset does not hide it*/
+    else if (!TimeInRange(time, buffer)) validity = TIME_CORRUPT;
+    else validity = TIME_VALID;
+
+    TRACE_SPAN_END(TRACE_GET_TIME, validity);
+    return (validity == TIME_VALID);
+}
+
+/*Gets the validity of the last time read. Declared in header file*/
+DS3231_Validity GetTimeValidity(void){
+    return validity;
 }
 
 /*Initializes a time struct. Declared in header file*/
@@ -68,11 +119,41 @@ void InitTime(DS3231_DateTime *time){
 	time->Year = YEAR_CORRECTION + BcdToDec(Y2K);
 }
 
+/*Checks whether a temperature conversion is running. Declared in header file*/
+bool IsConversionBusy(void){
+    uint8_t buffer[2]; /**< Control and status registers are consecutive, so one read gets both*/
+    I2CReadMemory(CONTROL_REGISTER,DS3231_ADDR,buffer,2);
+
+    return ((buffer[0] & CONV_BIT) || (buffer[1] & BSY_BIT));
+}
+
 /*Checks whether there is an alarm set to the DS3231 RTC. Declared in header file*/
 bool IsAlarmSet(DS3231_DateTime *alarm) {
     return ((alarm->Day >= FIRST_DAY)&&(alarm->Day <= LAST_DAY)); /**< If alarm is set, Day byte varies from 1 to 7. Otherwise, no alarm is set*/
 }
 
+/*Enables or disables the 32kHz output of the DS3231 RTC. Declared in header file*/
+void Set32kHzOutput(bool enable){
+    uint8_t buffer[REGISTER_WRITE_SIZE];
+    I2CReadMemory(STATUS_REGISTER,DS3231_ADDR,&buffer[1],1);
+
+    buffer[0] = STATUS_REGISTER;
+    if (enable) buffer[1] |= EN32KHZ_BIT; /**< Flags are cleared by writing 0, so writing back the ones read keeps them*/
+    else buffer[1] &= ~EN32KHZ_BIT;
+    I2CMasterTransmit(DS3231_ADDR, buffer, REGISTER_WRITE_SIZE);
+}
+
+/*Sets the aging offset of the DS3231 RTC. Declared in header file*/
+void SetAgingOffset(int8_t offset){
+    uint8_t buffer[REGISTER_WRITE_SIZE];
+
+    buffer[0] = AGING_REGISTER;
+    buffer[1] = (uint8_t)offset;
+    I2CMasterTransmit(DS3231_ADDR, buffer, REGISTER_WRITE_SIZE);
+
+    StartConversion(); /**< The new capacitance is loaded on the next conversion. If one is running, it loads it*/
+}
+
 /*Sets the alarm of the DS3231 RTC. Declared in header file*/
 void SetAlarm(DS3231_DateTime *time){
 	uint8_t buffer[ALARM_SIZE];
@@ -85,6 +166,17 @@ void SetAlarm(DS3231_DateTime *time){
 	I2CMasterTransmit(DS3231_ADDR, buffer, ALARM_SIZE);
 }
 
+/*Selects the function of the INT/SQW pin. Declared in header file*/
+void SetSquareWave(bool enable){
+    uint8_t buffer[REGISTER_WRITE_SIZE];
+    I2CReadMemory(CONTROL_REGISTER,DS3231_ADDR,&buffer[1],1);
+
+    buffer[0] = CONTROL_REGISTER;
+    if (enable) buffer[1] &= ~(INTCN_BIT | RATE_SELECT_MASK);
+    else buffer[1] |= INTCN_BIT;
+    I2CMasterTransmit(DS3231_ADDR, buffer, REGISTER_WRITE_SIZE);
+}
+
 /*Sets the time of the DS3231 RTC. Declared in header file*/
 void SetTime(DS3231_DateTime *time) {
     uint8_t buffer[TIME_SIZE];
@@ -99,4 +191,26 @@ void SetTime(DS3231_DateTime *time) {
     buffer[7] = DecToBcd(time->Year - YEAR_CORRECTION);
 
     I2CMasterTransmit(DS3231_ADDR, buffer, TIME_SIZE);
+
+    I2CReadMemory(STATUS_REGISTER,DS3231_ADDR,&buffer[1],1);
+    if (buffer[1] & OSF_BIT){
+        buffer[0] = STATUS_REGISTER;
+        buffer[1] &= ~OSF_BIT; /**< Flags are cleared by writing 0, so writing back the other ones read keeps them*/
+        I2CMasterTransmit(DS3231_ADDR, buffer, REGISTER_WRITE_SIZE);
+    }
+    validity = TIME_UNKNOWN; /**< Known again on the next GetTime*/
+}
+
+/*Forces a temperature conversion of the DS3231 RTC. Declared in header file*/
+bool StartConversion(void){
+    uint8_t buffer[REGISTER_WRITE_SIZE];
+    uint8_t registers[2];
+    I2CReadMemory(CONTROL_REGISTER,DS3231_ADDR,registers,2);
+
+    if ((registers[0] & CONV_BIT) || (registers[1] & BSY_BIT)) return false; /**< Datasheet: CONV must not be set while BSY is set*/
+
+    buffer[0] = CONTROL_REGISTER;
+    buffer[1] = registers[0] | CONV_BIT; /**< Keeps the rest of the control register as it is*/
+    I2CMasterTransmit(DS3231_ADDR, buffer, REGISTER_WRITE_SIZE);
+    return true;
 }
@@ -0,0 +1,193 @@
+/**
+ * @file hsiTrim.c
+ * @brief Implementation of the HSI trimming service.
+ *
+ * Contains the function definitions declared in hsiTrim.h.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "hsiTrim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief States of the service.
+ */
+typedef enum{
+	TRIM_MEASURING,
+	TRIM_WAITING
+} trimState_t;
+
+/**
+ * @brief Current state.
+ */
+static trimState_t state;
+
+/**
+ * @brief Timer of the window or of the wait between measurements.
+ */
+static swTimer_t trimTimer;
+
+/**
+ * @brief System clock the firmware was built for (72 MHz).
+ */
+static uint32_t nominalClock;
+
+/**
+ * @brief Error (ppm) of the last measurement.
+ */
+static int32_t lastError;
+
+/**
+ * @brief Error (ppm) of the previous measurement and its trim, to see whether the last step helped.
+ */
+static int32_t previousError;
+static uint8_t previousTrim;
+static bool_t previousValid;
+
+/**
+ * @brief Flag to check whether the best trim was found. Then only the software correction is refreshed.
+ */
+static bool_t locked;
+
+/**
+ * @brief Error change (ppm) of one trim step, measured when the search crossed zero.
+ */
+static int32_t stepSize;
+
+/**
+ * @brief Callback of the timer: ends a window or a wait. Defined at the end of the file.
+ */
+static void TrimExpired(uint32_t arg);
+
+/**
+ * @brief Reads the HSITRIM field.
+ */
+static uint8_t GetTrim(void){
+	return (RCC->CR & RCC_CR_HSITRIM) >> RCC_CR_HSITRIM_Pos;
+}
+
+/**
+ * @brief Starts a measurement window.
+ */
+static void StartWindow(void){
+	state = TRIM_MEASURING;
+	PowerHold(); /**< TIM2 and the PLL stop with the core*/
+	ClockHold(); /**< The window counts cycles of the fast clock*/
+	CaptureStart();
+	SwTimerStart(&trimTimer, HSITRIM_WINDOW, 0);
+}
+
+/**
+ * @brief Waits for the next periodic measurement.
+ */
+static void StartWait(void){
+	state = TRIM_WAITING;
+	SwTimerStart(&trimTimer, HSITRIM_PERIOD, 0);
+}
+
+/**
+ * @brief Corrects what the trim cannot: timebase and baud rate are recomputed with the measured clock, in both clock
+ * modes.
+ */
+static void ApplyFrequency(uint32_t frequency){
+	ClockPortCalibrate(frequency);
+}
+
+/**
+ * @brief Sends the result of a measurement through USART2.
+ */
+static void SendReport(uint32_t frequency, uint8_t trim){
+	char line[64];
+	sprintf(line, "HSI trim=%u f=%lu Hz error=%ld ppm\r\n", trim, (unsigned long)frequency, (long)lastError);
+	UARTSendString(line);
+}
+
+/*Returns the error of the last measurement. Declared in header file*/
+int32_t HsiTrimGetError(void){
+	return lastError;
+}
+
+/*Starts the service. Declared in header file*/
+void HsiTrimInit(void){
+	nominalClock = SystemCoreClock;
+	previousValid = false;
+	locked = false;
+	Set32kHzOutput(true);
+	CaptureInit();
+	SwTimerInit(&trimTimer, TrimExpired, 0, SW_TIMER_LOOP);
+	StartWindow();
+}
+
+/**
+ * @brief Callback of the timer (main loop): ends the window and moves the trim, or starts the next window.
+ */
+static void TrimExpired(uint32_t arg){
+	uint32_t ticks, edges, frequency;
+	uint8_t trim = GetTrim();
+
+	if (state == TRIM_WAITING){
+		StartWindow();
+		return;
+	}
+
+	CaptureStop();
+	PowerRelease();
+	ClockRelease();
+	CaptureGet(&ticks, &edges);
+	if (edges < HSITRIM_MIN_EDGES){ /**< No 32kHz signal: keep everything as it is and retry later*/
+		StartWait();
+		return;
+	}
+
+	frequency = (uint64_t)ticks * HSITRIM_REFERENCE / edges;
+	lastError = ((int64_t)frequency - nominalClock) * 1000000 / (int64_t)nominalClock;
+	SendReport(frequency, trim);
+
+	if (locked){
+		if (abs(lastError) <= stepSize){ /**< Still the best trim: only the software correction is refreshed*/
+			ApplyFrequency(frequency);
+			StartWait();
+			return;
+		}
+		locked = false; /**< Drifted more than a step (e.g. temperature): search again*/
+		previousValid = false;
+	}
+
+	if (previousValid && (abs(previousTrim - trim) == 1) && ((previousError < 0) != (lastError < 0))){
+		/* The last step crossed zero: keep the trim closest to it and correct the rest in software*/
+		stepSize = abs(previousError - lastError);
+		locked = true;
+		if (abs(previousError) < abs(lastError)){
+			__HAL_RCC_HSI_CALIBRATIONVALUE_ADJUST(previousTrim);
+			StartWindow(); /**< Measures again with the better trim before applying the frequency*/
+			return;
+		}
+	}
+	else if ((lastError > 0) && (trim > 0)){
+		previousError = lastError;
+		previousTrim = trim;
+		previousValid = true;
+		__HAL_RCC_HSI_CALIBRATIONVALUE_ADJUST(trim - 1); /**< A lower trim lowers the frequency*/
+		StartWindow();
+		return;
+	}
+	else if ((lastError < 0) && (trim < HSITRIM_MAX)){
+		previousError = lastError;
+		previousTrim = trim;
+		previousValid = true;
+		__HAL_RCC_HSI_CALIBRATIONVALUE_ADJUST(trim + 1);
+		StartWindow();
+		return;
+	}
+	else{ /**< End of the trim range: the software correction does the rest*/
+		stepSize = abs(lastError);
+		locked = true;
+	}
+
+	ApplyFrequency(frequency);
+	StartWait();
+}
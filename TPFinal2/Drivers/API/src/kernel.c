@@ -0,0 +1,356 @@
+/**
+ * @file kernel.c
+ * @brief Implementation of the preemptive kernel.
+ *
+ * Contains the function definitions declared in kernel.h.
+ * The threads are few, so the ready thread to run is found walking the whole table.
+ * Every change of the state of a thread masks the interrupts; the switch it can cause
+ * is only requested (KernelPortSwitch) and happens once they are unmasked. A unit
+ * given to a semaphore some thread waits for goes straight to that thread, so a
+ * higher priority thread that runs first can not take it.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "kernel.h"
+
+/**
+ * @brief Includes the functions of the port that switch the threads.
+ */
+#include "portKernel.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief States of a thread.
+ */
+typedef enum{
+	THREAD_READY,
+	THREAD_WAITING,
+	THREAD_SLEEPING
+} threadState_t;
+
+kThread_t *volatile kernelCurrent;
+kThread_t *volatile kernelNext;
+
+/**
+ * @brief Table of threads, in the order they were created.
+ */
+static kThread_t *threads[KERNEL_MAX_THREADS];
+
+/**
+ * @brief Amount of threads.
+ */
+static uint8_t threadCount;
+
+/**
+ * @brief Thread that runs when no other is ready.
+ */
+static kThread_t idleThread;
+
+/**
+ * @brief Stack of the idle thread.
+ */
+static uint32_t idleStack[KERNEL_IDLE_STACK] __attribute__((aligned(8)));
+
+/**
+ * @brief Ticks counted by KernelTick.
+ */
+static volatile tick_t kernelTicks;
+
+/**
+ * @brief Flag to check whether the kernel was started.
+ */
+static bool_t running;
+
+/**
+ * @brief Cycle counter when the CPU time was last charged to a thread.
+ */
+static uint32_t chargeCycles;
+
+/**
+ * @brief Function of the idle thread.
+ */
+static void IdleThread(void){
+	for (;;) KernelIdle();
+}
+
+/**
+ * @brief Charges the cycles elapsed since the last charge to the thread that runs.
+ */
+static void Charge(void){
+	uint32_t now = CyclesNow();
+
+	if (kernelCurrent != NULL) kernelCurrent->runCycles += (uint32_t)(now - chargeCycles);
+	chargeCycles = now;
+}
+
+/**
+ * @brief Requests the switch to the highest priority ready thread, if it is not the one that runs. Interrupts masked.
+ */
+static void Reschedule(void){
+	kThread_t *best = NULL;
+
+	if (!running) return;
+	for (uint8_t i = 0; i < threadCount; i++){
+		if ((threads[i]->state == THREAD_READY) && ((best == NULL) || (threads[i]->priority > best->priority))) best = threads[i];
+	}
+	kernelNext = best;
+	if (best != kernelCurrent){
+		Charge();
+		KernelPortSwitch();
+	}
+}
+
+/**
+ * @brief Makes a waiting or sleeping thread ready, starting an activation. Interrupts masked.
+ */
+static void Wake(kThread_t *thread){
+	thread->state = THREAD_READY;
+	thread->waitSem = NULL;
+	thread->timed = false;
+	thread->readyCycles = CyclesNow();
+}
+
+/**
+ * @brief Blocks the thread that runs, ending its activation. The switch happens when the caller unmasks the
+ * interrupts. Interrupts masked.
+ */
+static void Block(uint8_t state, kSem_t *sem, tick_t timeout){
+	kThread_t *thread = kernelCurrent;
+	uint32_t response = CyclesNow() - thread->readyCycles;
+
+	thread->activations++;
+	if (response > thread->worstResponse) thread->worstResponse = response;
+	thread->state = state;
+	thread->waitSem = sem;
+	thread->acquired = false;
+	thread->timed = (timeout != KERNEL_FOREVER);
+	thread->wakeTick = kernelTicks + timeout + 1; /**< The current tick is partly gone: at least timeout whole ticks*/
+	Reschedule();
+}
+
+/**
+ * @brief Counts the words at the bottom of a stack that were never written.
+ */
+static uint32_t StackUnused(const kThread_t *thread){
+	uint32_t words = 0;
+
+	while ((words < thread->stackWords) && (thread->stack[words] == KERNEL_STACK_FILL)) words++;
+	return words;
+}
+
+/*Counts several ticks. Declared in header file*/
+void KernelAdvance(tick_t ticks){
+	kThread_t *thread;
+	bool_t woken = false;
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	kernelTicks += ticks;
+	for (uint8_t i = 0; i < threadCount; i++){
+		thread = threads[i];
+		if ((thread->state != THREAD_READY) && thread->timed && ((int32_t)(kernelTicks - thread->wakeTick) >= 0)){
+			Wake(thread); /**< acquired stays false*/
+			woken = true;
+		}
+	}
+	if (woken) Reschedule();
+	__set_PRIMASK(mask);
+}
+
+/*Gets the ticks to the earliest timeout. Declared in header file*/
+tick_t KernelNextTimeout(void){
+	tick_t next = KERNEL_FOREVER, left;
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	for (uint8_t i = 0; i < threadCount; i++){
+		if ((threads[i]->state == THREAD_READY) || !threads[i]->timed) continue;
+		left = ((int32_t)(threads[i]->wakeTick - kernelTicks) > 0) ? threads[i]->wakeTick - kernelTicks : 0;
+		if (left < next) next = left;
+	}
+	__set_PRIMASK(mask);
+	return next;
+}
+
+/*Gets the items waiting in a queue. Declared in header file*/
+uint16_t KernelQueueCount(kQueue_t *queue){
+	return queue->items.count;
+}
+
+/*Initializes a message queue. Declared in header file*/
+void KernelQueueInit(kQueue_t *queue, void *buffer, uint16_t itemSize, uint16_t length){
+	queue->buffer = buffer;
+	queue->itemSize = itemSize;
+	queue->length = length;
+	queue->head = 0;
+	queue->tail = 0;
+	KernelSemInit(&queue->items, 0, length);
+	KernelSemInit(&queue->spaces, length, length);
+}
+
+/*Takes the oldest item of a queue. Declared in header file*/
+bool_t KernelQueueReceive(kQueue_t *queue, void *item, tick_t timeout){
+	uint32_t mask;
+
+	if (!KernelSemTake(&queue->items, timeout)) return false;
+	mask = __get_PRIMASK();
+	__disable_irq();
+	memcpy(item, &queue->buffer[queue->head * queue->itemSize], queue->itemSize);
+	queue->head = (queue->head + 1) % queue->length;
+	__set_PRIMASK(mask);
+	KernelSemGive(&queue->spaces);
+	return true;
+}
+
+/*Appends an item to a queue. Declared in header file*/
+bool_t KernelQueueSend(kQueue_t *queue, const void *item, tick_t timeout){
+	uint32_t mask;
+
+	if (!KernelSemTake(&queue->spaces, timeout)) return false;
+	mask = __get_PRIMASK();
+	__disable_irq();
+	memcpy(&queue->buffer[queue->tail * queue->itemSize], item, queue->itemSize);
+	queue->tail = (queue->tail + 1) % queue->length;
+	__set_PRIMASK(mask);
+	KernelSemGive(&queue->items);
+	return true;
+}
+
+/*Sends the statistics. Declared in header file*/
+void KernelReport(void){
+	char line[96];
+	kThread_t *thread;
+	uint64_t total = 0;
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	Charge();
+	__set_PRIMASK(mask);
+	for (uint8_t i = 0; i < threadCount; i++) total += threads[i]->runCycles;
+	if (total == 0) total = 1;
+	for (uint8_t i = 0; i < threadCount; i++){
+		thread = threads[i];
+		sprintf(line, "thread %s act=%lu wcrt=%luus load=%lu/1000 stack=%lu/%lu\r\n", thread->name,
+				(unsigned long)thread->activations, (unsigned long)CyclesToMicros(thread->worstResponse),
+				(unsigned long)(thread->runCycles * 1000 / total),
+				(unsigned long)(thread->stackWords - StackUnused(thread)), (unsigned long)thread->stackWords);
+		UARTSendString(line);
+	}
+	sprintf(line, "cpu load=%lu/1000 time=%lums\r\n", (unsigned long)((total - idleThread.runCycles) * 1000 / total),
+			(unsigned long)(total / (SystemCoreClock / 1000)));
+	UARTSendString(line);
+}
+
+/*Clears the statistics. Declared in header file*/
+void KernelResetStats(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	for (uint8_t i = 0; i < threadCount; i++){
+		threads[i]->activations = 0;
+		threads[i]->worstResponse = 0;
+		threads[i]->runCycles = 0;
+	}
+	chargeCycles = CyclesNow();
+	__set_PRIMASK(mask);
+}
+
+/*Checks whether the kernel was started. Declared in header file*/
+bool_t KernelRunning(void){
+	return running;
+}
+
+/*Gives a unit to a semaphore. Declared in header file*/
+void KernelSemGive(kSem_t *sem){
+	kThread_t *waiter = NULL;
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	for (uint8_t i = 0; i < threadCount; i++){
+		if ((threads[i]->state == THREAD_WAITING) && (threads[i]->waitSem == sem) &&
+				((waiter == NULL) || (threads[i]->priority > waiter->priority))) waiter = threads[i];
+	}
+	if (waiter != NULL){
+		Wake(waiter);
+		waiter->acquired = true; /**< The unit goes straight to it*/
+		Reschedule();
+	}
+	else if (sem->count < sem->max) sem->count++;
+	__set_PRIMASK(mask);
+}
+
+/*Initializes a semaphore. Declared in header file*/
+void KernelSemInit(kSem_t *sem, uint16_t count, uint16_t max){
+	sem->count = count;
+	sem->max = max;
+}
+
+/*Takes a unit of a semaphore. Declared in header file*/
+bool_t KernelSemTake(kSem_t *sem, tick_t timeout){
+	kThread_t *thread = kernelCurrent;
+	uint32_t mask = __get_PRIMASK();
+	bool_t acquired = true;
+
+	__disable_irq();
+	if (sem->count > 0) sem->count--;
+	else if ((timeout == 0) || !running || KernelPortInIsr()) acquired = false;
+	else{
+		Block(THREAD_WAITING, sem, timeout);
+		__set_PRIMASK(mask); /**< Switches out here until a unit is given or the wait times out*/
+		return thread->acquired;
+	}
+	__set_PRIMASK(mask);
+	return acquired;
+}
+
+/*Blocks the calling thread for some ticks. Declared in header file*/
+void KernelSleep(tick_t ticks){
+	uint32_t mask;
+
+	if (!running || (ticks == 0)) return;
+	mask = __get_PRIMASK();
+	__disable_irq();
+	Block(THREAD_SLEEPING, NULL, ticks);
+	__set_PRIMASK(mask); /**< Switches out here until the ticks elapse*/
+}
+
+/*Starts the kernel. Declared in header file*/
+void KernelStart(void){
+	KernelThreadCreate(&idleThread, "idle", idleStack, KERNEL_IDLE_STACK, 0, IdleThread);
+	__disable_irq();
+	running = true;
+	KernelResetStats();
+	for (uint8_t i = 0; i < threadCount; i++) threads[i]->readyCycles = chargeCycles;
+	Reschedule(); /**< Requests the switch to the highest priority thread*/
+	KernelPortStart();
+}
+
+/*Creates a thread. Declared in header file*/
+void KernelThreadCreate(kThread_t *thread, const char *name, uint32_t *stack, uint32_t stackWords, uint8_t priority,
+		void (*entry)(void)){
+	if (threadCount == KERNEL_MAX_THREADS) Error_Handler();
+	for (uint32_t i = 0; i < stackWords; i++) stack[i] = KERNEL_STACK_FILL;
+	memset(thread, 0, sizeof(*thread));
+	thread->name = name;
+	thread->stack = stack;
+	thread->stackWords = stackWords;
+	thread->priority = priority;
+	thread->state = THREAD_READY;
+	KernelPortInitStack(thread, entry);
+	threads[threadCount++] = thread;
+}
+
+/*Gets a thread. Declared in header file*/
+const kThread_t *KernelThreadGet(uint8_t index){
+	return (index < threadCount) ? threads[index] : NULL;
+}
+
+/*Wakes the threads whose wait timed out. Declared in header file*/
+void KernelTick(void){
+	KernelAdvance(1);
+}
@@ -0,0 +1,140 @@
+/**
+ * @file latency.c
+ * @brief Implementation of the input to display latency histograms.
+ *
+ * Contains the function definitions declared in latency.h.
+ * Bucket b holds the values whose highest bit is b / 4 + 1 and whose next two bits
+ * are b % 4 (values under 4 get a bucket each), a log-linear layout that needs no division.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "latency.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Size (in chars) of a line of the dump.
+ */
+#define LINE_SIZE 64
+
+/**
+ * @brief Histogram and running summary of a screen.
+ */
+typedef struct{
+	uint16_t buckets[LATENCY_BUCKETS];
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+} latencyHistogram_t;
+
+/**
+ * @brief Histograms of every screen.
+ */
+static latencyHistogram_t histograms[LAT_SCREEN_COUNT];
+
+/**
+ * @brief Names of the screens for the dump.
+ */
+static const char *screenNames[LAT_SCREEN_COUNT] = {"MENU", "SETTIME", "SETALARM"};
+
+/**
+ * @brief Gets the bucket of a latency in microseconds.
+ */
+static uint8_t BucketOf(uint32_t micros){
+	uint8_t msb;
+	uint16_t bucket;
+
+	if (micros < LATENCY_SUB_BUCKETS) return micros;
+	msb = 31 - __builtin_clz(micros);
+	bucket = (msb - 1) * LATENCY_SUB_BUCKETS + ((micros >> (msb - 2)) & (LATENCY_SUB_BUCKETS - 1));
+	return (bucket < LATENCY_BUCKETS) ? bucket : LATENCY_BUCKETS - 1;
+}
+
+/**
+ * @brief Gets the smallest latency in microseconds that falls in a bucket.
+ */
+static uint32_t BucketStart(uint8_t bucket){
+	if (bucket < LATENCY_SUB_BUCKETS) return bucket;
+	return (uint32_t)(LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << (bucket / LATENCY_SUB_BUCKETS - 1);
+}
+
+/*Sends the histograms through USART2. Declared in header file*/
+void LatencyDump(void){
+	latencyStats_t stats;
+	char line[LINE_SIZE];
+	uint8_t screen, bucket;
+
+	UARTSendString("pantalla,n,min_us,avg_us,p99_us,max_us\r\n");
+	for (screen = 0; screen < LAT_SCREEN_COUNT; screen++){
+		LatencyGetStats(screen, &stats);
+		sprintf(line, "%s,%lu,%lu,%lu,%lu,%lu\r\n", screenNames[screen], (unsigned long)stats.count, (unsigned long)stats.min,
+				(unsigned long)stats.avg, (unsigned long)stats.p99, (unsigned long)stats.max);
+		UARTSendString(line);
+	}
+	for (screen = 0; screen < LAT_SCREEN_COUNT; screen++){
+		for (bucket = 0; bucket < LATENCY_BUCKETS; bucket++){
+			if (histograms[screen].buckets[bucket] == 0) continue;
+			sprintf(line, "# %s %lu-%lu %u\r\n", screenNames[screen], (unsigned long)BucketStart(bucket),
+					(unsigned long)((bucket + 1 < LATENCY_BUCKETS) ? BucketStart(bucket + 1) - 1 : UINT32_MAX), histograms[screen].buckets[bucket]);
+			UARTSendString(line);
+		}
+	}
+}
+
+/*Gets the summary of a screen. Declared in header file*/
+void LatencyGetStats(latencyScreen_t screen, latencyStats_t *stats){
+	latencyHistogram_t *histogram = &histograms[screen];
+
+	stats->count = histogram->count;
+	stats->min = histogram->count ? histogram->min : 0;
+	stats->avg = histogram->count ? (uint32_t)(histogram->sum / histogram->count) : 0;
+	stats->p99 = LatencyPercentile(screen, 990);
+	stats->max = histogram->max;
+}
+
+/*Gets a percentile of a screen. Declared in header file*/
+uint32_t LatencyPercentile(latencyScreen_t screen, uint16_t permille){
+	latencyHistogram_t *histogram = &histograms[screen];
+	uint32_t rank, seen = 0;
+	uint8_t bucket;
+
+	if (histogram->count == 0) return 0;
+	rank = ((uint64_t)histogram->count * permille + 999) / 1000; /**< Samples at or below the percentile, rounded up*/
+	for (bucket = 0; bucket < LATENCY_BUCKETS; bucket++){
+		seen += histogram->buckets[bucket];
+		if (seen >= rank) break;
+	}
+	if (bucket + 1 >= LATENCY_BUCKETS) return histogram->max;
+	return (BucketStart(bucket + 1) - 1 < histogram->max) ? BucketStart(bucket + 1) - 1 : histogram->max;
+}
+
+/*Records a latency. Declared in header file*/
+void LatencyRecord(latencyScreen_t screen, uint32_t edge){
+	latencyHistogram_t *histogram = &histograms[screen];
+	uint32_t micros = CyclesToMicros(CyclesNow() - edge);
+	uint8_t bucket = BucketOf(micros);
+
+	if (histogram->buckets[bucket] == UINT16_MAX) return; /**< Saturated: keeps the shape instead of wrapping*/
+	histogram->buckets[bucket]++;
+	if ((histogram->count == 0) || (micros < histogram->min)) histogram->min = micros;
+	if (micros > histogram->max) histogram->max = micros;
+	histogram->count++;
+	histogram->sum += micros;
+}
+
+/*Clears the histograms. Declared in header file*/
+void LatencyReset(void){
+	uint8_t screen;
+	uint8_t bucket;
+
+	for (screen = 0; screen < LAT_SCREEN_COUNT; screen++){
+		for (bucket = 0; bucket < LATENCY_BUCKETS; bucket++) histograms[screen].buckets[bucket] = 0;
+		histograms[screen].count = 0;
+		histograms[screen].min = 0;
+		histograms[screen].max = 0;
+		histograms[screen].sum = 0;
+	}
+}
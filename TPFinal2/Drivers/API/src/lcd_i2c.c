@@ -73,7 +73,9 @@ void LCD_I2C_Send(uint8_t data, uint8_t rs) {
     data_t[1] = data_u & ~ENABLE;
     data_t[2] = data_l|ENABLE;
     data_t[3] = data_l & ~ENABLE;
+    TRACE_SPAN_BEGIN(TRACE_LCD_SEND, data);
     I2CMasterTransmit(LCD_ADDR, data_t, BYTES_PER_BYTE);
+    TRACE_SPAN_END(TRACE_LCD_SEND, data);
 }
 
 /*Send one 8-bit instruction byte to the display. Declared in header file*/
@@ -0,0 +1,194 @@
+/**
+ * @file modbus.c
+ * @brief Implementation of the Modbus RTU slave on USART2.
+ *
+ * Contains the function definitions declared in modbus.h.
+ * The request is parsed straight from the frame of the reception, which is freed once
+ * the reply is queued. Registers and counts are big endian on the line; the CRC is the
+ * Modbus CRC-16 (reflected polynomial 0xA001, initial value 0xFFFF), low byte first.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "modbus.h"
+
+/**
+ * @brief Function codes served.
+ */
+#define READ_HOLDING 0x03
+#define WRITE_SINGLE 0x06
+#define WRITE_MULTIPLE 0x10
+
+/**
+ * @brief Register image and its size.
+ */
+static uint16_t *registers;
+static uint16_t registerCount;
+
+/**
+ * @brief Address of the slave, 0 while it is stopped.
+ */
+static uint8_t address;
+
+/**
+ * @brief Reply being built: address, function, data and room for the CRC.
+ */
+static uint8_t reply[3 + 2 * MODBUS_MAX_READ + 2];
+
+/**
+ * @brief Statistics.
+ */
+static modbusStats_t stats;
+
+/**
+ * @brief Computes the Modbus CRC-16 of a buffer.
+ */
+static uint16_t Crc16(const uint8_t *data, uint16_t size){
+	uint16_t crc = 0xFFFF;
+
+	while (size-- > 0){
+		crc ^= *data++;
+		for (uint8_t bit = 0; bit < 8; bit++) crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+	}
+	return crc;
+}
+
+/**
+ * @brief Reads a big endian word.
+ */
+static uint16_t GetWord(const uint8_t *data){
+	return ((uint16_t)data[0] << 8) | data[1];
+}
+
+/**
+ * @brief Writes a big endian word.
+ */
+static void PutWord(uint8_t *data, uint16_t value){
+	data[0] = value >> 8;
+	data[1] = value & 0xFF;
+}
+
+/**
+ * @brief Builds an exception reply. Returns its length without the CRC.
+ */
+static uint16_t Exception(uint8_t code){
+	reply[1] |= 0x80;
+	reply[2] = code;
+	stats.exceptions++;
+	return 3;
+}
+
+/**
+ * @brief Checks the range of a write and hands it to the user. Returns MODBUS_OK or an exception code.
+ */
+static uint8_t Write(uint16_t start, uint16_t count, const uint16_t *values){
+	if ((uint32_t)start + count > registerCount) return MODBUS_ILLEGAL_ADDRESS;
+	return ModbusWrite(start, count, values);
+}
+
+/**
+ * @brief Serves a request with a valid CRC into the reply. Returns the length of the reply without the CRC.
+ */
+static uint16_t Serve(const uint8_t *request, uint16_t size){
+	uint16_t values[MODBUS_MAX_WRITE];
+	uint16_t start = GetWord(&request[2]), count = GetWord(&request[4]);
+	uint8_t code;
+
+	reply[1] = request[1];
+	switch (request[1]){
+	case READ_HOLDING:
+		if ((size != 6) || (count == 0) || (count > MODBUS_MAX_READ)) return Exception(MODBUS_ILLEGAL_VALUE);
+		if ((uint32_t)start + count > registerCount) return Exception(MODBUS_ILLEGAL_ADDRESS);
+		reply[2] = 2 * count;
+		for (uint16_t i = 0; i < count; i++) PutWord(&reply[3 + 2 * i], registers[start + i]);
+		return 3 + 2 * count;
+	case WRITE_SINGLE:
+		if (size != 6) return Exception(MODBUS_ILLEGAL_VALUE);
+		values[0] = count; /**< The value takes the place of the count*/
+		count = 1;
+		break;
+	case WRITE_MULTIPLE:
+		if ((count == 0) || (count > MODBUS_MAX_WRITE) || (size < 7) || (request[6] != 2 * count) ||
+				(size != 7 + 2 * count)) return Exception(MODBUS_ILLEGAL_VALUE);
+		for (uint16_t i = 0; i < count; i++) values[i] = GetWord(&request[7 + 2 * i]);
+		break;
+	default:
+		return Exception(MODBUS_ILLEGAL_FUNCTION);
+	}
+	code = Write(start, count, values);
+	if (code != MODBUS_OK) return Exception(code);
+	for (uint8_t i = 2; i < 6; i++) reply[i] = request[i]; /**< Echo of the address and the value or count*/
+	return 6;
+}
+
+/*Gets the address of the slave. Declared in header file*/
+uint8_t ModbusAddress(void){
+	return address;
+}
+
+/*Gets the statistics. Declared in header file*/
+void ModbusGetStats(modbusStats_t *copy){
+	*copy = stats;
+}
+
+/*Takes the register image. Declared in header file*/
+void ModbusInit(uint16_t *image, uint16_t count){
+	registers = image;
+	registerCount = count;
+	ModbusResetStats();
+}
+
+/*Clears the statistics. Declared in header file*/
+void ModbusResetStats(void){
+	stats = (modbusStats_t){0};
+	UARTResetStats();
+}
+
+/*Starts the slave. Declared in header file*/
+bool_t ModbusStart(uint8_t slave){
+	if ((slave == MODBUS_BROADCAST) || (slave > MODBUS_MAX_ADDRESS)) return false;
+	address = slave;
+	UARTFrameMode(MODBUS_GAP);
+	return true;
+}
+
+/*Stops the slave. Declared in header file*/
+void ModbusStop(void){
+	address = 0;
+	UARTFrameMode(0);
+}
+
+/*Serves the request received. Declared in header file*/
+void ModbusUpdate(void){
+	uint16_t size, length, crc;
+	uint32_t stamp, micros;
+	uint8_t *request = UARTFrameGet(&size, &stamp);
+	uint8_t target;
+
+	if (request == NULL) return;
+	if ((size < 4) || (Crc16(request, size - 2) != (request[size - 2] | ((uint16_t)request[size - 1] << 8)))){
+		stats.crcErrors++;
+		UARTFrameFree();
+		return;
+	}
+	target = request[0];
+	if ((address == 0) || ((target != address) && (target != MODBUS_BROADCAST))){
+		stats.ignored++;
+		UARTFrameFree();
+		return;
+	}
+	stats.requests++;
+	reply[0] = address;
+	length = Serve(&request[0], size - 2); /**< May stop the slave: the reply still goes out*/
+	if (target != MODBUS_BROADCAST){
+		crc = Crc16(reply, length);
+		reply[length++] = crc & 0xFF;
+		reply[length++] = crc >> 8;
+		UARTFrameSend(reply, length);
+		stats.replies++;
+		micros = CyclesToMicros(CyclesNow() - stamp);
+		if (micros > stats.turnaroundMax) stats.turnaroundMax = micros;
+	}
+	UARTFrameFree();
+}
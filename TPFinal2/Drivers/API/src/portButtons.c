@@ -8,14 +8,39 @@
  */
 #include "portButtons.h"
 
+/**
+ * @brief Includes the timing inputs, which share the EXTI callback.
+ */
+#include "portSQW.h"
+
+/**
+ * @brief Includes the deferred work the interrupts hand the processing to.
+ */
+#include "deferred.h"
+
+/**
+ * @brief Includes the resync of the tick at the SQW edges.
+ */
+#include "power.h"
+
+/**
+ * @brief Includes the trace of the edges.
+ */
+#include "trace.h"
+
 /**
  * @brief Type defined for button debounce.
  *
- * Pressed turns true when it is pressed for the first time; delay contains a delay struct to check the delay to the next pressing.
+ * The first edge of a press starts the debounce timer and the rest of the bounce is ignored while it runs. When it
+ * expires the pin is read: if it is still pressed, the press is debounced. The repeat timer then times the
+ * auto-repeat of the repeating buttons until the pin is read released. Both interrupts (the edge and the expiry of
+ * the debounce timer) only post the event; the work is deferred to PendSV.
  */
 typedef struct{
-	bool_t pressed;
-	delay_t delay;
+	swTimer_t debounce;		/**< One-shot, runs in the tick interrupt */
+	swTimer_t repeat;		/**< Periodic, runs in the main loop */
+	uint8_t repeats;		/**< Repeats generated since the press */
+	uint32_t edge;			/**< Cycle counter at the first edge of the press */
 } buttonDebounce;
 
 /**
@@ -24,39 +49,70 @@ typedef struct{
 static buttonDebounce buttons[NUMBER_OF_BUTTONS];
 
 /**
- * @brief Position of the button in the buttons array.
+ * @brief Pin of each button in the buttons array.
  */
-static tick_t pos = 0;
+static const uint16_t buttonPins[NUMBER_OF_BUTTONS] = {RIGHT_PIN, MENU_PIN, LEFT_PIN, ENTER_PIN};
 
 /**
- * @brief Declaration of the function to reset button state.
- * @param buttonNumber: number of the button in the buttons array
- * @retval none
+ * @brief Steps of the next repeat, according to the repeats already generated
  */
-static void buttonReset(tick_t buttonNumber);
+static uint8_t repeatSteps(uint8_t repeats){
+	if (repeats < REPEAT_STAGE_LENGTH) return REPEAT_STEPS_1;
+	if (repeats < 2 * REPEAT_STAGE_LENGTH) return REPEAT_STEPS_2;
+	return REPEAT_STEPS_3;
+}
 
 /**
- * @brief Declaration of the function to reset all the buttons state.
- * @param none
- * @retval none
+ * @brief Deferred half of the edge interrupt: the first edge of a press starts the debounce, the rest is bounce
  */
-static void buttonReset(tick_t buttonNumber);
+static void buttonEdge(uint32_t buttonNumber, uint32_t stamp){
+    if (SwTimerIsRunning(&(buttons[buttonNumber].debounce))) return; /**< Bounce*/
+    buttons[buttonNumber].edge = stamp; /**< First edge, what the user did*/
+    SwTimerStart(&(buttons[buttonNumber].debounce), DELAY, 0);
+}
 
 /**
- * @brief Definition of the function to reset button state. It changes "pressed" to false and initializes the delay
+ * @brief Deferred half of the debounce timer: the bounce is over, a press if the pin is still pressed
  */
-static void buttonReset(tick_t buttonNumber){
-	buttons[buttonNumber].pressed = false;
-	delayInit(&(buttons[buttonNumber].delay),DELAY);
+static void debounceDone(uint32_t buttonNumber, uint32_t stamp){
+    buttonDebounce *button = &buttons[buttonNumber];
+
+    if (HAL_GPIO_ReadPin(ENTER_GPIO_PORT, buttonPins[buttonNumber]) != GPIO_PIN_RESET) return;
+    if (buttonPins[buttonNumber] & REPEAT_PINS){
+        button->repeats = 0;
+        SwTimerStart(&button->repeat, REPEAT_DELAY, REPEAT_PERIOD);
+    }
+    ButtonPressed(buttonPins[buttonNumber]);
 }
 
 /**
- * @brief Loops over buttons and resets them
+ * @brief Callback of the debounce timer (tick interrupt): defers the end of the debounce
  */
-static void buttonsReset(void){
-	for (tick_t i = 0;i<NUMBER_OF_BUTTONS;i++){
-		buttonReset(i);
-	}
+static void debounceExpired(uint32_t buttonNumber){
+    DeferredPost(debounceDone, buttonNumber);
+}
+
+/**
+ * @brief Callback of the repeat timer (main loop): a repeat while the pin is pressed, the end of them once released
+ */
+static void repeatExpired(uint32_t buttonNumber){
+    buttonDebounce *button = &buttons[buttonNumber];
+
+    if (HAL_GPIO_ReadPin(ENTER_GPIO_PORT, buttonPins[buttonNumber]) == GPIO_PIN_SET){
+        SwTimerStop(&button->repeat);
+        return;
+    }
+    ButtonRepeated(buttonPins[buttonNumber], repeatSteps(button->repeats));
+    if (button->repeats < 2 * REPEAT_STAGE_LENGTH) button->repeats++; /**< Saturates at the last stage*/
+}
+
+/*Gets the cycle counter at the first edge of the last press. Declared in header file*/
+uint32_t ButtonGetEdge(uint16_t GPIO_Pin)
+{
+    for (tick_t i = 0; i < NUMBER_OF_BUTTONS; i++){
+        if (buttonPins[i] == GPIO_Pin) return buttons[i].edge;
+    }
+    return 0;
 }
 
 /*Initializes the buttons. Declared in header file*/
@@ -69,6 +125,11 @@ void ButtonsInit(void)
   __HAL_RCC_GPIOA_CLK_ENABLE();
   __HAL_RCC_GPIOB_CLK_ENABLE();
 
+  for (uint32_t i = 0; i < NUMBER_OF_BUTTONS; i++){
+    SwTimerInit(&buttons[i].debounce, debounceExpired, i, SW_TIMER_TICK);
+    SwTimerInit(&buttons[i].repeat, repeatExpired, i, SW_TIMER_LOOP);
+  } /**< Before the interrupt is enabled*/
+
   GPIO_InitStruct.Pin = RIGHT_PIN|MENU_PIN|LEFT_PIN|ENTER_PIN;
   GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
   GPIO_InitStruct.Pull = GPIO_PULLUP;
@@ -76,30 +137,23 @@ void ButtonsInit(void)
 
   HAL_NVIC_SetPriority(ENTER_EXTI_IRQN, 0, 0); /**< In this case I use the EXTI line for Enter button but it's the same for any of them */
   HAL_NVIC_EnableIRQ(ENTER_EXTI_IRQN); /**< If there was more than one EXTI line used, all of them should be initialized */
-
-  buttonsReset();
 }
 
-/*Checks if button is pressed (taking debounce into account) and invokes callback function. Declared in header file*/
+/*Defers the edge of a button, stamped. Edges of other pins are handed to the timing inputs. Declared in header file*/
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
+    uint32_t pos;
+
+    TRACE_POINT(TRACE_EXTI, GPIO_Pin);
     if (GPIO_Pin == RIGHT_PIN) pos = 0;
     else if (GPIO_Pin == MENU_PIN) pos = 1;
     else if (GPIO_Pin == LEFT_PIN) pos = 2;
     else if (GPIO_Pin == ENTER_PIN) pos = 3;
-    else return;
-
-    if (!buttons[pos].pressed) {
-        buttons[pos].pressed = true;
-        delayRead(&(buttons[pos].delay));
+    else{
+        SQWEdge(GPIO_Pin); /**< Not a button: SQW or 1 PPS edge*/
+        if (GPIO_Pin == SQW_PIN) PowerSqwEdge();
         return;
     }
 
-    if (delayRead(&(buttons[pos].delay))) {
-        if (HAL_GPIO_ReadPin(ENTER_GPIO_PORT, GPIO_Pin) == GPIO_PIN_RESET) {
-            ButtonPressed(GPIO_Pin);
-        }
-
-        buttonReset(pos);
-    }
+    DeferredPost(buttonEdge, pos); /**< The debounce runs in PendSV, below every interrupt*/
 }
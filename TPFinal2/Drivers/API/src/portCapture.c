@@ -0,0 +1,86 @@
+/**
+ * @file portCapture.c
+ * @brief Implementation of the TIM2 input capture wrapper.
+ *
+ * This file contains the function definitions declared in portCapture.h.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "portCapture.h"
+
+/**
+ * @brief First capture of the window.
+ */
+static volatile uint32_t first;
+
+/**
+ * @brief Last capture of the window.
+ */
+static volatile uint32_t last;
+
+/**
+ * @brief Captures of the window.
+ */
+static volatile uint32_t captures;
+
+/*Gets the ticks and edges of the window. Declared in header file*/
+void CaptureGet(uint32_t *ticks, uint32_t *edges){
+	__disable_irq();
+	*ticks = (captures > 1) ? last - first : 0; /**< 32-bit timer: the difference survives one wrap (59.6 s at 72 MHz)*/
+	*edges = (captures > 1) ? (captures - 1) * CAPTURE_PRESCALER : 0;
+	__enable_irq();
+}
+
+/*Initializes TIM2 channel 1 as input capture. Declared in header file*/
+void CaptureInit(void){
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	__HAL_RCC_TIM2_CLK_ENABLE();
+
+	GPIO_InitStruct.Pin = CAPTURE_PIN;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	GPIO_InitStruct.Pull = GPIO_PULLUP; /**< 32kHz is open drain*/
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	GPIO_InitStruct.Alternate = CAPTURE_AF;
+	HAL_GPIO_Init(CAPTURE_GPIO_PORT, &GPIO_InitStruct);
+
+	TIM2->CR1 = 0;
+	TIM2->PSC = 0;
+	TIM2->ARR = 0xFFFFFFFF;
+	TIM2->CCMR1 = TIM_CCMR1_CC1S_0								/**< Channel 1 is an input mapped on TI1*/
+			| TIM_CCMR1_IC1PSC_0 | TIM_CCMR1_IC1PSC_1			/**< One capture every 8 edges*/
+			| TIM_CCMR1_IC1F_0 | TIM_CCMR1_IC1F_1;				/**< Filter: 8 samples at the timer clock*/
+	TIM2->CCER = TIM_CCER_CC1E;									/**< Rising edge*/
+	TIM2->EGR = TIM_EGR_UG;
+	TIM2->CR1 = TIM_CR1_CEN;
+
+	HAL_NVIC_SetPriority(TIM2_IRQn, CAPTURE_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+/*Stores a capture. Declared in header file*/
+void CaptureIRQHandler(void){
+	if (TIM2->SR & TIM_SR_CC1IF){
+		last = TIM2->CCR1; /**< Reading CCR1 clears CC1IF*/
+		if (captures == 0) first = last;
+		captures++;
+	}
+	TIM2->SR = ~(uint32_t)(TIM_SR_CC1OF | TIM_SR_UIF);
+}
+
+/*Restarts the window. Declared in header file*/
+void CaptureStart(void){
+	TIM2->DIER &= ~TIM_DIER_CC1IE;
+	captures = 0;
+	(void)TIM2->CCR1; /**< Drops a stale capture*/
+	TIM2->SR = 0;
+	TIM2->DIER |= TIM_DIER_CC1IE;
+}
+
+/*Stops the window. Declared in header file*/
+void CaptureStop(void){
+	TIM2->DIER &= ~TIM_DIER_CC1IE;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file portClock.c
+ * @brief Implementation of the wrapper RCC HAL functions of the clock modes.
+ *
+ * Contains the function definitions declared in portClock.h.
+ * HAL_RCC_ClockConfig restarts SysTick from the nominal clock of the new mode, so the
+ * switch reads what was left of the current tick first and loads it back, scaled, once
+ * SystemCoreClock holds the corrected clock; the usual reload is put back for the
+ * following ticks. The PLL is configured alone: the HSI and its trim stay as they are.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "portClock.h"
+
+/* Declaration of the error handler. Defined in the main */
+extern void Error_Handler(void);
+
+/**
+ * @brief Current mode. SystemClock_Config starts the fast one.
+ */
+static clockMode_t mode = CLOCK_MODE_FAST;
+
+/**
+ * @brief Core clock (in Hz) of the fast mode, as last measured.
+ */
+static uint32_t fastClock = CLOCK_FAST_HZ;
+
+/**
+ * @brief Gets the core clock (in Hz) of a mode. Both come from the HSI, so they share its error.
+ */
+static uint32_t ClockOf(clockMode_t target){
+	if (target == CLOCK_MODE_FAST) return fastClock;
+	return (uint64_t)fastClock * CLOCK_SLOW_HZ / CLOCK_FAST_HZ;
+}
+
+/**
+ * @brief Fills the bus clocks of a mode. Returns the flash wait states it needs.
+ */
+static uint32_t Config(clockMode_t target, RCC_ClkInitTypeDef *config){
+	config->ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+	config->APB2CLKDivider = RCC_HCLK_DIV1;
+	if (target == CLOCK_MODE_FAST){ /**< As SystemClock_Config*/
+		config->SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+		config->AHBCLKDivider = RCC_SYSCLK_DIV1;
+		config->APB1CLKDivider = RCC_HCLK_DIV2;
+		return FLASH_LATENCY_2;
+	}
+	config->SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+	config->AHBCLKDivider = RCC_SYSCLK_DIV2;
+	config->APB1CLKDivider = RCC_HCLK_DIV1;
+	return FLASH_LATENCY_0;
+}
+
+/**
+ * @brief Starts the PLL from the HSI and waits for its lock.
+ */
+static void LockPll(void){
+	RCC_OscInitTypeDef osc = {0};
+
+	osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+	osc.PLL.PLLState = RCC_PLL_ON;
+	osc.PLL.PLLSource = RCC_PLLSOURCE_HSI;
+	osc.PLL.PLLM = 8;
+	osc.PLL.PLLN = 72;
+	osc.PLL.PLLP = RCC_PLLP_DIV2;
+	osc.PLL.PLLQ = 2;
+	osc.PLL.PLLR = 2;
+	if (HAL_RCC_OscConfig(&osc) != HAL_OK) Error_Handler();
+}
+
+/**
+ * @brief Switches the system clock keeping the phase of SysTick. Interrupts masked.
+ */
+static void Switch(clockMode_t target){
+	RCC_ClkInitTypeDef config = {0};
+	uint32_t latency = Config(target, &config);
+	uint32_t period = SysTick->LOAD + 1;
+	uint32_t left, reload;
+
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+	left = SysTick->VAL;
+	if (left == 0) left = period; /**< Just reloaded, its interrupt is pending: a whole tick is left*/
+	if (HAL_RCC_ClockConfig(&config, latency) != HAL_OK) Error_Handler();
+	mode = target;
+	SystemCoreClock = ClockOf(target);
+	reload = SystemCoreClock / (1000U / uwTickFreq);
+	left = (uint64_t)left * reload / period;
+	if (left < 2) left = 2; /**< A reload of 0 would stop SysTick*/
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+	SysTick->LOAD = left - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+	SysTick->LOAD = reload - 1; /**< Taken at the next reload*/
+	UARTRetime();
+}
+
+/*Takes the measured clock. Declared in header file*/
+void ClockPortCalibrate(uint32_t frequency){
+	fastClock = frequency;
+	SystemCoreClock = ClockOf(mode);
+	HAL_InitTick(uwTickPrio); /**< SysTick reload from SystemCoreClock*/
+	UARTRetime();
+}
+
+/*Takes the clock of SystemClock_Config. Declared in header file*/
+void ClockPortInit(void){
+	mode = CLOCK_MODE_FAST;
+	fastClock = SystemCoreClock;
+}
+
+/*Gets the current mode. Declared in header file*/
+clockMode_t ClockPortMode(void){
+	return mode;
+}
+
+/*Restores the mode after STOP. Declared in header file*/
+uint32_t ClockPortResume(void){
+	RCC_ClkInitTypeDef config = {0};
+	uint32_t wake = CyclesNow();
+	uint32_t rate = (mode == CLOCK_MODE_FAST) ? (HSI_VALUE / 1000000) : CYCLES_PER_US; /**< Rate until the PLL locks*/
+
+	if (mode == CLOCK_MODE_FAST){
+		LockPll();
+		if (HAL_RCC_ClockConfig(&config, Config(mode, &config)) != HAL_OK) Error_Handler();
+		SystemCoreClock = ClockOf(mode);
+		UARTRetime();
+	}
+	HAL_InitTick(uwTickPrio); /**< The slow mode wakes as it was stopped: only SysTick is restarted*/
+	return (CyclesNow() - wake) / rate;
+}
+
+/*Switches the system clock. Declared in header file*/
+uint32_t ClockPortSet(clockMode_t target){
+	uint32_t start = CyclesNow();
+	uint32_t rate = CYCLES_PER_US;
+	uint32_t mask;
+
+	if (target == mode) return 0;
+	if (target == CLOCK_MODE_FAST) LockPll(); /**< On the HSI meanwhile: the ticks go on*/
+	mask = __get_PRIMASK();
+	__disable_irq();
+	Switch(target);
+	if (target == CLOCK_MODE_SLOW) __HAL_RCC_PLL_DISABLE();
+	__set_PRIMASK(mask);
+	return (CyclesNow() - start) / rate;
+}
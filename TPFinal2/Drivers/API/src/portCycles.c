@@ -0,0 +1,28 @@
+/**
+ * @file portCycles.c
+ * @brief Implementation of the wrapper of the DWT cycle counter.
+ *
+ * This file contains the function definitions declared in portCycles.h.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "portCycles.h"
+
+/*Enables the cycle counter. Declared in header file*/
+void CyclesInit(void){
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; /**< The DWT is part of the trace unit, it must be enabled first*/
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*Converts cycles to microseconds. Declared in header file*/
+uint32_t CyclesToMicros(uint32_t cycles){
+	return cycles / CYCLES_PER_US;
+}
+
+/*Waits for a value of the cycle counter. Declared in header file*/
+void CyclesWaitUntil(uint32_t cycles){
+	while ((int32_t)(CyclesNow() - cycles) < 0);
+}
@@ -15,9 +15,70 @@
 /* Declaration of the I2C handle (defined in the stm32f4xx_hal.h library).*/
 I2C_HandleTypeDef hi2c1;
 
+/**
+ * @brief Semaphore given by the interrupt that ends a transfer (completion or error).
+ */
+static kSem_t i2cDone;
+
+/**
+ * @brief Lock of the bus, held by a thread from the start to the end of its transfer.
+ */
+static kSem_t i2cLock;
+
+/**
+ * @brief Counts of the transfers.
+ */
+static i2cStats_t stats;
+
+/**
+ * @brief Flag set by the error interrupt of the transfer in progress.
+ */
+static volatile bool_t failed;
+
+/**
+ * @brief Counts a transfer started with a status.
+ */
+static void Count(HAL_StatusTypeDef status){
+	stats.transfers++;
+	if (status != HAL_OK) stats.errors++;
+}
+
+/**
+ * @brief Waits for the end of the transfer just started, resetting the peripheral if it never comes. Releases the
+ * bus.
+ */
+static void WaitTransfer(HAL_StatusTypeDef status){
+	Count(status);
+	if (status == HAL_OK){
+		if (!KernelSemTake(&i2cDone, I2C_IT_TIMEOUT)){
+			stats.timeouts++;
+			HAL_I2C_DeInit(&hi2c1);
+			HAL_I2C_Init(&hi2c1);
+		}
+		else if (failed) stats.errors++;
+	}
+	KernelSemGive(&i2cLock);
+}
+
 /*Delays the app for delayTime miliseconds. Declared in header file*/
 void I2CDelay(uint32_t delayTime){
-	HAL_Delay(delayTime);
+	if (KernelRunning()) KernelSleep(delayTime);
+	else HAL_Delay(delayTime);
+}
+
+/*Gets the counts of the transfers. Declared in header file*/
+void I2CGetStats(i2cStats_t *copy){
+	*copy = stats;
+}
+
+/*Handles the I2C1 error interrupt. Declared in header file*/
+void I2CErrorIRQHandler(void){
+	HAL_I2C_ER_IRQHandler(&hi2c1);
+}
+
+/*Handles the I2C1 event interrupt. Declared in header file*/
+void I2CEventIRQHandler(void){
+	HAL_I2C_EV_IRQHandler(&hi2c1);
 }
 
 /*Initialize the I2C protocol handle. Declared in header file*/
@@ -37,14 +98,78 @@ void I2CInit(){
   {
     Error_Handler();
   }
+  KernelSemInit(&i2cDone, 0, 1);
+  KernelSemInit(&i2cLock, 1, 1);
+  HAL_NVIC_SetPriority(I2C1_EV_IRQn, I2C_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+  HAL_NVIC_SetPriority(I2C1_ER_IRQn, I2C_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
+}
+
+/*Takes the bus. Declared in header file*/
+bool_t I2CLock(tick_t timeout){
+	return KernelSemTake(&i2cLock, timeout);
 }
 
 /*Writes the data buffer to the slave. Declared in header file*/
 void I2CMasterTransmit(uint16_t devAddr, uint8_t *buffer, uint16_t size){
-	HAL_I2C_Master_Transmit(&hi2c1, devAddr, buffer, size, TIMEOUT);
+	if (!KernelRunning()){
+		Count(HAL_I2C_Master_Transmit(&hi2c1, devAddr, buffer, size, TIMEOUT));
+		return;
+	}
+	KernelSemTake(&i2cLock, KERNEL_FOREVER);
+	KernelSemTake(&i2cDone, 0); /**< Drops a completion left by a transfer that timed out*/
+	failed = false;
+	TRACE_SPAN_BEGIN(TRACE_I2C, size);
+	WaitTransfer(HAL_I2C_Master_Transmit_IT(&hi2c1, devAddr, buffer, size));
+	TRACE_SPAN_END(TRACE_I2C, size);
 }
 
 /*Reads specific memory registers from a given IC. Declared in header file*/
 void I2CReadMemory(uint16_t startReg, uint16_t devAddr, uint8_t *buffer, uint16_t size){
-	HAL_I2C_Mem_Read(&hi2c1, devAddr, startReg, REG_SIZE, buffer, size, TIMEOUT);
+	if (!KernelRunning()){
+		Count(HAL_I2C_Mem_Read(&hi2c1, devAddr, startReg, REG_SIZE, buffer, size, TIMEOUT));
+		return;
+	}
+	KernelSemTake(&i2cLock, KERNEL_FOREVER);
+	KernelSemTake(&i2cDone, 0);
+	failed = false;
+	TRACE_SPAN_BEGIN(TRACE_I2C, size);
+	WaitTransfer(HAL_I2C_Mem_Read_IT(&hi2c1, devAddr, startReg, REG_SIZE, buffer, size));
+	TRACE_SPAN_END(TRACE_I2C, size);
+}
+
+/*Recomputes the timing from PCLK1. Declared in header file*/
+void I2CRetime(void){
+	HAL_I2C_Init(&hi2c1); /**< Resets the peripheral, which is idle while the bus is taken*/
+}
+
+/*Gives back the bus. Declared in header file*/
+void I2CUnlock(void){
+	KernelSemGive(&i2cLock);
+}
+
+/**
+ * @brief Callback of the HAL when a transmission ends: wakes the thread that waits for it.
+ */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c){
+	TRACE_POINT(TRACE_I2C_DONE, 0);
+	KernelSemGive(&i2cDone);
+}
+
+/**
+ * @brief Callback of the HAL when a memory read ends: wakes the thread that waits for it.
+ */
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c){
+	TRACE_POINT(TRACE_I2C_DONE, 1);
+	KernelSemGive(&i2cDone);
+}
+
+/**
+ * @brief Callback of the HAL when a transfer fails (e.g.: no acknowledge): wakes the thread that waits for it.
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c){
+	TRACE_POINT(TRACE_I2C_DONE, 2);
+	failed = true;
+	KernelSemGive(&i2cDone);
 }
@@ -0,0 +1,113 @@
+/**
+ * @file portKernel.c
+ * @brief Implementation of the Cortex-M4 port of the kernel.
+ *
+ * Contains the function definitions declared in portKernel.h and the PendSV handler,
+ * which first runs the deferred interrupt work (deferred.h) and then switches threads.
+ * On exception entry the core stacks r0-r3, r12, lr, pc and xPSR (and s0-s15 and FPSCR
+ * if the thread used the FPU) on the PSP; PendSV stacks the rest below them, so the
+ * saved stack pointer of a thread points to r4-r11 and its EXC_RETURN, whose bit 4
+ * tells whether s16-s31 are there too.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "portKernel.h"
+
+/**
+ * @brief Includes the deferred interrupt work run by PendSV.
+ */
+#include "deferred.h"
+
+/**
+ * @brief xPSR of the first frame: only the Thumb bit.
+ */
+#define INITIAL_XPSR 0x01000000U
+
+/**
+ * @brief EXC_RETURN of the first frame: thread mode, PSP, no FPU registers.
+ */
+#define INITIAL_EXC_RETURN 0xFFFFFFFDU
+
+/**
+ * @brief Return address of the function of a thread, which must never return.
+ */
+static void ThreadReturned(void){
+	Error_Handler();
+}
+
+/*Waits for the next interrupt. Declared in header file*/
+void KernelPortIdle(void){
+	__WFI();
+}
+
+/*Checks whether the caller is an interrupt. Declared in header file*/
+bool_t KernelPortInIsr(void){
+	return __get_IPSR() != 0;
+}
+
+/*Builds the first frame of a thread. Declared in header file*/
+void KernelPortInitStack(kThread_t *thread, void (*entry)(void)){
+	uint32_t *sp = (uint32_t *)((uint32_t)(thread->stack + thread->stackWords) & ~7U); /**< AAPCS: 8 byte aligned*/
+
+	*--sp = INITIAL_XPSR;
+	*--sp = (uint32_t)entry & ~1U; /**< pc*/
+	*--sp = (uint32_t)ThreadReturned; /**< lr*/
+	sp -= 5; /**< r12, r3, r2, r1, r0*/
+	*--sp = INITIAL_EXC_RETURN;
+	sp -= 8; /**< r11 to r4*/
+	thread->sp = sp;
+}
+
+/*Switches from main to the first thread. Declared in header file*/
+void KernelPortStart(void){
+	__enable_irq(); /**< The switch requested by KernelStart is taken here, main is left for good*/
+	for (;;);
+}
+
+/*Requests PendSV. Declared in header file*/
+void KernelPortSwitch(void){
+	SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+	__DSB();
+	__ISB();
+}
+
+/**
+ * @brief Handles the PendSV exception: runs the deferred work, then saves the context of kernelCurrent (if any) and
+ * restores the one of kernelNext, unless they are the same thread (or both NULL, before the kernel starts). At the
+ * first switch kernelCurrent is NULL and the frame of main is dropped.
+ */
+__attribute__((naked)) void PendSV_Handler(void){
+	__asm volatile(
+		"	push {r0, lr}			\n" /* EXC_RETURN, keeping the stack aligned to 8 bytes*/
+		"	bl DeferredRun			\n" /* With the interrupts enabled: it can wake threads*/
+		"	pop {r0, lr}			\n"
+		"	cpsid i					\n"
+		"	ldr r2, =kernelCurrent	\n"
+		"	ldr r1, [r2]			\n"
+		"	ldr r3, =kernelNext		\n"
+		"	ldr r3, [r3]			\n"
+		"	cmp r1, r3				\n"
+		"	beq 2f					\n"
+		"	cbz r1, 1f				\n"
+		"	mrs r0, psp				\n"
+		"	tst lr, #0x10			\n"
+		"	it eq					\n"
+		"	vstmdbeq r0!, {s16-s31}	\n" /* Only if the thread used the FPU*/
+		"	stmdb r0!, {r4-r11, lr}	\n"
+		"	str r0, [r1]			\n" /* kernelCurrent->sp*/
+		"1:							\n"
+		"	str r3, [r2]			\n" /* kernelCurrent = kernelNext*/
+		"	ldr r0, [r3]			\n"
+		"	ldmia r0!, {r4-r11, lr}	\n"
+		"	tst lr, #0x10			\n"
+		"	it eq					\n"
+		"	vldmiaeq r0!, {s16-s31}	\n"
+		"	msr psp, r0				\n"
+		"2:							\n"
+		"	cpsie i					\n"
+		"	bx lr					\n"
+		"	.ltorg					\n"
+	);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file portPower.c
+ * @brief Implementation of the wrapper PWR HAL functions of the STOP mode.
+ *
+ * Contains the function definitions declared in portPower.h and the EXTI3 handler.
+ * A long sleep loads SysTick with what is left of the current tick plus the whole ticks
+ * to sleep, so the interrupt falls on the usual tick boundary. On an earlier wake the
+ * cycles it counted give the ticks elapsed, and SysTick is loaded with what is left of
+ * the current one; its usual reload is put back for the following ticks.
+ * STOP leaves the core on the HSI with the PLL off: the clock mode it was stopped in is
+ * restored by portClock.h, which keeps the HSI trim and the measured clock.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "portPower.h"
+
+/*Selects the RX pin on EXTI3. Declared in header file*/
+void PowerPortInit(void){
+	SYSCFG->EXTICR[0] &= ~SYSCFG_EXTICR1_EXTI3; /**< PA3, still in its USART2 alternate function*/
+	EXTI->IMR &= ~POWER_RX_LINE;
+	EXTI->FTSR |= POWER_RX_LINE;
+	HAL_NVIC_SetPriority(POWER_RX_IRQN, POWER_RX_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(POWER_RX_IRQN);
+}
+
+/*Sleeps with SysTick reprogrammed. Declared in header file*/
+tick_t PowerPortSleep(tick_t ticks){
+	uint32_t period = SysTick->LOAD + 1;
+	uint32_t left, load, counted, rest;
+
+	if (ticks > SysTick_LOAD_RELOAD_Msk / period) ticks = SysTick_LOAD_RELOAD_Msk / period;
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+	left = SysTick->VAL;
+	if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) || (left == 0)){ /**< A tick is due: no sleep*/
+		SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+		return 0;
+	}
+	load = left + (ticks - 1) * period;
+	SysTick->LOAD = load - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+	SysTick->LOAD = period - 1; /**< Taken at the next reload*/
+
+	__WFI();
+
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk){ /**< Slept to the end: its interrupt counts the last tick*/
+		SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+		return ticks - 1;
+	}
+	counted = (period - left) + (load - SysTick->VAL); /**< Cycles from the start of the tick the sleep began in*/
+	rest = period - (counted % period);
+	if (rest == 1){ /**< A reload of 0 would stop SysTick: the boundary is taken as crossed*/
+		rest += period;
+		counted += period;
+	}
+	SysTick->LOAD = rest - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+	SysTick->LOAD = period - 1;
+	return counted / period;
+}
+
+/*Stops the core and restores the clock. Declared in header file*/
+uint32_t PowerPortStop(void){
+	uint32_t restore;
+
+	EXTI->PR = POWER_RX_LINE;
+	EXTI->IMR |= POWER_RX_LINE;
+	HAL_SuspendTick(); /**< A tick pending would wake the core at once*/
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+	restore = ClockPortResume(); /**< Also restarts SysTick*/
+	if ((EXTI->PR & POWER_RX_LINE) == 0) EXTI->IMR &= ~POWER_RX_LINE; /**< Otherwise its interrupt masks it*/
+	return restore;
+}
+
+/**
+ * @brief Handles the EXTI3 interrupt: the RX pin woke the core.
+ */
+void EXTI3_IRQHandler(void){
+	EXTI->PR = POWER_RX_LINE;
+	EXTI->IMR &= ~POWER_RX_LINE;
+	PowerRxWake();
+}
@@ -0,0 +1,78 @@
+/**
+ * @file portSQW.c
+ * @brief Implementations of the wrapper GPIO HAL functions of the timing inputs.
+ *
+ * This file contains function implementations for stamping the DS3231 SQW
+ * and 1 PPS edges. It relies on the HAL functions provided by stm32f4xx_hal.h.
+ */
+#include "portSQW.h"
+
+/**
+ * @brief Accumulated edges of each input. Written by the EXTI interrupts.
+ */
+static volatile edgeTrack_t tracks[EDGE_INPUTS];
+
+/*Stamps an edge of a timing input. Declared in header file*/
+void SQWEdge(uint16_t GPIO_Pin){
+	uint32_t now = CyclesNow(); /**< First thing, so that the stamp does not depend on the code below*/
+	volatile edgeTrack_t *track;
+	uint32_t elapsed;
+
+	if (GPIO_Pin == SQW_PIN) track = &tracks[SQW_INPUT];
+	else if (GPIO_Pin == PPS_PIN) track = &tracks[PPS_INPUT];
+	else return;
+
+	if (!track->started){
+		track->started = true;
+		track->last = now;
+		return;
+	}
+
+	elapsed = now - track->last; /**< Unsigned difference survives one wrap of the counter*/
+	if (elapsed < EDGE_MIN_PERIOD_US * CYCLES_PER_US) return;
+	track->cycles += elapsed;
+	track->periods++;
+	track->last = now;
+}
+
+/*Copies the edges of an input. Declared in header file*/
+void SQWGetTrack(edgeInput_t input, edgeTrack_t *track){
+	__disable_irq();
+	*track = *(edgeTrack_t *)&tracks[input];
+	__enable_irq();
+}
+
+/*Initializes the timing inputs. Declared in header file*/
+void SQWInit(void){
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	__HAL_RCC_GPIOC_CLK_ENABLE();
+
+	GPIO_InitStruct.Pin = SQW_PIN;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+	GPIO_InitStruct.Pull = GPIO_PULLUP; /**< INT/SQW is open drain*/
+	HAL_GPIO_Init(SQW_GPIO_PORT, &GPIO_InitStruct);
+
+	GPIO_InitStruct.Pin = PPS_PIN;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
+	GPIO_InitStruct.Pull = GPIO_PULLDOWN; /**< Reads low while no reference is connected*/
+	HAL_GPIO_Init(PPS_GPIO_PORT, &GPIO_InitStruct);
+
+	HAL_NVIC_SetPriority(SQW_EXTI_IRQN, SQW_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(SQW_EXTI_IRQN);
+	HAL_NVIC_SetPriority(PPS_EXTI_IRQN, SQW_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(PPS_EXTI_IRQN);
+
+	SQWReset();
+}
+
+/*Restarts the accumulation. Declared in header file*/
+void SQWReset(void){
+	__disable_irq();
+	for (uint8_t i = 0; i < EDGE_INPUTS; i++){
+		tracks[i].cycles = 0;
+		tracks[i].periods = 0;
+		tracks[i].started = false;
+	}
+	__enable_irq();
+}
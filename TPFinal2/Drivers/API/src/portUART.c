@@ -0,0 +1,547 @@
+/**
+ * @file portUART.c
+ * @brief Implementation of the wrapper UART HAL functions.
+ *
+ * This file contains the function definitions declared in portUART.h.
+ * Wraps HAL functions for other libraries' access. The reception runs on
+ * HAL_UARTEx_ReceiveToIdle_DMA in circular mode, which never ends: each event gives the
+ * position the DMA reached, and the bytes since the last one are handed to the lines.
+ * The transmission sends the transmit buffer from its tail with HAL_UART_Transmit_DMA,
+ * up to its head or its end; the completion of each chunk starts the next one. The
+ * senders copy in with the interrupts masked, for a few microseconds per line, so a
+ * thread and an interrupt can send at the same time. A thread that finds no room blocks
+ * on a semaphore given at the end of every chunk, so the others run meanwhile. _write, weak in syscalls.c, is
+ * defined here to send stdout and stderr with UARTWrite.
+ * In frame mode every event hands its bytes to the frame and stops TIM7; an idle event
+ * starts it for the rest of the silence (the event itself comes a frame after the last
+ * byte). TIM7 shares the priority of the reception, so neither preempts the other.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "portUART.h"
+
+/**
+ * @brief Includes the semaphore the senders wait for room on.
+ */
+#include "kernel.h"
+
+/**
+ * @brief Includes the trace of the reception events.
+ */
+#include "trace.h"
+
+#include <string.h>
+
+/* Declaration of the UART handle. Defined and initialized in the main */
+extern UART_HandleTypeDef huart2;
+
+/* Declaration of the error handler. Defined in the main */
+extern void Error_Handler(void);
+
+/**
+ * @brief DMA handles of the reception (DMA1 stream 5, channel 4, USART2_RX) and the transmission (DMA1 stream 6,
+ * channel 4, USART2_TX).
+ */
+static DMA_HandleTypeDef hdmaRx, hdmaTx;
+
+/**
+ * @brief Circular buffer written by the DMA.
+ */
+static uint8_t rxRing[UART_RX_RING];
+
+/**
+ * @brief Position of the circular buffer up to which the bytes were handed to the lines.
+ */
+static uint16_t rxTail;
+
+/**
+ * @brief Slots of the queue of lines. The line being received is built in the slot after the last one.
+ */
+static char lines[UART_LINE_SLOTS][UART_LINE_SIZE];
+
+/**
+ * @brief Cycle counter at the first byte of each line.
+ */
+static uint32_t lineStamps[UART_LINE_SLOTS];
+
+/**
+ * @brief Slot of the oldest line and number of lines in the queue.
+ */
+static uint8_t lineHead;
+static volatile uint8_t lineCount;
+
+/**
+ * @brief Length of the line being received.
+ */
+static uint8_t buildingLength;
+
+/**
+ * @brief Cycle counter at the first byte of the line being received.
+ */
+static uint32_t buildingStamp;
+
+/**
+ * @brief Flags to check whether a line is being received and whether it found the queue full.
+ */
+static bool buildingStarted, buildingDropped;
+
+/**
+ * @brief Tick of the last byte received.
+ */
+static volatile uint32_t rxTick;
+
+/**
+ * @brief Statistics: lines dropped and reception errors.
+ */
+static uint32_t linesDropped, rxErrors;
+
+/**
+ * @brief Silence (in us) that ends a frame, 0 while receiving lines.
+ */
+static volatile uint16_t frameGap;
+
+/**
+ * @brief Frame being received and its length.
+ */
+static uint8_t frame[UART_FRAME_SIZE];
+static uint16_t frameLength;
+
+/**
+ * @brief Cycle counter at the end of the last byte of the frame.
+ */
+static uint32_t frameStamp;
+
+/**
+ * @brief Flags to check whether the frame is complete (until UARTFrameFree), whether it got too long and whether
+ * bytes are being dropped because it was not freed.
+ */
+static volatile bool frameReady;
+static bool frameOverflow, frameDropping;
+
+/**
+ * @brief Circular transmit buffer.
+ */
+static uint8_t txRing[UART_TX_RING];
+
+/**
+ * @brief Position of the transmit buffer where the next byte is written, and of the first one not sent yet.
+ */
+static volatile uint16_t txHead, txTail;
+
+/**
+ * @brief Bytes the DMA is sending from the tail, 0 while it is idle.
+ */
+static volatile uint16_t txChunk;
+
+/**
+ * @brief Semaphore given when the DMA frees a chunk, for the threads that wait for room.
+ */
+static kSem_t txRoom;
+
+/**
+ * @brief Statistics: bytes dropped by UARTWrite.
+ */
+static uint32_t txDropped;
+
+/**
+ * @brief Gets the position of the circular buffer the DMA writes next.
+ */
+static uint16_t RxPosition(void){
+	return (UART_RX_RING - __HAL_DMA_GET_COUNTER(&hdmaRx)) % UART_RX_RING;
+}
+
+/**
+ * @brief Hands the bytes up to a position of the circular buffer to the lines. Called from the interrupt.
+ * An idle event comes a frame after the last byte, the half and full events right after it.
+ */
+static void ParseRing(uint16_t position, bool idle){
+	uint32_t frame = SystemCoreClock / huart2.Init.BaudRate * UART_FRAME_BITS;
+	uint32_t now = CyclesNow();
+	uint16_t after = (position - rxTail + UART_RX_RING) % UART_RX_RING; /**< Bytes from the current one to the event*/
+	uint8_t slot, byte;
+
+	while (rxTail != position){
+		byte = rxRing[rxTail];
+		rxTail = (rxTail + 1) % UART_RX_RING;
+		after--;
+		if (byte == '\r') continue;
+		slot = (lineHead + lineCount) % UART_LINE_SLOTS; /**< Unchanged by UARTLineFree, which moves both*/
+		if (!buildingStarted){
+			buildingStarted = true;
+			buildingStamp = now - (after + (idle ? 1 : 0)) * frame;
+			buildingDropped = (lineCount == UART_LINE_SLOTS);
+		}
+		if (byte == '\n'){
+			if (buildingDropped) linesDropped++;
+			else{
+				lines[slot][buildingLength] = '\0';
+				lineStamps[slot] = buildingStamp;
+				lineCount++;
+				UARTLineReceived();
+			}
+			buildingStarted = false;
+			buildingLength = 0;
+		}
+		else if (!buildingDropped && (buildingLength < UART_LINE_SIZE - 1)){
+			lines[slot][buildingLength++] = byte;
+		}
+	}
+}
+
+/**
+ * @brief Clears the line and the frame being received. Interrupts masked or from the interrupt.
+ */
+static void ClearBuilding(void){
+	buildingStarted = false;
+	buildingLength = 0;
+	TIM7->CR1 &= ~TIM_CR1_CEN;
+	TIM7->SR = 0;
+	if (!frameReady) frameLength = 0;
+	frameOverflow = false;
+	frameDropping = false;
+}
+
+/**
+ * @brief Hands the bytes up to a position of the circular buffer to the frame, in frame mode. Called from the
+ * interrupt. An idle event starts TIM7 for the rest of the silence.
+ */
+static void ParseFrame(uint16_t position, bool idle){
+	uint32_t frameMicros = UART_FRAME_BITS * 1000000 / huart2.Init.BaudRate;
+
+	TIM7->CR1 &= ~TIM_CR1_CEN; /**< The silence was broken*/
+	TIM7->SR = 0;
+	while (rxTail != position){
+		if (frameReady) frameDropping = true;
+		else if (frameLength < UART_FRAME_SIZE) frame[frameLength++] = rxRing[rxTail];
+		else frameOverflow = true;
+		rxTail = (rxTail + 1) % UART_RX_RING;
+	}
+	if (!idle) return;
+	if (frameDropping){
+		linesDropped++;
+		frameDropping = false;
+	}
+	if (frameReady || (frameLength == 0)) return;
+	frameStamp = CyclesNow() - SystemCoreClock / huart2.Init.BaudRate * UART_FRAME_BITS;
+	TIM7->ARR = (frameGap > frameMicros) ? (frameGap - frameMicros - 1) : 0;
+	TIM7->EGR = TIM_EGR_UG; /**< Restarts the count without setting UIF (URS)*/
+	TIM7->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * @brief Starts the circular reception from the beginning of the buffer.
+ */
+static void StartRing(void){
+	rxTail = 0;
+	HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rxRing, UART_RX_RING);
+}
+
+/**
+ * @brief Gets the prescaler of TIM7 for 1 us ticks: the APB1 timers run at twice PCLK1 when it is divided.
+ */
+static uint32_t TimerPrescaler(void){
+	uint32_t clock = HAL_RCC_GetPCLK1Freq();
+
+	if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) clock *= 2;
+	return clock / 1000000 - 1;
+}
+
+/**
+ * @brief Counts bytes of the output as dropped.
+ */
+static void TxDrop(uint16_t size){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	txDropped += size;
+	__set_PRIMASK(mask);
+}
+
+/**
+ * @brief Starts the DMA on the bytes from the tail up to the head or the end of the buffer, if it is idle.
+ * Interrupts masked.
+ */
+static void TxKick(void){
+	if ((txChunk != 0) || (txHead == txTail)) return;
+	txChunk = (txHead > txTail) ? (txHead - txTail) : (UART_TX_RING - txTail);
+	HAL_UART_Transmit_DMA(&huart2, &txRing[txTail], txChunk);
+}
+
+/**
+ * @brief Copies a buffer into the transmit buffer if it fits whole, and starts the DMA.
+ */
+static bool TxQueue(const uint8_t *buffer, uint16_t size){
+	uint32_t mask = __get_PRIMASK();
+	uint16_t free, first;
+
+	__disable_irq();
+	free = UART_TX_RING - 1 - ((txHead - txTail + UART_TX_RING) % UART_TX_RING);
+	if (size > free){
+		__set_PRIMASK(mask);
+		return false;
+	}
+	first = (size < UART_TX_RING - txHead) ? size : (UART_TX_RING - txHead);
+	memcpy(&txRing[txHead], buffer, first);
+	memcpy(txRing, &buffer[first], size - first);
+	txHead = (txHead + size) % UART_TX_RING;
+	TxKick();
+	__set_PRIMASK(mask);
+	return true;
+}
+
+/**
+ * @brief Copies a buffer into the transmit buffer, waiting for room. Threads only: before the kernel starts the wait
+ * is a poll.
+ */
+static void TxSend(const uint8_t *buffer, uint16_t size){
+	uint16_t part;
+
+	while (size > 0){
+		part = (size < UART_TX_RING / 2) ? size : (UART_TX_RING / 2);
+		while (!TxQueue(buffer, part)) KernelSemTake(&txRoom, UART_TX_WAIT); /**< The DMA frees the chunk it is sending*/
+		buffer += part;
+		size -= part;
+	}
+}
+
+/*Handles the half, full and idle line events of the reception*/
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size){
+	if (huart->Instance != USART2) return;
+	TRACE_POINT(TRACE_UART_RX, Size);
+	rxTick = HAL_GetTick();
+	if (frameGap != 0) ParseFrame(Size % UART_RX_RING, HAL_UARTEx_GetRxEventType(huart) == HAL_UART_RXEVENT_IDLE);
+	else ParseRing(Size % UART_RX_RING, HAL_UARTEx_GetRxEventType(huart) == HAL_UART_RXEVENT_IDLE);
+}
+
+/*Restarts whatever an error stopped: the reception (e.g. overrun) or, after a DMA error, the transmission*/
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart){
+	if (huart->Instance != USART2) return;
+	if (huart->RxState == HAL_UART_STATE_READY){
+		rxErrors++;
+		ClearBuilding();
+		StartRing();
+	}
+	if ((txChunk != 0) && (huart->gState == HAL_UART_STATE_READY)){ /**< The chunk is lost*/
+		txDropped += txChunk;
+		txTail = (txTail + txChunk) % UART_TX_RING;
+		txChunk = 0;
+		TxKick();
+		KernelSemGive(&txRoom);
+	}
+}
+
+/*Frees the chunk sent and sends the next one*/
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
+	if (huart->Instance != USART2) return;
+	txTail = (txTail + txChunk) % UART_TX_RING;
+	txChunk = 0;
+	TxKick();
+	KernelSemGive(&txRoom);
+}
+
+/*Sends stdout and stderr without waiting. Overrides the weak definition in syscalls.c*/
+int _write(int file, char *ptr, int len){
+	if ((file != 1) && (file != 2)) return -1;
+	UARTWrite((const uint8_t *)ptr, len); /**< A full buffer drops the bytes: they count as written*/
+	return len;
+}
+
+/*Handles the interrupt of the reception stream. Declared in header file*/
+void UARTRxDmaIRQHandler(void){
+	HAL_DMA_IRQHandler(&hdmaRx);
+}
+
+/*Frees the frame received. Declared in header file*/
+void UARTFrameFree(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	frameReady = false;
+	frameLength = 0;
+	__set_PRIMASK(mask);
+}
+
+/*Gets the frame received. Declared in header file*/
+uint8_t *UARTFrameGet(uint16_t *size, uint32_t *stamp){
+	if (!frameReady) return NULL;
+	*size = frameLength;
+	*stamp = frameStamp;
+	return frame;
+}
+
+/*Switches between frames and lines. Declared in header file*/
+void UARTFrameMode(uint16_t gap){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	frameGap = gap;
+	frameReady = false;
+	ClearBuilding();
+	TIM7->PSC = TimerPrescaler();
+	__set_PRIMASK(mask);
+}
+
+/*Sends a frame. Declared in header file*/
+void UARTFrameSend(const uint8_t *buffer, uint16_t size){
+	TxSend(buffer, size);
+}
+
+/*Ends a frame after its silence. Declared in header file*/
+void UARTFrameTimerIRQHandler(void){
+	TIM7->SR = 0;
+	if ((frameGap == 0) || frameReady || (frameLength == 0)) return;
+	if (RxPosition() != rxTail) return; /**< Bytes not handed over yet: their event starts the silence again*/
+	if (frameOverflow){
+		rxErrors++;
+		frameLength = 0;
+		frameOverflow = false;
+		return;
+	}
+	frameReady = true;
+	UARTFrameReceived();
+}
+
+/*Gets the number of lines waiting. Declared in header file*/
+uint8_t UARTLineCount(void){
+	return lineCount;
+}
+
+/*Frees the slot of the oldest line. Declared in header file*/
+void UARTLineFree(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	if (lineCount > 0){
+		lineHead = (lineHead + 1) % UART_LINE_SLOTS;
+		lineCount--;
+	}
+	__set_PRIMASK(mask);
+}
+
+/*Gets the oldest line. Declared in header file*/
+char *UARTLineGet(uint32_t *stamp){
+	if (lineCount == 0) return NULL;
+	*stamp = lineStamps[lineHead];
+	return lines[lineHead];
+}
+
+/*Gets the lines dropped. Declared in header file*/
+uint32_t UARTLinesDropped(void){
+	return linesDropped;
+}
+
+/*Clears the counts of the reception and UARTWrite. Declared in header file*/
+void UARTResetStats(void){
+	linesDropped = 0;
+	rxErrors = 0;
+	txDropped = 0;
+}
+
+/*Recomputes the baud rate divider. Declared in header file*/
+void UARTRetime(void){
+	uint32_t mask = __get_PRIMASK();
+	uint32_t cr3;
+
+	__disable_irq();
+	cr3 = huart2.Instance->CR3;
+	if (txChunk != 0){ /**< Pauses the DMA between two bytes, until the one on the line has left*/
+		huart2.Instance->CR3 = cr3 & ~USART_CR3_DMAT;
+		while ((huart2.Instance->SR & USART_SR_TC) == 0);
+	}
+	huart2.Instance->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(), huart2.Init.BaudRate); /**< Takes effect from the next frame*/
+	huart2.Instance->CR3 = cr3;
+	TIM7->PSC = TimerPrescaler(); /**< Loaded at the next start*/
+	__set_PRIMASK(mask);
+}
+
+/*Gets the reception errors. Declared in header file*/
+uint32_t UARTRxErrors(void){
+	return rxErrors;
+}
+
+/*Gets the tick of the last byte received. Declared in header file*/
+uint32_t UARTRxTick(void){
+	if (RxPosition() != rxTail) return HAL_GetTick(); /**< Written by the DMA, not handed over yet: a line is arriving*/
+	return rxTick;
+}
+
+/*Sends a string to the host. Declared in header file*/
+void UARTSendString(char *str){
+	UARTTransmit((uint8_t *)str, strlen(str));
+}
+
+/*Sends a buffer to the host. Declared in header file*/
+void UARTTransmit(uint8_t *buffer, uint16_t size){
+	if (frameGap != 0) TxDrop(size); /**< Text would corrupt the frames*/
+	else TxSend(buffer, size);
+}
+
+/*Handles the interrupt of the transmission stream. Declared in header file*/
+void UARTTxDmaIRQHandler(void){
+	HAL_DMA_IRQHandler(&hdmaTx);
+}
+
+/*Gets the bytes dropped by UARTWrite. Declared in header file*/
+uint32_t UARTTxDropped(void){
+	return txDropped;
+}
+
+/*Checks whether everything was sent. Declared in header file*/
+bool UARTTxIdle(void){
+	return (txChunk == 0) && (txHead == txTail);
+}
+
+/*Gets the bytes waiting to be sent. Declared in header file*/
+uint16_t UARTTxUsed(void){
+	return (txHead - txTail + UART_TX_RING) % UART_TX_RING;
+}
+
+/*Queues a buffer without waiting. Declared in header file*/
+bool UARTWrite(const uint8_t *buffer, uint16_t size){
+	if ((frameGap == 0) && TxQueue(buffer, size)) return true;
+	TxDrop(size);
+	return false;
+}
+
+/*Starts receiving lines. Declared in header file*/
+void UARTStartReception(void){
+	KernelSemInit(&txRoom, 0, 1);
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	hdmaRx.Instance = DMA1_Stream5;
+	hdmaRx.Init.Channel = DMA_CHANNEL_4;
+	hdmaRx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	hdmaRx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdmaRx.Init.MemInc = DMA_MINC_ENABLE;
+	hdmaRx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdmaRx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdmaRx.Init.Mode = DMA_CIRCULAR;
+	hdmaRx.Init.Priority = DMA_PRIORITY_HIGH;
+	hdmaRx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if (HAL_DMA_Init(&hdmaRx) != HAL_OK) Error_Handler();
+	__HAL_LINKDMA(&huart2, hdmarx, hdmaRx);
+
+	hdmaTx.Instance = DMA1_Stream6;
+	hdmaTx.Init = hdmaRx.Init;
+	hdmaTx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdmaTx.Init.Mode = DMA_NORMAL;
+	hdmaTx.Init.Priority = DMA_PRIORITY_LOW;
+	if (HAL_DMA_Init(&hdmaTx) != HAL_OK) Error_Handler();
+	__HAL_LINKDMA(&huart2, hdmatx, hdmaTx);
+
+	HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, UART_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+	HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, UART_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+	HAL_NVIC_SetPriority(USART2_IRQn, UART_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(USART2_IRQn);
+
+	__HAL_RCC_TIM7_CLK_ENABLE();
+	TIM7->CR1 = TIM_CR1_OPM | TIM_CR1_URS;						/**< One pulse; only the overflow sets UIF*/
+	TIM7->PSC = TimerPrescaler();
+	TIM7->DIER = TIM_DIER_UIE;
+	HAL_NVIC_SetPriority(TIM7_IRQn, UART_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(TIM7_IRQn);
+	StartRing();
+}
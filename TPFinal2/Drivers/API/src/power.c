@@ -0,0 +1,228 @@
+/**
+ * @file power.c
+ * @brief Implementation of the idle sleep and the low-power mode.
+ *
+ * Contains the function definitions declared in power.h.
+ * The ticks skipped by a sleep and the ticks lost in STOP are counted the same way, as
+ * if SysTick had interrupted at each of them: the timers and timeouts due meanwhile
+ * expire at once, in order.
+ * The check and the stop run with the interrupts masked: an interrupt that arrives in
+ * between stays pending and wakes the core at once. The tick delay at an SQW edge is
+ * the time the core was stopped since the last edge (it only falls behind while
+ * stopped), so it is also what the duty cycle counts as stopped.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "power.h"
+
+/**
+ * @brief Includes the function that waits for the next interrupt.
+ */
+#include "portKernel.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Flag to check whether the low-power mode is on.
+ */
+static bool_t enabled;
+
+/**
+ * @brief Holds of the core (PowerHold).
+ */
+static uint8_t holds;
+
+/**
+ * @brief Tick until which the core keeps running (PowerKeepAwake).
+ */
+static volatile tick_t awakeUntil;
+
+/**
+ * @brief Tick of the last SQW edge, once one arrived.
+ */
+static tick_t edgeTick;
+static bool_t edgeSeen;
+
+/**
+ * @brief Wake waiting for its first frame: cycle counter after the restore of the clock and time of the restore (us).
+ */
+static bool_t waking;
+static uint32_t wakeStamp, wakeRestore;
+
+/**
+ * @brief Statistics: stops, wakes measured, their worst and total latency (us), worst restore (us), ticks stopped,
+ * ticks skipped by the sleeps and tick of the last reset.
+ */
+static uint32_t stops, wakes, latencyMax, restoreMax, stoppedTicks, skippedTicks, resetTick;
+static uint64_t latencyTotal;
+
+/**
+ * @brief Counts ticks the SysTick interrupt did not: the HAL tick, the software timers and the kernel timeouts.
+ * PendSV, SysTick or interrupts masked.
+ */
+static void Advance(tick_t ticks){
+	for (tick_t i = 0; i < ticks; i++) HAL_IncTick();
+	SwTimerAdvance(ticks);
+	KernelAdvance(ticks);
+}
+
+/**
+ * @brief Checks whether the core can stop until the next event. Interrupts masked.
+ */
+static bool_t CanStop(void){
+	tick_t now = HAL_GetTick();
+
+	if (!enabled || (holds > 0) || !edgeSeen) return false;
+	if ((int32_t)(awakeUntil - now) > 0) return false;
+	if ((now - edgeTick) >= POWER_EDGE_PERIOD) return false; /**< No edge lately: the SQW output is off and would not wake it*/
+	if (KernelNextTimeout() != KERNEL_FOREVER) return false; /**< A thread in the middle of a transfer or a delay*/
+	if (!UARTTxIdle()) return false; /**< The transmission would stop with the clocks*/
+	return SwTimerNextExpiry() >= edgeTick + POWER_EDGE_PERIOD - now; /**< Otherwise the timer would be late*/
+}
+
+/**
+ * @brief Deferred half of the SQW edge: moves the tick, the timers and the kernel up to the edge.
+ */
+static void Resync(uint32_t tick, uint32_t stamp){
+	tick_t lag = edgeTick + POWER_EDGE_PERIOD - tick;
+
+	if (enabled && edgeSeen && ((int32_t)lag >= POWER_RESYNC_MIN) && (lag < POWER_EDGE_PERIOD)){
+		Advance(lag);
+		stoppedTicks += lag;
+		tick += lag;
+	}
+	edgeTick = tick;
+	edgeSeen = true;
+	if (enabled) PowerSecond();
+}
+
+/*Turns the mode on or off. Declared in header file*/
+void PowerEnable(bool_t enable){
+	enabled = enable;
+}
+
+/*Checks whether the mode is on. Declared in header file*/
+bool_t PowerEnabled(void){
+	return enabled;
+}
+
+/*Keeps the core running. Declared in header file*/
+void PowerHold(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	holds++;
+	__set_PRIMASK(mask);
+}
+
+/*Stops the core or waits for an interrupt. Declared in header file*/
+void PowerIdle(void){
+	uint32_t mask = __get_PRIMASK();
+	uint32_t restore;
+	tick_t next, skipped;
+
+	__disable_irq();
+	if (!CanStop()){
+		next = KernelNextTimeout();
+		if (SwTimerNextExpiry() < next) next = SwTimerNextExpiry();
+		if (next < POWER_SLEEP_MIN) KernelPortIdle(); /**< The next tick matters*/
+		else{
+			skipped = PowerPortSleep(next);
+			Advance(skipped);
+			skippedTicks += skipped;
+		}
+		__set_PRIMASK(mask);
+		return;
+	}
+	stops++;
+	restore = PowerPortStop();
+	wakeStamp = CyclesNow();
+	wakeRestore = restore;
+	waking = true;
+	if (restore > restoreMax) restoreMax = restore;
+	__set_PRIMASK(mask); /**< The interrupt that woke the core runs here*/
+}
+
+/*Initializes the mode. Declared in header file*/
+void PowerInit(void){
+	PowerPortInit();
+	PowerResetStats();
+}
+
+/*Keeps the core running for some time. Declared in header file*/
+void PowerKeepAwake(tick_t time){
+	uint32_t mask = __get_PRIMASK();
+	tick_t until = HAL_GetTick() + time;
+
+	__disable_irq();
+	if ((int32_t)(until - awakeUntil) > 0) awakeUntil = until;
+	__set_PRIMASK(mask);
+}
+
+/*Ends a hold. Declared in header file*/
+void PowerRelease(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	if (holds > 0) holds--;
+	__set_PRIMASK(mask);
+}
+
+/*Measures the latency of the first frame after a wake. Declared in header file*/
+void PowerRendered(void){
+	uint32_t latency;
+
+	if (!waking) return;
+	waking = false;
+	latency = wakeRestore + CyclesToMicros(CyclesNow() - wakeStamp);
+	wakes++;
+	latencyTotal += latency;
+	if (latency > latencyMax) latencyMax = latency;
+}
+
+/*Sends the statistics. Declared in header file*/
+void PowerReport(void){
+	char line[192];
+	uint32_t elapsed = HAL_GetTick() - resetTick;
+	uint32_t running, ticking;
+
+	/* A stop or sleep that began before the statistics were cleared counts whole, so right after PR the ticks it
+	 * skipped can pass the time elapsed*/
+	running = (stoppedTicks < elapsed) ? (elapsed - stoppedTicks) : 0;
+	ticking = (skippedTicks < running) ? (running - skippedTicks) : 0;
+
+	snprintf(line, sizeof(line),
+			"power mode=%s stops=%lu wake=%luus max=%luus restore=%luus duty=%lu/1000 ticks=%lu/s time=%lums\r\n",
+			enabled ? "stop" : "run", (unsigned long)stops,
+			(unsigned long)(wakes ? latencyTotal / wakes : 0), (unsigned long)latencyMax, (unsigned long)restoreMax,
+			(unsigned long)(elapsed ? (uint64_t)running * 1000 / elapsed : 1000),
+			(unsigned long)(elapsed ? (uint64_t)ticking * 1000 / elapsed : 1000),
+			(unsigned long)elapsed);
+	UARTSendString(line);
+}
+
+/*Clears the statistics. Declared in header file*/
+void PowerResetStats(void){
+	stops = 0;
+	wakes = 0;
+	latencyTotal = 0;
+	latencyMax = 0;
+	restoreMax = 0;
+	stoppedTicks = 0;
+	skippedTicks = 0;
+	resetTick = HAL_GetTick();
+}
+
+/*Hands the edge to PendSV. Declared in header file*/
+void PowerSqwEdge(void){
+	DeferredPost(Resync, HAL_GetTick());
+}
+
+/**
+ * @brief Callback of the RX wake (EXTI3 interrupt): the rest of the command is coming.
+ */
+void PowerRxWake(void){
+	PowerKeepAwake(POWER_RX_AWAKE);
+}
@@ -0,0 +1,182 @@
+/**
+ * @file scheduler.c
+ * @brief Implementation of the cooperative task scheduler.
+ *
+ * Contains the function definitions declared in scheduler.h.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "scheduler.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Table of tasks.
+ */
+static schedTask_t *tasks;
+
+/**
+ * @brief Amount of tasks.
+ */
+static uint8_t taskCount;
+
+/**
+ * @brief Cycles elapsed and spent inside the tasks since the statistics were reset.
+ */
+static uint64_t elapsedCycles, busyCycles;
+
+/**
+ * @brief Cycle counter at the last call, to accumulate the elapsed cycles before the counter wraps (59 s at 72 MHz).
+ */
+static uint32_t lastCycles;
+
+/**
+ * @brief Adds the cycles elapsed since the last call.
+ */
+static void AccountElapsed(void){
+	uint32_t now = CyclesNow();
+
+	elapsedCycles += (uint32_t)(now - lastCycles);
+	lastCycles = now;
+}
+
+/**
+ * @brief Takes the release of a task if it is due. Returns whether it is, with the tick it was released at.
+ */
+static bool_t TakeRelease(schedTask_t *task, tick_t now, tick_t *release){
+	if (task->signaled){
+		*release = task->signalTime;
+		task->signaled = false; /**< Before the run: a signal during it runs the task again*/
+		return true;
+	}
+	if ((task->period == 0) || ((int32_t)(now - task->release) < 0)) return false;
+	*release = task->release;
+	task->release += task->period;
+	if ((int32_t)(now - task->release) >= 0) task->release = now + task->period; /**< Overrun: the missed releases are skipped*/
+	return true;
+}
+
+/*Gets the cycles inside the tasks and elapsed. Declared in header file*/
+void SchedulerGetCycles(uint64_t *busy, uint64_t *elapsed){
+	AccountElapsed();
+	*busy = busyCycles;
+	*elapsed = elapsedCycles;
+}
+
+/*Takes the table of tasks. Declared in header file*/
+void SchedulerInit(schedTask_t *table, uint8_t count){
+	tick_t now = HAL_GetTick();
+
+	tasks = table;
+	taskCount = count;
+	for (uint8_t i = 0; i < taskCount; i++){
+		tasks[i].release = now + tasks[i].period;
+	}
+	SchedulerResetStats();
+}
+
+/*Gets the deadline misses of all the tasks. Declared in header file*/
+uint32_t SchedulerMisses(void){
+	uint32_t misses = 0;
+
+	for (uint8_t i = 0; i < taskCount; i++) misses += tasks[i].misses;
+	return misses;
+}
+
+/*Gets the ticks to the next release. Declared in header file*/
+tick_t SchedulerNextRelease(void){
+	tick_t now = HAL_GetTick();
+	tick_t next = SCHEDULER_NO_RELEASE, left;
+
+	for (uint8_t i = 0; i < taskCount; i++){
+		if (tasks[i].signaled) return 0;
+		if (tasks[i].period == 0) continue;
+		left = ((int32_t)(tasks[i].release - now) > 0) ? tasks[i].release - now : 0;
+		if (left < next) next = left;
+	}
+	return next;
+}
+
+/*Sends the statistics. Declared in header file*/
+void SchedulerReport(void){
+	char line[80];
+	schedTask_t *task;
+
+	AccountElapsed();
+	for (uint8_t i = 0; i < taskCount; i++){
+		task = &tasks[i];
+		sprintf(line, "task %s runs=%lu wcet=%luus avg=%luus miss=%lu\r\n", task->name, (unsigned long)task->runs,
+				(unsigned long)CyclesToMicros(task->worstCycles),
+				(unsigned long)CyclesToMicros(task->runs ? (uint32_t)(task->totalCycles / task->runs) : 0),
+				(unsigned long)task->misses);
+		UARTSendString(line);
+	}
+	sprintf(line, "cpu load=%lu/1000 time=%lums\r\n",
+			(unsigned long)(elapsedCycles ? busyCycles * 1000 / elapsedCycles : 0),
+			(unsigned long)(elapsedCycles / (SystemCoreClock / 1000)));
+	UARTSendString(line);
+}
+
+/*Clears the statistics. Declared in header file*/
+void SchedulerResetStats(void){
+	for (uint8_t i = 0; i < taskCount; i++){
+		tasks[i].runs = 0;
+		tasks[i].misses = 0;
+		tasks[i].worstCycles = 0;
+		tasks[i].totalCycles = 0;
+	}
+	elapsedCycles = 0;
+	busyCycles = 0;
+	lastCycles = CyclesNow();
+}
+
+/*Runs the first released task. Declared in header file*/
+bool_t SchedulerRunNext(void){
+	tick_t now = HAL_GetTick();
+	tick_t release;
+	uint32_t start, cycles;
+	schedTask_t *task = NULL;
+
+	AccountElapsed();
+	for (uint8_t i = 0; i < taskCount; i++){
+		if (TakeRelease(&tasks[i], now, &release)){
+			task = &tasks[i];
+			break;
+		}
+	}
+	if (task == NULL) return false;
+
+	TRACE_SPAN_BEGIN(TRACE_TASK, task - tasks);
+	start = CyclesNow();
+	task->run();
+	cycles = CyclesNow() - start;
+	TRACE_SPAN_END(TRACE_TASK, task - tasks);
+
+	task->runs++;
+	task->totalCycles += cycles;
+	busyCycles += cycles;
+	if (cycles > task->worstCycles) task->worstCycles = cycles;
+	if ((HAL_GetTick() - release) > task->deadline) task->misses++;
+	return true;
+}
+
+/*Changes the period of a task. Declared in header file*/
+void SchedulerSetPeriod(uint8_t task, tick_t period){
+	if (task >= taskCount) return;
+	tasks[task].period = period;
+	tasks[task].release = HAL_GetTick() + period;
+}
+
+/*Releases a task. Declared in header file*/
+void SchedulerSignal(uint8_t task){
+	if ((task >= taskCount) || tasks[task].signaled) return;
+	tasks[task].signalTime = HAL_GetTick();
+	tasks[task].signaled = true;
+}
+
+/*Gets the name of a task. Declared in header file*/
+const char *SchedulerTaskName(uint8_t task){
+	return (task < taskCount) ? tasks[task].name : NULL;
+}
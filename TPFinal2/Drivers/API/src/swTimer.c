@@ -0,0 +1,225 @@
+/**
+ * @file swTimer.c
+ * @brief Implementation of the software timer service.
+ *
+ * Contains the function definitions declared in swTimer.h.
+ * A timer at level L lies in the slot given by bits [6L, 6L+6) of its expiry tick, and the level is the
+ * lowest one whose turn covers the distance to it. When the first level completes a turn, the current
+ * slot of the second level is moved down (and so on up), so every timer reaches the first level before
+ * it expires. The lists are changed both by the tick interrupt and by the main loop (or the button
+ * interrupt), so every change masks the interrupts; none of them walks more than one slot.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "swTimer.h"
+
+#include <stddef.h>
+
+/**
+ * @brief States of a timer.
+ */
+typedef enum{
+	TIMER_IDLE,
+	TIMER_ARMED,
+	TIMER_EXPIRED
+} timerState_t;
+
+/**
+ * @brief Slot lists of every level.
+ */
+static swTimer_t *wheel[SW_TIMER_LEVELS][SW_TIMER_SLOTS];
+
+/**
+ * @brief SW_TIMER_LOOP timers that expired, waiting for SwTimerDispatch.
+ */
+static swTimer_t *expired;
+
+/**
+ * @brief Ticks processed by the wheel.
+ */
+static tick_t wheelTime;
+
+/**
+ * @brief Links a timer at the head of a list.
+ */
+static void Link(swTimer_t **head, swTimer_t *timer){
+	timer->next = *head;
+	if (*head != NULL) (*head)->link = &timer->next;
+	timer->link = head;
+	*head = timer;
+}
+
+/**
+ * @brief Unlinks a timer from the list it is in.
+ */
+static void Unlink(swTimer_t *timer){
+	*timer->link = timer->next;
+	if (timer->next != NULL) timer->next->link = timer->link;
+	timer->next = NULL;
+	timer->link = NULL;
+}
+
+/**
+ * @brief Puts a timer in the slot of its expiry, at the lowest level whose turn covers it.
+ */
+static void Insert(swTimer_t *timer){
+	tick_t distance = timer->expires - wheelTime;
+	uint8_t level = 0;
+
+	while ((level < SW_TIMER_LEVELS - 1) && (distance >> (SW_TIMER_BITS * (level + 1)))) level++;
+	Link(&wheel[level][(timer->expires >> (SW_TIMER_BITS * level)) & (SW_TIMER_SLOTS - 1)], timer);
+	timer->state = TIMER_ARMED;
+}
+
+/**
+ * @brief Moves the current slot of a level down to the levels below.
+ */
+static void Cascade(uint8_t level){
+	swTimer_t *list = wheel[level][(wheelTime >> (SW_TIMER_BITS * level)) & (SW_TIMER_SLOTS - 1)];
+	swTimer_t *next;
+
+	wheel[level][(wheelTime >> (SW_TIMER_BITS * level)) & (SW_TIMER_SLOTS - 1)] = NULL;
+	for (; list != NULL; list = next){
+		next = list->next;
+		Insert(list);
+	}
+}
+
+/**
+ * @brief Limits a delay to the range of the wheel.
+ */
+static tick_t Clamp(tick_t ticks){
+	return (ticks > SW_TIMER_MAX_DELAY) ? SW_TIMER_MAX_DELAY : ticks;
+}
+
+/*Advances the wheel several ticks. Declared in header file*/
+void SwTimerAdvance(tick_t ticks){
+	uint32_t mask;
+	tick_t skip;
+
+	while (ticks > 0){
+		mask = __get_PRIMASK();
+		__disable_irq();
+		for (skip = 0; (skip + 1 < ticks) && (((wheelTime + skip + 1) & (SW_TIMER_SLOTS - 1)) != 0) &&
+				(wheel[0][(wheelTime + skip + 1) & (SW_TIMER_SLOTS - 1)] == NULL); skip++);
+		wheelTime += skip; /**< Ticks that neither expire a timer nor cascade a level*/
+		__set_PRIMASK(mask);
+		SwTimerTick();
+		ticks -= skip + 1;
+	}
+}
+
+/*Runs the expired timers of the main loop. Declared in header file*/
+void SwTimerDispatch(void){
+	swTimer_t *timer;
+	uint32_t mask;
+
+	while (expired != NULL){
+		mask = __get_PRIMASK();
+		__disable_irq();
+		timer = expired;
+		Unlink(timer);
+		timer->state = TIMER_IDLE;
+		if (timer->period != 0){
+			timer->expires += timer->period; /**< From the expiry, not from now: no drift*/
+			if ((int32_t)(timer->expires - wheelTime) <= 0) timer->expires = wheelTime + 1; /**< Late by a whole period: no burst to catch up*/
+			Insert(timer);
+		}
+		__set_PRIMASK(mask);
+		timer->callback(timer->arg); /**< It can restart or stop its own timer*/
+	}
+}
+
+/*Initializes a timer. Declared in header file*/
+void SwTimerInit(swTimer_t *timer, swTimerCallback_t callback, uint32_t arg, uint8_t context){
+	SwTimerStop(timer);
+	timer->callback = callback;
+	timer->arg = arg;
+	timer->context = context;
+	timer->period = 0;
+}
+
+/*Checks whether a timer is running. Declared in header file*/
+bool_t SwTimerIsRunning(const swTimer_t *timer){
+	return timer->state != TIMER_IDLE;
+}
+
+/*Gets the ticks to the next expiry. Declared in header file*/
+tick_t SwTimerNextExpiry(void){
+	uint32_t mask = __get_PRIMASK();
+	tick_t next = SW_TIMER_NONE, slot, start;
+	uint8_t shift;
+
+	__disable_irq();
+	if (expired != NULL) next = 0;
+	for (uint8_t level = 0; level < SW_TIMER_LEVELS; level++){
+		shift = SW_TIMER_BITS * level;
+		for (tick_t distance = 1; distance <= SW_TIMER_SLOTS; distance++){
+			slot = (wheelTime >> shift) + distance;
+			if (wheel[level][slot & (SW_TIMER_SLOTS - 1)] == NULL) continue;
+			start = (slot << shift) - wheelTime; /**< A lower level can hold a later timer: every level is looked at*/
+			if (start < next) next = start;
+			break;
+		}
+	}
+	__set_PRIMASK(mask);
+	return next;
+}
+
+/*Starts a timer. Declared in header file*/
+void SwTimerStart(swTimer_t *timer, tick_t delay, tick_t period){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	if (timer->state != TIMER_IDLE) Unlink(timer);
+	timer->expires = wheelTime + ((delay == 0) ? 1 : Clamp(delay));
+	timer->period = Clamp(period);
+	Insert(timer);
+	__set_PRIMASK(mask);
+}
+
+/*Stops a timer. Declared in header file*/
+void SwTimerStop(swTimer_t *timer){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	if (timer->state != TIMER_IDLE) Unlink(timer);
+	timer->state = TIMER_IDLE;
+	__set_PRIMASK(mask);
+}
+
+/*Advances the wheel. Declared in header file*/
+void SwTimerTick(void){
+	uint32_t mask = __get_PRIMASK();
+	swTimer_t *list, *timer;
+	uint8_t level = 1;
+	bool_t queued = false;
+
+	__disable_irq();
+	wheelTime++;
+	while ((level < SW_TIMER_LEVELS) && ((wheelTime & ((1UL << (SW_TIMER_BITS * level)) - 1)) == 0)) level++;
+	while (--level > 0) Cascade(level); /**< Highest level first, so its timers can go on cascading down*/
+
+	list = wheel[0][wheelTime & (SW_TIMER_SLOTS - 1)]; /**< Detached: a timer restarted by its callback can land in this slot again*/
+	wheel[0][wheelTime & (SW_TIMER_SLOTS - 1)] = NULL;
+	if (list != NULL) list->link = &list;
+	while ((timer = list) != NULL){
+		Unlink(timer);
+		if (timer->context == SW_TIMER_LOOP){
+			Link(&expired, timer);
+			timer->state = TIMER_EXPIRED;
+			queued = true;
+			continue;
+		}
+		timer->state = TIMER_IDLE;
+		if (timer->period != 0){
+			timer->expires += timer->period;
+			Insert(timer);
+		}
+		timer->callback(timer->arg);
+	}
+	__set_PRIMASK(mask);
+	if (queued) SwTimerExpired();
+}
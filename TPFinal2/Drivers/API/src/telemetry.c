@@ -0,0 +1,155 @@
+/**
+ * @file telemetry.c
+ * @brief Implementation of the binary telemetry stream.
+ *
+ * Contains the function definitions declared in telemetry.h.
+ * The CRC is computed bit by bit (about 80 bytes per frame do not pay for a table)
+ * and the frame is encoded straight into the buffer handed to the UART.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "telemetry.h"
+
+#include <string.h>
+
+/**
+ * @brief Size of an encoded frame: the frame and its CRC, one COBS code byte (less than 254 bytes need one) and
+ * the two delimiters.
+ */
+#define ENCODED_SIZE (sizeof(telemetryFrame_t) + 2 + 1 + 2)
+
+/**
+ * @brief Timer of the period.
+ */
+static swTimer_t timer;
+
+/**
+ * @brief Period (ms), 0 while the stream is off.
+ */
+static tick_t period;
+
+/**
+ * @brief Frames built and their sequence number.
+ */
+static uint32_t frames;
+
+/**
+ * @brief Cycles inside the tasks and elapsed at the last frame, for the load since then.
+ */
+static uint64_t lastBusy, lastElapsed;
+
+/**
+ * @brief Computes the CRC-16/CCITT of a buffer.
+ */
+static uint16_t Crc16(const uint8_t *data, uint16_t size){
+	uint16_t crc = 0xFFFF;
+
+	while (size--){
+		crc ^= (uint16_t)(*data++) << 8;
+		for (uint8_t bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	return crc;
+}
+
+/**
+ * @brief COBS encodes a buffer: every zero byte is replaced by the distance to the next one. Returns the size
+ * written, one more than the input (up to 254 bytes).
+ */
+static uint16_t CobsEncode(const uint8_t *data, uint16_t size, uint8_t *out){
+	uint16_t code = 0, written = 1;
+
+	for (uint16_t i = 0; i < size; i++){
+		if (data[i] == 0){
+			out[code] = written - code;
+			code = written++;
+		}
+		else out[written++] = data[i];
+	}
+	out[code] = written - code;
+	return written;
+}
+
+/**
+ * @brief Fills the fields of the modules below the application.
+ */
+static void Fill(telemetryFrame_t *frame){
+	i2cStats_t i2c;
+	latencyStats_t latency;
+	uint64_t busy, elapsed;
+
+	frame->version = TELEMETRY_VERSION;
+	frame->sequence = (uint16_t)frames;
+	frame->uptime = HAL_GetTick();
+	SchedulerGetCycles(&busy, &elapsed);
+	if (elapsed < lastElapsed) lastBusy = lastElapsed = 0; /**< The statistics were reset*/
+	frame->load = (elapsed > lastElapsed) ? (uint16_t)((busy - lastBusy) * 1000 / (elapsed - lastElapsed)) : 0;
+	lastBusy = busy;
+	lastElapsed = elapsed;
+	I2CGetStats(&i2c);
+	frame->i2cTransfers = i2c.transfers;
+	frame->i2cErrors = i2c.errors + i2c.timeouts;
+	for (uint8_t screen = 0; screen < LAT_SCREEN_COUNT; screen++){
+		LatencyGetStats(screen, &latency);
+		frame->latency[screen].count = (latency.count > UINT16_MAX) ? UINT16_MAX : latency.count;
+		frame->latency[screen].avg = latency.avg;
+		frame->latency[screen].max = latency.max;
+	}
+	frame->uartLines = UARTLineCount();
+	frame->txUsed = UARTTxUsed();
+	frame->deadlineMisses = SchedulerMisses();
+	frame->rxErrors = UARTRxErrors();
+	frame->linesDropped = UARTLinesDropped();
+	frame->txDropped = UARTTxDropped();
+}
+
+/**
+ * @brief Callback of the timer: builds a frame and queues it.
+ */
+static void SendFrame(uint32_t arg){
+	uint8_t raw[sizeof(telemetryFrame_t) + 2];
+	uint8_t encoded[ENCODED_SIZE];
+	telemetryFrame_t frame = {0};
+	uint16_t crc, size;
+
+	Fill(&frame);
+	TelemetrySample(&frame);
+	memcpy(raw, &frame, sizeof(frame));
+	crc = Crc16(raw, sizeof(frame));
+	raw[sizeof(frame)] = crc & 0xFF;
+	raw[sizeof(frame) + 1] = crc >> 8;
+	encoded[0] = 0;
+	size = CobsEncode(raw, sizeof(raw), &encoded[1]) + 1;
+	encoded[size++] = 0;
+	UARTWrite(encoded, size);
+	frames++;
+}
+
+/*Gets the frames built. Declared in header file*/
+uint32_t TelemetryFrames(void){
+	return frames;
+}
+
+/*Initializes the timer. Declared in header file*/
+void TelemetryInit(void){
+	SwTimerInit(&timer, SendFrame, 0, SW_TIMER_LOOP);
+}
+
+/*Gets the period. Declared in header file*/
+tick_t TelemetryPeriod(void){
+	return period;
+}
+
+/*Starts or stops the stream. Declared in header file*/
+bool_t TelemetryStart(tick_t newPeriod){
+	if ((newPeriod != 0) && (newPeriod < TELEMETRY_MIN_PERIOD)) return false;
+	period = newPeriod;
+	if (period == 0){
+		SwTimerStop(&timer);
+		return true;
+	}
+	SchedulerGetCycles(&lastBusy, &lastElapsed);
+	SwTimerStart(&timer, 1, period);
+	return true;
+}
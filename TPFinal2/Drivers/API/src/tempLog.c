@@ -0,0 +1,290 @@
+/**
+ * @file tempLog.c
+ * @brief Implementation of the temperature history log.
+ *
+ * Contains the function definitions declared in tempLog.h.
+ * The oldest sample is kept as an absolute value and every following sample
+ * as the delta to the previous one, written as 2-bit symbols in a ring.
+ * A sample that does not follow the previous one by TEMPLOG_PERIOD is preceded
+ * by an anchor with its time, so the times of the older samples stay right.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "tempLog.h"
+
+/**
+ * @brief Symbol for a sample equal to the previous one.
+ */
+#define SYMBOL_SAME 0
+
+/**
+ * @brief Symbol for a sample 0.25 C above the previous one.
+ */
+#define SYMBOL_UP 1
+
+/**
+ * @brief Symbol for a sample 0.25 C below the previous one.
+ */
+#define SYMBOL_DOWN 2
+
+/**
+ * @brief Symbol followed by an 8-bit delta, written as four more symbols (high bits first).
+ */
+#define SYMBOL_ESCAPE 3
+
+/**
+ * @brief Symbols that follow an escape.
+ */
+#define ESCAPE_LENGTH 4
+
+/**
+ * @brief Delta after an escape that marks an anchor instead of a sample.
+ */
+#define ANCHOR_DELTA 0x80
+
+/**
+ * @brief Symbols of the time (32 bits, high bits first) that follow an anchor.
+ */
+#define ANCHOR_LENGTH 16
+
+/**
+ * @brief Size (in bits) of a symbol.
+ */
+#define SYMBOL_SIZE 2
+
+/**
+ * @brief Mask of a symbol.
+ */
+#define SYMBOL_MASK 0x03
+
+/**
+ * @brief Symbols per byte.
+ */
+#define SYMBOLS_PER_BYTE 4
+
+/**
+ * @brief Capacity of the ring in symbols.
+ */
+#define TEMPLOG_SYMBOLS (TEMPLOG_SIZE * SYMBOLS_PER_BYTE)
+
+/**
+ * @brief Ring with the encoded deltas.
+ */
+static uint8_t data[TEMPLOG_SIZE];
+
+/**
+ * @brief Samples stored.
+ */
+static uint16_t count;
+
+/**
+ * @brief Position where the next symbol is written.
+ */
+static uint16_t head;
+
+/**
+ * @brief Position of the first symbol (delta of the second oldest sample).
+ */
+static uint16_t tail;
+
+/**
+ * @brief Symbols stored.
+ */
+static uint16_t used;
+
+/**
+ * @brief Samples dropped since the history was emptied: the number of the oldest sample.
+ */
+static uint32_t dropped;
+
+/**
+ * @brief Temperature of the oldest sample.
+ */
+static int16_t oldest;
+
+/**
+ * @brief Temperature of the newest sample.
+ */
+static int16_t newest;
+
+/**
+ * @brief Time of the oldest sample.
+ */
+static uint32_t oldestEpoch;
+
+/**
+ * @brief Time of the newest sample.
+ */
+static uint32_t newestEpoch;
+
+/**
+ * @brief Reads the symbol at a given position of the ring.
+ */
+static uint8_t ReadSymbol(uint16_t position){
+	return (data[position / SYMBOLS_PER_BYTE] >> ((position % SYMBOLS_PER_BYTE) * SYMBOL_SIZE)) & SYMBOL_MASK;
+}
+
+/**
+ * @brief Writes a symbol at the head of the ring.
+ */
+static void WriteSymbol(uint8_t symbol){
+	uint8_t shift = (head % SYMBOLS_PER_BYTE) * SYMBOL_SIZE;
+	uint8_t *byte = &data[head / SYMBOLS_PER_BYTE];
+
+	*byte = (*byte & ~(SYMBOL_MASK << shift)) | (symbol << shift);
+	head = (head + 1) % TEMPLOG_SYMBOLS;
+	used++;
+}
+
+/**
+ * @brief Reads the given symbols at a position as a number (high bits first) and advances the position past them.
+ */
+static uint32_t ReadBits(uint16_t *position, uint8_t symbols){
+	uint32_t raw = 0;
+
+	for (uint8_t i = 0; i < symbols; i++){
+		raw = (raw << SYMBOL_SIZE) | ReadSymbol(*position);
+		*position = (*position + 1) % TEMPLOG_SYMBOLS;
+	}
+	return raw;
+}
+
+/**
+ * @brief Writes a number (high bits first) as the given symbols at the head of the ring.
+ */
+static void WriteBits(uint32_t raw, uint8_t symbols){
+	for (int8_t i = symbols - 1; i >= 0; i--){
+		WriteSymbol((raw >> (i * SYMBOL_SIZE)) & SYMBOL_MASK);
+	}
+}
+
+/**
+ * @brief Decodes the delta of the next sample at a given position and advances the position past it.
+ * The time of the previous sample is advanced to the one of the next sample (from its anchor, if any).
+ */
+static int16_t ReadDelta(uint16_t *position, uint32_t *epoch){
+	uint8_t symbol = ReadSymbol(*position);
+	uint8_t raw;
+
+	*position = (*position + 1) % TEMPLOG_SYMBOLS;
+	if (symbol == SYMBOL_ESCAPE){
+		raw = ReadBits(position, ESCAPE_LENGTH);
+		if (raw != ANCHOR_DELTA){
+			*epoch += TEMPLOG_PERIOD;
+			return (int8_t)raw;
+		}
+		*epoch = ReadBits(position, ANCHOR_LENGTH);
+		symbol = ReadSymbol(*position);
+		*position = (*position + 1) % TEMPLOG_SYMBOLS;
+		if (symbol == SYMBOL_ESCAPE) return (int8_t)ReadBits(position, ESCAPE_LENGTH);
+	}
+	else *epoch += TEMPLOG_PERIOD;
+
+	switch(symbol){
+	case SYMBOL_UP: return 1;
+	case SYMBOL_DOWN: return -1;
+	default: return 0;
+	}
+}
+
+/**
+ * @brief Drops the oldest sample, turning the second oldest into the absolute one.
+ */
+static void DropOldest(void){
+	uint16_t position = tail;
+
+	oldest += ReadDelta(&position, &oldestEpoch);
+	used -= (position + TEMPLOG_SYMBOLS - tail) % TEMPLOG_SYMBOLS;
+	tail = position;
+	count--;
+	dropped++;
+}
+
+/*Appends a sample to the history. Declared in header file*/
+void TempLogAdd(int16_t temperature, uint32_t epoch){
+	int16_t delta = temperature - newest;
+	bool anchor = (epoch != newestEpoch + TEMPLOG_PERIOD); /**< Samples skipped (time not valid) or time changed*/
+	uint8_t needed;
+
+	if (count == 0){
+		oldest = newest = temperature;
+		oldestEpoch = newestEpoch = epoch;
+		count = 1;
+		return;
+	}
+
+	if (delta > TEMPLOG_MAX_DELTA) delta = TEMPLOG_MAX_DELTA; /**< Not reachable by the DS3231 in one period, kept for safety*/
+	if (delta < TEMPLOG_MIN_DELTA) delta = TEMPLOG_MIN_DELTA;
+	needed = ((delta >= -1) && (delta <= 1)) ? 1 : 1 + ESCAPE_LENGTH;
+	if (anchor) needed += 1 + ESCAPE_LENGTH + ANCHOR_LENGTH;
+	while (TEMPLOG_SYMBOLS - used < needed) DropOldest();
+
+	if (anchor){
+		WriteSymbol(SYMBOL_ESCAPE);
+		WriteBits(ANCHOR_DELTA, ESCAPE_LENGTH);
+		WriteBits(epoch, ANCHOR_LENGTH);
+	}
+	if (delta == 0) WriteSymbol(SYMBOL_SAME);
+	else if (delta == 1) WriteSymbol(SYMBOL_UP);
+	else if (delta == -1) WriteSymbol(SYMBOL_DOWN);
+	else{
+		WriteSymbol(SYMBOL_ESCAPE);
+		WriteBits((uint8_t)delta, ESCAPE_LENGTH);
+	}
+	newest += delta;
+	newestEpoch = epoch;
+	count++;
+}
+
+/*Returns the amount of samples stored. Declared in header file*/
+uint16_t TempLogCount(void){
+	return count;
+}
+
+/*Places an iterator on the oldest sample. Declared in header file*/
+void TempLogFirst(tempLogIterator_t *it){
+	it->position = tail;
+	it->remaining = count;
+	it->value = oldest;
+	it->epoch = oldestEpoch;
+	it->index = dropped;
+}
+
+/*Empties the history. Declared in header file*/
+void TempLogInit(void){
+	count = 0;
+	head = 0;
+	tail = 0;
+	used = 0;
+	dropped = 0;
+}
+
+/*Returns the sample under the iterator and advances it. Declared in header file*/
+bool TempLogNext(tempLogIterator_t *it, int16_t *temperature, uint32_t *epoch){
+	uint16_t remaining;
+
+	if (it->remaining == 0) return false;
+	if (it->index < dropped){ /**< Its symbols may have been written over: goes on from the oldest sample*/
+		if (dropped - it->index >= it->remaining){
+			it->remaining = 0;
+			return false;
+		}
+		remaining = it->remaining - (dropped - it->index);
+		TempLogFirst(it);
+		it->remaining = remaining; /**< Without the samples added since it was placed*/
+	}
+
+	*temperature = it->value;
+	*epoch = it->epoch;
+	it->remaining--;
+	it->index++;
+	if (it->remaining > 0) it->value += ReadDelta(&it->position, &it->epoch);
+	return true;
+}
+
+/*Returns the bytes used by the encoded history. Declared in header file*/
+uint16_t TempLogUsage(void){
+	return (used + SYMBOLS_PER_BYTE - 1) / SYMBOLS_PER_BYTE;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file timeSync.c
+ * @brief Implementation of the setting of the DS3231 from the host clock.
+ *
+ * Contains the function definitions declared in timeSync.h.
+ * The local timescale extends the cycle counter to 64 bits at every event and converts
+ * it to microseconds at SystemCoreClock, so that it does not drift from the counter.
+ * Host and local times are signed 64-bit microseconds; the offset of the best round
+ * turns one into the other.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "timeSync.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Progress of the session and result of the last write.
+ */
+static timeSyncReport_t report;
+
+/**
+ * @brief Timer of the session: timeout of the rounds, write and check.
+ */
+static swTimer_t syncTimer;
+
+/**
+ * @brief Local timescale: cycles since the start of the session at a value of the cycle counter.
+ */
+static int64_t baseCount;
+static uint32_t baseCycles;
+
+/**
+ * @brief Last round: t1 (host), t2 and t3 (local), and whether it waits for its t4.
+ */
+static int64_t roundSend, roundReceive, roundReply;
+static bool roundPending;
+
+/**
+ * @brief Offset of the best round: local timescale minus host time (us).
+ */
+static int64_t offset;
+
+/**
+ * @brief Cycle counter at which the write starts.
+ */
+static uint32_t writeCycles;
+
+/**
+ * @brief Saturates a difference to 32 bits.
+ */
+static int32_t Clamp(int64_t value){
+	if (value > INT32_MAX) return INT32_MAX;
+	if (value < INT32_MIN) return INT32_MIN;
+	return (int32_t)value;
+}
+
+/**
+ * @brief Converts a value of the cycle counter, within 29.8 s of the base, to the local timescale.
+ */
+static int64_t Local(uint32_t stamp){
+	return (baseCount + (int32_t)(stamp - baseCycles)) * 1000000 / SystemCoreClock;
+}
+
+/**
+ * @brief Converts a time of the local timescale, within 29.8 s of the base, to a value of the cycle counter.
+ */
+static uint32_t Cycles(int64_t local){
+	return baseCycles + (uint32_t)(local * SystemCoreClock / 1000000 - baseCount);
+}
+
+/**
+ * @brief Moves the base of the local timescale to the current cycle counter, returning its time.
+ */
+static int64_t Advance(void){
+	uint32_t now = CyclesNow();
+
+	baseCount += (uint32_t)(now - baseCycles);
+	baseCycles = now;
+	return Local(now);
+}
+
+/**
+ * @brief Writes the second written and the errors measured around it.
+ */
+static void FormatWrite(char *text){
+	DS3231_DateTime set;
+	char rtc[16] = "?", edge[16] = "none";
+
+	TzEpochToDateTime(report.second, &set);
+	if (report.rtcKnown) sprintf(rtc, "%+ldms", (long)report.rtcError);
+	if (report.edgeSeen) sprintf(edge, "%+ldus", (long)report.edgeError);
+	sprintf(text, "%04u-%02u-%02u %02u:%02u:%02u rtc=%s edge=%s", set.Year, set.Month, set.Date, set.Hours, set.Minutes,
+			set.Seconds, rtc, edge);
+}
+
+/**
+ * @brief Starts the timer of the write of report.second, at its start on the host clock minus the I2C time to the
+ * seconds byte.
+ */
+static void Schedule(void){
+	int64_t write = (int64_t)report.second * 1000000 + offset - SYNC_WRITE_BITS * 1000000LL / CLOCKSPEED;
+	int64_t now = Advance();
+
+	writeCycles = Cycles(write);
+	report.state = SYNC_WRITING;
+	SwTimerStart(&syncTimer, (write - now) / 1000 - SYNC_LEAD, 0);
+}
+
+/**
+ * @brief Writes the second when its cycle comes, or schedules the next one if the timer expired too late.
+ */
+static void Write(void){
+	DS3231_DateTime set;
+
+	TzEpochToDateTime(report.second, &set); /**< The day of week comes from the date*/
+	I2CLock(KERNEL_FOREVER); /**< Waits for a transfer in progress to end*/
+	if ((int32_t)(CyclesNow() - writeCycles) > 0){
+		I2CUnlock();
+		report.second++;
+		Schedule();
+		return;
+	}
+	CyclesWaitUntil(writeCycles);
+	I2CUnlock();
+	SetTime(&set);
+	report.state = SYNC_CHECKING;
+	SwTimerStart(&syncTimer, SYNC_CHECK_TIME, 0);
+	TimeSyncWritten();
+}
+
+/**
+ * @brief Compares the first SQW edge after the write with the next host second, sends the result and ends the session.
+ */
+static void Check(void){
+	edgeTrack_t track;
+	char text[64];
+
+	SQWGetTrack(SQW_INPUT, &track);
+	Advance();
+	report.edgeSeen = track.started && ((int32_t)(track.last - writeCycles) > 0);
+	if (report.edgeSeen){
+		report.edgeError = Clamp(Local(track.last) - ((int64_t)(report.second + 1) * 1000000 + offset));
+	}
+	FormatWrite(text);
+	ConsoleReply("SYNC SET %s delay=%luus", text, (unsigned long)report.delay);
+	TimeSyncStop();
+}
+
+/**
+ * @brief Callback of the session timer (timers task): ends the rounds, writes or checks, by state.
+ */
+static void SyncExpired(uint32_t arg){
+	switch (report.state){
+	case SYNC_ROUNDS:
+		TimeSyncStop(); /**< No round for SYNC_TIMEOUT*/
+		break;
+	case SYNC_WRITING:
+		Write();
+		break;
+	case SYNC_CHECKING:
+		Check();
+		break;
+	default:
+		break;
+	}
+}
+
+/*Copies the progress. Declared in header file*/
+void TimeSyncGetReport(timeSyncReport_t *copy){
+	*copy = report;
+}
+
+/*Initializes the timer. Declared in header file*/
+void TimeSyncInit(void){
+	SwTimerInit(&syncTimer, SyncExpired, 0, SW_TIMER_LOOP);
+	report = (timeSyncReport_t){0};
+}
+
+/*Completes the last round. Declared in header file*/
+void TimeSyncReceived(uint64_t hostReceive){
+	int64_t delay, sample;
+
+	if (!roundPending || (report.state != SYNC_ROUNDS)) return;
+	roundPending = false;
+	delay = ((int64_t)hostReceive - roundSend) - (roundReply - roundReceive);
+	if ((delay < 0) || (delay > UINT32_MAX)) return; /**< The host clock stepped*/
+	sample = ((roundReceive - roundSend) + (roundReply - (int64_t)hostReceive)) / 2;
+	if ((report.rounds == 0) || (delay <= report.delay)){ /**< The latest of equal rounds: the least drift*/
+		offset = sample;
+		report.delay = delay;
+	}
+	report.rounds++;
+}
+
+/*Sends the progress. Declared in header file*/
+void TimeSyncReport(void){
+	static const char *states[] = {"idle", "rounds", "writing", "checking"};
+	char text[64] = "";
+
+	if (report.second != 0) FormatWrite(text);
+	ConsoleReply("SYNC %s rounds=%u delay=%luus%s%s", states[report.state], report.rounds,
+			(unsigned long)report.delay, (report.second != 0) ? " last=" : "", text);
+}
+
+/*Starts a round. Declared in header file*/
+bool_t TimeSyncRound(uint64_t hostSend, uint32_t stamp){
+	bool first = (report.state == SYNC_IDLE);
+
+	if ((report.state == SYNC_WRITING) || (report.state == SYNC_CHECKING)) return false;
+	if (first){ /**< The timescale counts cycles: the core must run, at one rate*/
+		PowerHold();
+		ClockHold();
+		SetSquareWave(true);
+		baseCount = 0;
+		baseCycles = stamp;
+		report.state = SYNC_ROUNDS;
+		report.rounds = 0;
+		report.delay = 0;
+	}
+	Advance();
+	roundSend = hostSend;
+	roundReceive = Local(stamp);
+	roundPending = !first; /**< The line that starts the session may have been stamped at another clock rate*/
+	SwTimerStart(&syncTimer, SYNC_TIMEOUT, 0);
+	roundReply = Local(CyclesNow());
+	ConsoleReply("SYNC %lu %lu", (unsigned long)(uint32_t)roundReceive, (unsigned long)(uint32_t)roundReply);
+	return true;
+}
+
+/*Schedules the write. Declared in header file*/
+bool_t TimeSyncSet(void){
+	edgeTrack_t before, after;
+	DS3231_DateTime rtc;
+	int64_t now, edge;
+	bool valid;
+
+	if ((report.state != SYNC_ROUNDS) || (report.rounds < SYNC_MIN_ROUNDS)) return false;
+	roundPending = false;
+	SQWGetTrack(SQW_INPUT, &before);
+	valid = GetTime(&rtc);
+	SQWGetTrack(SQW_INPUT, &after);
+	now = Advance();
+	edge = Local(after.last);
+	report.rtcKnown = valid && after.started && (after.last == before.last) && (now - edge < 1000000);
+	if (report.rtcKnown){ /**< Read in the second that started at the edge*/
+		report.rtcError = Clamp(((int64_t)TzDateTimeToEpoch(&rtc) * 1000000 - (edge - offset)) / 1000);
+	}
+	report.edgeSeen = false;
+	report.second = (now - offset + SYNC_MARGIN * 1000 + 999999) / 1000000;
+	Schedule();
+	return true;
+}
+
+/*Ends the session. Declared in header file*/
+void TimeSyncStop(void){
+	SwTimerStop(&syncTimer);
+	if (report.state != SYNC_IDLE){
+		SetSquareWave(PowerEnabled()); /**< The low-power mode wakes on its edges*/
+		PowerRelease();
+		ClockRelease();
+	}
+	report.state = SYNC_IDLE;
+	roundPending = false;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file timezone.c
+ * @brief Implementation of the UTC to local time conversion layer.
+ *
+ * Contains the function definitions declared in timezone.h.
+ * Converts datetimes to seconds since 01/01/2000 and looks the offset up
+ * in the transition tables compiled by Tools/tzgen.py.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "timezone.h"
+
+/**
+ * @brief Days elapsed in a non leap year before the first day of each month.
+ */
+static const uint16_t daysBeforeMonth[12] = {0,31,59,90,120,151,181,212,243,273,304,334};
+
+/**
+ * @brief Days of each month in a non leap year.
+ */
+static const uint8_t daysInMonth[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+
+/**
+ * @brief Zone used as local time.
+ */
+static uint8_t localZone = TZ_DEFAULT_ZONE;
+
+/**
+ * @brief Last transition row used for each zone. Time moves forward, so the next lookup
+ * usually hits the same row or the following one.
+ */
+static uint16_t lastRow[TZ_ZONE_COUNT];
+
+/**
+ * @brief Checks if a year between 2000 and 2099 is leap (2000 is, 2100 is out of range).
+ */
+static bool IsLeap(uint16_t year){
+	return ((year % 4) == 0);
+}
+
+/*Converts a datetime to seconds since 01/01/2000. Declared in header file*/
+uint32_t TzDateTimeToEpoch(DS3231_DateTime *time){
+	uint32_t years = time->Year - YEAR_CORRECTION;
+	uint32_t days = years * 365 + (years + 3) / 4; /**< (years + 3) / 4 leap days elapsed before this year, 2000 included*/
+
+	days += daysBeforeMonth[time->Month - 1] + (time->Date - 1);
+	if (IsLeap(time->Year) && (time->Month > 2)) days++;
+
+	return days * SECONDS_PER_DAY + time->Hours * SECONDS_PER_HOUR
+			+ time->Minutes * SECONDS_PER_MINUTE + time->Seconds;
+}
+
+/*Converts seconds since 01/01/2000 to a datetime. Declared in header file*/
+void TzEpochToDateTime(uint32_t epoch, DS3231_DateTime *time){
+	uint32_t days = epoch / SECONDS_PER_DAY;
+	uint32_t seconds = epoch % SECONDS_PER_DAY;
+	uint8_t month = 0;
+	uint8_t length;
+
+	time->Hours = seconds / SECONDS_PER_HOUR;
+	time->Minutes = (seconds % SECONDS_PER_HOUR) / SECONDS_PER_MINUTE;
+	time->Seconds = seconds % SECONDS_PER_MINUTE;
+	time->Day = ((days + EPOCH_DAY_OF_WEEK) % LAST_DAY) + FIRST_DAY;
+
+	time->Year = YEAR_CORRECTION + (days / DAYS_PER_4_YEARS) * 4;
+	days %= DAYS_PER_4_YEARS;
+	if (days >= 366){ /**< The first year of every 4 year block is the leap one*/
+		days -= 366;
+		time->Year++;
+		time->Year += days / 365;
+		days %= 365;
+	}
+
+	while (1){
+		length = daysInMonth[month] + ((month == 1) && IsLeap(time->Year));
+		if (days < length) break;
+		days -= length;
+		month++;
+	}
+	time->Month = month + 1;
+	time->Date = days + 1;
+}
+
+/*Returns the LCD label of a zone. Declared in header file*/
+const char *TzGetLabel(uint8_t zone){
+	return tzZones[zone].Label;
+}
+
+/*Returns the local zone. Declared in header file*/
+uint8_t TzGetLocalZone(void){
+	return localZone;
+}
+
+/*Gets the offset of a zone at a given UTC second. Declared in header file*/
+int32_t TzGetOffset(uint8_t zone, uint32_t utc, bool *dst){
+	const TZ_Transition *rows = tzZones[zone].Transitions;
+	uint16_t count = tzZones[zone].Count;
+	uint16_t row = lastRow[zone];
+
+	if (utc < rows[row].Utc) row = 0; /**< Time went backwards (e.g. it was set): search again from the start*/
+	while ((row + 1 < count) && (utc >= rows[row + 1].Utc)) row++;
+	lastRow[zone] = row;
+
+	if (dst != NULL) *dst = rows[row].Dst;
+	return rows[row].Offset * SECONDS_PER_MINUTE;
+}
+
+/*Converts a local datetime to UTC. Declared in header file*/
+bool TzLocalToUtc(uint8_t zone, DS3231_DateTime *local, DS3231_DateTime *utc){
+	uint32_t epoch = TzDateTimeToEpoch(local);
+	/* The offset depends on the UTC time we are looking for: guess it with the local time and refine once.
+	 * Local times skipped or repeated by a DST change resolve to the offset in effect after it*/
+	uint32_t guess = epoch - TzGetOffset(zone, epoch, NULL);
+	int64_t result = (int64_t)epoch - TzGetOffset(zone, guess, NULL);
+
+	if ((result < 0) || (result >= (int64_t)TZ_EPOCH_END)) return false; /**< Before 2000 or after 2099*/
+	TzEpochToDateTime((uint32_t)result, utc);
+	return true;
+}
+
+/*Selects the local zone. Declared in header file*/
+void TzSetLocalZone(uint8_t zone){
+	if (zone < TZ_ZONE_COUNT) localZone = zone;
+}
+
+/*Converts a UTC datetime to the local time of a zone. Declared in header file*/
+bool TzUtcToLocal(uint8_t zone, DS3231_DateTime *utc, DS3231_DateTime *local){
+	bool dst;
+	uint32_t epoch = TzDateTimeToEpoch(utc);
+
+	TzEpochToDateTime(epoch + TzGetOffset(zone, epoch, &dst), local);
+	return dst;
+}
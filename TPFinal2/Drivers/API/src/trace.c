@@ -0,0 +1,98 @@
+/**
+ * @file trace.c
+ * @brief Implementation of the event trace.
+ *
+ * Contains the function definitions declared in trace.h.
+ * Records are taken by TraceRecord, inlined in the header; this file holds the ring
+ * and sends it.
+ */
+
+/**
+ * @brief Includes the header file of this library.
+ */
+#include "trace.h"
+
+/**
+ * @brief Includes the names of the commands.
+ */
+#include "console.h"
+
+/**
+ * @brief Includes the names of the tasks.
+ */
+#include "scheduler.h"
+
+/**
+ * @brief Includes functions for sending the dump through USART2.
+ */
+#include "portUART.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Names of the events, in the order of traceEvent_t.
+ */
+static const char *names[TRACE_EVENTS] = {"task", "frame", "lcd_send", "get_time", "button", "i2c", "i2c_done",
+		"exti", "uart_rx", "command", "clock"};
+
+/*Ring of records. Declared in header file*/
+traceRecord_t traceRing[TRACE_SIZE];
+
+/*Records made. Declared in header file*/
+uint32_t traceCount;
+
+/*Flag of the recording. Declared in header file*/
+volatile bool_t traceOn = TRACE_ENABLE;
+
+/*Empties the ring. Declared in header file*/
+void TraceClear(void){
+	uint32_t mask = __get_PRIMASK();
+
+	__disable_irq();
+	traceCount = 0;
+	__set_PRIMASK(mask);
+}
+
+/*Sends the ring. Declared in header file*/
+void TraceDump(void){
+	char line[64];
+	bool_t on = traceOn;
+	uint32_t count = traceCount, first = (count > TRACE_SIZE) ? (count - TRACE_SIZE) : 0;
+	const kThread_t *thread;
+	const char *name;
+	traceRecord_t *record;
+
+	traceOn = false; /**< The dump would overwrite what it sends*/
+	snprintf(line, sizeof(line), "TRACE records=%lu lost=%lu clock=%lu\r\n", (unsigned long)(count - first),
+			(unsigned long)first, (unsigned long)SystemCoreClock);
+	UARTSendString(line);
+	for (uint8_t i = 0; i < TRACE_EVENTS; i++){
+		snprintf(line, sizeof(line), "TE %02X %s\r\n", i, names[i]);
+		UARTSendString(line);
+	}
+	for (uint8_t i = 0; (thread = KernelThreadGet(i)) != NULL; i++){
+		snprintf(line, sizeof(line), "TN %02X %s\r\n", thread->priority, thread->name);
+		UARTSendString(line);
+	}
+	for (uint8_t i = 0; (name = SchedulerTaskName(i)) != NULL; i++){
+		snprintf(line, sizeof(line), "TK %02X %s\r\n", i, name);
+		UARTSendString(line);
+	}
+	for (uint8_t i = 0; (name = ConsoleCommandName(i)) != NULL; i++){
+		snprintf(line, sizeof(line), "TC %02X %s\r\n", i, name);
+		UARTSendString(line);
+	}
+	for (uint32_t i = first; i < count; i++){
+		record = &traceRing[i & (TRACE_SIZE - 1)];
+		snprintf(line, sizeof(line), "TR %08lX %02X %02X %04X\r\n", (unsigned long)record->cycles, record->code,
+				record->context, record->arg);
+		UARTSendString(line);
+	}
+	UARTSendString("TRACE END\r\n");
+	traceOn = on;
+}
+
+/*Starts or stops the recording. Declared in header file*/
+void TraceEnable(bool_t enable){
+	traceOn = enable && TRACE_ENABLE;
+}
@@ -0,0 +1,644 @@
+/**
+ * @file tzdata.c
+ * @brief Transition tables of the time zones compiled into the firmware.
+ *
+ * Generated by Tools/tzgen.py from Tools/tzzones.txt. Do not edit.
+ * Each row holds the first UTC second (since 01/01/2000) an offset applies.
+ */
+#include "timezone.h"
+
+/* America/Argentina/Buenos_Aires */
+static const TZ_Transition tzBUE[6] = {
+	{0U, -180, 1},
+	{5367600U, -180, 0},
+	{252298800U, -120, 1},
+	{258948000U, -180, 0},
+	{277700400U, -120, 1},
+	{290397600U, -180, 0},
+};
+
+/* Etc/UTC */
+static const TZ_Transition tzUTC[1] = {
+	{0U, 0, 0},
+};
+
+/* America/Santiago */
+static const TZ_Transition tzSCL[199] = {
+	{0U, -180, 1},
+	{6145200U, -240, 0},
+	{24897600U, -180, 1},
+	{37594800U, -240, 0},
+	{56347200U, -180, 1},
+	{69044400U, -240, 0},
+	{87796800U, -180, 1},
+	{100494000U, -240, 0},
+	{119246400U, -180, 1},
+	{132548400U, -240, 0},
+	{150696000U, -180, 1},
+	{163998000U, -240, 0},
+	{182145600U, -180, 1},
+	{195447600U, -240, 0},
+	{214200000U, -180, 1},
+	{226897200U, -240, 0},
+	{245649600U, -180, 1},
+	{260161200U, -240, 0},
+	{277099200U, -180, 1},
+	{290401200U, -240, 0},
+	{308548800U, -180, 1},
+	{323665200U, -240, 0},
+	{339998400U, -180, 1},
+	{358138800U, -240, 0},
+	{367214400U, -180, 1},
+	{388983600U, -240, 0},
+	{399873600U, -180, 1},
+	{420433200U, -240, 0},
+	{431928000U, -180, 1},
+	{451882800U, -240, 0},
+	{463377600U, -180, 1},
+	{516596400U, -240, 0},
+	{524462400U, -180, 1},
+	{548046000U, -240, 0},
+	{555912000U, -180, 1},
+	{579495600U, -240, 0},
+	{587361600U, -180, 1},
+	{607921200U, -240, 0},
+	{621230400U, -180, 1},
+	{639370800U, -240, 0},
+	{652680000U, -180, 1},
+	{670820400U, -240, 0},
+	{684129600U, -180, 1},
+	{702270000U, -240, 0},
+	{716184000U, -180, 1},
+	{733719600U, -240, 0},
+	{747028800U, -180, 1},
+	{765774000U, -240, 0},
+	{779083200U, -180, 1},
+	{797223600U, -240, 0},
+	{810532800U, -180, 1},
+	{828673200U, -240, 0},
+	{841982400U, -180, 1},
+	{860122800U, -240, 0},
+	{873432000U, -180, 1},
+	{891572400U, -240, 0},
+	{904881600U, -180, 1},
+	{923626800U, -240, 0},
+	{936331200U, -180, 1},
+	{955076400U, -240, 0},
+	{968385600U, -180, 1},
+	{986526000U, -240, 0},
+	{999835200U, -180, 1},
+	{1017975600U, -240, 0},
+	{1031284800U, -180, 1},
+	{1049425200U, -240, 0},
+	{1062734400U, -180, 1},
+	{1080874800U, -240, 0},
+	{1094184000U, -180, 1},
+	{1112929200U, -240, 0},
+	{1125633600U, -180, 1},
+	{1144378800U, -240, 0},
+	{1157688000U, -180, 1},
+	{1175828400U, -240, 0},
+	{1189137600U, -180, 1},
+	{1207278000U, -240, 0},
+	{1220587200U, -180, 1},
+	{1238727600U, -240, 0},
+	{1252036800U, -180, 1},
+	{1270782000U, -240, 0},
+	{1283486400U, -180, 1},
+	{1302231600U, -240, 0},
+	{1315540800U, -180, 1},
+	{1333681200U, -240, 0},
+	{1346990400U, -180, 1},
+	{1365130800U, -240, 0},
+	{1378440000U, -180, 1},
+	{1396580400U, -240, 0},
+	{1409889600U, -180, 1},
+	{1428030000U, -240, 0},
+	{1441339200U, -180, 1},
+	{1460084400U, -240, 0},
+	{1472788800U, -180, 1},
+	{1491534000U, -240, 0},
+	{1504843200U, -180, 1},
+	{1522983600U, -240, 0},
+	{1536292800U, -180, 1},
+	{1554433200U, -240, 0},
+	{1567742400U, -180, 1},
+	{1585882800U, -240, 0},
+	{1599192000U, -180, 1},
+	{1617332400U, -240, 0},
+	{1630641600U, -180, 1},
+	{1649386800U, -240, 0},
+	{1662696000U, -180, 1},
+	{1680836400U, -240, 0},
+	{1694145600U, -180, 1},
+	{1712286000U, -240, 0},
+	{1725595200U, -180, 1},
+	{1743735600U, -240, 0},
+	{1757044800U, -180, 1},
+	{1775185200U, -240, 0},
+	{1788494400U, -180, 1},
+	{1807239600U, -240, 0},
+	{1819944000U, -180, 1},
+	{1838689200U, -240, 0},
+	{1851998400U, -180, 1},
+	{1870138800U, -240, 0},
+	{1883448000U, -180, 1},
+	{1901588400U, -240, 0},
+	{1914897600U, -180, 1},
+	{1933038000U, -240, 0},
+	{1946347200U, -180, 1},
+	{1964487600U, -240, 0},
+	{1977796800U, -180, 1},
+	{1996542000U, -240, 0},
+	{2009246400U, -180, 1},
+	{2027991600U, -240, 0},
+	{2041300800U, -180, 1},
+	{2059441200U, -240, 0},
+	{2072750400U, -180, 1},
+	{2090890800U, -240, 0},
+	{2104200000U, -180, 1},
+	{2122340400U, -240, 0},
+	{2135649600U, -180, 1},
+	{2154394800U, -240, 0},
+	{2167099200U, -180, 1},
+	{2185844400U, -240, 0},
+	{2199153600U, -180, 1},
+	{2217294000U, -240, 0},
+	{2230603200U, -180, 1},
+	{2248743600U, -240, 0},
+	{2262052800U, -180, 1},
+	{2280193200U, -240, 0},
+	{2293502400U, -180, 1},
+	{2311642800U, -240, 0},
+	{2324952000U, -180, 1},
+	{2343697200U, -240, 0},
+	{2356401600U, -180, 1},
+	{2375146800U, -240, 0},
+	{2388456000U, -180, 1},
+	{2406596400U, -240, 0},
+	{2419905600U, -180, 1},
+	{2438046000U, -240, 0},
+	{2451355200U, -180, 1},
+	{2469495600U, -240, 0},
+	{2482804800U, -180, 1},
+	{2500945200U, -240, 0},
+	{2514254400U, -180, 1},
+	{2532999600U, -240, 0},
+	{2546308800U, -180, 1},
+	{2564449200U, -240, 0},
+	{2577758400U, -180, 1},
+	{2595898800U, -240, 0},
+	{2609208000U, -180, 1},
+	{2627348400U, -240, 0},
+	{2640657600U, -180, 1},
+	{2658798000U, -240, 0},
+	{2672107200U, -180, 1},
+	{2690852400U, -240, 0},
+	{2703556800U, -180, 1},
+	{2722302000U, -240, 0},
+	{2735611200U, -180, 1},
+	{2753751600U, -240, 0},
+	{2767060800U, -180, 1},
+	{2785201200U, -240, 0},
+	{2798510400U, -180, 1},
+	{2816650800U, -240, 0},
+	{2829960000U, -180, 1},
+	{2848100400U, -240, 0},
+	{2861409600U, -180, 1},
+	{2880154800U, -240, 0},
+	{2892859200U, -180, 1},
+	{2911604400U, -240, 0},
+	{2924913600U, -180, 1},
+	{2943054000U, -240, 0},
+	{2956363200U, -180, 1},
+	{2974503600U, -240, 0},
+	{2987812800U, -180, 1},
+	{3005953200U, -240, 0},
+	{3019262400U, -180, 1},
+	{3038007600U, -240, 0},
+	{3050712000U, -180, 1},
+	{3069457200U, -240, 0},
+	{3082766400U, -180, 1},
+	{3100906800U, -240, 0},
+	{3114216000U, -180, 1},
+	{3132356400U, -240, 0},
+	{3145665600U, -180, 1},
+};
+
+/* America/New_York */
+static const TZ_Transition tzNYC[201] = {
+	{0U, -300, 0},
+	{7974000U, -240, 1},
+	{26114400U, -300, 0},
+	{39423600U, -240, 1},
+	{57564000U, -300, 0},
+	{71478000U, -240, 1},
+	{89013600U, -300, 0},
+	{102927600U, -240, 1},
+	{120463200U, -300, 0},
+	{134377200U, -240, 1},
+	{152517600U, -300, 0},
+	{165826800U, -240, 1},
+	{183967200U, -300, 0},
+	{197276400U, -240, 1},
+	{215416800U, -300, 0},
+	{226911600U, -240, 1},
+	{247471200U, -300, 0},
+	{258361200U, -240, 1},
+	{278920800U, -300, 0},
+	{289810800U, -240, 1},
+	{310370400U, -300, 0},
+	{321865200U, -240, 1},
+	{342424800U, -300, 0},
+	{353314800U, -240, 1},
+	{373874400U, -300, 0},
+	{384764400U, -240, 1},
+	{405324000U, -300, 0},
+	{416214000U, -240, 1},
+	{436773600U, -300, 0},
+	{447663600U, -240, 1},
+	{468223200U, -300, 0},
+	{479113200U, -240, 1},
+	{499672800U, -300, 0},
+	{511167600U, -240, 1},
+	{531727200U, -300, 0},
+	{542617200U, -240, 1},
+	{563176800U, -300, 0},
+	{574066800U, -240, 1},
+	{594626400U, -300, 0},
+	{605516400U, -240, 1},
+	{626076000U, -300, 0},
+	{636966000U, -240, 1},
+	{657525600U, -300, 0},
+	{669020400U, -240, 1},
+	{689580000U, -300, 0},
+	{700470000U, -240, 1},
+	{721029600U, -300, 0},
+	{731919600U, -240, 1},
+	{752479200U, -300, 0},
+	{763369200U, -240, 1},
+	{783928800U, -300, 0},
+	{794818800U, -240, 1},
+	{815378400U, -300, 0},
+	{826268400U, -240, 1},
+	{846828000U, -300, 0},
+	{858322800U, -240, 1},
+	{878882400U, -300, 0},
+	{889772400U, -240, 1},
+	{910332000U, -300, 0},
+	{921222000U, -240, 1},
+	{941781600U, -300, 0},
+	{952671600U, -240, 1},
+	{973231200U, -300, 0},
+	{984121200U, -240, 1},
+	{1004680800U, -300, 0},
+	{1016175600U, -240, 1},
+	{1036735200U, -300, 0},
+	{1047625200U, -240, 1},
+	{1068184800U, -300, 0},
+	{1079074800U, -240, 1},
+	{1099634400U, -300, 0},
+	{1110524400U, -240, 1},
+	{1131084000U, -300, 0},
+	{1141974000U, -240, 1},
+	{1162533600U, -300, 0},
+	{1173423600U, -240, 1},
+	{1193983200U, -300, 0},
+	{1205478000U, -240, 1},
+	{1226037600U, -300, 0},
+	{1236927600U, -240, 1},
+	{1257487200U, -300, 0},
+	{1268377200U, -240, 1},
+	{1288936800U, -300, 0},
+	{1299826800U, -240, 1},
+	{1320386400U, -300, 0},
+	{1331276400U, -240, 1},
+	{1351836000U, -300, 0},
+	{1362726000U, -240, 1},
+	{1383285600U, -300, 0},
+	{1394780400U, -240, 1},
+	{1415340000U, -300, 0},
+	{1426230000U, -240, 1},
+	{1446789600U, -300, 0},
+	{1457679600U, -240, 1},
+	{1478239200U, -300, 0},
+	{1489129200U, -240, 1},
+	{1509688800U, -300, 0},
+	{1520578800U, -240, 1},
+	{1541138400U, -300, 0},
+	{1552633200U, -240, 1},
+	{1573192800U, -300, 0},
+	{1584082800U, -240, 1},
+	{1604642400U, -300, 0},
+	{1615532400U, -240, 1},
+	{1636092000U, -300, 0},
+	{1646982000U, -240, 1},
+	{1667541600U, -300, 0},
+	{1678431600U, -240, 1},
+	{1698991200U, -300, 0},
+	{1709881200U, -240, 1},
+	{1730440800U, -300, 0},
+	{1741935600U, -240, 1},
+	{1762495200U, -300, 0},
+	{1773385200U, -240, 1},
+	{1793944800U, -300, 0},
+	{1804834800U, -240, 1},
+	{1825394400U, -300, 0},
+	{1836284400U, -240, 1},
+	{1856844000U, -300, 0},
+	{1867734000U, -240, 1},
+	{1888293600U, -300, 0},
+	{1899788400U, -240, 1},
+	{1920348000U, -300, 0},
+	{1931238000U, -240, 1},
+	{1951797600U, -300, 0},
+	{1962687600U, -240, 1},
+	{1983247200U, -300, 0},
+	{1994137200U, -240, 1},
+	{2014696800U, -300, 0},
+	{2025586800U, -240, 1},
+	{2046146400U, -300, 0},
+	{2057036400U, -240, 1},
+	{2077596000U, -300, 0},
+	{2089090800U, -240, 1},
+	{2109650400U, -300, 0},
+	{2120540400U, -240, 1},
+	{2141100000U, -300, 0},
+	{2151990000U, -240, 1},
+	{2172549600U, -300, 0},
+	{2183439600U, -240, 1},
+	{2203999200U, -300, 0},
+	{2214889200U, -240, 1},
+	{2235448800U, -300, 0},
+	{2246338800U, -240, 1},
+	{2266898400U, -300, 0},
+	{2278393200U, -240, 1},
+	{2298952800U, -300, 0},
+	{2309842800U, -240, 1},
+	{2330402400U, -300, 0},
+	{2341292400U, -240, 1},
+	{2361852000U, -300, 0},
+	{2372742000U, -240, 1},
+	{2393301600U, -300, 0},
+	{2404191600U, -240, 1},
+	{2424751200U, -300, 0},
+	{2436246000U, -240, 1},
+	{2456805600U, -300, 0},
+	{2467695600U, -240, 1},
+	{2488255200U, -300, 0},
+	{2499145200U, -240, 1},
+	{2519704800U, -300, 0},
+	{2530594800U, -240, 1},
+	{2551154400U, -300, 0},
+	{2562044400U, -240, 1},
+	{2582604000U, -300, 0},
+	{2593494000U, -240, 1},
+	{2614053600U, -300, 0},
+	{2625548400U, -240, 1},
+	{2646108000U, -300, 0},
+	{2656998000U, -240, 1},
+	{2677557600U, -300, 0},
+	{2688447600U, -240, 1},
+	{2709007200U, -300, 0},
+	{2719897200U, -240, 1},
+	{2740456800U, -300, 0},
+	{2751346800U, -240, 1},
+	{2771906400U, -300, 0},
+	{2783401200U, -240, 1},
+	{2803960800U, -300, 0},
+	{2814850800U, -240, 1},
+	{2835410400U, -300, 0},
+	{2846300400U, -240, 1},
+	{2866860000U, -300, 0},
+	{2877750000U, -240, 1},
+	{2898309600U, -300, 0},
+	{2909199600U, -240, 1},
+	{2929759200U, -300, 0},
+	{2940649200U, -240, 1},
+	{2961208800U, -300, 0},
+	{2972703600U, -240, 1},
+	{2993263200U, -300, 0},
+	{3004153200U, -240, 1},
+	{3024712800U, -300, 0},
+	{3035602800U, -240, 1},
+	{3056162400U, -300, 0},
+	{3067052400U, -240, 1},
+	{3087612000U, -300, 0},
+	{3098502000U, -240, 1},
+	{3119061600U, -300, 0},
+	{3129951600U, -240, 1},
+	{3150511200U, -300, 0},
+};
+
+/* Europe/Madrid */
+static const TZ_Transition tzMAD[201] = {
+	{0U, 60, 0},
+	{7347600U, 120, 1},
+	{26096400U, 60, 0},
+	{38797200U, 120, 1},
+	{57546000U, 60, 0},
+	{70851600U, 120, 1},
+	{88995600U, 60, 0},
+	{102301200U, 120, 1},
+	{120445200U, 60, 0},
+	{133750800U, 120, 1},
+	{152499600U, 60, 0},
+	{165200400U, 120, 1},
+	{183949200U, 60, 0},
+	{196650000U, 120, 1},
+	{215398800U, 60, 0},
+	{228099600U, 120, 1},
+	{246848400U, 60, 0},
+	{260154000U, 120, 1},
+	{278298000U, 60, 0},
+	{291603600U, 120, 1},
+	{309747600U, 60, 0},
+	{323053200U, 120, 1},
+	{341802000U, 60, 0},
+	{354502800U, 120, 1},
+	{373251600U, 60, 0},
+	{385952400U, 120, 1},
+	{404701200U, 60, 0},
+	{418006800U, 120, 1},
+	{436150800U, 60, 0},
+	{449456400U, 120, 1},
+	{467600400U, 60, 0},
+	{480906000U, 120, 1},
+	{499050000U, 60, 0},
+	{512355600U, 120, 1},
+	{531104400U, 60, 0},
+	{543805200U, 120, 1},
+	{562554000U, 60, 0},
+	{575254800U, 120, 1},
+	{594003600U, 60, 0},
+	{607309200U, 120, 1},
+	{625453200U, 60, 0},
+	{638758800U, 120, 1},
+	{656902800U, 60, 0},
+	{670208400U, 120, 1},
+	{688957200U, 60, 0},
+	{701658000U, 120, 1},
+	{720406800U, 60, 0},
+	{733107600U, 120, 1},
+	{751856400U, 60, 0},
+	{765162000U, 120, 1},
+	{783306000U, 60, 0},
+	{796611600U, 120, 1},
+	{814755600U, 60, 0},
+	{828061200U, 120, 1},
+	{846205200U, 60, 0},
+	{859510800U, 120, 1},
+	{878259600U, 60, 0},
+	{890960400U, 120, 1},
+	{909709200U, 60, 0},
+	{922410000U, 120, 1},
+	{941158800U, 60, 0},
+	{954464400U, 120, 1},
+	{972608400U, 60, 0},
+	{985914000U, 120, 1},
+	{1004058000U, 60, 0},
+	{1017363600U, 120, 1},
+	{1036112400U, 60, 0},
+	{1048813200U, 120, 1},
+	{1067562000U, 60, 0},
+	{1080262800U, 120, 1},
+	{1099011600U, 60, 0},
+	{1111712400U, 120, 1},
+	{1130461200U, 60, 0},
+	{1143766800U, 120, 1},
+	{1161910800U, 60, 0},
+	{1175216400U, 120, 1},
+	{1193360400U, 60, 0},
+	{1206666000U, 120, 1},
+	{1225414800U, 60, 0},
+	{1238115600U, 120, 1},
+	{1256864400U, 60, 0},
+	{1269565200U, 120, 1},
+	{1288314000U, 60, 0},
+	{1301619600U, 120, 1},
+	{1319763600U, 60, 0},
+	{1333069200U, 120, 1},
+	{1351213200U, 60, 0},
+	{1364518800U, 120, 1},
+	{1382662800U, 60, 0},
+	{1395968400U, 120, 1},
+	{1414717200U, 60, 0},
+	{1427418000U, 120, 1},
+	{1446166800U, 60, 0},
+	{1458867600U, 120, 1},
+	{1477616400U, 60, 0},
+	{1490922000U, 120, 1},
+	{1509066000U, 60, 0},
+	{1522371600U, 120, 1},
+	{1540515600U, 60, 0},
+	{1553821200U, 120, 1},
+	{1572570000U, 60, 0},
+	{1585270800U, 120, 1},
+	{1604019600U, 60, 0},
+	{1616720400U, 120, 1},
+	{1635469200U, 60, 0},
+	{1648774800U, 120, 1},
+	{1666918800U, 60, 0},
+	{1680224400U, 120, 1},
+	{1698368400U, 60, 0},
+	{1711674000U, 120, 1},
+	{1729818000U, 60, 0},
+	{1743123600U, 120, 1},
+	{1761872400U, 60, 0},
+	{1774573200U, 120, 1},
+	{1793322000U, 60, 0},
+	{1806022800U, 120, 1},
+	{1824771600U, 60, 0},
+	{1838077200U, 120, 1},
+	{1856221200U, 60, 0},
+	{1869526800U, 120, 1},
+	{1887670800U, 60, 0},
+	{1900976400U, 120, 1},
+	{1919725200U, 60, 0},
+	{1932426000U, 120, 1},
+	{1951174800U, 60, 0},
+	{1963875600U, 120, 1},
+	{1982624400U, 60, 0},
+	{1995325200U, 120, 1},
+	{2014074000U, 60, 0},
+	{2027379600U, 120, 1},
+	{2045523600U, 60, 0},
+	{2058829200U, 120, 1},
+	{2076973200U, 60, 0},
+	{2090278800U, 120, 1},
+	{2109027600U, 60, 0},
+	{2121728400U, 120, 1},
+	{2140477200U, 60, 0},
+	{2153178000U, 120, 1},
+	{2171926800U, 60, 0},
+	{2185232400U, 120, 1},
+	{2203376400U, 60, 0},
+	{2216682000U, 120, 1},
+	{2234826000U, 60, 0},
+	{2248131600U, 120, 1},
+	{2266275600U, 60, 0},
+	{2279581200U, 120, 1},
+	{2298330000U, 60, 0},
+	{2311030800U, 120, 1},
+	{2329779600U, 60, 0},
+	{2342480400U, 120, 1},
+	{2361229200U, 60, 0},
+	{2374534800U, 120, 1},
+	{2392678800U, 60, 0},
+	{2405984400U, 120, 1},
+	{2424128400U, 60, 0},
+	{2437434000U, 120, 1},
+	{2456182800U, 60, 0},
+	{2468883600U, 120, 1},
+	{2487632400U, 60, 0},
+	{2500333200U, 120, 1},
+	{2519082000U, 60, 0},
+	{2532387600U, 120, 1},
+	{2550531600U, 60, 0},
+	{2563837200U, 120, 1},
+	{2581981200U, 60, 0},
+	{2595286800U, 120, 1},
+	{2613430800U, 60, 0},
+	{2626736400U, 120, 1},
+	{2645485200U, 60, 0},
+	{2658186000U, 120, 1},
+	{2676934800U, 60, 0},
+	{2689635600U, 120, 1},
+	{2708384400U, 60, 0},
+	{2721690000U, 120, 1},
+	{2739834000U, 60, 0},
+	{2753139600U, 120, 1},
+	{2771283600U, 60, 0},
+	{2784589200U, 120, 1},
+	{2803338000U, 60, 0},
+	{2816038800U, 120, 1},
+	{2834787600U, 60, 0},
+	{2847488400U, 120, 1},
+	{2866237200U, 60, 0},
+	{2878938000U, 120, 1},
+	{2897686800U, 60, 0},
+	{2910992400U, 120, 1},
+	{2929136400U, 60, 0},
+	{2942442000U, 120, 1},
+	{2960586000U, 60, 0},
+	{2973891600U, 120, 1},
+	{2992640400U, 60, 0},
+	{3005341200U, 120, 1},
+	{3024090000U, 60, 0},
+	{3036790800U, 120, 1},
+	{3055539600U, 60, 0},
+	{3068845200U, 120, 1},
+	{3086989200U, 60, 0},
+	{3100294800U, 120, 1},
+	{3118438800U, 60, 0},
+	{3131744400U, 120, 1},
+	{3149888400U, 60, 0},
+};
+
+const TZ_Zone tzZones[TZ_ZONE_COUNT] = {
+	{"BUE", tzBUE, 6},
+	{"UTC", tzUTC, 1},
+	{"SCL", tzSCL, 199},
+	{"NYC", tzNYC, 201},
+	{"MAD", tzMAD, 201},
+};
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+@file bench.py
+@brief Runs the microbenchmarks of the drivers (bench.h) and compares them with a baseline.
+
+Sends "BENCH <runs>" to the board, or replays it on the host build of the clock
+(simclock, see sim/replay.py), and collects the "BENCH" replies: the fewest, average
+and most cycles per call of each case, without the cost of the measurement. On the
+board they are DWT cycles; on the host only the modelled I2C bus and delay time
+advances the cycle counter, so the pure functions read 0 and the rest give the bus
+cost of each call. The results can be saved as a JSON report and later runs compared
+against it, case by case; the exit status is 1 if the average of a case grew more
+than the threshold.
+
+Usage:
+    python3 bench.py --sim                               host build, simulated bus
+    python3 bench.py /dev/ttyACM0 --runs 64              board on the ST-LINK virtual COM port
+    python3 bench.py --sim --save baseline.json          stores the report
+    python3 bench.py --sim --compare baseline.json       prints the change of every case
+    python3 bench.py --pty                               creates a pty pair and prints the
+                                                         path of the device end (stand-in
+                                                         for testing)
+    python3 bench.py --file uart.txt                     reads a capture (or "-" for stdin)
+"""
+import argparse
+import json
+import os
+import select
+import subprocess
+import sys
+import tempfile
+import time
+
+from serialport import open_port, open_pty, LineReader
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FIRST_ATTEMPTS = 30
+REPLY_TIMEOUT = 30.0
+SIM_START = "S 825681600 0"  # 2026-03-01 12:00:00 UTC, as the traces of the simulator
+SIM_COMMAND_MS = 1500  # after the boot overlay
+SIM_RUN_MS = 100  # most simulated time per call of a case
+
+
+class Report:
+    """Collects the replies of a benchmark."""
+
+    def __init__(self):
+        self.clock = None
+        self.overhead = None
+        self.runs = None
+        self.cases = {}
+        self.done = False
+        self.error = None
+
+    def feed(self, line):
+        words = line.split()
+        if words[:1] == ["ERR"] and self.clock is None:
+            self.error = line
+            return
+        if len(words) < 2 or words[0] != "BENCH":
+            return
+        try:
+            fields = dict(word.split("=", 1) for word in words[2:])
+            if words[1] == "START":
+                self.__init__()
+                self.clock, self.overhead, self.runs = (int(fields[key]) for key in ("clock", "overhead", "runs"))
+            elif words[1] == "END":
+                self.done = self.clock is not None
+            elif self.clock is not None:
+                self.cases[words[1]] = {key: int(fields[key]) for key in ("runs", "min", "avg", "max", "us")}
+        except (ValueError, KeyError):
+            pass
+
+    def as_dict(self, target):
+        return {"target": target, "clock": self.clock, "overhead": self.overhead, "runs": self.runs,
+                "cases": self.cases}
+
+
+def run_sim(runs):
+    """Replays "BENCH <runs>" on simclock. Returns the lines it sent."""
+    sys.path.insert(0, os.path.join(HERE, "sim"))
+    import replay
+    end = SIM_COMMAND_MS + 1000 + runs * SIM_RUN_MS * 8  # 8 cases
+    with tempfile.TemporaryDirectory() as directory:
+        binary = replay.build(directory)
+        trace = os.path.join(directory, "bench.trace")
+        with open(trace, "w") as f:
+            f.write("%s\nU %d BENCH %d\nE %d\n" % (SIM_START, SIM_COMMAND_MS, runs, end))
+        output = subprocess.run([binary, "-u", "-", trace], check=True, capture_output=True).stdout
+    return output.decode(errors="replace").splitlines()
+
+
+def run_live(fd, runs):
+    """Sends "BENCH <runs>" and returns the report, once "BENCH END" arrives or the line goes quiet."""
+    report = Report()
+    reader = LineReader(fd)
+    attempts = 0
+    while not report.done and report.error is None:
+        if report.clock is None:  # sent again until the benchmark starts (the board, or the pty peer, may not be ready)
+            if attempts == FIRST_ATTEMPTS:
+                break
+            os.write(fd, b"BENCH %d\n" % runs)
+            attempts += 1
+        ready, _, _ = select.select([fd], [], [], 1.0 if report.clock is None else REPLY_TIMEOUT)
+        if not ready:
+            if report.clock is None:
+                continue
+            break
+        try:
+            lines = reader.feed()
+        except OSError:  # pty peer not open yet
+            time.sleep(0.1)
+            continue
+        for line in lines:
+            report.feed(line)
+    return report
+
+
+def show(report, baseline, threshold):
+    """Prints the cases, with their change from the baseline. Returns the names of those that got slower."""
+    slower = []
+    old_cases = baseline.get("cases", {}) if baseline else {}
+    print("clock=%d Hz overhead=%d cycles runs=%d" % (report.clock, report.overhead, report.runs))
+    for name, case in report.cases.items():
+        line = "    %-20s min=%-9d avg=%-9d max=%-9d %8d us" % (name, case["min"], case["avg"], case["max"], case["us"])
+        old = old_cases.get(name)
+        if old:
+            change = (case["avg"] - old["avg"]) * 100.0 / old["avg"] if old["avg"] else 0.0
+            line += "    (avg was %d, %+.1f%%)" % (old["avg"], change)
+            if case["avg"] > old["avg"] and change > threshold:
+                slower.append(name)
+        print(line)
+    return slower
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?", help="serial port of the clock")
+    parser.add_argument("--sim", action="store_true", help="run on the host build with the simulated bus")
+    parser.add_argument("--pty", action="store_true", help="talk through a new pty instead of a port")
+    parser.add_argument("--file", help="read a capture instead ('-' for stdin)")
+    parser.add_argument("--runs", type=int, default=16, help="calls of each case (1 to 1000)")
+    parser.add_argument("--save", metavar="FILE", help="store the report as a baseline")
+    parser.add_argument("--compare", metavar="FILE", help="compare against a stored baseline")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="growth of an average (%%) that fails the comparison")
+    args = parser.parse_args()
+    if not 1 <= args.runs <= 1000:
+        parser.error("--runs must be from 1 to 1000")
+
+    if args.sim or args.file:
+        report = Report()
+        if args.sim:
+            target = "sim"
+            lines = run_sim(args.runs)
+        else:
+            target = "capture"
+            lines = sys.stdin if args.file == "-" else open(args.file, errors="replace")
+        for line in lines:
+            report.feed(line)
+    else:
+        if args.pty:
+            fd, path = open_pty()
+            print("device end: %s" % path, file=sys.stderr, flush=True)
+        elif args.port:
+            fd = open_port(args.port)
+        else:
+            parser.error("a port, --sim, --pty or --file is required")
+        target = "board"
+        report = run_live(fd, args.runs)
+    if report.error or report.clock is None:
+        print("BENCH: %s" % (report.error or "no reply"), file=sys.stderr)
+        return 1
+    if not report.done:
+        print("BENCH: incomplete", file=sys.stderr)
+
+    baseline = {}
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)
+        if baseline.get("target") != target:
+            print("baseline taken on %s, this run on %s" % (baseline.get("target"), target), file=sys.stderr)
+    slower = show(report, baseline, args.threshold)
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(report.as_dict(target), f, indent=2)
+    if slower:
+        print("slower than the baseline: %s" % " ".join(slower), file=sys.stderr)
+        return 1
+    return 0 if report.done else 1
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except KeyboardInterrupt:
+        sys.exit(1)
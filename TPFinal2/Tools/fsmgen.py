@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""
+@file fsmgen.py
+@brief Compiles the application FSM spec (appfsm.txt) into const tables.
+
+Runs as a pre-build step of the STM32CubeIDE project, after tzgen.py. Every screen,
+menu entry and editable field of the spec becomes a row of a const table in flash:
+app.c dispatches with one table lookup per pass instead of nested switches, and a new
+screen or field is a line of the spec.
+
+Outputs (only rewritten when their content changes, so the build stays incremental):
+    Drivers/API/inc/appFsm.h  states, table types and handler prototypes
+    Drivers/API/src/appFsm.c  screen, menu and field tables (placed in flash)
+
+Usage: python3 fsmgen.py [spec file]
+"""
+import os
+import shlex
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(HERE)
+HEADER = os.path.join(ROOT, "Drivers", "API", "inc", "appFsm.h")
+SOURCE = os.path.join(ROOT, "Drivers", "API", "src", "appFsm.c")
+
+# Members of DS3231_DateTime and their size in bytes
+MEMBERS = {"Seconds": 1, "Minutes": 1, "Hours": 1, "Day": 1, "Date": 1, "Month": 1, "Year": 2}
+NONE = 0xFF
+
+
+def fail(path, number, message):
+    sys.exit("%s:%d: %s" % (path, number, message))
+
+
+def read_spec(path):
+    screens, menu, fields = [], [], []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            words = shlex.split(line, comments=True)
+            if not words:
+                continue
+            kind, args = words[0], words[1:]
+            if kind == "screen" and len(args) == 4:
+                if args[0] in [s[0] for s in screens]:
+                    fail(path, number, "screen %s defined twice" % args[0])
+                screens.append(tuple(None if a == "-" else a for a in args))
+            elif kind == "menu" and len(args) == 5:
+                menu.append((args[0], args[1], int(args[2]), args[3], int(args[4]), number))
+            elif kind == "field" and len(args) == 7:
+                screen, member, low, high, mode, row, col = args
+                if member not in MEMBERS:
+                    fail(path, number, "%s is not a member of DS3231_DateTime" % member)
+                if mode not in ("wrap", "clamp"):
+                    fail(path, number, "expected wrap or clamp, not %s" % mode)
+                high = 0 if high == "mdays" else int(high)
+                if high and high < int(low):
+                    fail(path, number, "empty range")
+                fields.append((screen, member, int(low), high, mode == "wrap", int(row), int(col), number))
+            else:
+                fail(path, number, "can not parse '%s'" % line.strip())
+    names = [s[0] for s in screens]
+    for entry in menu:
+        if entry[0] not in names:
+            fail(path, entry[5], "unknown screen %s" % entry[0])
+    for field in fields:
+        if field[0] not in names:
+            fail(path, field[7], "unknown screen %s" % field[0])
+    if "MENU" not in names:
+        sys.exit("%s: a MENU screen is required" % path)
+    return screens, menu, fields
+
+
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path, newline="") as f:
+            if f.read() == text:
+                return
+    with open(path, "w", newline="\n") as f:
+        f.write(text)
+
+
+def main():
+    spec_file = sys.argv[1] if len(sys.argv) > 1 else os.path.join(HERE, "appfsm.txt")
+    screens, menu, fields = read_spec(spec_file)
+
+    # Fields grouped by screen, in spec order: each one points to the next of its screen
+    order = [f for s in screens for f in fields if f[0] == s[0]]
+    first = {}
+    for i, field in enumerate(order):
+        first.setdefault(field[0], i)
+    updates = sorted({s[1] for s in screens})
+    actions = sorted({a for s in screens for a in s[2:] if a})
+
+    h = []
+    h.append("/**\n")
+    h.append(" * @file appFsm.h\n")
+    h.append(" * @brief States and transition tables of the application FSM.\n")
+    h.append(" *\n")
+    h.append(" * Generated by Tools/fsmgen.py from Tools/appfsm.txt. Do not edit.\n")
+    h.append(" */\n")
+    h.append("#ifndef APPFSM_H\n#define APPFSM_H\n\n")
+    h.append("#include <stdint.h>\n\n")
+    h.append("/**\n * @brief States of the main FSM (one per screen).\n */\n")
+    h.append("typedef enum{\n")
+    h.append(",\n".join("\t%s" % s[0] for s in screens))
+    h.append("\n} app_t;\n\n")
+    h.append("/**\n * @brief States of the menu FSM (one per entry).\n */\n")
+    h.append("typedef enum{\n")
+    h.append(",\n".join("\t%s_M" % m[0] for m in menu))
+    h.append("\n} menu_t;\n\n")
+    h.append("/**\n * @brief Amount of screens.\n */\n")
+    h.append("#define APP_SCREEN_COUNT %d\n\n" % len(screens))
+    h.append("/**\n * @brief Amount of menu entries.\n */\n")
+    h.append("#define APP_MENU_COUNT %d\n\n" % len(menu))
+    h.append("/**\n * @brief Amount of editable fields (all screens).\n */\n")
+    h.append("#define APP_FIELD_COUNT %d\n\n" % len(order))
+    h.append("/**\n * @brief Field index meaning none: after the last field, or the first field of a screen without fields.\n */\n")
+    h.append("#define APP_FIELD_NONE 0x%02X\n\n" % NONE)
+    h.append("/**\n * @brief Maximum of a field that takes the length of the month being edited.\n */\n")
+    h.append("#define APP_FIELD_MDAYS 0\n\n")
+    h.append("/**\n * @brief Screen: handlers and first editable field.\n */\n")
+    h.append("typedef struct{\n")
+    h.append("\tvoid (*update)(uint16_t button);\t/**< Called every pass with the button pressed (0 if none)*/\n")
+    h.append("\tvoid (*enter)(void);\t\t\t\t/**< Called when the menu enters the screen (NULL if none)*/\n")
+    h.append("\tvoid (*leave)(void);\t\t\t\t/**< Called when MENU leaves the screen (NULL if none)*/\n")
+    h.append("\tuint8_t firstField;\t\t\t\t\t/**< Index in appFields, APP_FIELD_NONE if none*/\n")
+    h.append("} appScreen_t;\n\n")
+    h.append("/**\n * @brief Menu entry: text, screen entered and neighbours.\n */\n")
+    h.append("typedef struct{\n")
+    h.append("\tconst char *text[2];\t/**< Text of each row*/\n")
+    h.append("\tuint8_t col[2];\t\t\t/**< Column of the text of each row*/\n")
+    h.append("\tuint8_t screen;\t\t\t/**< app_t entered with ENTER*/\n")
+    h.append("\tuint8_t right;\t\t\t/**< menu_t selected with RIGHT*/\n")
+    h.append("\tuint8_t left;\t\t\t/**< menu_t selected with LEFT*/\n")
+    h.append("} appMenuEntry_t;\n\n")
+    h.append("/**\n * @brief Editable field: member of DS3231_DateTime, range, cursor and next field.\n */\n")
+    h.append("typedef struct{\n")
+    h.append("\tuint8_t offset;\t\t/**< Offset of the member in DS3231_DateTime*/\n")
+    h.append("\tuint8_t size;\t\t/**< Size of the member (bytes)*/\n")
+    h.append("\tuint16_t min;\t\t/**< Minimum value*/\n")
+    h.append("\tuint16_t max;\t\t/**< Maximum value, APP_FIELD_MDAYS for the length of the month*/\n")
+    h.append("\tuint8_t wrap;\t\t/**< 1 to wrap around the range, 0 to stop at its ends*/\n")
+    h.append("\tuint8_t row;\t\t/**< Row of the cursor*/\n")
+    h.append("\tuint8_t col;\t\t/**< Column of the cursor*/\n")
+    h.append("\tuint8_t next;\t\t/**< Field selected with ENTER, APP_FIELD_NONE after the last one*/\n")
+    h.append("} appField_t;\n\n")
+    h.append("/**\n * @brief Screens, indexed by app_t.\n */\n")
+    h.append("extern const appScreen_t appScreens[APP_SCREEN_COUNT];\n\n")
+    h.append("/**\n * @brief Menu entries, indexed by menu_t.\n */\n")
+    h.append("extern const appMenuEntry_t appMenu[APP_MENU_COUNT];\n\n")
+    h.append("/**\n * @brief Editable fields, grouped by screen.\n */\n")
+    h.append("extern const appField_t appFields[APP_FIELD_COUNT];\n\n")
+    for name in updates:
+        screen = [s[0] for s in screens if s[1] == name]
+        h.append("/**\n * @function %s\n * @brief Update handler of %s.\n" % (name, ", ".join(screen)))
+        h.append(" * @param button: button pressed (0 if none)\n * @retval none\n */\n")
+        h.append("void %s(uint16_t button);\n\n" % name)
+    for name in actions:
+        roles = ["enter action of %s" % s[0] for s in screens if s[2] == name]
+        roles += ["leave action of %s" % s[0] for s in screens if s[3] == name]
+        brief = ", ".join(roles)
+        h.append("/**\n * @function %s\n * @brief %s%s.\n" % (name, brief[0].upper(), brief[1:]))
+        h.append(" * @param none\n * @retval none\n */\n")
+        h.append("void %s(void);\n\n" % name)
+    h.append("#endif\n")
+
+    def handler(name):
+        return name if name else "NULL"
+
+    c = []
+    c.append("/**\n")
+    c.append(" * @file appFsm.c\n")
+    c.append(" * @brief Transition tables of the application FSM.\n")
+    c.append(" *\n")
+    c.append(" * Generated by Tools/fsmgen.py from Tools/appfsm.txt. Do not edit.\n")
+    c.append(" */\n")
+    c.append('#include "appFsm.h"\n\n')
+    c.append('#include "ds3231.h"\n\n')
+    c.append("#include <stddef.h>\n\n")
+    c.append("const appScreen_t appScreens[APP_SCREEN_COUNT] = {\n")
+    for name, update, enter, leave in screens:
+        field = first.get(name)
+        c.append("\t{%s, %s, %s, %s},\t/* %s */\n" % (update, handler(enter), handler(leave),
+                                                       "APP_FIELD_NONE" if field is None else field, name))
+    c.append("};\n\n")
+    c.append("const appMenuEntry_t appMenu[APP_MENU_COUNT] = {\n")
+    for i, (screen, row0, col0, row1, col1, _) in enumerate(menu):
+        right = "%s_M" % menu[(i + 1) % len(menu)][0]
+        left = "%s_M" % menu[(i - 1) % len(menu)][0]
+        c.append('\t{{"%s", "%s"}, {%d, %d}, %s, %s, %s},\n' % (row0, row1, col0, col1, screen, right, left))
+    c.append("};\n\n")
+    c.append("const appField_t appFields[APP_FIELD_COUNT] = {\n")
+    for i, (screen, member, low, high, wrap, row, col, _) in enumerate(order):
+        last = (i + 1 == len(order)) or (order[i + 1][0] != screen)
+        c.append("\t{offsetof(DS3231_DateTime, %s), %d, %d, %s, %d, %d, %d, %s},\t/* %d: %s */\n" % (
+            member, MEMBERS[member], low, high if high else "APP_FIELD_MDAYS", wrap, row, col,
+            "APP_FIELD_NONE" if last else i + 1, i, screen))
+    c.append("};\n")
+
+    write_if_changed(HEADER, "".join(h))
+    write_if_changed(SOURCE, "".join(c))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""
+@file hostref.py
+@brief Host time reference for the DS3231 aging offset calibration.
+
+Sends "T <milliseconds>" lines (host monotonic clock) once per second through the
+serial port while the clock runs "6) Calibrar reloj (aging)" without a 1 PPS input,
+and prints the "CAL ..." report lines the firmware sends back.
+
+Usage:
+    python3 hostref.py /dev/ttyACM0        board on the ST-LINK virtual COM port
+    python3 hostref.py --pty               creates a pty pair and prints the path of
+                                           the device end (stand-in for testing)
+"""
+import argparse
+import os
+import select
+import sys
+import time
+
+from serialport import LineReader, open_port, open_pty
+
+PERIOD = 1.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?", help="serial port of the clock")
+    parser.add_argument("--pty", action="store_true", help="serve on a new pty instead of a port")
+    parser.add_argument("--period", type=float, default=PERIOD, help="seconds between timestamps")
+    args = parser.parse_args()
+
+    if args.pty:
+        fd, path = open_pty()
+        print("device end: %s" % path, flush=True)
+    elif args.port:
+        fd = open_port(args.port)
+    else:
+        parser.error("a port or --pty is required")
+
+    reader = LineReader(fd)
+    deadline = time.monotonic()
+    while True:
+        now = time.monotonic()
+        if now >= deadline:
+            stamp = time.monotonic_ns() // 1000000  # taken right before the write: it is the send time
+            os.write(fd, b"T %d\n" % (stamp & 0xFFFFFFFF))
+            deadline += args.period
+        ready, _, _ = select.select([fd], [], [], max(0.0, deadline - time.monotonic()))
+        if ready:
+            try:
+                lines = reader.feed()
+            except OSError:  # pty peer closed
+                continue
+            for line in lines:
+                if line:
+                    print(line, flush=True)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        sys.exit(0)
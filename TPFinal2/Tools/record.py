@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""
+@file record.py
+@brief Records the button events of the clock into a trace for sim/replay.py.
+
+Sends "R1" through the serial port, stores the start ("S", "A") and event ("B", "H")
+lines the firmware sends back and, on Ctrl-C, sends "R0" and waits for the end line
+("E"). Other lines (calibration reports, latency dumps) are printed and not stored.
+
+Usage:
+    python3 record.py /dev/ttyACM0 sim/traces/new.trace
+"""
+import argparse
+import os
+import select
+import time
+
+from serialport import LineReader, open_port
+
+END_TIMEOUT = 2.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", help="serial port of the clock")
+    parser.add_argument("trace", help="trace file to write")
+    args = parser.parse_args()
+
+    fd = open_port(args.port)
+    reader = LineReader(fd)
+    os.write(fd, b"R1\n")
+    print("recording, Ctrl-C to stop", flush=True)
+
+    with open(args.trace, "w") as trace:
+        deadline = None
+        try:
+            while True:
+                ready, _, _ = select.select([fd], [], [], 0.5)
+                if ready:
+                    for line in reader.feed():
+                        if line[:2] in ("S ", "A ", "B ", "H "):
+                            trace.write(line + "\n")
+                            print(line, flush=True)
+                        elif line:
+                            print("  %s" % line, flush=True)
+        except KeyboardInterrupt:
+            os.write(fd, b"R0\n")
+            deadline = time.monotonic() + END_TIMEOUT
+        while deadline is not None and time.monotonic() < deadline:
+            ready, _, _ = select.select([fd], [], [], max(0.0, deadline - time.monotonic()))
+            if not ready:
+                continue
+            for line in reader.feed():
+                if line[:2] in ("B ", "H "):
+                    trace.write(line + "\n")
+                elif line.startswith("E "):
+                    trace.write(line + "\n")
+                    print(line)
+                    return
+        print("no end line received: the trace ends at its last event")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,48 @@
+"""
+@file serialport.py
+@brief Minimal raw serial port access for the host tools (no pyserial needed).
+
+Opens a tty (the ST-LINK virtual COM port, e.g. /dev/ttyACM0) in raw mode at the
+firmware baud rate. A pseudo terminal works the same way, so every tool can be
+exercised against a pty pair instead of the board: `open_pty()` returns the master
+end and the path of the slave end to hand to the other program.
+"""
+import os
+import termios
+import tty
+
+BAUD_RATE = termios.B115200
+
+
+def open_port(path):
+    """Opens a tty in raw mode (115200 8N1) and returns its file descriptor."""
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = BAUD_RATE  # ispeed, ospeed (ignored by ptys)
+    attrs[2] |= termios.CLOCAL | termios.CREAD
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def open_pty():
+    """Creates a raw pty pair. Returns (master fd, slave path)."""
+    master, slave = os.openpty()
+    tty.setraw(master)
+    tty.setraw(slave)
+    path = os.ttyname(slave)
+    return master, path
+
+
+class LineReader:
+    """Splits the bytes read from a descriptor into text lines."""
+
+    def __init__(self, fd):
+        self.fd = fd
+        self.pending = b""
+
+    def feed(self):
+        """Reads what is available and returns the complete lines."""
+        self.pending += os.read(self.fd, 4096)
+        *lines, self.pending = self.pending.split(b"\n")
+        return [line.rstrip(b"\r").decode(errors="replace") for line in lines]
@@ -0,0 +1,108 @@
+/**
+ * @file stm32f4xx_hal.h
+ * @brief Host stand-in for the STM32 HAL header, used by the simulator.
+ *
+ * The simulator compiles the application and driver sources unchanged and replaces
+ * the port* wrappers with models (see sim.h). This header only provides the types,
+ * constants and registers those sources name, backed by simulator state.
+ */
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief HAL status codes.
+ */
+typedef enum{
+	HAL_OK,
+	HAL_ERROR,
+	HAL_BUSY,
+	HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+/**
+ * @brief Interrupt lines named by the port headers.
+ */
+typedef enum{
+	EXTI0_IRQn = 6,
+	EXTI1_IRQn = 7,
+	EXTI9_5_IRQn = 23,
+	TIM2_IRQn = 28,
+	USART2_IRQn = 38
+} IRQn_Type;
+
+/**
+ * @brief GPIO port registers (unused by the simulator, only their addresses are compared).
+ */
+typedef struct{
+	uint32_t IDR;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef simGPIOA, simGPIOC;
+#define GPIOA (&simGPIOA)
+#define GPIOC (&simGPIOC)
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_AF1_TIM2 ((uint8_t)0x01)
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+#define I2C_MEMADD_SIZE_8BIT 0x00000001U
+
+/**
+ * @brief Cycle counter of the DWT, advanced with the simulated time.
+ */
+typedef struct{
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+extern DWT_Type simDWT;
+#define DWT (&simDWT)
+
+/**
+ * @brief RCC registers used by the HSI trimming.
+ */
+typedef struct{
+	volatile uint32_t CR;
+} RCC_TypeDef;
+
+extern RCC_TypeDef simRCC;
+#define RCC (&simRCC)
+
+#define RCC_CR_HSITRIM_Pos 3U
+#define RCC_CR_HSITRIM (0x1FU << RCC_CR_HSITRIM_Pos)
+#define __HAL_RCC_HSI_CALIBRATIONVALUE_ADJUST(value) \
+	(RCC->CR = (RCC->CR & ~RCC_CR_HSITRIM) | ((uint32_t)(value) << RCC_CR_HSITRIM_Pos))
+
+/**
+ * @brief Interrupt mask of the core. The simulated interrupts (the tick of SimAdvance) run synchronously, so the
+ * mask only holds back the thread switch requested meanwhile, taken when it is cleared (as PendSV on the board).
+ */
+extern uint32_t simPrimask;
+void SimPendSV(void);
+static inline uint32_t __get_PRIMASK(void){ return simPrimask; }
+static inline void __set_PRIMASK(uint32_t mask){ simPrimask = mask; if (!mask) SimPendSV(); }
+static inline void __disable_irq(void){ simPrimask = 1; }
+
+/**
+ * @brief Exception that runs: the simulated interrupts are those of SysTick (15).
+ */
+extern int simInIsr;
+static inline uint32_t __get_IPSR(void){ return simInIsr ? 15 : 0; }
+
+extern uint32_t SystemCoreClock;
+extern uint32_t uwTickPrio;
+
+uint32_t HAL_GetTick(void);
+void HAL_IncTick(void);
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority);
+
+#endif
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+@file replay.py
+@brief Replays the recorded button traces on the host build of the clock.
+
+Compiles the application and the drivers unchanged together with the simulated
+ports (simclock), runs every trace and prints the metrics of each run: the final
+screen, the simulated I2C, LCD, UART and delay time, the activations and worst
+response time of every thread of the kernel, the CPU time outside the idle thread
+and the button to LCD latency histograms of the firmware.
+
+The metrics of a run can be saved as a baseline and later runs compared against it,
+so a change that costs bus time or latency shows up before it reaches the board.
+
+Usage:
+    python3 replay.py                          all the traces in traces/
+    python3 replay.py traces/settime.trace     the given traces
+    python3 replay.py --save baseline.json     stores the metrics
+    python3 replay.py --compare baseline.json  prints the change of every metric
+    python3 replay.py --uart ...               also prints what the firmware sends
+"""
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(HERE))
+API = os.path.join(ROOT, "Drivers", "API")
+GENERATORS = [os.path.join(ROOT, "Tools", name) for name in ("tzgen.py", "fsmgen.py")]
+
+# Firmware modules built for the host: everything above the port* wrappers
+FIRMWARE = ["app", "appFsm", "ds3231", "lcd_i2c", "timezone", "tzdata", "tempLog", "latency",
+            "API_delay", "agingCal", "hsiTrim", "swTimer", "scheduler", "kernel",
+            "deferred", "power", "clockGov", "console", "telemetry", "modbus", "timeSync", "trace", "bench"]
+
+# Metrics shown in the comparison (the others are only printed)
+COMPARED = ["cpu_busy_us", "thread_app_wcrt_us", "i2c_transactions", "i2c_bytes", "i2c_bus_us",
+            "lcd_instructions", "lcd_chars", "lcd_chars_unchanged", "app_delay_us", "uart_bytes"]
+
+
+def build(directory):
+    """Compiles simclock into directory and returns its path."""
+    for generator in GENERATORS:
+        subprocess.run([sys.executable, generator], check=True, stdout=subprocess.DEVNULL)
+    binary = os.path.join(directory, "simclock")
+    sources = sorted(glob.glob(os.path.join(HERE, "*.c")))
+    sources += [os.path.join(API, "src", name + ".c") for name in FIRMWARE]
+    command = ["gcc", "-std=gnu11", "-O2", "-Wall", "-Werror", "-I", os.path.join(HERE, "inc"), "-I", HERE,
+               "-I", os.path.join(API, "inc"), "-o", binary] + sources
+    subprocess.run(command, check=True)
+    return binary
+
+
+def run(binary, trace, uart):
+    """Replays a trace. Returns the metrics as a dictionary."""
+    command = [binary] + (["-u", "-"] if uart else []) + [trace]
+    output = subprocess.run(command, check=True, capture_output=True, text=True).stdout
+    metrics = {}
+    for line in output.splitlines():
+        key, _, value = line.partition(" ")
+        if key.startswith("lcd0") or key.startswith("lcd1"):
+            metrics[key] = value
+        elif key.startswith("latency_"):
+            count, low, avg, p99, high = (int(v) for v in value.split())
+            metrics[key] = {"count": count, "min": low, "avg": avg, "p99": p99, "max": high}
+        elif value.isdigit():
+            metrics[key] = int(value)
+        elif uart:
+            print("    uart: %s" % line)
+    return metrics
+
+
+def show(metrics, baseline):
+    for key, value in metrics.items():
+        if isinstance(value, dict):
+            value = "n=%(count)d min=%(min)d avg=%(avg)d p99=%(p99)d max=%(max)d" % value
+        line = "    %-22s %s" % (key, value)
+        old = baseline.get(key) if baseline else None
+        if key in COMPARED and isinstance(old, int):
+            change = (metrics[key] - old) * 100.0 / old if old else 0.0
+            line += "    (was %d, %+.1f%%)" % (old, change)
+        elif key.startswith("latency_") and isinstance(old, dict):
+            line += "    (avg was %d)" % old["avg"]
+        elif key.startswith("lcd") and (old is not None) and (old != metrics[key]) and not isinstance(old, int):
+            line += "    (was %s)" % old
+        print(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("traces", nargs="*", help="trace files (default: traces/*.trace)")
+    parser.add_argument("--save", metavar="FILE", help="store the metrics as a baseline")
+    parser.add_argument("--compare", metavar="FILE", help="compare against a stored baseline")
+    parser.add_argument("--uart", action="store_true", help="print what the firmware sends through USART2")
+    args = parser.parse_args()
+
+    traces = args.traces or sorted(glob.glob(os.path.join(HERE, "traces", "*.trace")))
+    baseline = {}
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)
+
+    results = {}
+    with tempfile.TemporaryDirectory() as directory:
+        binary = build(directory)
+        for trace in traces:
+            name = os.path.basename(trace)
+            print(name, flush=True)
+            results[name] = run(binary, trace, args.uart)
+            show(results[name], baseline.get(name))
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(results, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,196 @@
+/**
+ * @file sim.h
+ * @brief Declarations shared by the host simulator of the clock.
+ *
+ * The simulator builds app.c and the drivers unchanged on the host. The port*
+ * wrappers are replaced by simPorts.c, which routes the I2C traffic to a DS3231
+ * model (simDs3231.c) and a PCF8574 + HD44780 model (simLcd.c) and charges the
+ * bus, UART and blocking delay times to a simulated clock (simHal.c). simKernel.c
+ * runs the threads of the kernel on host contexts. simMain.c replays a button trace
+ * against it and prints the final screen and statistics.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Core clock of the simulated MCU (Hz). The DWT cycle counter advances at this rate.
+ */
+#define SIM_CORE_CLOCK 72000000
+
+/**
+ * @brief Time (in microseconds) of a byte on the I2C bus at 100 kHz (8 bits and ACK).
+ */
+#define SIM_I2C_BYTE_US 90
+
+/**
+ * @brief Time (in microseconds) of a byte on USART2 at 115200 8N1.
+ */
+#define SIM_UART_BYTE_US 87
+
+/**
+ * @brief Time (in microseconds) the DS3231 takes for a temperature conversion.
+ */
+#define SIM_CONVERSION_US 125000
+
+/**
+ * @typedef simStats_t
+ * @brief Counters of the simulated run.
+ */
+typedef struct{
+	uint32_t i2cTransactions;	/**< I2C transactions, any device */
+	uint32_t i2cBytes;			/**< Bytes on the bus, addresses included */
+	uint64_t i2cMicros;			/**< Time the bus was busy */
+	uint32_t ds3231Transactions;/**< Transactions addressed to the DS3231 */
+	uint32_t lcdTransactions;	/**< Transactions addressed to the PCF8574 */
+	uint32_t lcdInstructions;	/**< Instructions executed by the HD44780 */
+	uint32_t lcdChars;			/**< Characters written to the DDRAM */
+	uint32_t lcdCharsUnchanged;	/**< Characters written over the same character */
+	uint32_t lcdNibblesDropped;	/**< Nibbles latched while the HD44780 was busy (ignored) */
+	uint64_t delayMicros;		/**< Time of the delays (I2CDelay) of the application: a sleep of the calling thread once the kernel runs */
+	uint32_t uartBytes;			/**< Bytes sent through USART2 */
+	uint64_t uartMicros;		/**< Time of the bytes sent through USART2 on the line (the DMA sends them meanwhile) */
+} simStats_t;
+
+/**
+ * @brief Counters of the run. Defined in simHal.c.
+ */
+extern simStats_t simStats;
+
+/**
+ * @brief File that receives what the firmware sends through USART2 (NULL to discard). Defined in simPorts.c.
+ */
+extern FILE *simUart;
+
+/**
+ * @brief Set while SimInterrupt runs: the kernel takes the caller for an interrupt. Defined in simKernel.c.
+ */
+extern int simInIsr;
+
+/**
+ * @brief Set by SimInterrupt when the replay is over: the idle thread returns to main. Defined in simKernel.c.
+ */
+extern int simDone;
+
+/**
+ * @function SimAdvance
+ * @brief Advances the simulated time, the HAL tick and the DWT cycle counter, calling SimInterrupt at every
+ * millisecond crossed. A thread switch requested meanwhile is taken at the end.
+ * @param micros: microseconds to advance
+ * @retval none
+ */
+void SimAdvance(uint64_t micros);
+
+/**
+ * @function SimInterrupt
+ * @brief Runs the interrupts of a millisecond: hands the events of the trace that are due to the application (the
+ * button and USART2 interrupts) and runs the SysTick interrupt (SwTimerTick and KernelTick).
+ * @param none
+ * @retval none
+ */
+void SimInterrupt(void);
+
+/**
+ * @function SimMicros
+ * @brief Gets the simulated time.
+ * @param none
+ * @retval microseconds since the simulated reset
+ */
+uint64_t SimMicros(void);
+
+/**
+ * @function SimDs3231Init
+ * @brief Powers the DS3231 model up holding a UTC time.
+ * @param epoch: seconds since 01/01/2000 UTC
+ * @param stopped: true to start with the oscillator stop flag set (as after losing VBAT)
+ * @retval none
+ */
+void SimDs3231Init(uint32_t epoch, int stopped);
+
+/**
+ * @function SimDs3231LastSecond
+ * @brief Gets the last seconds update of the DS3231 model since its time was written, the falling edge of the 1 Hz
+ * square wave.
+ * @param micros: pointer to store the simulated time of the update
+ * @retval 1 if the square wave is on and an update happened, 0 if not
+ */
+int SimDs3231LastSecond(uint64_t *micros);
+
+/**
+ * @function SimDs3231Read
+ * @brief Reads registers of the DS3231 model, starting at a register (wrapping from 0x12 to 0x00).
+ * @param reg: first register
+ * @param buffer: buffer to fill
+ * @param size: amount of registers
+ * @retval none
+ */
+void SimDs3231Read(uint8_t reg, uint8_t *buffer, uint16_t size);
+
+/**
+ * @function SimDs3231SetAlarm
+ * @brief Loads the alarm 2 registers of the DS3231 model (day of week mode, 24 hour).
+ * @param day: day of week (1-7)
+ * @param hours: hours
+ * @param minutes: minutes
+ * @retval none
+ */
+void SimDs3231SetAlarm(uint8_t day, uint8_t hours, uint8_t minutes);
+
+/**
+ * @function SimDs3231Write
+ * @brief Handles a write transaction to the DS3231 model: register address followed by the values.
+ * @param buffer: bytes of the transaction (without the device address)
+ * @param size: amount of bytes
+ * @retval none
+ */
+void SimDs3231Write(uint8_t *buffer, uint16_t size);
+
+/**
+ * @function SimLcdRow
+ * @brief Gets the 16 visible characters of a row of the HD44780 model.
+ * @param row: row (0 or 1)
+ * @param text: buffer of at least 17 chars to fill (non printable characters become '?')
+ * @retval none
+ */
+void SimLcdRow(uint8_t row, char *text);
+
+/**
+ * @function SimLcdWrite
+ * @brief Handles a byte written to the PCF8574 model. A falling edge of E latches a nibble into the HD44780.
+ * @param value: byte written to the PCF8574 outputs
+ * @param micros: simulated time the byte is complete on the bus
+ * @retval none
+ */
+void SimLcdWrite(uint8_t value, uint64_t micros);
+
+/**
+ * @function SimButton
+ * @brief Hands a button event to the application, as the deferred end of the debounce (through PendSV) or the
+ * auto-repeat would.
+ * @param pin: pin of the button
+ * @param steps: 0 for a press, the steps of the repeat otherwise
+ * @retval none
+ */
+void SimButton(uint16_t pin, uint8_t steps);
+
+/**
+ * @function SimUartFrame
+ * @brief Hands a frame over as received through USART2 in frame mode, its silence already elapsed. Dropped (and
+ * counted) outside the frame mode or while the last frame was not freed.
+ * @param data: bytes of the frame
+ * @param size: length of the frame
+ * @retval none
+ */
+void SimUartFrame(const uint8_t *data, uint16_t size);
+
+/**
+ * @function SimUartReceive
+ * @brief Queues a line as received through USART2.
+ * @param line: text of the line (without line end)
+ * @retval none
+ */
+void SimUartReceive(const char *line);
+
+#endif
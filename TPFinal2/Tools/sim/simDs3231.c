@@ -0,0 +1,171 @@
+/**
+ * @file simDs3231.c
+ * @brief Register level model of the DS3231.
+ *
+ * Keeps the 0x00-0x12 register file. The time registers are computed from the
+ * simulated time when they are read, the register pointer wraps from 0x12 to 0x00,
+ * status flags can only be cleared, and a forced conversion keeps CONV and BSY set
+ * for SIM_CONVERSION_US. The date arithmetic uses the C library, not timezone.c,
+ * so the model does not share the firmware conversions it checks.
+ */
+#define _DEFAULT_SOURCE
+#include "sim.h"
+
+#include <time.h>
+
+/**
+ * @brief Amount of registers.
+ */
+#define REGISTERS 0x13
+
+/**
+ * @brief Unix time of 01/01/2000 00:00:00 UTC.
+ */
+#define UNIX_2000 946684800LL
+
+/**
+ * @brief Register file (the time registers are refreshed before each access).
+ */
+static uint8_t registers[REGISTERS];
+
+/**
+ * @brief Seconds since 01/01/2000 held at baseMicros.
+ */
+static int64_t base;
+
+/**
+ * @brief Simulated time the time registers were last written.
+ */
+static uint64_t baseMicros;
+
+/**
+ * @brief Day of week register minus the day of week of the date: the DS3231 counts it on its own.
+ */
+static int dayOffset;
+
+/**
+ * @brief Simulated time the running conversion ends.
+ */
+static uint64_t conversionEnd;
+
+/**
+ * @brief Temperature reported (0.25 C units).
+ */
+static int16_t temperature = 25 * 4;
+
+static uint8_t ToBcd(int value){
+	return (uint8_t)(((value / 10) << 4) | (value % 10));
+}
+
+static int FromBcd(uint8_t value){
+	return (value >> 4) * 10 + (value & 0x0F);
+}
+
+/**
+ * @brief Writes the current time, temperature and busy flags into the register file.
+ */
+static void Refresh(void){
+	time_t seconds = (time_t)(UNIX_2000 + base + (int64_t)((SimMicros() - baseMicros) / 1000000));
+	struct tm fields;
+	int busy = SimMicros() < conversionEnd;
+
+	gmtime_r(&seconds, &fields);
+	registers[0x00] = ToBcd(fields.tm_sec);
+	registers[0x01] = ToBcd(fields.tm_min);
+	registers[0x02] = ToBcd(fields.tm_hour);
+	registers[0x03] = (uint8_t)(((fields.tm_wday + dayOffset) % 7 + 7) % 7 + 1);
+	registers[0x04] = ToBcd(fields.tm_mday);
+	registers[0x05] = ToBcd(fields.tm_mon + 1);
+	registers[0x06] = ToBcd(fields.tm_year - 100);
+
+	registers[0x0E] = busy ? (registers[0x0E] | 0x20) : (registers[0x0E] & ~0x20);
+	registers[0x0F] = busy ? (registers[0x0F] | 0x04) : (registers[0x0F] & ~0x04);
+	registers[0x11] = (uint8_t)(temperature >> 2);
+	registers[0x12] = (uint8_t)((temperature & 3) << 6);
+}
+
+/**
+ * @brief Loads the time written to the time registers.
+ */
+static void Latch(void){
+	struct tm fields = {0};
+	time_t seconds;
+
+	fields.tm_sec = FromBcd(registers[0x00] & 0x7F);
+	fields.tm_min = FromBcd(registers[0x01] & 0x7F);
+	fields.tm_hour = FromBcd(registers[0x02] & 0x3F);
+	fields.tm_mday = FromBcd(registers[0x04] & 0x3F);
+	fields.tm_mon = FromBcd(registers[0x05] & 0x1F) - 1;
+	fields.tm_year = FromBcd(registers[0x06]) + 100;
+	seconds = timegm(&fields);
+	gmtime_r(&seconds, &fields);
+
+	base = (int64_t)seconds - UNIX_2000;
+	baseMicros = SimMicros();
+	dayOffset = (registers[0x03] - 1) - fields.tm_wday;
+}
+
+/*Powers the model up. Declared in sim.h*/
+void SimDs3231Init(uint32_t epoch, int stopped){
+	uint8_t i;
+
+	for (i = 0; i < REGISTERS; i++) registers[i] = 0;
+	registers[0x0E] = 0x1C;				/**< INTCN set, 8 kHz rate: power on value*/
+	registers[0x0F] = 0x08;				/**< EN32kHz set*/
+	if (stopped) registers[0x0F] |= 0x80;	/**< OSF*/
+	base = epoch;
+	baseMicros = SimMicros();
+	dayOffset = 0;
+	conversionEnd = 0;
+}
+
+/*Reads registers. Declared in sim.h*/
+void SimDs3231Read(uint8_t reg, uint8_t *buffer, uint16_t size){
+	uint16_t i;
+
+	Refresh();
+	for (i = 0; i < size; i++){
+		buffer[i] = registers[reg % REGISTERS];
+		reg = (reg + 1) % REGISTERS;
+	}
+}
+
+/*Gets the last seconds update on the square wave. Declared in sim.h*/
+int SimDs3231LastSecond(uint64_t *micros){
+	uint64_t elapsed = SimMicros() - baseMicros;
+
+	if ((registers[0x0E] & 0x1C) != 0) return 0; /**< INTCN set, or not the 1 Hz rate*/
+	if (elapsed < 1000000) return 0; /**< The countdown restarted at the last write*/
+	*micros = baseMicros + elapsed / 1000000 * 1000000;
+	return 1;
+}
+
+/*Loads the alarm 2 registers. Declared in sim.h*/
+void SimDs3231SetAlarm(uint8_t day, uint8_t hours, uint8_t minutes){
+	registers[0x0B] = ToBcd(minutes);
+	registers[0x0C] = ToBcd(hours);
+	registers[0x0D] = day & 0x0F;
+}
+
+/*Handles a write transaction. Declared in sim.h*/
+void SimDs3231Write(uint8_t *buffer, uint16_t size){
+	uint8_t reg;
+	uint16_t i;
+	int timeWritten = 0;
+
+	if (size == 0) return;
+	Refresh();
+	reg = buffer[0] % REGISTERS;
+	for (i = 1; i < size; i++){
+		if (reg == 0x0F) registers[reg] = (registers[reg] & buffer[i] & 0x83) | (buffer[i] & 0x08) | (registers[reg] & 0x04); /**< Flags only clear*/
+		else if (reg == 0x0E){
+			if ((buffer[i] & 0x20) && (SimMicros() >= conversionEnd)) conversionEnd = SimMicros() + SIM_CONVERSION_US;
+			registers[reg] = buffer[i];
+		}
+		else if ((reg == 0x11) || (reg == 0x12)) {} /**< Read only*/
+		else registers[reg] = buffer[i];
+		if (reg <= 0x06) timeWritten = 1;
+		reg = (reg + 1) % REGISTERS;
+	}
+	if (timeWritten) Latch();
+}
@@ -0,0 +1,65 @@
+/**
+ * @file simHal.c
+ * @brief Simulated clock and the HAL symbols named by the firmware sources.
+ *
+ * Time only advances when the firmware spends it: bus transfers, UART transfers
+ * and blocking delays (simPorts.c), and the sleep of the idle thread (simKernel.c).
+ */
+#include "sim.h"
+
+#include "stm32f4xx_hal.h"
+
+#include <stdlib.h>
+
+GPIO_TypeDef simGPIOA, simGPIOC;
+DWT_Type simDWT;
+RCC_TypeDef simRCC = {16U << RCC_CR_HSITRIM_Pos}; /**< Factory trim in the middle of the range*/
+uint32_t SystemCoreClock = SIM_CORE_CLOCK;
+uint32_t uwTickPrio;
+simStats_t simStats;
+
+/**
+ * @brief Simulated time in microseconds.
+ */
+static uint64_t now;
+
+/*Advances the simulated time, running the interrupts at every millisecond crossed. Declared in sim.h*/
+void SimAdvance(uint64_t micros){
+	uint64_t end = now + micros;
+	uint64_t tick;
+
+	while ((tick = (now / 1000 + 1) * 1000) <= end){
+		simDWT.CYCCNT += (uint32_t)((tick - now) * (SIM_CORE_CLOCK / 1000000));
+		now = tick;
+		SimInterrupt();
+	}
+	simDWT.CYCCNT += (uint32_t)((end - now) * (SIM_CORE_CLOCK / 1000000));
+	now = end;
+	SimPendSV(); /**< A thread woken by the interrupts preempts the caller, once the time it spent is charged*/
+}
+
+/*Gets the simulated time. Declared in sim.h*/
+uint64_t SimMicros(void){
+	return now;
+}
+
+/*Tick of the HAL, in milliseconds*/
+uint32_t HAL_GetTick(void){
+	return (uint32_t)(now / 1000);
+}
+
+/*The tick always follows the simulated time: nothing to count*/
+void HAL_IncTick(void){
+}
+
+/*The tick always follows the simulated time, whatever the core clock is set to*/
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority){
+	(void)TickPriority;
+	return HAL_OK;
+}
+
+/*Error handler of the firmware: the run can not go on*/
+void Error_Handler(void){
+	fprintf(stderr, "simclock: Error_Handler called at %llu us\n", (unsigned long long)now);
+	exit(2);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file simKernel.c
+ * @brief Host version of the kernel port (portKernel.c).
+ *
+ * Every thread runs on a ucontext of its own, with a host stack (the static stack of the
+ * firmware is only used for its size). PendSV (the deferred work and the switch) runs when
+ * the interrupt mask is cleared outside an interrupt, or at the end of SimAdvance: the
+ * simulated interrupts run inside SimAdvance, whose caller is the thread they preempt.
+ * The idle thread sleeps until the next tick and gives the control back to main once
+ * the replay is over.
+ */
+#include "sim.h"
+
+#include "deferred.h"
+#include "portKernel.h"
+
+#include <stdlib.h>
+#include <ucontext.h>
+
+/**
+ * @brief Size (bytes) of the host stack of a thread.
+ */
+#define SIM_THREAD_STACK (256 * 1024)
+
+uint32_t simPrimask;
+int simInIsr;
+int simDone;
+
+/**
+ * @brief Context of main, resumed when the replay is over.
+ */
+static ucontext_t mainContext;
+
+/**
+ * @brief Flag to check whether a switch was requested and not taken yet.
+ */
+static int pending;
+
+/*The host context of a thread is kept where the board keeps its stack pointer*/
+static ucontext_t *ContextOf(kThread_t *thread){
+	return (ucontext_t *)thread->sp;
+}
+
+void KernelPortIdle(void){
+	if (simDone) swapcontext(ContextOf(kernelCurrent), &mainContext);
+	SimAdvance(1000 - SimMicros() % 1000); /**< WFI: up to the next SysTick*/
+}
+
+bool_t KernelPortInIsr(void){
+	return simInIsr != 0;
+}
+
+void KernelPortInitStack(kThread_t *thread, void (*entry)(void)){
+	ucontext_t *context = calloc(1, sizeof(ucontext_t));
+
+	getcontext(context);
+	context->uc_stack.ss_sp = malloc(SIM_THREAD_STACK);
+	context->uc_stack.ss_size = SIM_THREAD_STACK;
+	context->uc_link = NULL;
+	makecontext(context, entry, 0);
+	thread->sp = (uint32_t *)context;
+}
+
+void KernelPortStart(void){
+	pending = 0;
+	kernelCurrent = kernelNext;
+	simPrimask = 0;
+	swapcontext(&mainContext, ContextOf(kernelCurrent)); /**< Back here once the replay is over*/
+}
+
+void KernelPortSwitch(void){
+	pending = 1;
+}
+
+/*Runs PendSV if it was requested, the interrupts are unmasked and none runs: the deferred work, then the switch.
+ * Declared in stm32f4xx_hal.h*/
+void SimPendSV(void){
+	kThread_t *from = kernelCurrent;
+
+	if (!pending || simInIsr || simPrimask) return;
+	pending = 0;
+	DeferredRun();
+	if ((from == NULL) || (kernelNext == from)) return;
+	kernelCurrent = kernelNext;
+	swapcontext(ContextOf(from), ContextOf(kernelCurrent));
+}
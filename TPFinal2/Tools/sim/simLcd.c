@@ -0,0 +1,143 @@
+/**
+ * @file simLcd.c
+ * @brief Model of the PCF8574 I2C expander driving an HD44780 in 4-bit mode.
+ *
+ * The PCF8574 outputs are RS (P0), RW (P1), E (P2), backlight (P3) and D4-D7 (P4-P7).
+ * A falling edge of E latches D4-D7. The HD44780 starts in 8-bit mode (D0-D3 read as
+ * high), switches with a function set and then pairs nibbles. Nibbles latched while
+ * the controller is still executing the previous instruction are ignored, as the real
+ * one does: the firmware init sequence depends on it to align the nibble pairs.
+ */
+#include "sim.h"
+
+/**
+ * @brief Size of the DDRAM address space.
+ */
+#define DDRAM_SIZE 0x80
+
+/**
+ * @brief Visible columns.
+ */
+#define COLUMNS 16
+
+/**
+ * @brief Execution time (in microseconds) of clear display and return home.
+ */
+#define SLOW_INSTRUCTION_US 1520
+
+/**
+ * @brief Execution time (in microseconds) of the other instructions and of a data write.
+ */
+#define FAST_INSTRUCTION_US 37
+
+/**
+ * @brief Execution time (in microseconds) of the first instruction after power on.
+ */
+#define POWER_ON_US 4100
+
+static uint8_t ddram[DDRAM_SIZE];
+static uint8_t address;
+static int increment = 1;
+static int fourBit;
+static int poweredOn;
+static int halfPending;
+static uint8_t firstHalf;
+static uint8_t firstRs;
+static uint8_t lastOutput;
+static uint64_t busyUntil;
+
+/**
+ * @brief Moves the address counter one position, wrapping between the two lines as in 2-line mode.
+ */
+static void Step(void){
+	if (increment){
+		if (address == 0x27) address = 0x40;
+		else if (address == 0x67) address = 0x00;
+		else address++;
+	}
+	else{
+		if (address == 0x00) address = 0x67;
+		else if (address == 0x40) address = 0x27;
+		else address--;
+	}
+}
+
+/**
+ * @brief Executes an instruction or a data write.
+ */
+static void Execute(uint8_t value, uint8_t rs, uint64_t micros){
+	uint8_t i;
+
+	busyUntil = micros + FAST_INSTRUCTION_US;
+	if (rs){
+		if (ddram[address] == value) simStats.lcdCharsUnchanged++;
+		ddram[address] = value;
+		simStats.lcdChars++;
+		Step();
+		return;
+	}
+	simStats.lcdInstructions++;
+	if (value & 0x80) address = value & 0x7F;
+	else if (value & 0x40) {} /**< CGRAM address: not modelled*/
+	else if (value & 0x20) fourBit = !(value & 0x10);
+	else if (value & 0x10) {} /**< Cursor or display shift: not used by the firmware*/
+	else if (value & 0x08) {} /**< Display on/off control: contents are kept*/
+	else if (value & 0x04) increment = (value & 0x02) != 0;
+	else if (value & 0x02){
+		address = 0;
+		busyUntil = micros + SLOW_INSTRUCTION_US;
+	}
+	else if (value & 0x01){
+		for (i = 0; i < DDRAM_SIZE; i++) ddram[i] = ' ';
+		address = 0;
+		increment = 1;
+		busyUntil = micros + SLOW_INSTRUCTION_US;
+	}
+}
+
+/*Gets a visible row. Declared in sim.h*/
+void SimLcdRow(uint8_t row, char *text){
+	uint8_t i, c;
+
+	for (i = 0; i < COLUMNS; i++){
+		c = ddram[(row ? 0x40 : 0x00) + i];
+		text[i] = ((c >= 0x20) && (c < 0x7F)) ? (char)c : '?';
+	}
+	text[COLUMNS] = '\0';
+}
+
+/*Handles a byte written to the PCF8574. Declared in sim.h*/
+void SimLcdWrite(uint8_t value, uint64_t micros){
+	uint8_t nibble = value >> 4;
+	uint8_t rs = value & 0x01;
+	int falling = (lastOutput & 0x04) && !(value & 0x04);
+	uint8_t i;
+
+	if (!poweredOn){
+		for (i = 0; i < DDRAM_SIZE; i++) ddram[i] = ' ';
+		poweredOn = 1;
+		busyUntil = 0;
+	}
+	lastOutput = value;
+	if (!falling) return;
+	if (micros < busyUntil){
+		simStats.lcdNibblesDropped++;
+		return;
+	}
+
+	if (!fourBit){
+		int first = (busyUntil == 0);
+		Execute((uint8_t)((nibble << 4) | 0x0F), rs, micros);
+		if (first) busyUntil = micros + POWER_ON_US;
+		halfPending = 0;
+		return;
+	}
+	if (!halfPending){
+		firstHalf = nibble;
+		firstRs = rs;
+		halfPending = 1;
+		return;
+	}
+	halfPending = 0;
+	Execute((uint8_t)((firstHalf << 4) | nibble), firstRs, micros);
+}
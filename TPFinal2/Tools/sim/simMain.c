@@ -0,0 +1,247 @@
+/**
+ * @file simMain.c
+ * @brief Replays a button trace against the host build of the clock.
+ *
+ * Runs the same sequence as main.c (init, then the threads of the kernel) on the simulated
+ * clock, handing the events of the trace to the application at their times from the
+ * interrupts of every millisecond, and prints the final screen and the statistics as "key value" lines.
+ *
+ * Trace lines (times in milliseconds from the start of the recording):
+ *     S <utc> <zone> [osf]   DS3231 time (seconds since 01/01/2000) and local zone at the start
+ *     A <day> <hh> <mm>      DS3231 alarm registers (UTC) at the start
+ *     B <ms> <button>        press of RIGHT, LEFT, MENU or ENTER
+ *     H <ms> <button> <n>    auto-repeat of a held button, n steps
+ *     U <ms> <text>          line received through USART2
+ *     F <ms> <hex>           frame received through USART2 in frame mode (Modbus), up to 31 bytes in hex
+ *     E <ms>                 end of the recording
+ * Empty lines and lines starting with '#' are skipped. The firmware sends these lines
+ * itself while recording ("R1"/"R0" through USART2).
+ *
+ * Usage: simclock [-u uart.txt] trace
+ */
+#include "sim.h"
+
+#include "app.h"
+#include "swTimer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Time (milliseconds) the run goes on after the last event when the trace has no end line.
+ */
+#define TAIL_TIME 2000
+
+/**
+ * @brief Maximum length of a trace line.
+ */
+#define TRACE_LINE 128
+
+/**
+ * @brief Event of the trace.
+ */
+typedef struct{
+	char kind;
+	uint32_t ms;
+	uint16_t pin;
+	uint8_t steps;
+	char text[UART_LINE_SIZE];
+} simEvent_t;
+
+static simEvent_t *events;
+static size_t eventCount, next;
+static uint64_t origin;
+static uint32_t end;
+static int replaying;
+
+static uint16_t ParseButton(const char *name, int line){
+	if (strcmp(name, "RIGHT") == 0) return RIGHT_BUTTON;
+	if (strcmp(name, "LEFT") == 0) return LEFT_BUTTON;
+	if (strcmp(name, "MENU") == 0) return MENU_BUTTON;
+	if (strcmp(name, "ENTER") == 0) return ENTER_BUTTON;
+	fprintf(stderr, "simclock: line %d: unknown button '%s'\n", line, name);
+	exit(1);
+}
+
+/**
+ * @brief Reads the trace, applying the start conditions. Returns the end time.
+ */
+static uint32_t ReadTrace(FILE *file, uint32_t *epoch, uint8_t *zone, int *stopped){
+	char line[TRACE_LINE], name[16], flag[8];
+	unsigned long ms = 0, value;
+	unsigned int a, b, c;
+	int offset;
+	uint32_t end = 0;
+	int number = 0, endSeen = 0;
+	size_t capacity = 0;
+	simEvent_t *event;
+
+	while (fgets(line, sizeof(line), file) != NULL){
+		number++;
+		line[strcspn(line, "\r\n")] = '\0';
+		if ((line[0] == '\0') || (line[0] == '#')) continue;
+		if (line[0] == 'S'){
+			flag[0] = '\0';
+			if (sscanf(line, "S %lu %u %7s", &value, &a, flag) < 2) goto bad;
+			*epoch = (uint32_t)value;
+			*zone = (uint8_t)a;
+			*stopped = (strcmp(flag, "osf") == 0);
+			continue;
+		}
+		if (line[0] == 'A'){
+			if (sscanf(line, "A %u %u %u", &a, &b, &c) != 3) goto bad;
+			SimDs3231SetAlarm(a, b, c);
+			continue;
+		}
+		if (line[0] == 'E'){
+			if (sscanf(line, "E %lu", &ms) != 1) goto bad;
+			end = ms;
+			endSeen = 1;
+			continue;
+		}
+		if (eventCount == capacity){
+			capacity = capacity ? capacity * 2 : 64;
+			events = realloc(events, capacity * sizeof(simEvent_t));
+		}
+		event = &events[eventCount];
+		memset(event, 0, sizeof(*event));
+		event->kind = line[0];
+		if (line[0] == 'B'){
+			if (sscanf(line, "B %lu %15s", &ms, name) != 2) goto bad;
+			event->pin = ParseButton(name, number);
+		}
+		else if (line[0] == 'H'){
+			if (sscanf(line, "H %lu %15s %u", &ms, name, &a) != 3) goto bad;
+			event->pin = ParseButton(name, number);
+			event->steps = (a > 0) ? a : 1;
+		}
+		else if ((line[0] == 'U') || (line[0] == 'F')){
+			if (sscanf(&line[1], " %lu %n", &ms, &offset) < 1) goto bad;
+			strncpy(event->text, &line[1 + offset], UART_LINE_SIZE - 1);
+			if ((line[0] == 'F') && (strspn(event->text, "0123456789abcdefABCDEF") != strlen(event->text) ||
+					(strlen(event->text) % 2 != 0))) goto bad;
+		}
+		else goto bad;
+		event->ms = ms;
+		if (!endSeen && (ms + TAIL_TIME > end)) end = ms + TAIL_TIME;
+		eventCount++;
+	}
+	return end;
+bad:
+	fprintf(stderr, "simclock: line %d: can not parse '%s'\n", number, line);
+	exit(1);
+}
+
+/**
+ * @brief Hands the hex bytes of an F line over as a frame.
+ */
+static void ReceiveFrame(const char *hex){
+	uint8_t frame[UART_LINE_SIZE / 2];
+	unsigned int byte;
+	uint16_t size = 0;
+
+	while ((hex[0] != '\0') && (sscanf(hex, "%2x", &byte) == 1)){
+		frame[size++] = byte;
+		hex += 2;
+	}
+	SimUartFrame(frame, size);
+}
+
+/*Runs the interrupts of a millisecond. Declared in sim.h*/
+void SimInterrupt(void){
+	simInIsr = 1;
+	if (replaying){
+		while ((next < eventCount) && ((uint64_t)events[next].ms * 1000 <= SimMicros() - origin)){
+			if (events[next].kind == 'U') SimUartReceive(events[next].text);
+			else if (events[next].kind == 'F') ReceiveFrame(events[next].text);
+			else SimButton(events[next].pin, events[next].steps);
+			next++;
+		}
+		if (SimMicros() - origin > (uint64_t)end * 1000) simDone = 1;
+	}
+	DeferredTick(); /**< Same order as SysTick_Handler*/
+	SwTimerTick();
+	KernelTick();
+	simInIsr = 0;
+}
+
+static void PrintLatency(const char *name, latencyScreen_t screen){
+	latencyStats_t stats;
+
+	LatencyGetStats(screen, &stats);
+	printf("latency_%s_us %lu %lu %lu %lu %lu\n", name, (unsigned long)stats.count, (unsigned long)stats.min,
+			(unsigned long)stats.avg, (unsigned long)stats.p99, (unsigned long)stats.max);
+}
+
+int main(int argc, char **argv){
+	const char *tracePath = NULL;
+	FILE *trace;
+	uint32_t epoch = 26 * 365 * 86400UL; /**< Default start: early 2026*/
+	uint8_t zone = TZ_DEFAULT_ZONE;
+	int stopped = 0, i;
+	uint64_t busy = 0;
+	const kThread_t *thread;
+	char row[17];
+
+	for (i = 1; i < argc; i++){
+		if ((strcmp(argv[i], "-u") == 0) && (i + 1 < argc)){
+			i++;
+			simUart = (strcmp(argv[i], "-") == 0) ? stdout : fopen(argv[i], "w");
+		}
+		else tracePath = argv[i];
+	}
+	if (tracePath == NULL){
+		fprintf(stderr, "usage: simclock [-u uart.txt] trace\n");
+		return 1;
+	}
+	trace = fopen(tracePath, "r");
+	if (trace == NULL){
+		perror(tracePath);
+		return 1;
+	}
+	end = ReadTrace(trace, &epoch, &zone, &stopped);
+	fclose(trace);
+
+	SimDs3231Init(epoch, stopped);
+	TzSetLocalZone(zone);
+
+	/* Same sequence as main.c*/
+	CyclesInit();
+	I2CInit();
+	ButtonsInit();
+	SQWInit();
+	UARTStartReception();
+	AppInit();
+
+	origin = SimMicros();
+	memset(&simStats, 0, sizeof(simStats)); /**< Only the replay is measured, not the boot*/
+	replaying = 1;
+	KernelStart(); /**< Returns once the replay is over*/
+
+	SimLcdRow(0, row);
+	printf("lcd0 |%s|\n", row);
+	SimLcdRow(1, row);
+	printf("lcd1 |%s|\n", row);
+	printf("sim_ms %llu\n", (unsigned long long)((SimMicros() - origin) / 1000));
+	for (i = 0; (thread = KernelThreadGet(i)) != NULL; i++){
+		if (thread->priority != 0) busy += thread->runCycles;
+		printf("thread_%s_activations %lu\n", thread->name, (unsigned long)thread->activations);
+		printf("thread_%s_wcrt_us %lu\n", thread->name, (unsigned long)CyclesToMicros(thread->worstResponse));
+	}
+	printf("cpu_busy_us %llu\n", (unsigned long long)(busy / (SIM_CORE_CLOCK / 1000000)));
+	printf("i2c_transactions %lu\n", (unsigned long)simStats.i2cTransactions);
+	printf("i2c_bytes %lu\n", (unsigned long)simStats.i2cBytes);
+	printf("i2c_bus_us %llu\n", (unsigned long long)simStats.i2cMicros);
+	printf("ds3231_transactions %lu\n", (unsigned long)simStats.ds3231Transactions);
+	printf("lcd_transactions %lu\n", (unsigned long)simStats.lcdTransactions);
+	printf("lcd_instructions %lu\n", (unsigned long)simStats.lcdInstructions);
+	printf("lcd_chars %lu\n", (unsigned long)simStats.lcdChars);
+	printf("lcd_chars_unchanged %lu\n", (unsigned long)simStats.lcdCharsUnchanged);
+	printf("lcd_nibbles_dropped %lu\n", (unsigned long)simStats.lcdNibblesDropped);
+	printf("app_delay_us %llu\n", (unsigned long long)simStats.delayMicros);
+	printf("uart_bytes %lu\n", (unsigned long)simStats.uartBytes);
+	PrintLatency("MENU", LAT_MENU);
+	PrintLatency("SETTIME", LAT_SETTIME);
+	PrintLatency("SETALARM", LAT_SETALARM);
+	return 0;
+}
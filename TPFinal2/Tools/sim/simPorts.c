@@ -0,0 +1,390 @@
+/**
+ * @file simPorts.c
+ * @brief Host versions of the port* wrappers.
+ *
+ * Replaces portI2C.c, portUART.c, portButtons.c, portCycles.c, portCapture.c,
+ * portSQW.c, portPower.c and portClock.c. Every transfer is charged to the simulated clock with the time it takes
+ * on the real bus, so blocking drivers cost in the simulation what they cost on target.
+ */
+#include "sim.h"
+
+#include "ds3231.h"
+#include "lcd_i2c.h"
+#include "deferred.h"
+#include "portButtons.h"
+#include "portCapture.h"
+#include "portClock.h"
+#include "portCycles.h"
+#include "portI2C.h"
+#include "portKernel.h"
+#include "portPower.h"
+#include "portSQW.h"
+#include "portUART.h"
+#include "trace.h"
+
+#include <string.h>
+
+FILE *simUart;
+
+static char uartLines[UART_LINE_SLOTS][UART_LINE_SIZE];
+static uint32_t uartStamps[UART_LINE_SLOTS];
+static uint8_t uartHead, uartCount;
+static uint32_t uartDropped, uartTxDropped;
+static uint64_t uartTxDone;
+static uint8_t uartFrame[UART_FRAME_SIZE];
+static uint16_t uartFrameLength, uartFrameGap;
+static uint32_t uartFrameStamp;
+static bool uartFrameReady;
+static uint32_t buttonEdges[NUMBER_OF_BUTTONS];
+static uint64_t captureStart, captureStop;
+static edgeTrack_t sqwTrack;
+static uint32_t uartRxTick;
+static clockMode_t clockMode = CLOCK_MODE_FAST;
+
+/**
+ * @brief Charges a transaction to the bus counters and the simulated clock.
+ */
+static void BusTransfer(uint16_t bytes){
+	uint64_t micros = (uint64_t)bytes * SIM_I2C_BYTE_US;
+
+	simStats.i2cTransactions++;
+	simStats.i2cBytes += bytes;
+	simStats.i2cMicros += micros;
+	SimAdvance(micros);
+}
+
+static uint8_t ButtonIndex(uint16_t pin){
+	return (pin == RIGHT_PIN) ? 0 : (pin == MENU_PIN) ? 1 : (pin == LEFT_PIN) ? 2 : 3;
+}
+
+/* portI2C -------------------------------------------------------------------*/
+
+void I2CInit(void){
+}
+
+void I2CDelay(uint32_t delayTime){
+	simStats.delayMicros += (uint64_t)delayTime * 1000;
+	if (KernelRunning()) KernelSleep(delayTime); /**< Only the calling thread waits*/
+	else SimAdvance((uint64_t)delayTime * 1000);
+}
+
+void I2CGetStats(i2cStats_t *stats){
+	stats->transfers = simStats.i2cTransactions;
+	stats->errors = 0; /**< The simulated bus never fails*/
+	stats->timeouts = 0;
+}
+
+bool_t I2CLock(tick_t timeout){
+	(void)timeout;
+	return true; /**< The transfers are charged at once: none is ever in progress*/
+}
+
+void I2CRetime(void){
+}
+
+void I2CUnlock(void){
+}
+
+void I2CMasterTransmit(uint16_t devAddr, uint8_t *buffer, uint16_t size){
+	uint64_t start = SimMicros();
+	uint16_t i;
+
+	if (devAddr == DS3231_ADDR){
+		simStats.ds3231Transactions++;
+		SimDs3231Write(buffer, size);
+	}
+	else if (devAddr == LCD_ADDR){
+		simStats.lcdTransactions++;
+		for (i = 0; i < size; i++) SimLcdWrite(buffer[i], start + (uint64_t)(i + 2) * SIM_I2C_BYTE_US); /**< After the address byte*/
+	}
+	TRACE_SPAN_BEGIN(TRACE_I2C, size);
+	BusTransfer(size + 1);
+	TRACE_POINT(TRACE_I2C_DONE, 0);
+	TRACE_SPAN_END(TRACE_I2C, size);
+}
+
+void I2CReadMemory(uint16_t startReg, uint16_t devAddr, uint8_t *buffer, uint16_t size){
+	if (devAddr == DS3231_ADDR){
+		simStats.ds3231Transactions++;
+		SimDs3231Read((uint8_t)startReg, buffer, size);
+	}
+	else memset(buffer, 0xFF, size); /**< No device: the bus reads high*/
+	TRACE_SPAN_BEGIN(TRACE_I2C, size);
+	BusTransfer(size + 3); /**< Address, register, address again*/
+	TRACE_POINT(TRACE_I2C_DONE, 1);
+	TRACE_SPAN_END(TRACE_I2C, size);
+}
+
+/* portUART ------------------------------------------------------------------*/
+
+/**
+ * @brief Queues bytes on the line, waiting for room in the transmit buffer as the target does: once the kernel runs
+ * only the calling thread waits.
+ */
+static void TxSend(const uint8_t *buffer, uint16_t size){
+	uint64_t now, queued, wait;
+
+	if (simUart != NULL) fwrite(buffer, 1, size, simUart);
+	simStats.uartBytes += size;
+	simStats.uartMicros += (uint64_t)size * SIM_UART_BYTE_US;
+	while (true){
+		now = SimMicros();
+		if (uartTxDone < now) uartTxDone = now;
+		queued = (uartTxDone - now) / SIM_UART_BYTE_US;
+		if (queued + size <= UART_TX_RING - 1) break;
+		wait = (queued + size - (UART_TX_RING - 1)) * SIM_UART_BYTE_US;
+		if (KernelRunning() && !KernelPortInIsr()) KernelSleep((wait + 999) / 1000);
+		else SimAdvance(wait);
+	}
+	uartTxDone += (uint64_t)size * SIM_UART_BYTE_US;
+}
+
+void UARTFrameFree(void){
+	uartFrameReady = false;
+}
+
+uint8_t *UARTFrameGet(uint16_t *size, uint32_t *stamp){
+	if (!uartFrameReady) return NULL;
+	*size = uartFrameLength;
+	*stamp = uartFrameStamp;
+	return uartFrame;
+}
+
+void UARTFrameMode(uint16_t gap){
+	uartFrameGap = gap;
+	uartFrameReady = false;
+}
+
+void UARTFrameSend(const uint8_t *buffer, uint16_t size){
+	TxSend(buffer, size);
+}
+
+uint8_t UARTLineCount(void){
+	return uartCount;
+}
+
+void UARTLineFree(void){
+	if (uartCount == 0) return;
+	uartHead = (uartHead + 1) % UART_LINE_SLOTS;
+	uartCount--;
+}
+
+char *UARTLineGet(uint32_t *stamp){
+	if (uartCount == 0) return NULL;
+	*stamp = uartStamps[uartHead];
+	return uartLines[uartHead];
+}
+
+uint32_t UARTLinesDropped(void){
+	return uartDropped;
+}
+
+void UARTResetStats(void){
+	uartDropped = 0;
+	uartTxDropped = 0;
+}
+
+void UARTRetime(void){
+}
+
+uint32_t UARTRxErrors(void){
+	return 0;
+}
+
+uint32_t UARTRxTick(void){
+	return uartRxTick;
+}
+
+void UARTSendString(char *str){
+	UARTTransmit((uint8_t *)str, strlen(str));
+}
+
+void UARTStartReception(void){
+}
+
+void UARTTransmit(uint8_t *buffer, uint16_t size){
+	if (uartFrameGap != 0) uartTxDropped += size; /**< Frame mode: text is dropped*/
+	else TxSend(buffer, size);
+}
+
+uint32_t UARTTxDropped(void){
+	return uartTxDropped;
+}
+
+bool UARTTxIdle(void){
+	return SimMicros() >= uartTxDone;
+}
+
+uint16_t UARTTxUsed(void){
+	uint64_t now = SimMicros();
+
+	return (uartTxDone > now) ? (uint16_t)((uartTxDone - now) / SIM_UART_BYTE_US) : 0;
+}
+
+bool UARTWrite(const uint8_t *buffer, uint16_t size){
+	uint64_t now = SimMicros();
+
+	if (uartTxDone < now) uartTxDone = now;
+	if ((uartFrameGap != 0) || ((uartTxDone - now) / SIM_UART_BYTE_US + size > UART_TX_RING - 1)){
+		uartTxDropped += size;
+		return false;
+	}
+	TxSend(buffer, size);
+	return true;
+}
+
+/*Hands a received frame over. Declared in sim.h*/
+void SimUartFrame(const uint8_t *data, uint16_t size){
+	uartRxTick = HAL_GetTick();
+	if ((uartFrameGap == 0) || uartFrameReady || (size > UART_FRAME_SIZE)){ /**< Garbage for the lines, or dropped*/
+		uartDropped++;
+		return;
+	}
+	memcpy(uartFrame, data, size);
+	uartFrameLength = size;
+	uartFrameStamp = CyclesNow();
+	uartFrameReady = true;
+	TRACE_POINT(TRACE_UART_RX, size);
+	UARTFrameReceived();
+}
+
+/*Queues a received line. Declared in sim.h*/
+void SimUartReceive(const char *line){
+	uint8_t slot = (uartHead + uartCount) % UART_LINE_SLOTS;
+
+	uartRxTick = HAL_GetTick();
+	if (uartCount == UART_LINE_SLOTS){
+		uartDropped++;
+		return;
+	}
+	strncpy(uartLines[slot], line, UART_LINE_SIZE - 1);
+	uartLines[slot][UART_LINE_SIZE - 1] = '\0';
+	uartStamps[slot] = CyclesNow();
+	uartCount++;
+	TRACE_POINT(TRACE_UART_RX, slot);
+	UARTLineReceived();
+}
+
+/* portButtons ---------------------------------------------------------------*/
+
+uint32_t ButtonGetEdge(uint16_t GPIO_Pin){
+	return buttonEdges[ButtonIndex(GPIO_Pin)];
+}
+
+void ButtonsInit(void){
+	/* Presses and repeats are part of the trace (B and H lines): see SimButton*/
+}
+
+/*Deferred half of a debounced press, as debounceDone in portButtons.c*/
+static void PressDone(uint32_t pin, uint32_t stamp){
+	buttonEdges[ButtonIndex(pin)] = stamp;
+	ButtonPressed(pin);
+}
+
+/*Hands a button event to the application. Declared in sim.h*/
+void SimButton(uint16_t pin, uint8_t steps){
+	if (steps == 0){
+		TRACE_POINT(TRACE_EXTI, pin);
+		DeferredPost(PressDone, pin);
+	}
+	else ButtonRepeated(pin, steps);
+}
+
+/* portCycles ----------------------------------------------------------------*/
+
+void CyclesInit(void){
+	DWT->CYCCNT = 0;
+}
+
+uint32_t CyclesToMicros(uint32_t cycles){
+	return cycles / CYCLES_PER_US;
+}
+
+void CyclesWaitUntil(uint32_t cycles){
+	int32_t left = (int32_t)(cycles - CyclesNow());
+	uint32_t cyclesPerUs = SIM_CORE_CLOCK / 1000000;
+
+	if (left > 0) SimAdvance((left + cyclesPerUs - 1) / cyclesPerUs); /**< The counter only moves with the simulated time*/
+}
+
+/* portCapture: the 32 kHz output of the DS3231 is exact and so is the core clock ------*/
+
+void CaptureGet(uint32_t *ticks, uint32_t *edges){
+	uint64_t elapsed = captureStop - captureStart;
+
+	*edges = (uint32_t)(elapsed * 32768 / 1000000 / CAPTURE_PRESCALER * CAPTURE_PRESCALER);
+	*ticks = (uint32_t)((uint64_t)*edges * SIM_CORE_CLOCK / 32768);
+}
+
+void CaptureInit(void){
+}
+
+void CaptureIRQHandler(void){
+}
+
+void CaptureStart(void){
+	captureStart = SimMicros();
+}
+
+void CaptureStop(void){
+	captureStop = SimMicros();
+}
+
+/* portSQW: the last SQW edge comes from the DS3231 model, no 1 PPS is wired ---*/
+
+void SQWEdge(uint16_t GPIO_Pin){
+	(void)GPIO_Pin;
+}
+
+void SQWGetTrack(edgeInput_t input, edgeTrack_t *track){
+	uint64_t edge;
+
+	if ((input == SQW_INPUT) && SimDs3231LastSecond(&edge)){
+		sqwTrack.last = CyclesNow() - (uint32_t)((SimMicros() - edge) * (SIM_CORE_CLOCK / 1000000));
+		sqwTrack.started = true; /**< Without periods: a calibration never ends a window*/
+	}
+	if (input == SQW_INPUT) *track = sqwTrack;
+	else memset(track, 0, sizeof(*track));
+}
+
+void SQWInit(void){
+}
+
+void SQWReset(void){
+	memset(&sqwTrack, 0, sizeof(sqwTrack));
+}
+
+/* portPower: without SQW edges the low-power mode never stops the core --------*/
+
+void PowerPortInit(void){
+}
+
+tick_t PowerPortSleep(tick_t ticks){
+	(void)ticks;
+	KernelPortIdle(); /**< The simulated tick runs its interrupt every millisecond anyway*/
+	return 0;
+}
+
+uint32_t PowerPortStop(void){
+	KernelPortIdle();
+	return 0;
+}
+
+/* portClock: the simulated time does not depend on the clock, only the mode is kept ---*/
+
+void ClockPortCalibrate(uint32_t frequency){
+	SystemCoreClock = frequency; /**< Of the fast mode in any mode: the cycle counter always runs at it here*/
+}
+
+void ClockPortInit(void){
+	clockMode = CLOCK_MODE_FAST;
+}
+
+clockMode_t ClockPortMode(void){
+	return clockMode;
+}
+
+uint32_t ClockPortSet(clockMode_t mode){
+	clockMode = mode;
+	return 0; /**< The PLL locks at once*/
+}
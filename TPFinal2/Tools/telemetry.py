@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""
+@file telemetry.py
+@brief Decoder of the binary telemetry stream of the clock (telemetry.h).
+
+Splits the bytes received through the serial port at the zero delimiters, decodes
+each COBS chunk, checks its CRC-16 (CCITT, initial 0xFFFF, low byte first) and its
+version, and prints one line per frame: time, temperature, CPU load, I2C counters,
+input latency, queue depths and error counts. The frames lost (gaps in the sequence
+number) and the chunks with a bad CRC are counted; the text lines sent by the console
+between frames are printed as they are.
+
+Usage:
+    python3 telemetry.py /dev/ttyACM0 --period 100   board on the ST-LINK virtual COM
+                                                     port, sends "TM 100" first
+    python3 telemetry.py --pty                       creates a pty pair and prints the
+                                                     path of the device end (stand-in
+                                                     for testing)
+    python3 telemetry.py --file uart.bin --csv       decodes a capture (or "-" for
+                                                     stdin, e.g. the simulator output)
+"""
+import argparse
+import datetime
+import os
+import select
+import struct
+import sys
+
+from serialport import open_port, open_pty
+
+VERSION = 1
+FRAME = struct.Struct("<BBHIIhHII" + "HII" * 3 + "BBHIIII")
+SCREENS = ("menu", "settime", "setalarm")
+EPOCH = datetime.datetime(2000, 1, 1)
+FLAGS = ((0x01, "valid"), (0x02, "lp"), (0x04, "gov"))
+FIELDS = ("seq", "uptime_ms", "time", "flags", "temp_c", "load_pct", "i2c", "i2c_err") + \
+    tuple("%s_%s" % (screen, item) for screen in SCREENS for item in ("n", "avg_us", "max_us")) + \
+    ("buttons", "lines", "tx_used", "misses", "rx_err", "lines_dropped", "tx_dropped")
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as Crc16 in telemetry.c."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(chunk):
+    """Decodes a COBS chunk (without its delimiters). Returns None if it is malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(chunk):
+        code = chunk[i]
+        if code == 0 or i + code > len(chunk):
+            return None
+        out += chunk[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(chunk):
+            out.append(0)
+    return bytes(out)
+
+
+def parse(chunk):
+    """Returns the fields of a frame chunk, or None if it is not a valid frame."""
+    data = cobs_decode(chunk)
+    if data is None or len(data) != FRAME.size + 2:
+        return None
+    if crc16(data[:-2]) != struct.unpack_from("<H", data, FRAME.size)[0]:
+        return None
+    values = FRAME.unpack_from(data)
+    if values[0] != VERSION:
+        return None
+    (_, flags, sequence, uptime, epoch, temperature, load, transfers, errors), rest = values[:9], values[9:]
+    latency, rest = rest[:9], rest[9:]
+    return [sequence, uptime, (EPOCH + datetime.timedelta(seconds=epoch)).isoformat() if flags & 0x01 else "-",
+            "+".join(name for bit, name in FLAGS if flags & bit) or "-", temperature / 4, load / 10,
+            transfers, errors] + list(latency) + list(rest)
+
+
+class Decoder:
+    """Splits the stream into chunks and keeps the counts."""
+
+    def __init__(self, csv):
+        self.csv = csv
+        self.pending = b""
+        self.sequence = None
+        self.frames = self.lost = self.bad = 0
+        if csv:
+            print(",".join(FIELDS), flush=True)
+
+    def feed(self, data):
+        self.pending += data
+        *chunks, self.pending = self.pending.split(b"\x00")
+        for chunk in chunks:
+            if chunk:
+                self.chunk(chunk)
+
+    def flush(self):
+        """Takes the bytes after the last delimiter, at the end of the stream."""
+        if self.pending:
+            self.chunk(self.pending)
+            self.pending = b""
+
+    def chunk(self, chunk):
+        fields = parse(chunk)
+        if fields is None:
+            lines = chunk.decode(errors="replace").splitlines()
+            if all(line.isprintable() for line in lines):  # console lines between frames
+                for line in lines:
+                    if line and not self.csv:
+                        print(line, flush=True)
+            else:
+                self.bad += 1
+            return
+        if self.sequence is not None:
+            self.lost += (fields[0] - self.sequence - 1) & 0xFFFF
+        self.sequence = fields[0]
+        self.frames += 1
+        if self.csv:
+            print(",".join(str(field) for field in fields), flush=True)
+            return
+        latency = " ".join("%s=%d/%d/%dus" % (SCREENS[i], *fields[8 + 3 * i:11 + 3 * i]) for i in range(3))
+        print("#%d %dms %s [%s] %.2fC load=%.1f%% i2c=%d err=%d %s buttons=%d lines=%d tx=%dB "
+              "misses=%d rxerr=%d dropped=%d txdrop=%dB" % (*fields[:8], latency, *fields[17:]), flush=True)
+
+    def summary(self):
+        return "frames=%d lost=%d bad=%d" % (self.frames, self.lost, self.bad)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?", help="serial port of the clock")
+    parser.add_argument("--pty", action="store_true", help="listen on a new pty instead of a port")
+    parser.add_argument("--file", help="decode a capture instead ('-' for stdin)")
+    parser.add_argument("--period", type=int, help="send 'TM <period>' first (ms, 0 stops the stream)")
+    parser.add_argument("--csv", action="store_true", help="print the frames as CSV")
+    args = parser.parse_args()
+
+    decoder = Decoder(args.csv)
+    if args.file:
+        stream = sys.stdin.buffer if args.file == "-" else open(args.file, "rb")
+        for data in iter(lambda: stream.read(4096), b""):
+            decoder.feed(data)
+        decoder.flush()
+        print(decoder.summary(), file=sys.stderr)
+        return
+
+    if args.pty:
+        fd, path = open_pty()
+        print("device end: %s" % path, file=sys.stderr, flush=True)
+    elif args.port:
+        fd = open_port(args.port)
+    else:
+        parser.error("a port, --pty or --file is required")
+
+    if args.period is not None:
+        os.write(fd, b"TM %d\n" % args.period)
+    try:
+        while True:
+            select.select([fd], [], [])
+            try:
+                decoder.feed(os.read(fd, 4096))
+            except OSError:  # pty peer closed
+                continue
+    finally:
+        print(decoder.summary(), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        sys.exit(0)
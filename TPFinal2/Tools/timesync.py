@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+@file timesync.py
+@brief Sets the DS3231 of the clock from the host clock (timeSync.h).
+
+Runs rounds of "SYNC <t1> [<t4>]" with the board. t1 is the host time when the line
+starts to be sent, moved to the end of its first byte (where the board stamps it);
+t4 is the time the reply arrived, moved back to the start of its first byte by the
+length of the line at the baud rate. Times are microseconds since 01/01/2000 UTC from
+the system clock, which should be disciplined (NTP). Each round prints its round trip
+delay; the board keeps the offset of the shortest one. Then "SYNC SET <t4>" writes
+the next whole host second to the DS3231, at that second, and the tool waits for the
+result: the error of the DS3231 before the write and the first SQW edge after it
+against the host second. The exit status is 0 if that edge is within the tolerance.
+The rounds are only as good as the link: the virtual COM port of the ST-LINK adds
+about a millisecond each way, the shortest round keeps the least of it. Through a pty
+there is no byte time to take off.
+
+Usage:
+    python3 timesync.py /dev/ttyACM0                     8 rounds, then writes the DS3231
+    python3 timesync.py /dev/ttyACM0 --rounds 16 --dry   rounds only, the DS3231 is not written
+    python3 timesync.py --pty                            creates a pty pair and prints the
+                                                         path of the device end (stand-in
+                                                         for testing)
+"""
+import argparse
+import os
+import re
+import select
+import sys
+import time
+
+from serialport import open_port, open_pty, LineReader
+
+EPOCH_2000 = 946684800
+FIRST_ATTEMPTS = 30
+RESULT = re.compile(r"SYNC SET .* edge=([+-]\d+)us")
+
+
+def host_now():
+    """Host time in microseconds since 01/01/2000 UTC."""
+    return time.time_ns() // 1000 - EPOCH_2000 * 1000000
+
+
+class Link:
+    """Sends command lines and waits for the reply lines, stamping their arrival."""
+
+    def __init__(self, fd):
+        self.fd = fd
+        self.reader = LineReader(fd)
+        self.lines = []
+
+    def send(self, text):
+        os.write(self.fd, (text + "\n").encode())
+
+    def wait(self, match, timeout):
+        """Returns the first line that matches (a function of the line) and its host time, or (None, None)."""
+        deadline = time.monotonic() + timeout
+        while True:
+            while self.lines:
+                line, stamp = self.lines.pop(0)
+                if match(line):
+                    return line, stamp
+            left = deadline - time.monotonic()
+            if left <= 0:
+                return None, None
+            ready, _, _ = select.select([self.fd], [], [], left)
+            if ready:
+                try:
+                    lines = self.reader.feed()
+                except OSError:  # pty peer not open yet
+                    time.sleep(0.1)
+                    continue
+                stamp = host_now()  # taken right after the read: the end of the last line
+                self.lines += [(line, stamp) for line in lines]
+
+
+def is_round(line):
+    words = line.split()
+    return (len(words) == 3 and words[0] == "SYNC" and words[1].isdigit() and words[2].isdigit()) or \
+        line.startswith("ERR")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?", help="serial port of the clock")
+    parser.add_argument("--pty", action="store_true", help="talk through a new pty instead of a port")
+    parser.add_argument("--rounds", type=int, default=8, help="rounds before the write (at least 5)")
+    parser.add_argument("--interval", type=float, default=0.2, help="time between rounds (s)")
+    parser.add_argument("--baud", type=int, default=115200, help="baud rate of the line, for the byte times")
+    parser.add_argument("--tolerance", type=int, default=5000, help="largest error of the SQW edge accepted (us)")
+    parser.add_argument("--dry", action="store_true", help="run the rounds only, without writing the DS3231")
+    args = parser.parse_args()
+
+    if args.pty:
+        fd, path = open_pty()
+        print("device end: %s" % path, file=sys.stderr, flush=True)
+    elif args.port:
+        fd = open_port(args.port)
+    else:
+        parser.error("a port or --pty is required")
+    link = Link(fd)
+    byte = 0 if args.pty else 10 * 1000000 // args.baud  # 8N1; a pty moves whole writes at once
+
+    last = None
+    best = None
+    for number in range(args.rounds):
+        if number > 0:
+            time.sleep(args.interval)
+        for attempt in range(FIRST_ATTEMPTS if number == 0 else 1):  # the first waits for the board (or the pty peer)
+            send = host_now() + byte  # taken right before the write, moved to the end of the first byte
+            link.send("SYNC %d%s" % (send, "" if last is None else " %d" % last))
+            line, stamp = link.wait(is_round, 1.0)
+            if line is not None:
+                break
+        if line is None or line.startswith("ERR"):
+            print("round %d: %s" % (number, line or "no reply"), file=sys.stderr)
+            return 1
+        last = stamp - (len(line) + 2) * byte  # start of the first byte of the reply
+        receive, reply = (int(word) for word in line.split()[1:])
+        delay = (last - send) - ((reply - receive) & 0xFFFFFFFF)
+        if number == 0:
+            print("round 0: starts the session (delay=%dus)" % delay, flush=True)
+            continue
+        best = delay if best is None else min(best, delay)
+        print("round %d: delay=%dus" % (number, delay), flush=True)
+
+    if args.dry:
+        print("best delay=%sus (the session ends on the board after 20 s)" % best)
+        return 0
+    link.send("SYNC SET %d" % last)
+    line, _ = link.wait(lambda text: text == "OK" or text.startswith("ERR"), 2.0)
+    if line != "OK":
+        print("SYNC SET: %s" % (line or "no reply"), file=sys.stderr)
+        return 1
+    line, _ = link.wait(lambda text: text.startswith("SYNC SET "), 5.0)
+    if line is None:
+        print("SYNC SET: no result", file=sys.stderr)
+        return 1
+    print(line)
+    match = RESULT.match(line)
+    return 0 if match and abs(int(match.group(1))) <= args.tolerance else 1
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except KeyboardInterrupt:
+        sys.exit(1)
@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""
+@file tracejson.py
+@brief Converter of the event trace of the clock (trace.h) to the Chrome trace format.
+
+Reads the dump sent by "TR" (TRACE, TE, TN, TK, TC and TR lines) and writes a JSON
+file for chrome://tracing or ui.perfetto.dev. The cycle counter of the records is
+unwrapped (gaps shorter than its wrap, 59.6 s at 72 MHz) and converted to
+microseconds at the clock of the dump, changed by the clock events in between. Each
+context is a track: the threads by their name, the interrupts by their exception
+(the simulator only has SysTick). Spans are named by their task or command, or by
+their event; the ends whose beginning was overwritten in the ring are dropped. Time
+with the core stopped (power.h) does not count cycles, so it does not show.
+
+Usage:
+    python3 tracejson.py /dev/ttyACM0 -o trace.json   board on the ST-LINK virtual COM
+                                                      port, sends "TR" and waits for the dump
+    python3 tracejson.py --pty -o trace.json          creates a pty pair and prints the
+                                                      path of the device end (stand-in
+                                                      for testing)
+    python3 tracejson.py --file uart.txt -o trace.json
+                                                      converts a capture (or "-" for
+                                                      stdin, e.g. the simulator output)
+"""
+import argparse
+import json
+import os
+import select
+import sys
+import time
+
+from serialport import open_port, open_pty, LineReader
+
+BEGIN = 0x40
+END = 0x80
+ISR = 0x80
+MAIN = 0x7F
+EXCEPTIONS = {2: "NMI", 3: "HardFault", 11: "SVCall", 14: "PendSV", 15: "SysTick"}
+FIRST_ATTEMPTS = 30
+DUMP_TIMEOUT = 10.0
+
+
+class Dump:
+    """Collects the lines of a dump."""
+
+    def __init__(self):
+        self.clock = None
+        self.lost = 0
+        self.events = {}
+        self.threads = {}
+        self.tasks = {}
+        self.commands = {}
+        self.records = []
+        self.done = False
+
+    def feed(self, line):
+        words = line.split()
+        if not words:
+            return
+        try:
+            if words[0] == "TRACE" and len(words) == 4:
+                fields = dict(word.split("=") for word in words[1:])
+                self.__init__()
+                self.clock = int(fields["clock"])
+                self.lost = int(fields["lost"])
+            elif words[0] == "TRACE" and words[1:] == ["END"]:
+                self.done = self.clock is not None
+            elif words[0] in ("TE", "TN", "TK", "TC") and len(words) == 3:
+                table = {"TE": self.events, "TN": self.threads, "TK": self.tasks, "TC": self.commands}[words[0]]
+                table[int(words[1], 16)] = words[2]
+            elif words[0] == "TR" and len(words) == 5:
+                self.records.append(tuple(int(word, 16) for word in words[1:]))
+        except (ValueError, KeyError):  # other lines of the console
+            pass
+
+
+def context_name(dump, context):
+    if context & ISR:
+        exception = context & ~ISR
+        return EXCEPTIONS.get(exception, "IRQ%d" % (exception - 16))
+    if context == MAIN:
+        return "main"
+    return dump.threads.get(context, "thread %d" % context)
+
+
+def span_name(dump, event, arg):
+    name = dump.events.get(event, "event %d" % event)
+    if name == "task":
+        return dump.tasks.get(arg, "task %d" % arg)
+    if name == "command":
+        return dump.commands.get(arg, "command %d" % arg)
+    return name
+
+
+def convert(dump):
+    """Returns the Chrome trace events of the dump and the number of ends dropped."""
+    out = []
+    stacks = {}
+    dropped = 0
+    clock = dump.clock
+    stamp = 0.0
+    last = None
+    for cycles, code, context, arg in dump.records:
+        if last is not None:
+            stamp += ((cycles - last) & 0xFFFFFFFF) * 1e6 / clock
+        last = cycles
+        event, phase = code & 0x3F, code & 0xC0
+        name = span_name(dump, event, arg)
+        stack = stacks.setdefault(context, [])
+        item = {"name": name, "cat": dump.events.get(event, "event"), "pid": 1, "tid": context,
+                "ts": round(stamp, 3), "args": {"arg": arg}}
+        if phase == BEGIN:
+            stack.append(event)
+            item["ph"] = "B"
+        elif phase == END:
+            if not stack or stack[-1] != event:
+                dropped += 1  # its beginning was overwritten
+                continue
+            stack.pop()
+            item["ph"] = "E"
+        else:
+            item["ph"] = "i"
+            item["s"] = "t"
+            if dump.events.get(event) == "clock":
+                clock = arg * 1000000 if arg else clock  # the next gaps count at the new frequency
+        out.append(item)
+    for context in stacks:
+        out.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": context,
+                    "args": {"name": context_name(dump, context)}})
+        out.append({"name": "thread_sort_index", "ph": "M", "pid": 1, "tid": context,
+                    "args": {"sort_index": -context if context & ISR else 256 - context}})
+    out.append({"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "clock"}})
+    return out, dropped
+
+
+def read_live(fd):
+    """Sends "TR" and returns the dump, once "TRACE END" arrives or the line goes quiet."""
+    dump = Dump()
+    reader = LineReader(fd)
+    attempts = 0
+    while not dump.done:
+        if dump.clock is None:  # sent again until the dump starts (the board, or the pty peer, may not be ready)
+            if attempts == FIRST_ATTEMPTS:
+                break
+            os.write(fd, b"TR\n")
+            attempts += 1
+        ready, _, _ = select.select([fd], [], [], 1.0 if dump.clock is None else DUMP_TIMEOUT)
+        if not ready:
+            if dump.clock is None:
+                continue
+            break
+        try:
+            lines = reader.feed()
+        except OSError:  # pty peer not open yet
+            time.sleep(0.1)
+            continue
+        for line in lines:
+            dump.feed(line)
+    return dump
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?", help="serial port of the clock")
+    parser.add_argument("--pty", action="store_true", help="talk through a new pty instead of a port")
+    parser.add_argument("--file", help="convert a capture instead ('-' for stdin)")
+    parser.add_argument("-o", "--output", default="-", help="JSON file to write ('-' for stdout)")
+    args = parser.parse_args()
+
+    if args.file:
+        dump = Dump()
+        stream = sys.stdin if args.file == "-" else open(args.file, errors="replace")
+        for line in stream:
+            dump.feed(line)
+    else:
+        if args.pty:
+            fd, path = open_pty()
+            print("device end: %s" % path, file=sys.stderr, flush=True)
+        elif args.port:
+            fd = open_port(args.port)
+        else:
+            parser.error("a port, --pty or --file is required")
+        dump = read_live(fd)
+    if dump.clock is None:
+        print("no dump found", file=sys.stderr)
+        return 1
+
+    events, dropped = convert(dump)
+    output = sys.stdout if args.output == "-" else open(args.output, "w")
+    json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, output)
+    if output is not sys.stdout:
+        output.close()
+    print("records=%d lost=%d dropped=%d%s" % (len(dump.records), dump.lost, dropped,
+                                                "" if dump.done else " (incomplete)"), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except KeyboardInterrupt:
+        sys.exit(1)
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""
+@file tzgen.py
+@brief Compiles the time zones listed in tzzones.txt into transition tables.
+
+Runs as the pre-build step of the STM32CubeIDE project. For every configured zone
+it walks the IANA database (python zoneinfo) from 2000 to 2099, the range the DS3231
+can hold, and emits every UTC offset change as a row of a const table. The firmware
+never parses rules: converting UTC to local time is a table lookup plus an add.
+
+Outputs (only rewritten when their content changes, so the build stays incremental):
+    Drivers/API/inc/tzdata.h  zone identifiers and sizes
+    Drivers/API/src/tzdata.c  transition tables (placed in flash)
+
+Usage: python3 tzgen.py [zones file]
+"""
+import datetime
+import os
+import sys
+import zoneinfo
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(HERE)
+HEADER = os.path.join(ROOT, "Drivers", "API", "inc", "tzdata.h")
+SOURCE = os.path.join(ROOT, "Drivers", "API", "src", "tzdata.c")
+
+EPOCH = datetime.datetime(2000, 1, 1, tzinfo=datetime.timezone.utc)
+END = datetime.datetime(2100, 1, 1, tzinfo=datetime.timezone.utc)
+DAY = datetime.timedelta(days=1)
+
+
+def read_zones(path):
+    zones = []
+    with open(path) as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            label, name = line.split()
+            if len(label) != 3:
+                sys.exit("tzgen: label '%s' must have 3 characters" % label)
+            zones.append((label.upper(), name))
+    if not zones:
+        sys.exit("tzgen: no zones configured")
+    return zones
+
+
+def state(zone, when):
+    local = when.astimezone(zone)
+    offset = int(local.utcoffset().total_seconds()) // 60
+    dst = 1 if local.dst() else 0
+    return offset, dst
+
+
+def transitions(name):
+    """Returns [(utc seconds since 2000, offset minutes, dst)] for 2000-2099."""
+    zone = zoneinfo.ZoneInfo(name)
+    rows = [(0,) + state(zone, EPOCH)]
+    day = EPOCH
+    while day < END:
+        nxt = min(day + DAY, END)
+        if state(zone, nxt) != state(zone, day):
+            lo, hi = day, nxt  # bisect down to the exact second of the change
+            while hi - lo > datetime.timedelta(seconds=1):
+                mid = lo + (hi - lo) / 2
+                mid = mid.replace(microsecond=0)
+                if state(zone, mid) == state(zone, lo):
+                    lo = mid
+                else:
+                    hi = mid
+            rows.append((int((hi - EPOCH).total_seconds()),) + state(zone, hi))
+        day = nxt
+    return rows
+
+
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path, newline="") as f:
+            if f.read() == text:
+                return
+    with open(path, "w", newline="\n") as f:
+        f.write(text)
+
+
+def main():
+    zones_file = sys.argv[1] if len(sys.argv) > 1 else os.path.join(HERE, "tzzones.txt")
+    zones = read_zones(zones_file)
+    tables = [(label, name, transitions(name)) for label, name in zones]
+    longest = max(len(rows) for _, _, rows in tables)
+
+    h = []
+    h.append("/**\n")
+    h.append(" * @file tzdata.h\n")
+    h.append(" * @brief Identifiers of the time zones compiled into the firmware.\n")
+    h.append(" *\n")
+    h.append(" * Generated by Tools/tzgen.py from Tools/tzzones.txt. Do not edit.\n")
+    h.append(" */\n")
+    h.append("#ifndef TZDATA_H\n#define TZDATA_H\n\n")
+    for i, (label, name, rows) in enumerate(tables):
+        plural = "" if len(rows) == 1 else "s"
+        h.append("/**\n * @brief %s (%d transition%s).\n */\n" % (name, len(rows), plural))
+        h.append("#define TZ_%s %d\n\n" % (label, i))
+    h.append("/**\n * @brief Amount of time zones compiled.\n */\n")
+    h.append("#define TZ_ZONE_COUNT %d\n\n" % len(tables))
+    h.append("/**\n * @brief Length of the longest transition table.\n */\n")
+    h.append("#define TZ_MAX_TRANSITIONS %d\n\n" % longest)
+    h.append("#endif\n")
+
+    c = []
+    c.append("/**\n")
+    c.append(" * @file tzdata.c\n")
+    c.append(" * @brief Transition tables of the time zones compiled into the firmware.\n")
+    c.append(" *\n")
+    c.append(" * Generated by Tools/tzgen.py from Tools/tzzones.txt. Do not edit.\n")
+    c.append(" * Each row holds the first UTC second (since 01/01/2000) an offset applies.\n")
+    c.append(" */\n")
+    c.append('#include "timezone.h"\n\n')
+    for label, name, rows in tables:
+        c.append("/* %s */\n" % name)
+        c.append("static const TZ_Transition tz%s[%d] = {\n" % (label, len(rows)))
+        for utc, offset, dst in rows:
+            c.append("\t{%uU, %d, %d},\n" % (utc, offset, dst))
+        c.append("};\n\n")
+    c.append("const TZ_Zone tzZones[TZ_ZONE_COUNT] = {\n")
+    for label, _, rows in tables:
+        c.append('\t{"%s", tz%s, %d},\n' % (label, label, len(rows)))
+    c.append("};\n")
+
+    write_if_changed(HEADER, "".join(h))
+    write_if_changed(SOURCE, "".join(c))
+
+
+if __name__ == "__main__":
+    main()